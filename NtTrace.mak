@@ -59,6 +59,33 @@ NtTrace.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res
 MemoryStats.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res 
 	cl $(CCFLAGS) /Fe$@ $** $(LINKFLAGS)
 
+NtFlightDump.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res 
+	cl $(CCFLAGS) /Fe$@ $** $(LINKFLAGS)
+
+NtTraceAnalyze.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res 
+	cl $(CCFLAGS) /Fe$@ $** $(LINKFLAGS)
+
+NtTraceDiff.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res 
+	cl $(CCFLAGS) /Fe$@ $** $(LINKFLAGS)
+
+NtTraceMerge.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res 
+	cl $(CCFLAGS) /Fe$@ $** $(LINKFLAGS)
+
+NtTracePatterns.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res 
+	cl $(CCFLAGS) /Fe$@ $** $(LINKFLAGS)
+
+NtTraceQuery.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res 
+	cl $(CCFLAGS) /Fe$@ $** $(LINKFLAGS)
+
+NtTraceScan.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res 
+	cl $(CCFLAGS) /Fe$@ $** $(LINKFLAGS)
+
+NtTraceStore.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res 
+	cl $(CCFLAGS) /Fe$@ $** $(LINKFLAGS)
+
+NtTraceTotals.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res 
+	cl $(CCFLAGS) /Fe$@ $** $(LINKFLAGS)
+
 ShowLoaderSnaps.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res 
 	cl $(CCFLAGS) /Fe$@ $** $(LINKFLAGS)
 
@@ -69,16 +96,33 @@ SymExplorer.exe : $(BUILD)\$(*B).obj $(BUILD)\$(*B).res
 
 $(BUILD)\NtTrace.obj : \
 	"include/AdjustPriv.h" \
+	"include/CallTotals.h" \
+	"include/ChromeTrace.h" \
 	"include/DebugPriv.h" \
 	"include/DisplayError.h" \
 	"include/DisplayError.inl" \
+	"include/FileIoStats.h" \
+	"include/FilterExpression.h" \
+	"include/FlightRecorder.h" \
+	"include/FoldedStacks.h" \
+	"include/HandleTable.h" \
+	"include/JsonWriter.h" \
+	"include/LeakTracker.h" \
 	"include/MsvcExceptions.h" \
 	"include/NtDllStruct.h" \
 	"include/Options.h" \
 	"include/Options.inl" \
 	"include/ProcessHelper.h" \
 	"include/ProcessInfo.h" \
+	"include/RedundantCalls.h" \
+	"include/RegistryProfile.h" \
+	"include/ShardedOutput.h" \
 	"include/SimpleTokenizer.h" \
+	"include/SmallIoDetector.h" \
+	"include/StackTable.h" \
+	"include/TraceTrigger.h" \
+	"include/VirtualMemoryMap.h" \
+	"include/WaitProfiler.h" \
 	"include/DebugDriver.h" \
 	"include/EntryPoint.h" \
 	"include/GetFileNameFromHandle.h" \
@@ -93,7 +137,53 @@ MemoryStats.exe : $(BUILD)\DebugDriver.obj $(BUILD)\ShowData.obj
 NtTrace.res: $(*B).rc "version.rc"
 
 NtTrace.exe : $(BUILD)\DebugDriver.obj $(BUILD)\EntryPoint.obj $(BUILD)\Enumerations.obj $(BUILD)\ShowData.obj \
-	$(BUILD)\GetFileNameFromHandle.obj $(BUILD)\GetModuleBase.obj $(BUILD)\SymbolEngine.obj
+	$(BUILD)\GetFileNameFromHandle.obj $(BUILD)\GetModuleBase.obj $(BUILD)\SymbolEngine.obj $(BUILD)\X64Unwinder.obj \
+	$(BUILD)\FilterExpression.obj $(BUILD)\FlightRecorder.obj $(BUILD)\HandleTable.obj $(BUILD)\JsonWriter.obj \
+	$(BUILD)\LeakTracker.obj $(BUILD)\FileIoStats.obj $(BUILD)\RedundantCalls.obj \
+	$(BUILD)\RegistryProfile.obj $(BUILD)\VirtualMemoryMap.obj $(BUILD)\WaitProfiler.obj \
+	$(BUILD)\CallTotals.obj $(BUILD)\ChromeTrace.obj $(BUILD)\SmallIoDetector.obj \
+	$(BUILD)\ShardedOutput.obj $(BUILD)\X64Trampoline.obj
+
+NtFlightDump.res: $(*B).rc "version.rc"
+
+NtFlightDump.exe : $(BUILD)\ChromeTrace.obj $(BUILD)\FlightRecorder.obj $(BUILD)\JsonWriter.obj
+
+NtTraceAnalyze.res: $(*B).rc "version.rc"
+
+NtTraceAnalyze.exe : $(BUILD)\ChromeTrace.obj $(BUILD)\HandleTable.obj $(BUILD)\JsonWriter.obj \
+	$(BUILD)\RedundantCalls.obj $(BUILD)\RegistryProfile.obj $(BUILD)\SmallIoDetector.obj $(BUILD)\TraceLine.obj \
+	$(BUILD)\TraceParser.obj $(BUILD)\WaitProfiler.obj
+
+NtTraceDiff.res: $(*B).rc "version.rc"
+
+NtTraceDiff.exe : $(BUILD)\HandleTable.obj $(BUILD)\MappedFile.obj $(BUILD)\RedundantCalls.obj \
+	$(BUILD)\TraceDiff.obj $(BUILD)\TraceParser.obj
+
+NtTraceMerge.res: $(*B).rc "version.rc"
+
+NtTraceMerge.exe : $(BUILD)\MappedFile.obj $(BUILD)\ShardedOutput.obj
+
+NtTracePatterns.res: $(*B).rc "version.rc"
+
+NtTracePatterns.exe : $(BUILD)\MappedFile.obj $(BUILD)\PatternMiner.obj $(BUILD)\TraceParser.obj \
+	$(BUILD)\TraceStore.obj
+
+NtTraceQuery.res: $(*B).rc "version.rc"
+
+NtTraceQuery.exe : $(BUILD)\MappedFile.obj $(BUILD)\TraceParser.obj $(BUILD)\TraceQuery.obj \
+	$(BUILD)\TraceStore.obj
+
+NtTraceScan.res: $(*B).rc "version.rc"
+
+NtTraceScan.exe : $(BUILD)\MappedFile.obj $(BUILD)\TraceParser.obj
+
+NtTraceStore.res: $(*B).rc "version.rc"
+
+NtTraceStore.exe : $(BUILD)\MappedFile.obj $(BUILD)\TraceParser.obj $(BUILD)\TraceStore.obj
+
+NtTraceTotals.res: $(*B).rc "version.rc"
+
+NtTraceTotals.exe : $(BUILD)\CallTotals.obj $(BUILD)\MappedFile.obj $(BUILD)\TraceParser.obj
 
 ShowLoaderSnaps.res: $(*B).rc "version.rc"
 
@@ -101,23 +191,178 @@ ShowLoaderSnaps.exe : $(BUILD)\DebugDriver.obj $(BUILD)\GetModuleBase.obj
 
 SymExplorer.res: $(*B).rc "version.rc"
 
-SymExplorer.exe : $(BUILD)\GetModuleBase.obj $(BUILD)\GetFileNameFromHandle.obj $(BUILD)\SymbolEngine.obj
+SymExplorer.exe : $(BUILD)\GetModuleBase.obj $(BUILD)\GetFileNameFromHandle.obj $(BUILD)\SymbolEngine.obj $(BUILD)\X64Unwinder.obj
+
+$(BUILD)\CallTotals.obj : \
+	"include/CallTotals.h"
+
+$(BUILD)\ChromeTrace.obj : \
+	"include/ChromeTrace.h" \
+	"include/JsonWriter.h"
 
 $(BUILD)\DebugDriver.obj : \
 	"include/DisplayError.h" \
 	"include/DisplayError.inl" \
 	"include/DebugDriver.h"
 
+$(BUILD)\FileIoStats.obj : \
+	"include/FileIoStats.h"
+
+$(BUILD)\FilterExpression.obj : \
+	"include/FilterExpression.h"
+
+$(BUILD)\FlightRecorder.obj : \
+	"include/FlightRecorder.h"
+
+$(BUILD)\HandleTable.obj : \
+	"include/HandleTable.h"
+
+$(BUILD)\JsonWriter.obj : \
+	"include/JsonWriter.h"
+
+$(BUILD)\LeakTracker.obj : \
+	"include/LeakTracker.h" \
+	"include/StackTable.h"
+
+$(BUILD)\MappedFile.obj : \
+	"include/MappedFile.h"
+
+$(BUILD)\NtFlightDump.obj : \
+	"include/ChromeTrace.h" \
+	"include/FlightRecorder.h" \
+	"include/JsonWriter.h" \
+	"include/Options.h" \
+	"include/Options.inl"
+
+$(BUILD)\NtTraceAnalyze.obj : \
+	"include/ChromeTrace.h" \
+	"include/HandleTable.h" \
+	"include/JsonWriter.h" \
+	"include/Options.h" \
+	"include/Options.inl" \
+	"include/RedundantCalls.h" \
+	"include/RegistryProfile.h" \
+	"include/SmallIoDetector.h" \
+	"include/StackTable.h" \
+	"include/TraceLine.h" \
+	"include/TraceParser.h" \
+	"include/WaitProfiler.h"
+
+$(BUILD)\NtTraceDiff.obj : \
+	"include/HandleTable.h" \
+	"include/MappedFile.h" \
+	"include/Options.h" \
+	"include/Options.inl" \
+	"include/TraceDiff.h" \
+	"include/TraceParser.h"
+
+$(BUILD)\NtTraceMerge.obj : \
+	"include/MappedFile.h" \
+	"include/Options.h" \
+	"include/Options.inl" \
+	"include/ShardedOutput.h"
+
+$(BUILD)\NtTracePatterns.obj : \
+	"include/MappedFile.h" \
+	"include/Options.h" \
+	"include/Options.inl" \
+	"include/PatternMiner.h" \
+	"include/StackTable.h" \
+	"include/TraceParser.h" \
+	"include/TraceStore.h"
+
+$(BUILD)\NtTraceQuery.obj : \
+	"include/MappedFile.h" \
+	"include/Options.h" \
+	"include/Options.inl" \
+	"include/TraceParser.h" \
+	"include/TraceQuery.h" \
+	"include/TraceStore.h"
+
+$(BUILD)\NtTraceScan.obj : \
+	"include/MappedFile.h" \
+	"include/Options.h" \
+	"include/Options.inl" \
+	"include/TraceParser.h"
+
+$(BUILD)\NtTraceStore.obj : \
+	"include/MappedFile.h" \
+	"include/Options.h" \
+	"include/Options.inl" \
+	"include/TraceParser.h" \
+	"include/TraceStore.h"
+
+$(BUILD)\NtTraceTotals.obj : \
+	"include/CallTotals.h" \
+	"include/MappedFile.h" \
+	"include/Options.h" \
+	"include/Options.inl" \
+	"include/TraceParser.h"
+
+$(BUILD)\PatternMiner.obj : \
+	"include/PatternMiner.h" \
+	"include/StackTable.h"
+
+$(BUILD)\RedundantCalls.obj : \
+	"include/RedundantCalls.h" \
+	"include/StackTable.h"
+
+$(BUILD)\RegistryProfile.obj : \
+	"include/RegistryProfile.h"
+
+$(BUILD)\ShardedOutput.obj : \
+	"include/ShardedOutput.h"
+
+$(BUILD)\SmallIoDetector.obj : \
+	"include/SmallIoDetector.h"
+
+$(BUILD)\TraceDiff.obj : \
+	"include/HandleTable.h" \
+	"include/RedundantCalls.h" \
+	"include/TraceDiff.h" \
+	"include/TraceParser.h"
+
+$(BUILD)\TraceLine.obj : \
+	"include/TraceLine.h" \
+	"include/TraceParser.h"
+
+$(BUILD)\TraceParser.obj : \
+	"include/TraceParser.h"
+
+$(BUILD)\TraceQuery.obj : \
+	"include/MappedFile.h" \
+	"include/TraceParser.h" \
+	"include/TraceQuery.h" \
+	"include/TraceStore.h"
+
+$(BUILD)\TraceStore.obj : \
+	"include/MappedFile.h" \
+	"include/TraceParser.h" \
+	"include/TraceStore.h"
+
+$(BUILD)\VirtualMemoryMap.obj : \
+	"include/StackTable.h" \
+	"include/VirtualMemoryMap.h"
+
+$(BUILD)\WaitProfiler.obj : \
+	"include/StackTable.h" \
+	"include/WaitProfiler.h"
+
 $(BUILD)\EntryPoint.obj : \
 	"include/DisplayError.h" \
 	"include/DisplayError.inl" \
 	"include/DbgHelper.h" \
 	"include/DbgHelper.inl" \
+	"include/HandleTable.h" \
+	"include/JsonWriter.h" \
+	"include/ModuleMap.h" \
 	"include/NtDllStruct.h" \
 	"include/ProcessInfo.h" \
+	"include/SymbolCache.h" \
 	"include/SymbolEngine.h" \
 	"include/TrapNtOpcodes.h" \
-	"include/ShowData.h"
+	"include/ShowData.h" \
+	"include/X64Trampoline.h"
 
 $(BUILD)\MemoryStats.obj: \
 	"include/DisplayError.h" \
@@ -160,10 +405,13 @@ $(BUILD)\SymbolEngine.obj: \
 	"include/SymbolEngine.h" \
 	"include/DbgHelper.h" \
 	"include/DbgHelper.inl" \
+	"include/ModuleMap.h" \
 	"include/MSvcExceptions.h" \
 	"include/ReadPartialMemory.h" \
 	"include/StrFromWchar.h" \
-	"include/Utf16ToMbs.h"
+	"include/SymbolCache.h" \
+	"include/Utf16ToMbs.h" \
+	"include/X64Unwinder.h"
 
 $(BUILD)\SymExplorer.obj: \
 	"include/BasicType.h" \
@@ -176,3 +424,10 @@ $(BUILD)\SymExplorer.obj: \
 	"include/StrFromWchar.h" \
 	"include/StreamGUID.h" \
 	"include/SymbolEngine.h"
+
+$(BUILD)\X64Trampoline.obj: \
+	"include/X64Trampoline.h"
+
+$(BUILD)\X64Unwinder.obj: \
+	"include/ModuleMap.h" \
+	"include/X64Unwinder.h"
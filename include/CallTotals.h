@@ -0,0 +1,153 @@
+#ifndef OR2_CALLTOTALS_H
+#define OR2_CALLTOTALS_H
+
+/**@file
+
+  Machine readable totals of the calls made, and the comparison of a run
+  with a stored baseline so that a build can fail when a change makes many
+  more calls than before.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace or2 {
+
+/**
+ * Totals of calls by process, category and function.
+ *
+ * The totals file is text, one row per line with tab separated fields:
+ *
+ *   process category function calls errors p50_us p90_us p99_us
+ *
+ * A process or category of "*" is the total over all of them, and a
+ * function of "*" the total for the category. The latency percentiles are
+ * "-" when the durations of the calls were not measured.
+ */
+class CallTotals {
+public:
+  /** Process, category and function of a row */
+  using Key = std::tuple<std::string, std::string, std::string>;
+
+  /** The totals in one row */
+  struct Row {
+    uint64_t calls{};  ///< number of calls
+    uint64_t errors{}; ///< calls returning an NTSTATUS error
+    bool timed{};      ///< true if the latencies are known
+    uint64_t p50{};    ///< median latency in microseconds
+    uint64_t p90{};    ///< 90th percentile latency in microseconds
+    uint64_t p99{};    ///< 99th percentile latency in microseconds
+  };
+
+  /** The rows, in order of their keys */
+  using Table = std::map<Key, Row>;
+
+  /** The increase allowed over the baseline */
+  struct Tolerance {
+    double percent{10}; ///< allowed percentage increase
+    uint64_t slack{};   ///< allowed increase in number, however small
+    double latency{-1}; ///< allowed latency increase, negative to ignore
+  };
+
+  /** A value exceeding its tolerance, or improving on the baseline */
+  struct Change {
+    Key key;           ///< the row
+    char const *what;  ///< the value: "calls", "errors" or "p99 us"
+    uint64_t baseline; ///< value in the baseline
+    uint64_t current;  ///< value in this run
+  };
+
+  /**
+   * Add a call.
+   * @param microseconds the duration of the call, or negative if unknown
+   */
+  void add(std::string const &process, std::string const &category,
+           std::string const &function, bool error,
+           int64_t microseconds = -1);
+
+  /** Returns true if no calls have been added */
+  bool empty() const { return functions_.empty(); }
+
+  /** Get the rows for each function and the totals */
+  Table table() const;
+
+  /** Write a table as a totals file */
+  static void write(std::ostream &os, Table const &table);
+
+  /**
+   * Read a totals file.
+   * @return false if the file is invalid, with the reason in 'error'
+   */
+  static bool read(std::istream &is, Table &table, std::string &error);
+
+  /**
+   * Read per function or per category tolerances, one per line as
+   * "<name> <percent> [<slack> [<latency percent>]]"; lines starting with
+   * '#' are ignored.
+   * @return false if the file is invalid, with the reason in 'error'
+   */
+  static bool readTolerances(std::istream &is,
+                             std::map<std::string, Tolerance> &tolerances,
+                             std::string &error);
+
+  /**
+   * Compare a run with a baseline; the tolerance for a row is that given
+   * for its function, else for its category, else the default.
+   * @param regressions set to the values exceeding their tolerance
+   * @param improvements set to the values lower than the baseline
+   */
+  static void compare(Table const &baseline, Table const &current,
+                      Tolerance const &tolerance,
+                      std::map<std::string, Tolerance> const &tolerances,
+                      std::vector<Change> &regressions,
+                      std::vector<Change> &improvements);
+
+private:
+  /** Totals with a histogram of the latencies */
+  struct Counts {
+    uint64_t calls{};
+    uint64_t errors{};
+    std::vector<uint64_t> latencies; // log-linear buckets, empty if none
+
+    void add(bool error, int64_t microseconds);
+    void add(Counts const &other);
+    Row row() const;
+  };
+
+  std::map<Key, Counts> functions_;
+};
+
+} // namespace or2
+
+#endif // OR2_CALLTOTALS_H
@@ -0,0 +1,137 @@
+#ifndef OR2_CHROMETRACE_H
+#define OR2_CHROMETRACE_H
+
+/**@file
+
+  Export of calls and other events in the Chrome trace-event format, for
+  viewing the threads of the traced processes on a timeline in a viewer such
+  as chrome://tracing or Perfetto.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "JsonWriter.h"
+
+namespace or2 {
+
+/**
+ * Streaming writer for a trace in the JSON array form of the trace-event
+ * format.
+ *
+ * Calls are written as complete ("X") events on the track of their thread
+ * and other events as thread scoped instant ("i") events; times are in
+ * microseconds from the start of the trace. Events are written as they are
+ * added, so the size of the trace is not limited by memory.
+ *
+ * Long traces can be split into files each covering a fixed slice of time,
+ * so that each file is small enough to be loaded by a viewer. The process
+ * and thread names are repeated at the start of each file.
+ */
+class ChromeTrace {
+public:
+  /** An argument shown in the details of an event */
+  struct Arg {
+    std::string name;  ///< label
+    std::string value; ///< value as text
+  };
+
+  /**
+   * Construct an exporter
+   * @param fileName the file to write
+   * @param slice if non-zero, split the trace into files each holding this
+   * number of microseconds, named by inserting "-<n>" before any extension
+   */
+  explicit ChromeTrace(std::string fileName, uint64_t slice = 0);
+  ~ChromeTrace();
+  ChromeTrace(ChromeTrace const &) = delete;
+  ChromeTrace &operator=(ChromeTrace const &) = delete;
+
+  /** Returns false if any file could not be opened or written */
+  bool good() const { return error_.empty(); }
+
+  /** Get the name of the first file that could not be opened or written */
+  std::string const &error() const { return error_; }
+
+  /** Set the name shown for a process */
+  void processName(uint32_t processId, std::string const &name);
+
+  /** Set the name shown for a thread */
+  void threadName(uint32_t processId, uint32_t threadId,
+                  std::string const &name);
+
+  /** Add a call, or other event with a duration */
+  void complete(uint32_t processId, uint32_t threadId, uint64_t start,
+                uint64_t duration, std::string const &name,
+                std::string const &category, std::vector<Arg> const &args);
+
+  /** Add an event at a single point in time */
+  void instant(uint32_t processId, uint32_t threadId, uint64_t time,
+               std::string const &name, std::string const &category,
+               std::vector<Arg> const &args = {});
+
+  /**
+   * Finish the current file; no further events can be added.
+   * @return false if any file could not be opened or written
+   */
+  bool close();
+
+  /** Get the name of the file for one slice of a trace */
+  static std::string sliceName(std::string const &fileName, size_t index);
+
+private:
+  void select(uint64_t time);
+  void open(size_t index);
+  void beginEvent(char const *phase, uint32_t processId, uint32_t threadId,
+                  std::string const &name);
+  void writeArgs(std::vector<Arg> const &args);
+  void writeName(char const *kind, uint32_t processId, uint32_t threadId,
+                 std::string const &name);
+
+  std::string const fileName_;
+  uint64_t const slice_;
+  size_t index_{};
+  std::string current_;
+  std::ofstream os_;
+  std::string error_;
+  JsonWriter writer_{os_};
+  std::map<uint32_t, std::string> processes_; // process names
+  std::map<std::pair<uint32_t, uint32_t>, std::string>
+      threads_; // thread names, by process and thread
+};
+
+} // namespace or2
+
+#endif // OR2_CHROMETRACE_H
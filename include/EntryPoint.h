@@ -46,6 +46,12 @@
 // Forward Reference
 struct NtCall;
 
+namespace or2 {
+class FilterProgram;
+class HandleTable;
+class JsonWriter;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Possible distinct argument types
 enum ArgType {
@@ -108,6 +114,15 @@ struct Argument {
 
   bool isDummy() const { return dummy_; }
 
+  /** Get the formal name of the argument */
+  std::string const &getName() const { return name_; }
+
+  /** Get the type used to process the argument */
+  ArgType getArgType() const { return argType_; }
+
+  /** Get the type name of the argument */
+  std::string const &getArgTypeName() const { return argTypeName_; }
+
   /** Write argument to the output stream */
   void printOn(std::ostream &os) const;
 
@@ -201,14 +216,44 @@ public:
 
   size_t getTotal() const { return total_; }
 
+  /**
+   * Trace a call to the entry point; if a handle table is supplied handle
+   * arguments are annotated with the names of the objects they refer to.
+   */
   void trace(std::ostream &os, HANDLE hProcess, HANDLE hThread,
              CONTEXT const &Context, bool bNames, bool bStackTrace,
-             bool before) const;
+             bool before, or2::HandleTable const *handles = nullptr) const;
+
+  /**
+   * Write a call to the entry point as members of the current JSON object:
+   * the function, category, typed arguments and return value.
+   */
+  void traceJson(or2::JsonWriter &writer, HANDLE hProcess,
+                 CONTEXT const &Context, bool before,
+                 or2::HandleTable const *handles = nullptr) const;
 
   bool operator<(EntryPoint const &rhs) const;
 
   static void stackTrace(std::ostream &os, HANDLE hProcess, HANDLE hThread);
 
+  /** Get the names of the functions on the stack, innermost first */
+  static void stackFunctions(HANDLE hProcess, HANDLE hThread,
+                             CONTEXT const &Context,
+                             std::vector<std::string> &functions);
+
+  /** Set the memory limit for the symbol cache shared by all processes */
+  static void setSymbolCacheLimit(size_t maxBytes);
+
+  /** Release the stack trace resources for a process that has exited */
+  static void releaseProcess(HANDLE hProcess);
+
+  /** Record a module loaded into a process, for use by stack traces */
+  static void moduleLoaded(HANDLE hProcess, PVOID base,
+                           std::string const &name);
+
+  /** Record a module unloaded from a process */
+  static void moduleUnloaded(HANDLE hProcess, PVOID base);
+
 private:
   std::string name_;                // name of entry point
   std::string exported_;            // (optional) exported name for entry point
@@ -219,13 +264,18 @@ private:
   ReturnType retType_{};            // Return type
   std::string retTypeName_;         // full name of return type
   unsigned char *targetAddress_{};
-  unsigned char *preSave_{}; // address of pre-save (for X64 fast-call)
-  DWORD ssn_{};              // System Service Number
-                             // Used to set Eax/Rax to pre-call breakpoint
-  size_t total_{};           // total call count
+  unsigned char *preSave_{};    // address of pre-save (for X64 fast-call)
+  unsigned char *trampoline_{}; // address of jump to trampoline (for X64)
+  DWORD ssn_{};                 // System Service Number
+                                // Used to set Eax/Rax to pre-call breakpoint
+  size_t total_{};              // total call count
 
   NtCall insertBrkpt(HANDLE hProcess, unsigned char *address,
                      unsigned int offset, unsigned char *setssn);
+
+  bool setTrampoline(HANDLE hProcess, unsigned char *setssn);
+
+  bool isSuccess(ULONG_PTR returnCode) const;
 };
 
 using EntryPointSet = std::set<EntryPoint>;
@@ -240,6 +290,9 @@ struct NtCall {
   enum TrapType { trapContinue, trapReturn, trapReturn0, trapJump };
   TrapType trapType_{};
   DWORD jumpTarget_{}; // used for trapJump
+
+  or2::FilterProgram const *filter_{}; // Optional filter for traced calls
+  bool trace_{true}; // False if only trapped as a trigger
 };
 
 #endif // ENTRYPOINT_H_
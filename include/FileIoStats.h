@@ -0,0 +1,111 @@
+#ifndef OR2_FILEIOSTATS_H
+#define OR2_FILEIOSTATS_H
+
+/**@file
+
+  Aggregation of file I/O calls by file path: the number of opens, reads,
+  writes and queries, the bytes moved, the distribution of request sizes and,
+  when it is measured, the time spent in the calls.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace or2 {
+
+/** File I/O statistics for each file path */
+class FileIoStats {
+public:
+  /** Kinds of file operation */
+  enum Op { Open, Read, Write, Query, OpCount };
+
+  /** Read and write request sizes are counted in buckets growing by 16x */
+  static constexpr size_t sizeBuckets = 6;
+
+  /** Statistics for one file */
+  struct File {
+    std::string path;              ///< full path of the file
+    uint64_t calls[OpCount]{};     ///< number of calls by operation
+    uint64_t bytesRead{};          ///< bytes transferred by reads
+    uint64_t bytesWritten{};       ///< bytes transferred by writes
+    uint64_t sizes[sizeBuckets]{}; ///< read and write requests by size
+    uint64_t timed{};              ///< number of calls with a time
+    uint64_t microseconds{};       ///< total time of the timed calls
+
+    /** Total number of calls */
+    uint64_t total() const;
+  };
+
+  /**
+   * Add a call.
+   * @param path the file path
+   * @param op the operation
+   * @param requested the number of bytes requested, for reads and writes
+   * @param transferred the number of bytes actually transferred
+   * @param microseconds the time in the call, or -1 if not measured
+   */
+  void add(std::string const &path, Op op, uint64_t requested,
+           uint64_t transferred, int64_t microseconds);
+
+  /** Get the 'count' files with the most calls, busiest first */
+  std::vector<File const *> top(size_t count) const;
+
+  /** Number of distinct files */
+  size_t size() const { return files_.size(); }
+
+  /** Returns true if no calls have been added */
+  bool empty() const { return files_.empty(); }
+
+  /** Get the size bucket for a request */
+  static size_t bucket(uint64_t requested);
+
+  /** Get the label for a size bucket, for example "<4K" */
+  static char const *bucketName(size_t bucket);
+
+  /** Print a table of the 'count' busiest files */
+  void report(std::ostream &os, size_t count) const;
+
+  /**
+   * Get the operation performed by a file I/O entry point.
+   * @return OpCount if the entry point is not counted
+   */
+  static Op operation(std::string const &function);
+
+private:
+  std::unordered_map<std::string, File> files_;
+};
+
+} // namespace or2
+
+#endif // OR2_FILEIOSTATS_H
@@ -0,0 +1,186 @@
+#ifndef OR2_FILTEREXPRESSION_H
+#define OR2_FILTEREXPRESSION_H
+
+/**@file
+
+  Filter expressions selecting the calls to trace, for example:
+
+    NtCreateFile && ObjectAttributes ~ "*\\temp\\*" && status != 0
+
+  An expression is parsed once and then compiled, for each entry point, into
+  a compact bytecode program which is evaluated against the raw values of a
+  call before any formatting is done.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace or2 {
+
+/** Supplies the values of a call when evaluating a filter */
+class FilterContext {
+public:
+  /** Fields of a call: argument 'n' is field 'fieldArgument + n' */
+  enum Field : unsigned {
+    fieldStatus,   ///< return code
+    fieldError,    ///< non-zero if the return code is not a success code
+    fieldPid,      ///< process ID
+    fieldTid,      ///< thread ID
+    fieldArgument, ///< first argument
+  };
+
+  virtual ~FilterContext() = default;
+
+  /** Get the value of an integer field */
+  virtual int64_t integer(unsigned field) = 0;
+
+  /**
+   * Get the value of a string field.
+   * @return false if the value is not available
+   */
+  virtual bool string(unsigned field, std::string &value) = 0;
+};
+
+/** The entry point a filter is compiled for */
+struct FilterTarget {
+  /** An argument of the entry point */
+  struct Argument {
+    std::string name; ///< formal name of the argument
+    bool isString;    ///< true if the argument value is a string
+  };
+
+  std::string function;            ///< name of the entry point
+  std::string category;            ///< category of the entry point
+  std::vector<Argument> arguments; ///< the arguments, in order
+};
+
+/**
+ * A filter compiled for one entry point.
+ *
+ * Evaluation uses scratch storage in the program, so a program must not be
+ * evaluated on more than one thread at a time.
+ */
+class FilterProgram {
+public:
+  /** Evaluate the filter for a call */
+  bool evaluate(FilterContext &context) const;
+
+  /** Returns true if the filter does not match any call */
+  bool alwaysFalse() const;
+
+  /** Returns true if the filter matches every call */
+  bool alwaysTrue() const;
+
+  /** Number of instructions in the program */
+  size_t size() const { return code_.size(); }
+
+  /** Print the instructions, for diagnostic purposes */
+  void print(std::ostream &os) const;
+
+private:
+  friend class FilterCompiler;
+
+  enum class Op : uint8_t {
+    PushInt,    // push integers_[operand]
+    PushString, // push strings_[operand]
+    LoadInt,    // push integer field 'operand'
+    LoadString, // push string field stringFields_[operand]
+    Eq,
+    Ne,
+    Lt,
+    Le,
+    Gt,
+    Ge,
+    StrEq,
+    StrNe,
+    Match,
+    NoMatch,
+    StrTruth, // replace string with non-empty test
+    Not,
+    JumpIfFalse, // if top is zero jump to 'operand', else pop
+    JumpIfTrue,  // if top is non-zero jump to 'operand', else pop
+  };
+
+  struct Instruction {
+    Op op;
+    uint32_t operand;
+  };
+
+  std::vector<Instruction> code_;
+  std::vector<int64_t> integers_;
+  std::vector<std::string> strings_;
+  std::vector<unsigned> stringFields_; // fields loaded by LoadString
+
+  // Scratch storage for evaluation
+  mutable std::vector<int64_t> intStack_;
+  mutable std::vector<std::string const *> stringStack_;
+  mutable std::vector<std::string> fetched_;
+  mutable std::vector<char> fetchState_;
+};
+
+/** A parsed filter expression */
+class FilterExpression {
+public:
+  /**
+   * Parse an expression.
+   * @throws std::runtime_error if the expression is not valid
+   */
+  explicit FilterExpression(std::string const &text);
+
+  ~FilterExpression();
+
+  /** Compile the expression for an entry point */
+  FilterProgram compile(FilterTarget const &target) const;
+
+  /**
+   * Check every identifier is a field of one of the entry points, or the
+   * name of one of them, so that a misspelt name is not silently false.
+   * @throws std::runtime_error naming the first unknown identifier
+   */
+  void check(std::vector<FilterTarget> const &targets) const;
+
+  /** Get the text of the expression */
+  std::string const &getText() const { return text_; }
+
+  /** Node of the parsed expression */
+  struct Node;
+
+private:
+  std::string text_;
+  std::shared_ptr<Node const> root_;
+};
+
+} // namespace or2
+
+#endif // OR2_FILTEREXPRESSION_H
@@ -0,0 +1,153 @@
+#ifndef OR2_FLIGHTRECORDER_H
+#define OR2_FLIGHTRECORDER_H
+
+/**@file
+
+  Fixed size in-memory record of the most recent calls made by a process, in
+  compact binary form, which can be written to a dump file when something of
+  interest happens.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace or2 {
+
+/**
+ * Ring buffer of calls.
+ *
+ * Calls are stored as variable length records in a single block of memory
+ * allocated on construction; when the ring is full the oldest records are
+ * discarded to make room for new ones.
+ */
+class FlightRecorder {
+public:
+  /** A recorded call */
+  struct Record {
+    uint64_t time{};            ///< time of the call, in ticks
+    uint32_t threadId{};        ///< thread making the call
+    uint32_t entry{};           ///< index of the entry point name
+    uint64_t result{};          ///< return value
+    std::vector<uint64_t> args; ///< argument values
+  };
+
+  /** The contents of a dump file */
+  struct Dump {
+    uint32_t processId{};           ///< process the calls were made in
+    uint64_t frequency{};           ///< ticks per second
+    std::string reason;             ///< why the dump was written
+    std::vector<std::string> names; ///< entry point names
+    std::vector<Record> records;    ///< the calls, oldest first
+  };
+
+  /** Construct a recorder holding up to 'capacity' bytes of records */
+  explicit FlightRecorder(size_t capacity);
+
+  /** Add a call */
+  template <typename Arg>
+  void add(uint64_t time, uint32_t threadId, uint32_t entry, uint64_t result,
+           Arg const *args, size_t argCount) {
+    static_assert(std::is_integral_v<Arg> && std::is_unsigned_v<Arg>,
+                  "arguments must be unsigned integers");
+    size_t const length = headerSize + argCount * sizeof(uint64_t);
+    if (!reserve(length)) {
+      return;
+    }
+    putHeader(static_cast<uint32_t>(length), time, threadId, entry, result);
+    for (size_t idx = 0; idx != argCount; ++idx) {
+      putValue(static_cast<uint64_t>(args[idx]));
+    }
+    ++count_;
+  }
+
+  /** Get the recorded calls, oldest first */
+  std::vector<Record> records() const;
+
+  /** Number of calls held */
+  size_t size() const { return count_; }
+
+  /** Returns true if no calls are held */
+  bool empty() const { return count_ == 0; }
+
+  /** Size of the ring in bytes */
+  size_t capacity() const { return buffer_.size(); }
+
+  /** Discard all the recorded calls */
+  void clear();
+
+  /**
+   * Write a dump file of the recorded calls.
+   * @param os the (binary) stream to write to
+   * @param processId the process the calls were made in
+   * @param frequency the number of ticks per second
+   * @param reason why the dump is being written
+   * @param names the entry point names, indexed by Record::entry
+   */
+  void write(std::ostream &os, uint32_t processId, uint64_t frequency,
+             std::string const &reason,
+             std::vector<std::string> const &names) const;
+
+  /** Write a dump */
+  static void write(std::ostream &os, Dump const &dump);
+
+  /**
+   * Read a dump file.
+   * @return false if the stream does not contain a valid dump
+   */
+  static bool read(std::istream &is, Dump &dump);
+
+  /** Print a dump as text, with times relative to the last call */
+  static void print(std::ostream &os, Dump const &dump);
+
+private:
+  // size, time, thread, entry, result
+  static constexpr size_t headerSize = 4 + 8 + 4 + 4 + 8;
+
+  bool reserve(size_t length);
+  void putHeader(uint32_t length, uint64_t time, uint32_t threadId,
+                 uint32_t entry, uint64_t result);
+  void putValue(uint64_t value);
+  void put(void const *data, size_t length);
+  void get(size_t offset, void *data, size_t length) const;
+
+  std::vector<unsigned char> buffer_;
+  size_t head_{}; // offset for the next record
+  size_t tail_{}; // offset of the oldest record
+  size_t used_{}; // bytes in use
+  size_t count_{};
+};
+
+} // namespace or2
+
+#endif // OR2_FLIGHTRECORDER_H
@@ -0,0 +1,118 @@
+#ifndef OR2_FOLDEDSTACKS_H
+#define OR2_FOLDEDSTACKS_H
+
+/**@file
+
+  Aggregate call stacks into the "folded stack" format read by flame graph
+  tools: one line per distinct stack, with the frames from the root outwards
+  separated by semicolons, followed by a space and the total weight.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace or2 {
+
+/**
+ * Folded stacks for the calls to each entry point.
+ *
+ * Each stack is rooted at the category of the entry point and ends with the
+ * entry point itself, so a flame graph groups the calls first by category and
+ * shows each entry point at the top of the stacks calling it.
+ */
+class FoldedStacks {
+public:
+  /**
+   * Add a call.
+   * @param category the category of the entry point
+   * @param function the name of the entry point
+   * @param frames the calling frames, innermost first
+   * @param weight the call count or time to add
+   */
+  void add(std::string const &category, std::string const &function,
+           std::vector<std::string> const &frames, uint64_t weight) {
+    key_.clear();
+    append(category);
+    for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+      key_ += ';';
+      append(*it);
+    }
+    key_ += ';';
+    append(function);
+    stacks_[key_] += weight;
+  }
+
+  /** Write the folded stacks, one per line, in sorted order */
+  void write(std::ostream &os) const {
+    std::vector<std::pair<std::string const *, uint64_t>> sorted;
+    sorted.reserve(stacks_.size());
+    for (auto const &entry : stacks_) {
+      sorted.emplace_back(&entry.first, entry.second);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](auto const &lhs, auto const &rhs) {
+                return *lhs.first < *rhs.first;
+              });
+    for (auto const &entry : sorted) {
+      os << *entry.first << ' ' << entry.second << '\n';
+    }
+  }
+
+  /** Number of distinct stacks */
+  size_t size() const { return stacks_.size(); }
+
+  /** Returns true if no stacks have been added */
+  bool empty() const { return stacks_.empty(); }
+
+  /** Remove all stacks */
+  void clear() { stacks_.clear(); }
+
+private:
+  // Append a frame name, replacing characters with special meaning in the
+  // folded format
+  void append(std::string const &name) {
+    for (char ch : name) {
+      key_ += (ch == ';') ? ':' : (ch == '\n' || ch == '\r') ? ' ' : ch;
+    }
+  }
+
+  std::unordered_map<std::string, uint64_t> stacks_;
+  std::string key_; // reused buffer for building keys
+};
+
+} // namespace or2
+
+#endif // OR2_FOLDEDSTACKS_H
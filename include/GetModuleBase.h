@@ -46,6 +46,16 @@
  */
 DWORD64 CALLBACK GetModuleBase(HANDLE hProcess, DWORD64 dwAddress);
 
+/**
+ * Load symbols for a module whose location is already known.
+ * @param hProcess handle to the target process
+ * @param filename the full file name of the module
+ * @param baseAddress the base address of the module
+ * @param size the size of the module, or zero if not known
+ */
+void LoadModuleSymbols(HANDLE hProcess, std::string const &filename,
+                       DWORD64 baseAddress, DWORD size);
+
 /**
  * Get module file name, correcting for a couple of common issues.
  *
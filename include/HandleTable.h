@@ -0,0 +1,95 @@
+#ifndef OR2_HANDLETABLE_H
+#define OR2_HANDLETABLE_H
+
+/**@file
+
+  Shadow copy of the handles held by a traced process, filled in from the
+  calls that open, duplicate and close handles, so that later calls using a
+  handle can be annotated with the name of the object it refers to.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace or2 {
+
+/**
+ * Table of the names of the open handles in one process.
+ *
+ * The table is a flat hash map using open addressing with linear probing,
+ * keyed on the handle value; zero is never a valid handle so it marks an
+ * empty slot.
+ */
+class HandleTable {
+public:
+  /**
+   * A handle was opened.
+   * @param handle the new handle
+   * @param name the object name, empty if the object is unnamed
+   * @param root the directory handle the name is relative to, or zero
+   */
+  void opened(uint64_t handle, std::string const &name, uint64_t root = 0);
+
+  /** A handle was closed */
+  void closed(uint64_t handle);
+
+  /** A handle was duplicated within the process */
+  void duplicated(uint64_t source, uint64_t target);
+
+  /** Get the object name for a handle, or nullptr if unknown */
+  std::string const *find(uint64_t handle) const;
+
+  /** Number of named handles held */
+  size_t size() const { return size_; }
+
+  /** Discard all the handles */
+  void clear();
+
+private:
+  struct Slot {
+    uint64_t handle{};
+    std::string name;
+  };
+
+  size_t home(uint64_t handle) const;
+  size_t locate(uint64_t handle) const;
+  void insert(uint64_t handle, std::string name);
+  void grow();
+
+  std::vector<Slot> slots_; // size is zero or a power of two
+  unsigned int shift_{64};  // 64 - log2(slots_.size())
+  size_t size_{};
+};
+
+} // namespace or2
+
+#endif // OR2_HANDLETABLE_H
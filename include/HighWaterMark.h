@@ -0,0 +1,90 @@
+#ifndef OR2_HIGHWATERMARK_H
+#define OR2_HIGHWATERMARK_H
+
+/**@file
+
+  High-water mark of a value over time, for reports of the handles open or
+  the memory committed by a process.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace or2 {
+
+/**
+ * The largest value seen in each period of a fixed length, and overall.
+ *
+ * Periods start at the first sample and only those in which a sample was
+ * taken are kept. Times are in milliseconds from an arbitrary origin.
+ */
+class HighWaterMark {
+public:
+  /** The largest value in one period of time */
+  struct Mark {
+    uint64_t time;    ///< start of the period, relative to the first sample
+    uint64_t maximum; ///< high-water mark in the period
+  };
+
+  /** Construct a timeline with periods of 'interval' ms */
+  explicit HighWaterMark(uint64_t interval = 1000)
+      : interval_(interval ? interval : 1) {}
+
+  /** The value changed at the given time */
+  void sample(uint64_t value, uint64_t time);
+
+  /** Largest value at any one time */
+  uint64_t peak() const { return peak_; }
+
+  /** Time the peak was first reached, relative to the first sample */
+  uint64_t peakTime() const { return peakTime_ - start_; }
+
+  /** Get the high-water mark for each period in which a sample was taken */
+  std::vector<Mark> const &timeline() const { return timeline_; }
+
+  /**
+   * Get the timeline with adjacent periods merged so there are at most
+   * 'maxMarks' entries.
+   */
+  std::vector<Mark> marks(size_t maxMarks) const;
+
+private:
+  uint64_t interval_;
+  uint64_t peak_{};
+  uint64_t peakTime_{};
+  bool started_{};
+  uint64_t start_{};
+  std::vector<Mark> timeline_;
+};
+
+} // namespace or2
+
+#endif // OR2_HIGHWATERMARK_H
@@ -0,0 +1,176 @@
+#ifndef OR2_JSONWRITER_H
+#define OR2_JSONWRITER_H
+
+/**@file
+
+  Streaming writer for JSON text, used to write events one object per line
+  (JSON Lines), for example:
+
+    {"event":"call","pid":1234,"tid":5678,"function":"NtClose"}
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace or2 {
+
+/**
+ * Write JSON values directly to a stream.
+ *
+ * The writer keeps only a fixed amount of state, so writing a value never
+ * allocates memory. The output of each call is collected in a small buffer
+ * and written to the stream at once, except that a key is written with the
+ * following value. Commas are inserted automatically; the caller is
+ * responsible for balancing the begin and end calls and for supplying a key
+ * before each member of an object.
+ */
+class JsonWriter {
+public:
+  explicit JsonWriter(std::ostream &os) : os_(os) {}
+  JsonWriter(JsonWriter const &) = delete;
+  JsonWriter &operator=(JsonWriter const &) = delete;
+
+  /** Start an object */
+  JsonWriter &beginObject();
+
+  /** End the current object */
+  JsonWriter &endObject();
+
+  /** Start an array */
+  JsonWriter &beginArray();
+
+  /** End the current array */
+  JsonWriter &endArray();
+
+  /** Write the key of the next member of an object */
+  JsonWriter &key(std::string_view name);
+
+  /** Write a string value */
+  JsonWriter &value(std::string_view text);
+  JsonWriter &value(char const *text) { return value(std::string_view(text)); }
+
+  /** Write a numeric value */
+  JsonWriter &value(uint64_t number);
+  JsonWriter &value(int64_t number);
+  JsonWriter &value(uint32_t number) { return value(uint64_t{number}); }
+  JsonWriter &value(int32_t number) { return value(int64_t{number}); }
+
+  /** Write a boolean value */
+  JsonWriter &value(bool flag);
+
+  /** Write a null value */
+  JsonWriter &null();
+
+  /** Write a key and a value */
+  template <typename T> JsonWriter &member(std::string_view name, T &&data) {
+    key(name);
+    return value(data);
+  }
+
+  /** Start the next value in the current array or object on a new line */
+  JsonWriter &newLine();
+
+  /** End a top level value with a newline */
+  void endLine();
+
+  /** Flush the underlying stream */
+  void flush();
+
+  /** Current nesting depth */
+  size_t depth() const { return depth_; }
+
+  /**
+   * Write the contents of a JSON string, without the quotes, escaping any
+   * quotes, backslashes and control characters. Bytes which are not part of
+   * a valid UTF-8 sequence are taken as Latin-1 and written as \u escapes,
+   * so the output is always valid UTF-8.
+   */
+  static void escape(std::ostream &os, std::string_view text);
+
+private:
+  static constexpr size_t maxDepth = 32;
+
+  void separate();
+  void push(char open);
+  void pop(char close);
+  void put(char ch);
+  void write(char const *text, size_t size);
+  void writeString(std::string_view text);
+  void send();
+
+  std::ostream &os_;
+  char buffer_[256]; // output not yet written to the stream
+  size_t used_{};    // characters in use in the buffer
+  size_t depth_{};
+  bool first_[maxDepth + 1]{true}; // no member yet at each level
+  bool afterKey_{};                // the next value completes a member
+  bool newLine_{};                 // the next value starts a new line
+};
+
+/**
+ * Stream buffer writing each line of text as a JSON object, so free text
+ * can be mixed with other JSON Lines events:
+ *
+ *   {"event":"message","time":"12:34:56.789","pid":1234,"tid":5678,
+ *    "text":"Thread 5678 exit code: 0"}
+ *
+ * The time and IDs are omitted if not set. Any incomplete line is written
+ * when the buffer is destroyed.
+ */
+class JsonTextBuf : public std::streambuf {
+public:
+  explicit JsonTextBuf(JsonWriter &writer) : writer_(writer) {}
+  ~JsonTextBuf() override;
+
+  /** Set the source of the following lines of text */
+  void source(std::string_view time, uint32_t processId, uint32_t threadId);
+
+protected:
+  int_type overflow(int_type ch) override;
+  std::streamsize xsputn(char const *text, std::streamsize count) override;
+  int sync() override;
+
+private:
+  void writeLine();
+
+  JsonWriter &writer_;
+  std::string line_; // the incomplete line
+  std::string time_;
+  uint32_t processId_{};
+  uint32_t threadId_{};
+};
+
+} // namespace or2
+
+#endif // OR2_JSONWRITER_H
@@ -0,0 +1,122 @@
+#ifndef OR2_LEAKTRACKER_H
+#define OR2_LEAKTRACKER_H
+
+/**@file
+
+  Accounting of the handles opened and closed by a process, to report the
+  handles still open when tracing ends and the high-water mark over time.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include "HighWaterMark.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace or2 {
+
+class StackTable;
+
+/**
+ * Open handles of one process, by object type, category and creating stack.
+ *
+ * Handles already open when tracing begins are not known, so closing one of
+ * these is ignored. Times are in milliseconds from an arbitrary origin.
+ */
+class LeakTracker {
+public:
+  /** Open handles of one type, category and stack */
+  struct Group {
+    std::string type;     ///< object type, such as "Key" or "Event"
+    std::string category; ///< category of the creating entry point
+    size_t count{};       ///< number of open handles
+    /** creating stack ids with their counts, largest first */
+    std::vector<std::pair<uint32_t, size_t>> stacks;
+  };
+
+  /** The largest number of handles open in one period of time */
+  using Mark = HighWaterMark::Mark;
+
+  /** Construct a tracker sampling the high-water mark every 'interval' ms */
+  explicit LeakTracker(uint64_t interval = 1000);
+
+  /** A handle was opened */
+  void opened(uint64_t handle, std::string const &type,
+              std::string const &category, uint32_t stack, uint64_t time);
+
+  /** A handle was closed */
+  void closed(uint64_t handle, uint64_t time);
+
+  /** A handle was duplicated within the process */
+  void duplicated(uint64_t source, uint64_t target, uint32_t stack,
+                  uint64_t time);
+
+  /** Number of handles currently open */
+  size_t open() const { return handles_.size(); }
+
+  /** Largest number of handles open at any one time */
+  size_t peak() const { return static_cast<size_t>(marks_.peak()); }
+
+  /** Get the open handles grouped by type and category, largest first */
+  std::vector<Group> groups() const;
+
+  /** Get the high-water mark for each period in which handles changed */
+  std::vector<Mark> const &timeline() const { return marks_.timeline(); }
+
+  /**
+   * Print a report of the open handles.
+   * @param os the stream to write to
+   * @param stacks the table the stack ids refer to
+   * @param maxStacks the number of creating stacks to show for each group
+   * @param maxMarks the number of high-water marks to show
+   */
+  void report(std::ostream &os, StackTable const &stacks, size_t maxStacks = 3,
+              size_t maxMarks = 20) const;
+
+private:
+  struct Handle {
+    uint32_t kind;  // index into kinds_
+    uint32_t stack; // creating stack id
+  };
+
+  uint32_t kind(std::string const &type, std::string const &category);
+
+  std::unordered_map<uint64_t, Handle> handles_;
+  std::vector<std::pair<std::string, std::string>> kinds_; // type, category
+  HighWaterMark marks_;
+};
+
+} // namespace or2
+
+#endif // OR2_LEAKTRACKER_H
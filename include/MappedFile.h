@@ -0,0 +1,76 @@
+#ifndef OR2_MAPPEDFILE_H
+#define OR2_MAPPEDFILE_H
+
+/**@file
+
+  Read only memory mapping of a whole file, so that large traces can be
+  parsed in place.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace or2 {
+
+/** A file mapped read only into memory */
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile() { close(); }
+  MappedFile(MappedFile const &) = delete;
+  MappedFile &operator=(MappedFile const &) = delete;
+
+  /**
+   * Map a file, replacing any file already mapped.
+   * @return false on failure, with the reason in 'error'
+   */
+  bool open(std::string const &fileName, std::string &error);
+
+  /** Unmap the file */
+  void close();
+
+  /** Get the contents of the file */
+  std::string_view text() const { return {data_, size_}; }
+
+  /** Size of the file in bytes */
+  size_t size() const { return size_; }
+
+private:
+  char const *data_{};
+  size_t size_{};
+#ifdef _WIN32
+  void *mapping_{}; // handle of the file mapping object
+#endif
+};
+
+} // namespace or2
+
+#endif // OR2_MAPPEDFILE_H
@@ -0,0 +1,143 @@
+#ifndef OR2_MODULEMAP_H
+#define OR2_MODULEMAP_H
+
+/**@file
+
+  Map of the modules loaded in a process, allowing addresses to be
+  resolved to modules without querying the target process.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace or2 {
+
+/**
+ * Interval map of loaded modules, kept up to date from the DLL load and
+ * unload events.
+ *
+ * The modules are held in a vector sorted by base address, so lookups are a
+ * binary search; loads and unloads are rare by comparison.
+ */
+class ModuleMap {
+public:
+  /** A single loaded module */
+  struct Module {
+    uint64_t base;    ///< Base address of the image
+    uint64_t size;    ///< Size of the image
+    std::string name;   ///< Full file name, if known
+    uint64_t serial;    ///< Unique number for this load of the module
+    uint32_t timeStamp; ///< Time stamp from the image header, if known
+    uint32_t checkSum;  ///< Checksum from the image header, if known
+
+    /** Returns true if the address lies in this module */
+    bool contains(uint64_t address) const { return address - base < size; }
+  };
+
+  using const_iterator = std::vector<Module>::const_iterator;
+
+  /**
+   * Add a newly loaded module, replacing any that overlap it.
+   * @return the added module
+   */
+  Module const &add(uint64_t base, uint64_t size, std::string name,
+                    uint32_t timeStamp = 0, uint32_t checkSum = 0) {
+    auto first = std::lower_bound(
+        modules_.begin(), modules_.end(), base,
+        [](Module const &lhs, uint64_t rhs) { return lhs.base < rhs; });
+    if (first != modules_.begin() && std::prev(first)->contains(base)) {
+      --first;
+    }
+    auto last = first;
+    while (last != modules_.end() && last->base < base + size) {
+      ++last;
+    }
+    first = modules_.erase(first, last);
+    return *modules_.insert(first, Module{base, size, std::move(name),
+                                          ++serial_, timeStamp, checkSum});
+  }
+
+  /**
+   * Remove an unloaded module.
+   * @return true if a module was loaded at the specified base address
+   */
+  bool remove(uint64_t base) {
+    const auto it = std::lower_bound(
+        modules_.begin(), modules_.end(), base,
+        [](Module const &lhs, uint64_t rhs) { return lhs.base < rhs; });
+    if (it == modules_.end() || it->base != base) {
+      return false;
+    }
+    modules_.erase(it);
+    return true;
+  }
+
+  /**
+   * Find the module containing an address.
+   * @return the module, or nullptr if the address is not in a known module
+   */
+  Module const *find(uint64_t address) const {
+    auto it = std::upper_bound(
+        modules_.begin(), modules_.end(), address,
+        [](uint64_t lhs, Module const &rhs) { return lhs < rhs.base; });
+    if (it == modules_.begin()) {
+      return nullptr;
+    }
+    --it;
+    return it->contains(address) ? &*it : nullptr;
+  }
+
+  /** Number of loaded modules */
+  size_t size() const { return modules_.size(); }
+
+  /** Returns true if no modules are loaded */
+  bool empty() const { return modules_.empty(); }
+
+  /** Remove all modules */
+  void clear() { modules_.clear(); }
+
+  /** Start of modules, in address order */
+  const_iterator begin() const { return modules_.begin(); }
+
+  /** End of modules */
+  const_iterator end() const { return modules_.end(); }
+
+private:
+  std::vector<Module> modules_; // sorted by base address, non-overlapping
+  uint64_t serial_{};
+};
+
+} // namespace or2
+
+#endif // OR2_MODULEMAP_H
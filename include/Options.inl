@@ -33,6 +33,7 @@
 
 // $Id: Options.inl 3148 2026-04-10 20:41:33Z roger $
 
+#include <cstdio>
 #include <iomanip>
 #include <iostream>
 #include <vector>
@@ -59,6 +60,16 @@ struct Options::Data {
 
   Data() {}
 
+  /** Read a numeric value using a scanf format */
+  template <typename T>
+  static bool scan(char const *pArg, char const *format, T *pValue) {
+#ifdef _MSC_VER
+    return sscanf_s(pArg, format, pValue) == 1;
+#else
+    return std::sscanf(pArg, format, pValue) == 1;
+#endif
+  }
+
   void set(std::string const &option, void *pValue, OptionType eType,
            std::string const &helpString) {
     options.push_back(OptionInfo(option, pValue, eType, helpString));
@@ -176,35 +187,36 @@ inline bool Options::process(
           *((bool *)(option.pValue)) = true;
           break;
         case Data::eInt: {
-          if (sscanf_s(pArg, "%i", ((int *)(option.pValue))) != 1) {
+          if (!Data::scan(pArg, "%i", ((int *)(option.pValue)))) {
             std::cerr << "Invalid numeric value '" << pArg << "' found for "
                       << option.option << std::endl;
             bRet = false;
           }
         } break;
         case Data::eUInt: {
-          if (sscanf_s(pArg, "%u", ((unsigned int *)(option.pValue))) != 1) {
+          if (!Data::scan(pArg, "%u", ((unsigned int *)(option.pValue)))) {
             std::cerr << "Invalid numeric value '" << pArg << "' found for "
                       << option.option << std::endl;
             bRet = false;
           }
         } break;
         case Data::eLong: {
-          if (sscanf_s(pArg, "%li", ((long *)(option.pValue))) != 1) {
+          if (!Data::scan(pArg, "%li", ((long *)(option.pValue)))) {
             std::cerr << "Invalid numeric value '" << pArg << "' found for "
                       << option.option << std::endl;
             bRet = false;
           }
         } break;
         case Data::eULong: {
-          if (sscanf_s(pArg, "%lu", ((unsigned long *)(option.pValue))) != 1) {
+          if (!Data::scan(pArg, "%lu",
+                          ((unsigned long *)(option.pValue)))) {
             std::cerr << "Invalid numeric value '" << pArg << "' found for "
                       << option.option << std::endl;
             bRet = false;
           }
         } break;
         case Data::eDouble: {
-          if (sscanf_s(pArg, "%lf", ((double *)(option.pValue))) != 1) {
+          if (!Data::scan(pArg, "%lf", ((double *)(option.pValue)))) {
             std::cerr << "Invalid numeric value '" << pArg << "' found for "
                       << option.option << std::endl;
             bRet = false;
@@ -0,0 +1,137 @@
+#ifndef OR2_PATTERNMINER_H
+#define OR2_PATTERNMINER_H
+
+/**@file
+
+  Mining of the sequences of calls repeated on each thread, to find the
+  chatty code paths.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace or2 {
+
+class StackTable;
+
+/**
+ * Finds the sequences of calls repeated most often on each thread.
+ *
+ * The calls of all the threads are joined into one sequence, with a
+ * separator between threads, and a suffix array of the sequence is sorted
+ * by the first 'longest' calls. Each group of adjacent suffixes sharing a
+ * prefix is a pattern occurring once per suffix, so all the repeated
+ * sequences (from n-grams upwards) are found in one pass over the array.
+ *
+ * A pattern always followed by the same call is reported as part of the
+ * longer pattern. Patterns that can overlap themselves, such as A B A or
+ * A B A B, are not reported, except for the shortest repetition of a call
+ * or other pattern too short to report, such as A A; the occurrences of
+ * these are counted without overlaps. Of the rotations of a pattern in a
+ * loop, such as A B C and B C A, only the highest ranked is reported; and
+ * a pattern is not reported if nearly all of its occurrences could be
+ * within a higher ranked pattern, or within a loop of one.
+ */
+class PatternMiner {
+public:
+  /** Limits on the patterns found */
+  struct Settings {
+    size_t shortest{2};  ///< fewest calls in a pattern
+    size_t longest{32};  ///< most calls in a pattern
+    uint64_t minimum{2}; ///< fewest occurrences of a pattern
+  };
+
+  /** Order of the patterns */
+  enum Order {
+    Calls, ///< by calls in all the occurrences
+    Time,  ///< by time in all the occurrences
+    Count, ///< by number of occurrences
+  };
+
+  /** A repeated sequence of calls */
+  struct Pattern {
+    std::vector<std::string> functions; ///< entry point names, in order
+    uint64_t count{};        ///< number of occurrences
+    uint64_t calls{};        ///< calls in all the occurrences
+    bool timed{};            ///< true if the durations of calls are known
+    uint64_t microseconds{}; ///< time in the calls with known durations
+    uint32_t processId{};    ///< process of a sample occurrence
+    uint32_t threadId{};     ///< thread of a sample occurrence
+    uint32_t stack{};        ///< stack of the first call of the sample
+  };
+
+  explicit PatternMiner(Settings const &settings) : settings_(settings) {}
+
+  /**
+   * Add a call; calls after the first 4000 million are ignored.
+   * @param microseconds the duration of the call, or negative if unknown
+   * @param stack the id of the stack of the call in a StackTable, or zero
+   */
+  void add(uint32_t processId, uint32_t threadId, std::string_view function,
+           int64_t microseconds = -1, uint32_t stack = 0);
+
+  /** Number of calls added */
+  uint64_t calls() const { return calls_; }
+
+  /** Find the 'count' patterns ranked highest in the given order */
+  std::vector<Pattern> mine(Order order, size_t count) const;
+
+  /** Print the patterns */
+  static void report(std::ostream &os, StackTable const &stacks,
+                     std::vector<Pattern> const &patterns);
+
+private:
+  /** The calls on one thread */
+  struct Thread {
+    uint32_t processId{};
+    uint32_t threadId{};
+    std::vector<uint32_t> functions; // index into names_ plus one
+    std::vector<uint32_t> durations; // microseconds plus one, zero if unknown
+    std::vector<uint32_t> stacks;    // empty if no call has a stack
+  };
+
+  Settings const settings_;
+  uint64_t calls_{};
+  std::deque<std::string> names_;
+  std::unordered_map<std::string_view, uint32_t> ids_; // index into names_
+  std::vector<Thread> threads_;
+  std::unordered_map<uint64_t, size_t> threadIndex_; // by process and thread
+  size_t last_{SIZE_MAX};                            // thread of the last call
+};
+
+} // namespace or2
+
+#endif // OR2_PATTERNMINER_H
@@ -0,0 +1,124 @@
+#ifndef OR2_REDUNDANTCALLS_H
+#define OR2_REDUNDANTCALLS_H
+
+/**@file
+
+  Detection of redundant calls: the same entry point called with the same
+  arguments again within a short window of calls on the same thread.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace or2 {
+
+class StackTable;
+
+/**
+ * Finds calls repeated within a sliding window on each thread.
+ *
+ * Each call is fingerprinted from the entry point name and the normalized
+ * text of its input arguments, with handles replaced by the object name; a
+ * call is redundant if a call with the same fingerprint is among the
+ * previous 'window' calls on the thread.
+ */
+class RedundantCalls {
+public:
+  /** A call that has been repeated */
+  struct Offender {
+    std::string function;          ///< entry point name
+    std::vector<std::string> keys; ///< normalized arguments
+    uint64_t calls{};              ///< number of calls
+    uint64_t repeats{};            ///< calls repeating one in the window
+    uint32_t stack{};              ///< sample stack of a repeat, or zero
+  };
+
+  /** Construct a detector with a window of 'window' calls per thread */
+  explicit RedundantCalls(size_t window = 64);
+
+  /**
+   * Add a call.
+   * @return the offender if this call is a repeat, otherwise nullptr; the
+   * caller can then supply a sample stack if the offender has none
+   */
+  Offender *add(uint32_t threadId, std::string const &function,
+                std::vector<std::string> const &keys);
+
+  /** A thread has exited */
+  void threadExit(uint32_t threadId) { threads_.erase(threadId); }
+
+  /** Returns true if no call has been repeated */
+  bool empty() const { return offenders_.empty(); }
+
+  /** Get the 'count' calls with the most repeats, worst first */
+  std::vector<Offender const *> worst(size_t count) const;
+
+  /** Print the 'count' worst offenders */
+  void report(std::ostream &os, StackTable const &stacks, size_t count) const;
+
+  /** Fingerprint a call */
+  static uint64_t fingerprint(std::string const &function,
+                              std::vector<std::string> const &keys);
+
+  /**
+   * Normalize the text of an argument value, as written by NtTrace, so that
+   * values differing only in volatile detail compare equal: bracketed output
+   * values and pointer values are removed, quoted strings are kept.
+   */
+  static std::string normalize(std::string const &value);
+
+  /**
+   * Get the key for a handle argument: the quoted object name, or the handle
+   * value if the name is not known. Handles with a name are compared by name,
+   * as a value may be reused for another object, and an object closed and
+   * opened again gets a new value; unnamed handles can only be told apart by
+   * their values.
+   */
+  static std::string handleKey(std::string const *name, uint64_t handle);
+
+private:
+  struct Window {
+    std::deque<uint64_t> order;                   // oldest first
+    std::unordered_map<uint64_t, uint32_t> count; // fingerprints in window
+  };
+
+  size_t window_;
+  std::unordered_map<uint32_t, Window> threads_;
+  std::unordered_map<uint64_t, Offender> offenders_;
+};
+
+} // namespace or2
+
+#endif // OR2_REDUNDANTCALLS_H
@@ -0,0 +1,112 @@
+#ifndef OR2_REGISTRYPROFILE_H
+#define OR2_REGISTRYPROFILE_H
+
+/**@file
+
+  Registry access statistics for each key, to show which keys are worth
+  caching.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace or2 {
+
+/** Registry access statistics for each key path */
+class RegistryProfile {
+public:
+  /** Kinds of registry operation */
+  enum Op { Open, Query, Enumerate, ReadValue, Write, OpCount };
+
+  /** Statistics for one key */
+  struct Key {
+    std::string path;          ///< full path of the key
+    uint64_t calls[OpCount]{}; ///< number of calls by operation
+    uint64_t failures{};       ///< calls failing with an error status
+    uint64_t notFound{};       ///< calls failing as the name was not found
+    /** successful queries and reads repeating an earlier successful one */
+    uint64_t repeats{};
+    std::map<std::string, uint64_t> values; ///< reads by value name
+
+    /** Total number of calls */
+    uint64_t total() const;
+  };
+
+  /**
+   * Add a call.
+   * @param path the key path
+   * @param op the operation
+   * @param valueName the value name, for reads and writes of a value
+   * @param status the NTSTATUS returned
+   * @param infoClass the information class requested, for queries and
+   * reads, as any text identifying it
+   */
+  void add(std::string const &path, Op op, std::string const &valueName,
+           uint32_t status, std::string const &infoClass = std::string());
+
+  /** Get the 'count' keys with the most calls, busiest first */
+  std::vector<Key const *> top(size_t count) const;
+
+  /** Number of distinct keys */
+  size_t size() const { return keys_.size(); }
+
+  /** Returns true if no calls have been added */
+  bool empty() const { return keys_.empty(); }
+
+  /** Print a table of the 'count' busiest keys */
+  void report(std::ostream &os, size_t count) const;
+
+  /**
+   * Get the operation performed by a registry entry point.
+   * @return OpCount if the entry point is not profiled
+   */
+  static Op operation(std::string const &function);
+
+private:
+  struct Entry {
+    Key key;
+    // successful queries and reads made: operation, value name and
+    // information class
+    std::set<std::tuple<Op, std::string, std::string>> seen;
+  };
+
+  std::unordered_map<std::string, Entry> keys_;
+};
+
+} // namespace or2
+
+#endif // OR2_REGISTRYPROFILE_H
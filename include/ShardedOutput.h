@@ -0,0 +1,204 @@
+#ifndef OR2_SHARDEDOUTPUT_H
+#define OR2_SHARDEDOUTPUT_H
+
+/**@file
+
+  Output split into a file for each process, or for each thread, with an
+  index of the files and of the processes, and the merge of the files back
+  into a single trace.
+
+  Each file starts a block of lines with a marker line holding a sequence
+  number, "#123", whenever output moves to it from another file, so the
+  files can be merged back in the order the lines were written. A line of
+  the trace itself starting with '#' is written with an extra '#'.
+
+  The index is a text file with a header line, then one line for each file
+  and for each process start and exit:
+
+    # NtTrace shard index
+    shard 1234 5678 trace-1234-5678.txt
+    start 1234 1000 12:34:56.789 MyApp.exe
+    exit 1234 12:34:57.123 0
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iosfwd>
+#include <map>
+#include <set>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace or2 {
+
+/**
+ * Stream buffer writing each line of text to the file for the process, or
+ * the thread, that is its source. Each file has its own buffer, written when
+ * it is full and when the thread or process exits, but not when the stream
+ * is flushed; lines with no source go to the main file.
+ */
+class ShardBuf : public std::streambuf {
+public:
+  /** How the output is split */
+  enum Mode { Process, Thread };
+
+  /**
+   * Construct a buffer writing to files named from 'fileName': for example
+   * trace.txt is the main file, trace-1234.txt the file for process 1234,
+   * or trace-1234-5678.txt for thread 5678, and trace.index the index.
+   */
+  ShardBuf(std::string const &fileName, Mode mode, size_t bufferSize = 65536);
+  ~ShardBuf() override;
+
+  /**
+   * Write the text buffered for all the files.
+   * @return false if the index, or any file, could not be written
+   */
+  bool flush();
+
+  /** Returns false if the index, or any file, could not be written */
+  bool good() const { return error_.empty(); }
+
+  /** Get the name of the first file that could not be written */
+  std::string const &error() const { return error_; }
+
+  /** Set the source of the following lines, or zero for the main file */
+  void source(uint32_t processId, uint32_t threadId);
+
+  /** Record the start of a process in the index */
+  void processStarted(uint32_t processId, uint32_t parentId,
+                      std::string_view time, std::string_view image);
+
+  /** Record the exit of a process in the index, and write its files */
+  void processExited(uint32_t processId, std::string_view time,
+                     uint32_t exitCode);
+
+  /** A thread has exited: write its file, if it has one */
+  void threadExited(uint32_t processId, uint32_t threadId);
+
+  /** Get the name of the file for a process and thread */
+  static std::string shardName(std::string const &fileName,
+                               uint32_t processId, uint32_t threadId);
+
+  /** Get the name of the index for the files */
+  static std::string indexName(std::string const &fileName);
+
+protected:
+  int_type overflow(int_type ch) override;
+  std::streamsize xsputn(char const *text, std::streamsize count) override;
+  int sync() override;
+
+private:
+  struct Shard {
+    std::string fileName;
+    std::string buffer;   // text not yet written
+    bool lineStart{true}; // the next character starts a line
+    bool truncate{};      // the file is created by the next write
+  };
+
+  using Key = std::pair<uint32_t, uint32_t>; // process and thread
+
+  Shard &shard(Key const &key);
+  void write(Shard &shard);
+  void erase(std::map<Key, Shard>::iterator first,
+             std::map<Key, Shard>::iterator last);
+
+  std::string fileName_;
+  Mode mode_;
+  size_t bufferSize_;
+  std::ofstream index_;
+  std::map<Key, Shard> shards_;  // files with a buffer
+  std::set<std::string> created_; // files already created
+  Key source_{};
+  Shard *last_{};      // the file the last text was written to
+  uint64_t sequence_{}; // sequence number of the last block
+  std::string error_;
+};
+
+/** The index of a set of files written by ShardBuf */
+class ShardIndex {
+public:
+  /** A process traced */
+  struct Process {
+    uint32_t processId{}; ///< process ID
+    uint32_t parentId{};  ///< ID of the parent process
+    std::string image;    ///< image file name
+    std::string start;    ///< time the process started
+    std::string exit;     ///< time the process exited, if it has
+    uint32_t exitCode{};  ///< exit code, if the process has exited
+  };
+
+  /** A file of output */
+  struct Shard {
+    uint32_t processId{}; ///< process, or zero for the main file
+    uint32_t threadId{};  ///< thread, or zero for a whole process
+    std::string fileName; ///< name of the file, without a directory
+  };
+
+  /**
+   * Read an index.
+   * @return false if the stream does not hold an index
+   */
+  bool read(std::istream &is);
+
+  /** Get the processes, in the order they started */
+  std::vector<Process> const &processes() const { return processes_; }
+
+  /** Get the files, in the order they were created */
+  std::vector<Shard> const &shards() const { return shards_; }
+
+  /** Get a process and all its descendants */
+  std::set<uint32_t> tree(uint32_t processId) const;
+
+  /** Print the processes as a tree, children below their parent */
+  void print(std::ostream &os) const;
+
+  /**
+   * Merge the text of files written by ShardBuf back into one stream, in
+   * the order the lines were written, removing the markers.
+   */
+  static void merge(std::vector<std::string_view> const &texts,
+                    std::ostream &os);
+
+private:
+  void print(std::ostream &os, Process const &process, size_t depth,
+             std::set<uint32_t> &shown) const;
+
+  std::vector<Process> processes_;
+  std::vector<Shard> shards_;
+};
+
+} // namespace or2
+
+#endif // OR2_SHARDEDOUTPUT_H
@@ -34,6 +34,7 @@
 // $Id: ShowData.h 3048 2026-01-10 22:25:52Z roger $
 
 #include <ostream>
+#include <string>
 #include <windows.h>
 
 // or2 includes
@@ -66,6 +67,9 @@ void showMask(std::ostream &os, ULONG_PTR value,
 /** show an HRESULT from the debuggee */
 void showWinError(std::ostream &os, HRESULT hResult);
 
+/** get the message text for an HRESULT, or an empty string if unknown */
+std::string winErrorMessage(HRESULT hResult);
+
 /** show an image name from the debuggee (in ANSI or Unicode) */
 bool showName(std::ostream &os, HANDLE hProcess, LPCVOID lpImageName,
               bool bUnicode);
@@ -88,6 +92,21 @@ void showObjectAttributes(std::ostream &os, HANDLE hProcess,
 void showUnicodeString(std::ostream &os, HANDLE hProcess,
                        PUNICODE_STRING pTargetUnicodeString);
 
+/**
+ * Read an Unicode string from the debuggee, converted to UTF-8
+ * @return false if the string could not be read
+ */
+bool readUnicodeString(HANDLE hProcess, PUNICODE_STRING pTargetUnicodeString,
+                       std::string &result);
+
+/**
+ * Read the object name from object attributes in the debuggee, and optionally
+ * the root directory handle the name is relative to
+ * @return false if the name could not be read
+ */
+bool readObjectName(HANDLE hProcess, POBJECT_ATTRIBUTES pObjectAttributes,
+                    std::string &result, HANDLE *pRoot = nullptr);
+
 /** show a generic pointer from the debuggee, encoded as ULONG_PTR */
 void showPointer(std::ostream &os, HANDLE hProcess, ULONG_PTR argVal);
 
@@ -0,0 +1,150 @@
+#ifndef OR2_SMALLIODETECTOR_H
+#define OR2_SMALLIODETECTOR_H
+
+/**@file
+
+  Detection of inefficient I/O on each handle: streams of small sequential
+  reads, writes or device I/O controls that a buffer would combine, poorly
+  aligned offsets and reads following writes on the same handle.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace or2 {
+
+/**
+ * Finds inefficient I/O on each handle.
+ *
+ * The calls on a handle are split into runs of the same operation, each
+ * call starting where the previous one ended; device I/O controls are in
+ * the same run while the control code is unchanged. A run of small calls
+ * is estimated to need one call for each buffer full of data, any other
+ * run one call for each call made.
+ */
+class SmallIoDetector {
+public:
+  /** Kinds of I/O */
+  enum Op { Read, Write, Control, OpCount };
+
+  /** The offset of a call using the current file position */
+  static constexpr uint64_t current = UINT64_MAX;
+
+  /** Thresholds for the detector */
+  struct Settings {
+    uint64_t small{4096};     ///< calls below this size are small
+    uint64_t buffer{65536};   ///< size of the buffer assumed for estimates
+    uint64_t alignment{4096}; ///< offsets should be a multiple of this
+    uint64_t minimum{16};     ///< calls saved, misaligned or turns to report
+  };
+
+  /** The I/O on one handle, from its first use until it is closed */
+  struct Stream {
+    uint32_t processId{};      ///< process using the handle
+    uint64_t handle{};         ///< handle value
+    std::string name;          ///< object name, if known
+    uint64_t calls[OpCount]{}; ///< number of calls by operation
+    uint64_t bytes{};          ///< bytes requested or transferred
+    uint64_t small{};          ///< calls in runs of small calls
+    uint64_t buffered{};       ///< estimated calls needed with a buffer
+    uint64_t misaligned{};     ///< large calls at an offset not aligned
+    uint64_t turns{};          ///< reads immediately following a write
+    uint64_t timed{};          ///< number of calls with a time
+    uint64_t microseconds{};   ///< total time of the timed calls
+
+    /** Total number of calls */
+    uint64_t total() const {
+      return calls[Read] + calls[Write] + calls[Control];
+    }
+
+    /** Estimated number of calls a buffer would save */
+    uint64_t saved() const { return total() - buffered; }
+
+  private:
+    friend class SmallIoDetector;
+    Op op{OpCount};       // operation of the current run
+    uint32_t code{};      // control code of the current run
+    bool positioned{};    // true if the file position is known
+    uint64_t position{};  // file position after the previous call
+    uint64_t runCalls{};  // calls in the current run
+    uint64_t runBytes{};  // bytes in the current run
+  };
+
+  /** Construct a detector with the given thresholds */
+  explicit SmallIoDetector(Settings const &settings);
+
+  /**
+   * Add a call.
+   * @param processId the process making the call
+   * @param handle the handle used
+   * @param name the object name of the handle, or empty if not known
+   * @param op the operation
+   * @param offset the byte offset, or 'current' for the file position
+   * @param requested the number of bytes requested
+   * @param transferred the number of bytes actually transferred
+   * @param microseconds the time in the call, or -1 if not measured
+   * @param code the control code, for device I/O controls
+   */
+  void add(uint32_t processId, uint64_t handle, std::string const &name,
+           Op op, uint64_t offset, uint64_t requested, uint64_t transferred,
+           int64_t microseconds, uint32_t code = 0);
+
+  /** A handle has been closed: its stream is complete */
+  void close(uint32_t processId, uint64_t handle);
+
+  /**
+   * Get the 'count' streams reaching the minimum for any problem, those
+   * with the most calls saved first. The runs still in progress are
+   * counted as if they ended now.
+   */
+  std::vector<Stream> worst(size_t count) const;
+
+  /** Returns true if no calls have been added */
+  bool empty() const { return open_.empty() && closed_.empty(); }
+
+  /** Print the 'count' worst streams */
+  void report(std::ostream &os, size_t count) const;
+
+private:
+  void endRun(Stream &stream) const;
+
+  Settings settings_;
+  std::map<std::pair<uint32_t, uint64_t>, Stream> open_; // by process/handle
+  std::vector<Stream> closed_; // streams whose handle has been closed
+};
+
+} // namespace or2
+
+#endif // OR2_SMALLIODETECTOR_H
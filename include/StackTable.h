@@ -0,0 +1,85 @@
+#ifndef OR2_STACKTABLE_H
+#define OR2_STACKTABLE_H
+
+/**@file
+
+  Table of distinct call stacks, so that a stack can be recorded against
+  each event as a small integer id.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace or2 {
+
+/**
+ * Interned call stacks.
+ *
+ * Id zero is the empty stack; other ids are allocated in order of first use.
+ */
+class StackTable {
+public:
+  StackTable() : stacks_(1, &empty_) {}
+  StackTable(StackTable const &) = delete;
+  StackTable &operator=(StackTable const &) = delete;
+
+  /** Get the id for a stack of function names, innermost first */
+  uint32_t intern(std::vector<std::string> const &frames) {
+    if (frames.empty()) {
+      return 0;
+    }
+    auto const result =
+        ids_.emplace(frames, static_cast<uint32_t>(stacks_.size()));
+    if (result.second) {
+      stacks_.push_back(&result.first->first);
+    }
+    return result.first->second;
+  }
+
+  /** Get the frames of a stack; unknown ids give the empty stack */
+  std::vector<std::string> const &frames(uint32_t id) const {
+    return id < stacks_.size() ? *stacks_[id] : empty_;
+  }
+
+  /** Number of distinct stacks, including the empty stack */
+  size_t size() const { return stacks_.size(); }
+
+private:
+  std::vector<std::string> const empty_;
+  std::map<std::vector<std::string>, uint32_t> ids_;
+  std::vector<std::vector<std::string> const *> stacks_; // indexed by id
+};
+
+} // namespace or2
+
+#endif // OR2_STACKTABLE_H
@@ -0,0 +1,204 @@
+#ifndef OR2_SYMBOLCACHE_H
+#define OR2_SYMBOLCACHE_H
+
+/**@file
+
+  Least recently used cache of symbol names keyed by module and relative
+  address, allowing the symbol engines for several processes to share the
+  results of resolving addresses in the same module.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace or2 {
+
+/**
+ * Cache of symbol names keyed by (module, relative address).
+ *
+ * Modules are identified by a string (see identity) which is mapped to a
+ * small integer so the same module loaded in several processes, or at
+ * different addresses, shares the cached entries.
+ *
+ * The cache holds entries up to an approximate memory limit; the least
+ * recently used entries are discarded first.
+ */
+class SymbolCache {
+public:
+  /** Default memory limit, in bytes */
+  static constexpr size_t defaultLimit = 16 * 1024 * 1024;
+
+  /** Construct a cache with the given memory limit */
+  explicit SymbolCache(size_t maxBytes = defaultLimit) : maxBytes_(maxBytes) {}
+
+  /** Do not copy */
+  SymbolCache(SymbolCache const &) = delete;
+
+  /** Do not assign */
+  SymbolCache &operator=(SymbolCache const &) = delete;
+
+  /**
+   * Get the string identifying a module image: the file name, ignoring case,
+   * with the size, time stamp and checksum from the image header, so that a
+   * rebuilt module does not share the names cached for the old one.
+   */
+  static std::string identity(std::string fileName, uint64_t size,
+                              uint32_t timeStamp, uint32_t checkSum) {
+    std::transform(
+        fileName.begin(), fileName.end(), fileName.begin(),
+        [](unsigned char ch) { return static_cast<char>(tolower(ch)); });
+    return fileName + ':' + std::to_string(size) + ':' +
+           std::to_string(timeStamp) + ':' + std::to_string(checkSum);
+  }
+
+  /**
+   * Get the identifier for a module.
+   * @param identity string uniquely identifying the module image
+   * @return the identifier to use in calls to lookup
+   */
+  uint32_t moduleId(std::string const &identity) {
+    return modules_
+        .try_emplace(identity, static_cast<uint32_t>(modules_.size()))
+        .first->second;
+  }
+
+  /**
+   * Get the name for an address, resolving it on a cache miss.
+   * @param module the module identifier, from moduleId
+   * @param rva the address relative to the base of the module
+   * @param resolve callable as 'bool resolve(std::string &name)' which sets
+   * the name and returns true if the name can be cached
+   * @return the name for the address
+   */
+  template <typename Resolver>
+  std::string lookup(uint32_t module, uint64_t rva, Resolver resolve) {
+    Key const key{module, rva};
+    const auto it = index_.find(key);
+    if (it != index_.end()) {
+      ++hits_;
+      // Move to the front of the LRU list
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->second;
+    }
+
+    ++misses_;
+    std::string name;
+    if (resolve(name)) {
+      entries_.emplace_front(key, name);
+      index_.emplace(key, entries_.begin());
+      usedBytes_ += cost(entries_.front());
+      trim();
+    }
+    return name;
+  }
+
+  /** Set the memory limit (in bytes), discarding entries if necessary */
+  void setLimit(size_t maxBytes) {
+    maxBytes_ = maxBytes;
+    trim();
+  }
+
+  /** Get the memory limit (in bytes) */
+  size_t getLimit() const { return maxBytes_; }
+
+  /** Get the number of cached names */
+  size_t size() const { return entries_.size(); }
+
+  /** Get the (approximate) memory used by the cached names */
+  size_t memoryUsed() const { return usedBytes_; }
+
+  /** Get the number of lookups satisfied from the cache */
+  size_t hits() const { return hits_; }
+
+  /** Get the number of lookups that needed resolving */
+  size_t misses() const { return misses_; }
+
+  /** Discard all cached names (module identifiers are retained) */
+  void clear() {
+    index_.clear();
+    entries_.clear();
+    usedBytes_ = 0;
+  }
+
+private:
+  struct Key {
+    uint32_t module;
+    uint64_t rva;
+
+    bool operator==(Key const &rhs) const {
+      return module == rhs.module && rva == rhs.rva;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(Key const &key) const {
+      return std::hash<uint64_t>()(key.rva ^
+                                   (static_cast<uint64_t>(key.module) << 48));
+    }
+  };
+
+  using Entry = std::pair<Key, std::string>;
+  using Entries = std::list<Entry>; // most recently used first
+
+  // Approximate per-entry overhead of the list and hash nodes
+  static constexpr size_t nodeOverhead = 8 * sizeof(void *);
+
+  static size_t cost(Entry const &entry) {
+    return sizeof(Entry) + entry.second.capacity() + nodeOverhead;
+  }
+
+  void trim() {
+    while (usedBytes_ > maxBytes_ && !entries_.empty()) {
+      Entry const &oldest = entries_.back();
+      usedBytes_ -= cost(oldest);
+      index_.erase(oldest.first);
+      entries_.pop_back();
+    }
+  }
+
+  Entries entries_;
+  std::unordered_map<Key, Entries::iterator, KeyHash> index_;
+  std::map<std::string, uint32_t> modules_;
+  size_t maxBytes_;
+  size_t usedBytes_{};
+  size_t hits_{};
+  size_t misses_{};
+};
+
+} // namespace or2
+
+#endif // OR2_SYMBOLCACHE_H
@@ -34,13 +34,18 @@
 
 // $Id: SymbolEngine.h 3010 2025-12-21 18:00:47Z roger $
 
+#include <functional>
 #include <iosfwd>
 #include <string>
+#include <vector>
 
 #include "../include/DbgHelper.h"
 
 namespace or2 {
 
+class ModuleMap;
+class SymbolCache;
+
 /** Symbol Engine wrapper to assist with processing PDB information */
 class SymbolEngine : public DbgHelper {
 public:
@@ -60,6 +65,12 @@ public:
   /** Print address to a stream, return true if information cacheable */
   bool printAddress(DWORD64 address, std::ostream &os) const;
 
+  /**
+   * Print the function containing an address to a stream, as
+   * module!function, return true if information cacheable
+   */
+  bool printFunction(DWORD64 address, std::ostream &os) const;
+
   /** Print inline address to a stream */
   void printInlineAddress(DWORD64 address, DWORD inline_context,
                           std::ostream &os) const;
@@ -70,14 +81,40 @@ public:
   /** Convert pointer to a string */
   std::string addressToName(PVOID pointer) const;
 
+  /**
+   * Share address to name conversions through a module-relative cache,
+   * which may be used by the engines for several processes.
+   * @param cache the cache to use, or nullptr for a private cache
+   */
+  void setSymbolCache(SymbolCache *cache);
+
+  /**
+   * Resolve addresses to modules using the supplied map, rather than by
+   * querying the target process each time.
+   * @param modules the map of loaded modules, or nullptr to query the process
+   */
+  void setModuleMap(ModuleMap const *modules);
+
+  /** Forget the module unloaded from the specified base address */
+  void moduleUnloaded(DWORD64 base);
+
   /** Convert inline address to a string */
   std::string inlineToName(DWORD64 address, DWORD inline_context) const;
 
+  /** Get the name of the function containing an address, as module!function
+   */
+  std::string functionName(DWORD64 address) const;
+
   /** Provide a stack trace for the 'origContext' using current depth and params
    */
   void StackTrace(HANDLE hThread, const CONTEXT &context,
                   std::ostream &os) const;
 
+  /** Get the addresses of the frames for the 'context' using current depth
+   * and skip count, innermost first */
+  void StackFrames(HANDLE hThread, const CONTEXT &context,
+                   std::vector<DWORD64> &frames) const;
+
   /** get context for the current thread, correcting the stack frame to the
    * caller */
 #ifdef _M_IX86
@@ -163,6 +200,19 @@ private:
   SymbolEngine(SymbolEngine const &);
   SymbolEngine &operator=(SymbolEngine const &);
 
+  using FrameCallback = std::function<void(
+      STACKFRAME64 const &stackFrame, CONTEXT const &context, DWORD nonExec)>;
+
+  void walkStack(HANDLE hThread, const CONTEXT &context, std::ostream &os,
+                 FrameCallback const &fn) const;
+
+  DWORD printFrame(DWORD64 pc, DWORD nonExec, std::ostream &os) const;
+
+#ifdef _M_X64
+  bool unwindFrames(const CONTEXT &context,
+                    std::vector<DWORD64> &frames) const;
+#endif // _M_X64
+
   bool showLines_{true};      // true to show lines
   bool showParams_{false};    // true to show parameters
   bool showVariables_{false}; // true to show variables
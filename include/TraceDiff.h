@@ -0,0 +1,131 @@
+#ifndef OR2_TRACEDIFF_H
+#define OR2_TRACEDIFF_H
+
+/**@file
+
+  Structural comparison of two traces of the same program, for example
+  before and after upgrading a dependency, ignoring the details that vary
+  from run to run.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "HandleTable.h"
+#include "TraceParser.h"
+
+namespace or2 {
+
+/**
+ * Compares the calls made by each thread in two traces.
+ *
+ * Each call is normalized to its function, arguments and result with
+ * pointers and output values removed and handles replaced by the names of
+ * their objects, where the call opening them was traced, so that the text
+ * does not depend on the addresses, handles, IDs or times of one run.
+ *
+ * Threads are matched by the order in which their process and then the
+ * thread first appear in each trace, and the calls of each pair of threads
+ * aligned with a shortest edit script. A call removed from one place and
+ * inserted at another on the same thread is reported as reordered.
+ */
+class TraceDiff {
+public:
+  /** The two traces */
+  enum Side { Old, New };
+
+  /**
+   * Add a call from one of the traces; pre-call lines are ignored.
+   * @param line the line number of the call, for reporting
+   */
+  void add(Side side, TraceRecord const &record, uint64_t line);
+
+  /**
+   * Print the changes in the number of calls to each function, and the
+   * differences between the threads.
+   * @param maxHunks the number of groups of differing calls to print, or
+   * zero for all
+   */
+  void report(std::ostream &os, size_t maxHunks) const;
+
+  /**
+   * Find a shortest edit script from 'a' to 'b', using the linear space
+   * algorithm of Myers ("An O(ND) Difference Algorithm and Its
+   * Variations"). Very expensive comparisons settle for an edit script
+   * that may not be the shortest.
+   * @param removed set to true for each element of 'a' removed
+   * @param inserted set to true for each element of 'b' inserted
+   */
+  static void diff(std::vector<uint32_t> const &a,
+                   std::vector<uint32_t> const &b, std::vector<bool> &removed,
+                   std::vector<bool> &inserted);
+
+private:
+  /** The calls made by one thread */
+  struct Thread {
+    uint32_t processId{};
+    uint32_t threadId{};
+    std::vector<uint32_t> calls; // normalized call identifiers
+    std::vector<uint64_t> lines; // line numbers of the calls
+  };
+
+  /** One trace */
+  struct Trace {
+    std::map<uint32_t, HandleTable> handles; // by process ID
+    std::map<uint32_t, uint32_t> processes;  // ordinal by process ID
+    std::map<uint32_t, uint32_t> threadCounts; // by process ordinal
+    std::map<std::pair<uint32_t, uint32_t>, std::pair<uint32_t, uint32_t>>
+        ordinals; // of process and thread, by process and thread ID
+    std::map<std::pair<uint32_t, uint32_t>, Thread> threads; // by ordinals
+    std::map<std::string, uint64_t, std::less<>> functions; // call counts
+    uint64_t calls{};
+  };
+
+  static void trackHandles(HandleTable &handles, TraceRecord const &record);
+  static std::string normalize(HandleTable const &handles,
+                               TraceRecord const &record);
+  uint32_t intern(std::string const &call);
+
+  Trace traces_[2];
+  std::vector<std::string> calls_;
+  std::unordered_map<std::string, uint32_t> ids_; // index into calls_
+};
+
+} // namespace or2
+
+#endif // OR2_TRACEDIFF_H
@@ -0,0 +1,89 @@
+#ifndef OR2_TRACELINE_H
+#define OR2_TRACELINE_H
+
+/**@file
+
+  Parser for the lines of text written by NtTrace, so that saved traces can
+  be analysed offline, for example:
+
+    12:34:56.789: [1234/5678] NtClose(Handle=0x1c) => 0
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace or2 {
+
+/** One traced call, as written by NtTrace */
+struct TraceLine {
+  /** An argument of the call */
+  struct Argument {
+    std::string name;  ///< formal name, if shown
+    std::string value; ///< the value as written
+  };
+
+  std::string time;           ///< timestamp and/or delta prefix, if any
+  uint32_t processId{};       ///< process ID, if shown
+  uint32_t threadId{};        ///< thread ID, if shown
+  uint32_t id{};              ///< a single ID, shown without the other
+  std::string function;       ///< name of the entry point
+  std::vector<Argument> args; ///< the arguments
+  std::string result;         ///< return value, empty for a pre-call line
+  bool before{};              ///< true for a pre-call line ("...")
+
+  /** The thread ID, or a single ID of unknown kind */
+  uint32_t sequence() const { return threadId ? threadId : id; }
+
+  /**
+   * Parse a line of NtTrace output.
+   * A single ID in brackets is stored as 'id', as it may be a process or a
+   * thread ID.
+   * @return false if the line is not a call
+   */
+  bool parse(std::string const &line);
+
+  /**
+   * Parse only the time stamp and IDs at the start of a line, such as those
+   * written before a debug event.
+   * @return the position of the text following them
+   */
+  size_t parseHeader(std::string const &line);
+
+  /**
+   * Get the time of day from a time stamp of the form HH:MM:SS.mmm
+   * @return false if the line has no time stamp
+   */
+  bool timeOfDay(uint64_t &microseconds) const;
+};
+
+} // namespace or2
+
+#endif // OR2_TRACELINE_H
@@ -0,0 +1,169 @@
+#ifndef OR2_TRACEPARSER_H
+#define OR2_TRACEPARSER_H
+
+/**@file
+
+  Fast parser for the text written by NtTrace, working in place on the text
+  of a whole trace (typically a memory mapped file) so that no memory is
+  allocated for each line, and able to parse a large trace on all cores.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace or2 {
+
+/** One traced call, referring to the text of the line */
+struct TraceRecord {
+  std::string_view time;     ///< timestamp and/or delta prefix, if any
+  uint32_t processId{};      ///< process ID, if shown
+  uint32_t threadId{};       ///< thread ID, if shown
+  uint32_t id{};             ///< a single ID, shown without the other
+  std::string_view function; ///< name of the entry point
+  std::string_view args;     ///< the text of the arguments, without brackets
+  std::string_view result;   ///< return value, empty for a pre-call line
+  bool before{};             ///< true for a pre-call line ("...")
+
+  /**
+   * The ID of the sequence of calls this one belongs to: the thread ID, or
+   * a single ID when it is not known if that is a process or thread ID
+   */
+  uint32_t sequence() const { return threadId ? threadId : id; }
+};
+
+/** One argument of a traced call, referring to the text of the line */
+struct TraceArgument {
+  std::string_view name;  ///< formal name, if shown
+  std::string_view value; ///< the value as written
+};
+
+/** Parser for lines of NtTrace output */
+class TraceParser {
+public:
+  /**
+   * Parse the time stamp and IDs at the start of a line.
+   * A single ID in brackets may be a process or a thread ID, depending on
+   * the options used to write the trace, so it is stored as 'id' with both
+   * 'processId' and 'threadId' left as zero.
+   * @return the position of the text following them
+   */
+  static size_t parseHeader(std::string_view line, TraceRecord &record);
+
+  /**
+   * Parse a line of NtTrace output.
+   * @return false if the line is not a call
+   */
+  static bool parse(std::string_view line, TraceRecord &record);
+
+  /**
+   * Remove the first argument from the text of the arguments of a call.
+   * @return false if there are no more arguments
+   */
+  static bool nextArgument(std::string_view &args, TraceArgument &argument);
+
+  /**
+   * Get the time of day from a time stamp of the form HH:MM:SS.mmm
+   * @return false if the time stamp is not of this form
+   */
+  static bool timeOfDay(std::string_view time, uint64_t &microseconds);
+
+  /**
+   * Get the value of a number as written by NtTrace, in hex with a leading
+   * "0x" or in decimal.
+   * @return false if the text is not a number
+   */
+  static bool number(std::string_view text, uint64_t &value);
+
+  /** Returns true if a return value is an NTSTATUS error */
+  static bool isError(uint64_t status) {
+    return status <= 0xffffffff && (status & 0xc0000000) == 0xc0000000;
+  }
+
+  /** Returns true if the line is a frame of a stack trace */
+  static bool isFrame(std::string_view line) {
+    return line.find('!') != std::string_view::npos ||
+           line.substr(0, 2) == "0x" || line.substr(0, 14) == "[inline frame]";
+  }
+
+  /** Call 'visit' with each line of the text, without its line ending */
+  template <typename Visitor>
+  static void forEachLine(std::string_view text, Visitor &&visit) {
+    char const *pos = text.data();
+    char const *const end = pos + text.size();
+    while (pos != end) {
+      auto const eol = static_cast<char const *>(
+          std::memchr(pos, '\n', static_cast<size_t>(end - pos)));
+      char const *const next = eol ? eol + 1 : end;
+      char const *last = eol ? eol : end;
+      if (last != pos && last[-1] == '\r') {
+        --last;
+      }
+      visit(std::string_view(pos, static_cast<size_t>(last - pos)));
+      pos = next;
+    }
+  }
+
+  /** Split the text into up to 'count' chunks of whole lines */
+  static std::vector<std::string_view> chunks(std::string_view text,
+                                              size_t count);
+
+  /**
+   * Visit every line of the text using several threads.
+   * The text is split into chunks of whole lines, each visited in order by
+   * one thread with its own default constructed state, 'visit(state, line)'.
+   * @return the state for each chunk, in the order of the text
+   */
+  template <typename State, typename Visitor>
+  static std::vector<State> parallel(std::string_view text, size_t threads,
+                                     Visitor const &visit) {
+    std::vector<std::string_view> const parts = chunks(text, threads);
+    std::vector<State> states(parts.size());
+    std::vector<std::thread> workers;
+    workers.reserve(parts.size());
+    for (size_t idx = 0; idx != parts.size(); ++idx) {
+      workers.emplace_back([&, idx] {
+        forEachLine(parts[idx],
+                    [&](std::string_view line) { visit(states[idx], line); });
+      });
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    return states;
+  }
+};
+
+} // namespace or2
+
+#endif // OR2_TRACEPARSER_H
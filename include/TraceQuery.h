@@ -0,0 +1,130 @@
+#ifndef OR2_TRACEQUERY_H
+#define OR2_TRACEQUERY_H
+
+/**@file
+
+  Filter and group-by queries over a columnar trace store, such as the 99th
+  percentile latency of a function per process per minute.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TraceStore.h"
+
+namespace or2 {
+
+/** The values of the keys of one group; keys not grouped by are empty */
+struct TraceGroup {
+  uint64_t bucket{};    ///< start of the time bucket
+  uint64_t status{};    ///< return value
+  uint32_t function{};  ///< function identifier
+  uint32_t processId{}; ///< process ID
+  uint32_t threadId{};  ///< thread ID
+  std::string args;     ///< text of the arguments
+
+  bool operator==(TraceGroup const &rhs) const = default;
+};
+
+/** The totals for one group */
+struct TraceTotals {
+  uint64_t count{};                ///< number of calls
+  uint64_t errors{};               ///< number of NTSTATUS errors
+  uint64_t duration{};             ///< total of the known durations
+  std::vector<uint64_t> durations; ///< known durations, sorted by finish()
+
+  /** Add the totals of another part of the same group */
+  void add(TraceTotals &&other);
+
+  /** Sort the durations, after which percentiles can be taken */
+  void finish();
+
+  /** Get a percentile (0 to 100) of the durations; zero if none are known */
+  uint64_t percentile(double percent) const;
+};
+
+/**
+ * A query over the results of the calls in a trace store.
+ *
+ * Each block is first checked against the filters using its statistics,
+ * and skipped if no call in it can match. The columns used are then
+ * decoded and the filters applied as simple loops over each column in
+ * turn, before the selected calls are added to their groups. Blocks are
+ * shared between a number of threads, each with its own groups, which are
+ * merged at the end.
+ */
+struct TraceQuery {
+  /** Keys to group by, as a bit mask */
+  enum Key : unsigned {
+    Function = 1 << 0,
+    Process = 1 << 1,
+    Thread = 1 << 2,
+    Status = 1 << 3,
+    Args = 1 << 4,
+  };
+
+  /** A group and its totals */
+  using Result = std::pair<TraceGroup, TraceTotals>;
+
+  /** The amount of work done by a query */
+  struct Stats {
+    uint64_t blocks{};  ///< blocks scanned
+    uint64_t skipped{}; ///< blocks skipped using their statistics
+    uint64_t rows{};    ///< calls scanned
+    uint64_t matched{}; ///< calls matching the filters
+  };
+
+  unsigned keys{};                 ///< keys to group by
+  uint64_t bucket{};               ///< width of time buckets, zero for none
+  std::vector<uint32_t> functions; ///< function identifiers, empty for all
+  std::optional<uint32_t> processId; ///< process ID to include
+  std::optional<uint64_t> status;    ///< return value to include
+  bool errors{};                     ///< include only NTSTATUS errors
+  uint64_t from{};                   ///< earliest time to include
+  uint64_t to{UINT64_MAX};           ///< latest time to include
+
+  /**
+   * Run the query, giving the groups in descending order of count.
+   * @return false if the store is corrupt
+   */
+  bool run(TraceStoreReader const &reader, size_t threads,
+           std::vector<Result> &results, Stats &stats) const;
+
+private:
+  bool skip(TraceBlock const &block) const;
+};
+
+} // namespace or2
+
+#endif // OR2_TRACEQUERY_H
@@ -0,0 +1,223 @@
+#ifndef OR2_TRACESTORE_H
+#define OR2_TRACESTORE_H
+
+/**@file
+
+  Columnar store for NtTrace calls, so that aggregate queries over large
+  numbers of traces need only read and decode the columns they use.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "MappedFile.h"
+#include "TraceParser.h"
+
+namespace or2 {
+
+/**
+ * The values of the calls in one block of a store, one vector per column.
+ *
+ * Times are in microseconds from midnight on 1 January 1970, as the local
+ * date of the trace file plus the time of day of the line, or zero if not
+ * shown. Durations are one more than the microseconds from the pre-call
+ * line to the result, so that zero means unknown. Return values are zero if
+ * not numeric. Functions are identifiers in the string heap of the store.
+ */
+struct TraceColumns {
+  /** Columns, used as a bit mask to select the columns to read */
+  enum Column : unsigned {
+    Time = 1 << 0,
+    Duration = 1 << 1,
+    ProcessId = 1 << 2,
+    ThreadId = 1 << 3,
+    Function = 1 << 4,
+    Status = 1 << 5,
+    Before = 1 << 6,
+    Args = 1 << 7,
+    All = (1 << 8) - 1,
+  };
+  static constexpr size_t count = 8; ///< number of columns
+
+  std::vector<uint64_t> time;      ///< date and time of the line
+  std::vector<uint64_t> duration;  ///< time taken by the call, plus one
+  std::vector<uint32_t> processId; ///< process ID, if shown
+  std::vector<uint32_t> threadId;  ///< thread ID, or a single ID shown
+  std::vector<uint32_t> function;  ///< name of the entry point
+  std::vector<uint64_t> status;    ///< return value
+  std::vector<uint8_t> before;     ///< 1 for a pre-call line
+  std::vector<std::string> args;   ///< text of the arguments
+};
+
+/** Statistics for one block of a store, for skipping blocks */
+struct TraceBlock {
+  /** Smallest and largest value in a column */
+  struct Range {
+    uint64_t min{};
+    uint64_t max{};
+    /** Returns true if any value in [low, high] may be in the block */
+    bool overlaps(uint64_t low, uint64_t high) const {
+      return low <= max && min <= high;
+    }
+  };
+
+  uint64_t offset{}; ///< offset of the block in the file
+  uint64_t size{};   ///< size of the block in bytes
+  uint64_t rows{};   ///< number of calls in the block
+  Range time;        ///< range of the times
+  Range duration;    ///< range of the durations, plus one
+  Range processId;   ///< range of the process IDs
+  Range threadId;    ///< range of the thread IDs
+  Range function;    ///< range of the function identifiers
+  Range status;      ///< range of the return values
+};
+
+/**
+ * Writer for a columnar store of traced calls.
+ *
+ * Calls are buffered into blocks of a fixed number of rows, and each column
+ * of a block is encoded separately: times as deltas, the IDs, functions,
+ * return values and pre-call flags as a dictionary of the values in the
+ * block with run lengths, and the rest as variable length integers. The
+ * names of the functions and the quoted strings in the arguments, such as
+ * file and key names, are held once each in a string heap, written with the
+ * block statistics at the end of the file. The rest of the text of the
+ * arguments, which mostly differs from call to call, is held in the block.
+ */
+class TraceStoreWriter {
+public:
+  /**
+   * Construct a writer
+   * @param fileName the file to write
+   * @param blockRows the number of calls in each block
+   */
+  explicit TraceStoreWriter(std::string const &fileName,
+                            size_t blockRows = 65536);
+  ~TraceStoreWriter();
+  TraceStoreWriter(TraceStoreWriter const &) = delete;
+  TraceStoreWriter &operator=(TraceStoreWriter const &) = delete;
+
+  /** Returns false if the file could not be written */
+  bool good() const { return os_.good(); }
+
+  /**
+   * Start the calls from another trace file.
+   * @param date the date of the first call in the file, from date()
+   */
+  void beginFile(uint64_t date);
+
+  /**
+   * Add a call; the duration of a result is taken from the preceding
+   * pre-call line of the same thread in the same file, if any. The date
+   * advances when the time of day goes back by more than twelve hours.
+   */
+  void add(TraceRecord const &record);
+
+  /** Number of calls added */
+  uint64_t rows() const { return rows_; }
+
+  /** Finish the file; no further calls can be added */
+  void close();
+
+  /** Get the time of midnight at the start of a date */
+  static uint64_t date(int year, unsigned month, unsigned day);
+
+private:
+  uint32_t intern(std::string_view text);
+  void addArgs(std::string_view args);
+  void flush();
+
+  size_t const blockRows_;
+  std::ofstream os_;
+  bool closed_{};
+  uint64_t rows_{};
+  TraceColumns block_; // the arguments are held in args_
+  std::string args_;   // encoded arguments of the block
+  std::vector<TraceBlock> blocks_;
+  std::deque<std::string> strings_;
+  std::unordered_map<std::string_view, uint32_t> ids_; // index into strings_
+  std::map<std::pair<uint32_t, uint32_t>, uint64_t>
+      pending_;          // time of pre-call line, by process and thread
+  uint64_t date_{};      // date of the current line
+  uint64_t timeOfDay_{}; // time of day of the last line with a time stamp
+};
+
+/** Reader for a columnar store of traced calls */
+class TraceStoreReader {
+public:
+  /**
+   * Open a store, reading the string heap and the block statistics.
+   * @return false on failure, with the reason in 'error'
+   */
+  bool open(std::string const &fileName, std::string &error);
+
+  /** Statistics for each block */
+  std::vector<TraceBlock> const &blocks() const { return blocks_; }
+
+  /** Get a function name or quoted argument string by identifier */
+  std::string_view string(uint32_t id) const { return strings_[id]; }
+
+  /** Number of strings in the heap */
+  size_t strings() const { return strings_.size(); }
+
+  /** Find the identifier of a string, or return strings() if not present */
+  uint32_t find(std::string_view text) const;
+
+  /**
+   * Decode the selected columns of a block; other columns are left empty.
+   * @return false if the block is corrupt
+   */
+  bool read(size_t block, TraceColumns &columns,
+            unsigned mask = TraceColumns::All) const;
+
+  /** Number of calls in the store */
+  uint64_t rows() const;
+
+  /** Format a time from the store as YYYY-MM-DD HH:MM:SS.mmm */
+  static std::string format(uint64_t time);
+
+private:
+  MappedFile file_;
+  std::vector<TraceBlock> blocks_;
+  std::vector<std::string_view> strings_; // refer to the mapped file
+  std::unordered_map<std::string_view, uint32_t> ids_;
+};
+
+} // namespace or2
+
+#endif // OR2_TRACESTORE_H
@@ -0,0 +1,165 @@
+#ifndef OR2_TRACETRIGGER_H
+#define OR2_TRACETRIGGER_H
+
+/**@file
+
+  State machine switching tracing on and off in response to trigger events:
+  calls matching a start or stop condition, or debug strings containing a
+  start or stop text.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace or2 {
+
+/**
+ * Trigger controlling when tracing is active.
+ *
+ * With no start trigger tracing is active from the beginning; otherwise it
+ * starts on the first start event. A stop event ends tracing, either at once
+ * or after the stop delay, and tracing then waits for the next start event.
+ * A start event while waiting for the stop delay cancels the stop.
+ *
+ * Times are in milliseconds from an arbitrary origin. The event functions
+ * return true when the result of tracing() changes.
+ */
+class TraceTrigger {
+public:
+  /** States of the trigger */
+  enum class State {
+    Idle,     ///< waiting for a start event
+    Active,   ///< tracing
+    Stopping, ///< tracing until the stop delay expires
+  };
+
+  /** Set whether calls can start tracing */
+  void setStartCall(bool value) {
+    startCall_ = value;
+    reset();
+  }
+
+  /** Set whether calls can stop tracing */
+  void setStopCall(bool value) {
+    stopCall_ = value;
+    reset();
+  }
+
+  /** Set the text of a debug string that starts tracing */
+  void setStartText(std::string text) {
+    startText_ = std::move(text);
+    reset();
+  }
+
+  /** Set the text of a debug string that stops tracing */
+  void setStopText(std::string text) {
+    stopText_ = std::move(text);
+    reset();
+  }
+
+  /** Set the time tracing continues after a stop event */
+  void setStopDelay(uint64_t milliseconds) { stopDelay_ = milliseconds; }
+
+  /** Returns true if there are any triggers */
+  bool enabled() const {
+    return hasStart() || stopCall_ || !stopText_.empty();
+  }
+
+  /** Returns true if there is a start trigger */
+  bool hasStart() const { return startCall_ || !startText_.empty(); }
+
+  /** Return to the initial state */
+  void reset() { state_ = hasStart() ? State::Idle : State::Active; }
+
+  /** Get the current state */
+  State getState() const { return state_; }
+
+  /** Returns true if tracing is active */
+  bool tracing() const { return state_ != State::Idle; }
+
+  /** A call matching the start condition occurred */
+  bool startCall(uint64_t /*now*/) { return start(); }
+
+  /** A call matching the stop condition occurred */
+  bool stopCall(uint64_t now) { return stop(now); }
+
+  /** A debug string was written */
+  bool debugString(std::string const &text, uint64_t now) {
+    bool changed(false);
+    if (!startText_.empty() && text.find(startText_) != std::string::npos) {
+      changed = start();
+    }
+    if (!stopText_.empty() && text.find(stopText_) != std::string::npos) {
+      changed = stop(now) != changed;
+    }
+    return changed;
+  }
+
+  /** Time has passed: check for the end of the stop delay */
+  bool tick(uint64_t now) {
+    if (state_ == State::Stopping && now >= deadline_) {
+      state_ = State::Idle;
+      return true;
+    }
+    return false;
+  }
+
+private:
+  bool start() {
+    bool const changed = state_ == State::Idle;
+    state_ = State::Active;
+    return changed;
+  }
+
+  bool stop(uint64_t now) {
+    if (state_ == State::Active) {
+      if (stopDelay_ == 0) {
+        state_ = State::Idle;
+        return true;
+      }
+      state_ = State::Stopping;
+      deadline_ = now + stopDelay_;
+    }
+    return false;
+  }
+
+  bool startCall_{};
+  bool stopCall_{};
+  std::string startText_;
+  std::string stopText_;
+  uint64_t stopDelay_{};
+  uint64_t deadline_{};
+  State state_{State::Active};
+};
+
+} // namespace or2
+
+#endif // OR2_TRACETRIGGER_H
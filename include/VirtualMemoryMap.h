@@ -0,0 +1,178 @@
+#ifndef OR2_VIRTUALMEMORYMAP_H
+#define OR2_VIRTUALMEMORYMAP_H
+
+/**@file
+
+  Map of the virtual address space of a process, rebuilt from the calls
+  allocating, protecting and freeing memory and mapping views of sections.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include "HighWaterMark.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <vector>
+
+namespace or2 {
+
+class StackTable;
+
+/**
+ * Regions of the address space of one process.
+ *
+ * The regions are held in address order, split where the state or the
+ * protection of part of an allocation changes; memory reserved before
+ * tracing began is only known once it is used. Addresses are rounded to
+ * whole pages, sizes, protections and allocation types are as used by the
+ * native API, and times are in milliseconds from an arbitrary origin.
+ */
+class VirtualMemoryMap {
+public:
+  /** Kinds of region */
+  enum Kind { Private, Mapped };
+
+  /** A run of pages with the same state and protection */
+  struct Block {
+    uint64_t base{};           ///< address of the first page
+    uint64_t size{};           ///< size in bytes
+    uint64_t allocationBase{}; ///< base of the allocation or view
+    Kind kind{Private};        ///< private memory or a mapped view
+    bool committed{};          ///< committed, rather than only reserved
+    uint32_t protection{};     ///< page protection
+    uint32_t stack{};          ///< allocating stack, or zero
+    uint64_t time{};           ///< time of allocation
+  };
+
+  /** Allocations of one size freed soon after they were made */
+  struct Churn {
+    uint64_t size{};  ///< size of the allocation
+    uint64_t count{}; ///< number of allocations freed
+    uint32_t stack{}; ///< a stack making one of the allocations
+  };
+
+  /** The most memory committed in one period of time */
+  using Mark = HighWaterMark::Mark;
+
+  /**
+   * Construct a map.
+   * @param churnTime allocations freed within this many ms count as churn
+   * @param interval the period, in ms, of the committed memory timeline
+   */
+  explicit VirtualMemoryMap(uint64_t churnTime = 100, uint64_t interval = 1000);
+
+  /** Memory was allocated (NtAllocateVirtualMemory) */
+  void allocate(uint64_t base, uint64_t size, uint32_t type,
+                uint32_t protection, uint32_t stack, uint64_t time);
+
+  /** Memory was freed or decommitted (NtFreeVirtualMemory) */
+  void release(uint64_t base, uint64_t size, uint32_t type, uint64_t time);
+
+  /** The protection of memory was changed (NtProtectVirtualMemory) */
+  void protect(uint64_t base, uint64_t size, uint32_t protection,
+               uint64_t time);
+
+  /** A view of a section was mapped (NtMapViewOfSection) */
+  void mapView(uint64_t base, uint64_t size, uint32_t protection,
+               uint32_t stack, uint64_t time);
+
+  /** A view of a section was unmapped (NtUnmapViewOfSection) */
+  void unmapView(uint64_t base, uint64_t time);
+
+  /** Get the block containing an address, or nullptr */
+  Block const *find(uint64_t address) const;
+
+  /** Get the blocks, in address order */
+  std::vector<Block> blocks() const;
+
+  /** Number of allocations and views */
+  size_t allocations() const { return allocations_.size(); }
+
+  /** Bytes reserved or committed */
+  uint64_t reserved() const;
+
+  /** Bytes committed */
+  uint64_t committed() const { return committed_; }
+
+  /** Largest number of bytes committed at any one time */
+  uint64_t peak() const { return marks_.peak(); }
+
+  /** Get the blocks that are both writable and executable */
+  std::vector<Block const *> writableExecutable() const;
+
+  /** Get the 'count' sizes most often freed soon after allocation */
+  std::vector<Churn> churn(size_t count) const;
+
+  /** Get the high-water mark for each period in which memory changed */
+  std::vector<Mark> const &timeline() const { return marks_.timeline(); }
+
+  /**
+   * Print a report of the address space.
+   * @param os the stream to write to
+   * @param stacks the table the stack ids refer to
+   * @param maxItems the number of regions and sizes to show in each list
+   * @param maxMarks the number of high-water marks to show
+   */
+  void report(std::ostream &os, StackTable const &stacks, size_t maxItems = 10,
+              size_t maxMarks = 20) const;
+
+  /** Returns true if a page protection allows both writing and execution */
+  static bool isWritableExecutable(uint32_t protection);
+
+private:
+  struct Allocation {
+    uint64_t size;  // size reserved
+    uint64_t time;  // time of allocation
+    uint32_t stack; // allocating stack
+  };
+
+  using Blocks = std::map<uint64_t, Block>; // keyed by base address
+
+  void split(uint64_t address);
+  void erase(uint64_t begin, uint64_t end);
+  void commit(uint64_t begin, uint64_t end, uint32_t protection,
+              uint32_t stack, uint64_t time);
+  void merge(uint64_t begin, uint64_t end);
+  void setCommitted(Block &block, bool committed);
+  uint64_t allocationEnd(uint64_t base) const;
+  void freed(uint64_t base, uint64_t time);
+
+  uint64_t churnTime_;
+  Blocks blocks_;
+  std::map<uint64_t, Allocation> allocations_; // keyed by base address
+  std::map<uint64_t, Churn> churn_;            // keyed by size
+  uint64_t committed_{};
+  HighWaterMark marks_;
+};
+
+} // namespace or2
+
+#endif // OR2_VIRTUALMEMORYMAP_H
@@ -0,0 +1,138 @@
+#ifndef OR2_WAITPROFILER_H
+#define OR2_WAITPROFILER_H
+
+/**@file
+
+  Profile of the time threads spend blocked in wait calls, attributed to the
+  objects waited for and the waiting stacks.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace or2 {
+
+class StackTable;
+
+/**
+ * Blocked time for each object waited on.
+ *
+ * A convoy is a run of waits on the same object by several threads, each
+ * woken after the previous one while it was still waiting: the threads are
+ * released one after another rather than working in parallel. Threads woken
+ * together, as when an event is set, do not form a convoy.
+ */
+class WaitProfiler {
+public:
+  /** A completed wait; times are in microseconds */
+  struct Wait {
+    uint32_t processId{}; ///< process making the wait
+    uint32_t threadId{};  ///< thread making the wait
+    uint64_t start{};     ///< time the wait started
+    uint64_t end{};       ///< time the wait completed
+    std::string function; ///< entry point name
+    std::string object;   ///< name of the object(s) waited on
+    uint32_t stack{};     ///< waiting stack, or zero
+  };
+
+  /** Blocked time for one object */
+  struct Object {
+    uint32_t processId{};    ///< process owning the object
+    std::string name;        ///< name of the object
+    uint64_t waits{};        ///< number of waits
+    uint64_t microseconds{}; ///< total time blocked
+    uint64_t longest{};      ///< longest single wait
+    size_t threads{};        ///< number of distinct threads waiting
+    uint64_t convoys{};      ///< number of convoys
+    size_t convoyThreads{};  ///< most threads in a single convoy
+    uint32_t stack{};        ///< the stack blocked for longest in total
+  };
+
+  /**
+   * Construct a profiler.
+   * @param convoyThreads the number of threads that must be released one
+   * after another to count as a convoy
+   */
+  explicit WaitProfiler(size_t convoyThreads = 3);
+
+  /** A wait has started on a thread */
+  void begin(uint32_t threadId, uint64_t time);
+
+  /**
+   * A wait has completed on a thread: pair it with the start of the wait.
+   * @return false if no start was recorded for the thread
+   */
+  bool end(uint32_t processId, uint32_t threadId, uint64_t time,
+           std::string const &function, std::string const &object,
+           uint32_t stack);
+
+  /** Add a completed wait */
+  void add(Wait wait);
+
+  /** A thread has exited */
+  void threadExit(uint32_t threadId) { pending_.erase(threadId); }
+
+  /** Get the completed waits, in order of completion */
+  std::vector<Wait> const &waits() const { return waits_; }
+
+  /** Get the 'count' objects with the most blocked time, worst first */
+  std::vector<Object> ranked(size_t count) const;
+
+  /** Print the 'count' objects with the most blocked time */
+  void report(std::ostream &os, StackTable const &stacks, size_t count) const;
+
+  /**
+   * Write the waits as comma separated values, ordered by start time, with
+   * columns "process,thread,start,end,function,object"
+   */
+  void writeTimeline(std::ostream &os) const;
+
+  /**
+   * Check whether an entry point waits on objects.
+   * @param function the entry point name
+   * @param argument set to the index of the argument holding the handle
+   * waited on; for NtWaitForMultipleObjects this is the array of handles,
+   * preceded by the count
+   */
+  static bool isWait(std::string const &function, size_t &argument);
+
+private:
+  size_t convoyThreads_;
+  std::unordered_map<uint32_t, uint64_t> pending_; // start time by thread
+  std::vector<Wait> waits_;
+};
+
+} // namespace or2
+
+#endif // OR2_WAITPROFILER_H
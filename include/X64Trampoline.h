@@ -0,0 +1,88 @@
+#ifndef OR2_X64TRAMPOLINE_H
+#define OR2_X64TRAMPOLINE_H
+
+/**@file
+
+  Generator for the register-save trampoline used on x64 in place of a
+  pre-call breakpoint: the trampoline saves the register arguments of a
+  system call in their home area on the stack and loads the system service
+  number, so the arguments can be read when the call returns.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+
+namespace or2 {
+
+/**
+ * Register-save trampoline for an x64 system call stub.
+ *
+ * The 'mov eax,<ssn>' instruction of the system call stub is replaced by a
+ * jump to the trampoline, which is:
+ *
+ *   48 89 4c 24 08        mov     qword ptr [rsp+8],rcx
+ *   48 89 54 24 10        mov     qword ptr [rsp+10h],rdx
+ *   4c 89 44 24 18        mov     qword ptr [rsp+18h],r8
+ *   4c 89 4c 24 20        mov     qword ptr [rsp+20h],r9
+ *   b8 xx xx xx xx        mov     eax,<ssn>
+ *   ff 25 00 00 00 00     jmp     qword ptr [rip]
+ *   xx xx xx xx xx xx xx xx <resume>
+ *
+ * The trampoline is position independent so it can be placed anywhere in
+ * the target; only the jump to it must be within 2GB.
+ *
+ * This class does not depend on the Windows headers.
+ */
+class X64Trampoline {
+public:
+  /** Size of a trampoline in bytes */
+  static constexpr size_t size = 39;
+
+  /** Size of the jump to a trampoline in bytes */
+  static constexpr size_t jumpSize = 5;
+
+  /**
+   * Generate the trampoline for system service 'ssn' which resumes at the
+   * address 'resume', normally the instruction after the replaced 'mov'.
+   */
+  static void generate(unsigned char (&code)[size], uint32_t ssn,
+                       uint64_t resume);
+
+  /**
+   * Generate a jump at the address 'from' to the address 'to'.
+   * @return false if the target is out of range
+   */
+  static bool jump(unsigned char (&code)[jumpSize], uint64_t from,
+                   uint64_t to);
+};
+
+} // namespace or2
+
+#endif // OR2_X64TRAMPOLINE_H
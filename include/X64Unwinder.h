@@ -0,0 +1,173 @@
+#ifndef OR2_X64UNWINDER_H
+#define OR2_X64UNWINDER_H
+
+/**@file
+
+  Stack unwinder for x64 code using the unwind information in the .pdata and
+  .xdata sections of the loaded modules.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "ModuleMap.h"
+
+namespace or2 {
+
+/**
+ * Unwinder for x64 stacks.
+ *
+ * The function table of each module is read once, on first use, and the
+ * unwind information for each function is parsed once and cached. The stack
+ * itself is normally supplied as a single block of memory read from the
+ * target so walking the stack does not need any further reads of the target.
+ *
+ * This class does not depend on the Windows headers; all access to the target
+ * process is through the supplied memory reader.
+ */
+class X64Unwinder {
+public:
+  /**
+   * Read memory from the target.
+   * Called as 'bool read(uint64_t address, void *buffer, size_t size)' and
+   * returns true if all the requested bytes were read.
+   */
+  using ReadMemory = std::function<bool(uint64_t, void *, size_t)>;
+
+  /** Integer registers, in the order used by the unwind codes */
+  enum Register {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+  };
+
+  /** Register state for a frame */
+  struct Context {
+    uint64_t rip{};
+    uint64_t regs[16]{};
+  };
+
+  /** Copy of (part of) the stack of the target thread */
+  struct Stack {
+    uint64_t address{};               ///< Target address of the first byte
+    std::vector<unsigned char> bytes; ///< Contents of the stack
+
+    /** Returns true if the address lies in the copied stack */
+    bool contains(uint64_t target) const {
+      return target - address < bytes.size();
+    }
+  };
+
+  /** A frame found by the unwinder */
+  struct Frame {
+    uint64_t rip; ///< Instruction pointer
+    uint64_t rsp; ///< Stack pointer
+  };
+
+  /** Construct an unwinder reading memory with the supplied function */
+  explicit X64Unwinder(ReadMemory read);
+
+  /**
+   * Unwind the stack.
+   * @param context the register state of the innermost frame
+   * @param stack a copy of the stack, from the stack pointer upwards
+   * @param modules the modules loaded in the target
+   * @param frames the frames found, starting with the innermost
+   * @param maxFrames the maximum number of frames to return
+   * @return true if the unwind completed, false if it encountered an address
+   * it could not unwind
+   */
+  bool unwind(Context context, Stack const &stack, ModuleMap const &modules,
+              std::vector<Frame> &frames, size_t maxFrames = 1000);
+
+  /**
+   * Unwind a single frame.
+   * @param context the register state, updated to that of the caller
+   * @param stack a copy of the stack, from the stack pointer upwards
+   * @param modules the modules loaded in the target
+   * @param innermost true if this is the innermost frame, which may be
+   * stopped in a function epilog
+   * @return true if the frame was unwound
+   */
+  bool step(Context &context, Stack const &stack, ModuleMap const &modules,
+            bool innermost);
+
+  /** Discard the cached information */
+  void clear();
+
+private:
+  // An entry in the .pdata function table
+  struct Function {
+    uint32_t begin;
+    uint32_t end;
+    uint32_t unwindInfo;
+  };
+
+  // Parsed .xdata unwind information for a function
+  struct UnwindInfo {
+    uint8_t version;
+    uint8_t prologSize;
+    uint8_t frameRegister;
+    uint8_t frameOffset;
+    std::vector<uint16_t> codes;
+    bool chained;
+    Function chain; // parent function, if chained
+  };
+
+  // Information for one module
+  struct ModuleInfo {
+    std::vector<Function> functions; // sorted by begin address
+    std::unordered_map<uint32_t, UnwindInfo> unwindInfo; // keyed by RVA
+  };
+
+  ModuleInfo &moduleInfo(ModuleMap::Module const &module,
+                         ModuleMap const &modules);
+
+  bool readFunctions(uint64_t base, std::vector<Function> &functions) const;
+
+  UnwindInfo const *unwindInfo(ModuleInfo &info, uint64_t base,
+                               uint32_t rva) const;
+
+  bool unwindEpilog(Context &context, Function const &function,
+                    UnwindInfo const &info, uint64_t base,
+                    Stack const &stack) const;
+
+  bool read(Stack const &stack, uint64_t address, uint64_t &value) const;
+
+  ReadMemory read_;
+  std::map<uint64_t, ModuleInfo> modules_; // keyed by module serial number
+};
+
+} // namespace or2
+
+#endif // OR2_X64UNWINDER_H
@@ -0,0 +1,312 @@
+/*
+NAME
+  CallTotals.cpp
+
+DESCRIPTION
+  Machine readable totals of the calls made, compared with a baseline.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "CallTotals.h"
+
+#include <bit>
+#include <charconv>
+#include <istream>
+#include <ostream>
+#include <set>
+#include <sstream>
+
+namespace or2 {
+namespace {
+
+// Latencies are counted in buckets: exactly below 16us, and above that in
+// eight buckets per power of two, so percentiles are within 12.5%
+constexpr size_t linear = 16;
+constexpr size_t perOctave = 8;
+constexpr size_t bucketCount = linear + (64 - 4) * perOctave;
+
+size_t bucket(uint64_t microseconds) {
+  if (microseconds < linear) {
+    return static_cast<size_t>(microseconds);
+  }
+  auto const octave =
+      static_cast<unsigned>(std::bit_width(microseconds)) - 1;
+  size_t const sub = (microseconds >> (octave - 3)) & (perOctave - 1);
+  return linear + (octave - 4) * perOctave + sub;
+}
+
+// The smallest latency in a bucket
+uint64_t lowest(size_t index) {
+  if (index < linear) {
+    return index;
+  }
+  size_t const octave = (index - linear) / perOctave + 4;
+  uint64_t const sub = (index - linear) % perOctave;
+  return (perOctave + sub) << (octave - 3);
+}
+
+// Split a line into its tab separated fields
+std::vector<std::string> fields(std::string const &line) {
+  std::vector<std::string> result;
+  size_t start = 0;
+  for (;;) {
+    size_t const tab = line.find('\t', start);
+    result.push_back(line.substr(start, tab - start));
+    if (tab == std::string::npos) {
+      return result;
+    }
+    start = tab + 1;
+  }
+}
+
+bool number(std::string const &text, uint64_t &value) {
+  auto const end = text.data() + text.size();
+  return !text.empty() &&
+         std::from_chars(text.data(), end, value).ptr == end;
+}
+
+// Add a change if a value exceeds its tolerance, or is an improvement
+void check(CallTotals::Key const &key, char const *what, uint64_t baseline,
+           uint64_t current, double percent, uint64_t slack,
+           std::vector<CallTotals::Change> &regressions,
+           std::vector<CallTotals::Change> &improvements) {
+  if (current > baseline) {
+    uint64_t const increase = current - baseline;
+    if (increase > slack &&
+        static_cast<double>(increase) >
+            static_cast<double>(baseline) * percent / 100) {
+      regressions.push_back({key, what, baseline, current});
+    }
+  } else if (current < baseline) {
+    improvements.push_back({key, what, baseline, current});
+  }
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+void CallTotals::Counts::add(bool error, int64_t microseconds) {
+  ++calls;
+  if (error) {
+    ++errors;
+  }
+  if (microseconds >= 0) {
+    if (latencies.empty()) {
+      latencies.resize(bucketCount);
+    }
+    ++latencies[bucket(static_cast<uint64_t>(microseconds))];
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CallTotals::Counts::add(Counts const &other) {
+  calls += other.calls;
+  errors += other.errors;
+  if (!other.latencies.empty()) {
+    if (latencies.empty()) {
+      latencies.resize(bucketCount);
+    }
+    for (size_t idx = 0; idx != bucketCount; ++idx) {
+      latencies[idx] += other.latencies[idx];
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+CallTotals::Row CallTotals::Counts::row() const {
+  Row row;
+  row.calls = calls;
+  row.errors = errors;
+  uint64_t timed{};
+  for (uint64_t const count : latencies) {
+    timed += count;
+  }
+  if (timed == 0) {
+    return row;
+  }
+  row.timed = true;
+  // Nearest rank percentiles
+  uint64_t *const results[] = {&row.p50, &row.p90, &row.p99};
+  uint64_t const ranks[] = {(timed * 50 + 99) / 100, (timed * 90 + 99) / 100,
+                            (timed * 99 + 99) / 100};
+  size_t next = 0;
+  uint64_t seen{};
+  for (size_t idx = 0; idx != latencies.size() && next != 3; ++idx) {
+    seen += latencies[idx];
+    while (next != 3 && seen >= ranks[next]) {
+      *results[next++] = lowest(idx);
+    }
+  }
+  return row;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CallTotals::add(std::string const &process, std::string const &category,
+                     std::string const &function, bool error,
+                     int64_t microseconds) {
+  functions_[Key(process, category, function)].add(error, microseconds);
+}
+
+//////////////////////////////////////////////////////////////////////////
+CallTotals::Table CallTotals::table() const {
+  std::map<Key, Counts> totals;
+  for (auto const &entry : functions_) {
+    auto const &[process, category, function] = entry.first;
+    std::set<Key> const keys{
+        entry.first,
+        Key(process, category, "*"),
+        Key(process, "*", "*"),
+        Key("*", category, function),
+        Key("*", category, "*"),
+        Key("*", "*", "*"),
+    };
+    for (auto const &key : keys) {
+      totals[key].add(entry.second);
+    }
+  }
+  Table table;
+  for (auto const &entry : totals) {
+    table[entry.first] = entry.second.row();
+  }
+  return table;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CallTotals::write(std::ostream &os, Table const &table) {
+  os << "# NtTrace call totals\n"
+        "# process\tcategory\tfunction\tcalls\terrors\tp50_us\tp90_us\t"
+        "p99_us\n";
+  for (auto const &entry : table) {
+    auto const &[process, category, function] = entry.first;
+    Row const &row = entry.second;
+    os << process << '\t' << category << '\t' << function << '\t'
+       << row.calls << '\t' << row.errors;
+    if (row.timed) {
+      os << '\t' << row.p50 << '\t' << row.p90 << '\t' << row.p99 << '\n';
+    } else {
+      os << "\t-\t-\t-\n";
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool CallTotals::read(std::istream &is, Table &table, std::string &error) {
+  table.clear();
+  std::string line;
+  for (size_t lineNumber = 1; std::getline(is, line); ++lineNumber) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::vector<std::string> const field = fields(line);
+    Row row;
+    bool ok = field.size() == 8 && number(field[3], row.calls) &&
+              number(field[4], row.errors);
+    if (ok && field[5] != "-") {
+      row.timed = true;
+      ok = number(field[5], row.p50) && number(field[6], row.p90) &&
+           number(field[7], row.p99);
+    }
+    if (!ok) {
+      error = "invalid totals at line " + std::to_string(lineNumber);
+      return false;
+    }
+    table[Key(field[0], field[1], field[2])] = row;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool CallTotals::readTolerances(std::istream &is,
+                                std::map<std::string, Tolerance> &tolerances,
+                                std::string &error) {
+  std::string line;
+  for (size_t lineNumber = 1; std::getline(is, line); ++lineNumber) {
+    std::istringstream iss(line);
+    std::string name;
+    if (!(iss >> name) || name[0] == '#') {
+      continue;
+    }
+    Tolerance tolerance;
+    if (!(iss >> tolerance.percent)) {
+      error = "invalid tolerance at line " + std::to_string(lineNumber);
+      return false;
+    }
+    if (iss >> tolerance.slack) {
+      (void)(iss >> tolerance.latency);
+    }
+    tolerances[name] = tolerance;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CallTotals::compare(Table const &baseline, Table const &current,
+                         Tolerance const &tolerance,
+                         std::map<std::string, Tolerance> const &tolerances,
+                         std::vector<Change> &regressions,
+                         std::vector<Change> &improvements) {
+  regressions.clear();
+  improvements.clear();
+  std::set<Key> keys;
+  for (auto const &entry : baseline) {
+    keys.insert(entry.first);
+  }
+  for (auto const &entry : current) {
+    keys.insert(entry.first);
+  }
+  Row const none;
+  for (auto const &key : keys) {
+    auto const before = baseline.find(key);
+    auto const after = current.find(key);
+    Row const &old = before == baseline.end() ? none : before->second;
+    Row const &now = after == current.end() ? none : after->second;
+
+    auto const &[process, category, function] = key;
+    auto found = tolerances.find(function);
+    if (function == "*" || found == tolerances.end()) {
+      found = tolerances.find(category);
+    }
+    Tolerance const &allowed =
+        found == tolerances.end() ? tolerance : found->second;
+
+    check(key, "calls", old.calls, now.calls, allowed.percent, allowed.slack,
+          regressions, improvements);
+    check(key, "errors", old.errors, now.errors, allowed.percent,
+          allowed.slack, regressions, improvements);
+    if (allowed.latency >= 0 && old.timed && now.timed) {
+      check(key, "p99 us", old.p99, now.p99, allowed.latency, 0, regressions,
+            improvements);
+    }
+  }
+}
+
+} // namespace or2
@@ -0,0 +1,186 @@
+/*
+NAME
+  ChromeTrace.cpp
+
+DESCRIPTION
+  Export of events in the Chrome trace-event format.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "ChromeTrace.h"
+
+namespace or2 {
+
+//////////////////////////////////////////////////////////////////////////
+ChromeTrace::ChromeTrace(std::string fileName, uint64_t slice)
+    : fileName_(std::move(fileName)), slice_(slice) {
+  open(0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+ChromeTrace::~ChromeTrace() { (void)close(); }
+
+//////////////////////////////////////////////////////////////////////////
+std::string ChromeTrace::sliceName(std::string const &fileName,
+                                   size_t index) {
+  size_t dot = fileName.rfind('.');
+  size_t const separator = fileName.find_last_of("/\\");
+  if (dot == std::string::npos ||
+      (separator != std::string::npos && dot < separator)) {
+    dot = fileName.size();
+  }
+  return fileName.substr(0, dot) + '-' + std::to_string(index) +
+         fileName.substr(dot);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Start writing a file, repeating the names of the known processes and
+// threads. If the file cannot be opened the failure is kept, and the
+// following events are discarded.
+void ChromeTrace::open(size_t index) {
+  index_ = index;
+  current_ = slice_ ? sliceName(fileName_, index) : fileName_;
+  os_.clear();
+  os_.open(current_);
+  if (!os_.is_open()) {
+    if (error_.empty()) {
+      error_ = current_;
+    }
+    return;
+  }
+  writer_.beginArray();
+  for (auto const &process : processes_) {
+    writeName("process_name", process.first, 0, process.second);
+  }
+  for (auto const &thread : threads_) {
+    writeName("thread_name", thread.first.first, thread.first.second,
+              thread.second);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool ChromeTrace::close() {
+  if (os_.is_open()) {
+    writer_.endArray();
+    writer_.endLine();
+    os_.close();
+    if (!os_ && error_.empty()) {
+      error_ = current_;
+    }
+  }
+  return good();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Move on to the file for the slice holding 'time'. Events are expected in
+// roughly increasing time order; an event earlier than the current slice
+// is written to the current file.
+void ChromeTrace::select(uint64_t time) {
+  if (slice_ != 0 && os_.is_open() && time / slice_ > index_) {
+    (void)close();
+    open(static_cast<size_t>(time / slice_));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ChromeTrace::beginEvent(char const *phase, uint32_t processId,
+                             uint32_t threadId, std::string const &name) {
+  writer_.newLine().beginObject();
+  writer_.member("name", name).member("ph", phase);
+  writer_.member("pid", processId).member("tid", threadId);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ChromeTrace::writeArgs(std::vector<Arg> const &args) {
+  if (!args.empty()) {
+    writer_.key("args").beginObject();
+    for (auto const &arg : args) {
+      writer_.member(arg.name, arg.value);
+    }
+    writer_.endObject();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ChromeTrace::writeName(char const *kind, uint32_t processId,
+                            uint32_t threadId, std::string const &name) {
+  beginEvent("M", processId, threadId, kind);
+  writer_.key("args").beginObject().member("name", name).endObject();
+  writer_.endObject();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ChromeTrace::processName(uint32_t processId, std::string const &name) {
+  processes_[processId] = name;
+  if (os_.is_open()) {
+    writeName("process_name", processId, 0, name);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ChromeTrace::threadName(uint32_t processId, uint32_t threadId,
+                             std::string const &name) {
+  threads_[{processId, threadId}] = name;
+  if (os_.is_open()) {
+    writeName("thread_name", processId, threadId, name);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ChromeTrace::complete(uint32_t processId, uint32_t threadId,
+                           uint64_t start, uint64_t duration,
+                           std::string const &name,
+                           std::string const &category,
+                           std::vector<Arg> const &args) {
+  select(start);
+  if (!os_.is_open()) {
+    return;
+  }
+  beginEvent("X", processId, threadId, name);
+  writer_.member("cat", category).member("ts", start).member("dur", duration);
+  writeArgs(args);
+  writer_.endObject();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ChromeTrace::instant(uint32_t processId, uint32_t threadId,
+                          uint64_t time, std::string const &name,
+                          std::string const &category,
+                          std::vector<Arg> const &args) {
+  select(time);
+  if (!os_.is_open()) {
+    return;
+  }
+  beginEvent("i", processId, threadId, name);
+  writer_.member("cat", category).member("s", "t").member("ts", time);
+  writeArgs(args);
+  writer_.endObject();
+}
+
+} // namespace or2
@@ -35,6 +35,8 @@ COPYRIGHT
 
 #include "EntryPoint.h"
 
+#include <cstdio>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <map>
@@ -46,7 +48,12 @@ COPYRIGHT
 #include <windows.h>
 
 #include "../include/DisplayError.h"
+#include "../include/HandleTable.h"
+#include "../include/JsonWriter.h"
+#include "../include/ModuleMap.h"
 #include "../include/NtDllStruct.h"
+#include "../include/SymbolCache.h"
+#include "../include/X64Trampoline.h"
 #include <SymbolEngine.h>
 
 #include "Enumerations.h"
@@ -57,6 +64,7 @@ using namespace showData;
 using or2::displayError;
 
 namespace {
+or2::SymbolEngine &getEngine(HANDLE hProcess);
 void printStackTrace(std::ostream &os, HANDLE hProcess, HANDLE hThread,
                      CONTEXT const &Context);
 std::string buffToHex(unsigned char *buffer, size_t length);
@@ -64,6 +72,76 @@ ArgType getArgType(const std::string &typeName,
                    EntryPoint::Typedefs const &typedefs);
 bool deadExport(unsigned char instruction[], size_t length);
 
+// Symbol engine for stack traces and the modules loaded, per traced process
+struct ProcessSymbols {
+  std::unique_ptr<or2::SymbolEngine> engine;
+  or2::ModuleMap modules;
+};
+std::map<HANDLE, ProcessSymbols> processSymbols;
+
+// Symbol names shared by all the traced processes
+or2::SymbolCache symbolCache;
+
+#ifdef _M_X64
+// Register-save trampolines, per traced process. Trampolines are never freed
+// as a thread may still be executing one after its jump has been removed.
+struct ProcessTrampolines {
+  unsigned char *next{}; // next free trampoline in the current block
+  unsigned char *end{};  // end of the current block
+  std::map<unsigned char *, unsigned char *> saved; // by address of the jump
+};
+std::map<HANDLE, ProcessTrampolines> processTrampolines;
+
+// Returns true if 'code', read from 'address', is the jump to the trampoline
+// for 'address' written by setTrampoline, rather than some other hook
+bool isTrampolineJump(HANDLE hProcess, unsigned char *address,
+                      unsigned char const *code) {
+  auto const process = processTrampolines.find(hProcess);
+  if (code[0] != JMP || process == processTrampolines.end()) {
+    return false;
+  }
+  auto const it = process->second.saved.find(address);
+  int32_t rel32;
+  memcpy(&rel32, code + 1, sizeof(rel32));
+  return it != process->second.saved.end() &&
+         it->second == address + or2::X64Trampoline::jumpSize + rel32;
+}
+
+// Allocate a block of executable memory in the target process below 'target'
+// and within range of a 32-bit relative jump from it
+unsigned char *allocateNear(HANDLE hProcess, unsigned char *target,
+                            size_t &size) {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  ULONG_PTR const granularity = info.dwAllocationGranularity;
+  ULONG_PTR const range = 0x7fff0000;
+  ULONG_PTR address = reinterpret_cast<ULONG_PTR>(target);
+  ULONG_PTR const lowest = address > range ? address - range : granularity;
+
+  MEMORY_BASIC_INFORMATION mbi;
+  while (address > lowest &&
+         VirtualQueryEx(hProcess, reinterpret_cast<LPCVOID>(address), &mbi,
+                        sizeof(mbi))) {
+    ULONG_PTR const start = reinterpret_cast<ULONG_PTR>(mbi.BaseAddress);
+    if (mbi.State == MEM_FREE && mbi.RegionSize >= granularity) {
+      // Use the top of the free region, nearest the target
+      ULONG_PTR const top =
+          (start + mbi.RegionSize - granularity) & ~(granularity - 1);
+      if (top >= start && top >= lowest) {
+        if (LPVOID block = VirtualAllocEx(
+                hProcess, reinterpret_cast<LPVOID>(top), granularity,
+                MEM_RESERVE | MEM_COMMIT, PAGE_EXECUTE_READ)) {
+          size = granularity;
+          return static_cast<unsigned char *>(block);
+        }
+      }
+    }
+    address = start - 1;
+  }
+  return nullptr;
+}
+#endif // _M_X64
+
 #pragma warning(push)
 #pragma warning(disable : 4592) // symbol will be dynamically initialized
 const std::map<std::string, ArgAttributes> sal_attributes = {
@@ -573,11 +651,6 @@ NtCall EntryPoint::insertBrkpt(HANDLE hProcess, unsigned char *address,
 // Attempt to set a trap for the entry point in the target DLL.
 NtCall EntryPoint::setNtTrap(HANDLE hProcess, HMODULE hTargetDll,
                              bool pre_trace, DWORD dllOffset, bool verbose) {
-#ifdef _M_X64
-  // We need the pretrace on X64 to save the volatile registers
-  pre_trace = true;
-#endif // _M_X64
-
   unsigned char *address;
   if (dllOffset != 0) {
     address = reinterpret_cast<unsigned char *>(hTargetDll) + dllOffset;
@@ -634,6 +707,7 @@ NtCall EntryPoint::setNtTrap(HANDLE hProcess, HMODULE hTargetDll,
   }
 
   unsigned char *setssn = nullptr;
+  bool trampolined = false;
   for (const auto *pCheck : signatures) {
     unsigned int offset = 0;
     setssn = nullptr;
@@ -643,6 +717,15 @@ NtCall EntryPoint::setNtTrap(HANDLE hProcess, HMODULE hTargetDll,
         preamble = offset;
         break;
       }
+#ifdef _M_X64
+      if (pCheck[0] == MOVdwordEax &&
+          isTrampolineJump(hProcess, address + offset, instruction + offset)) {
+        // already trapping with a trampoline in place of the 'mov eax,<ssn>'
+        preamble = offset;
+        trampolined = true;
+        break;
+      }
+#endif // _M_X64
       if (instruction[offset] != pCheck[0])
         break;
       if (instruction[offset] == MOVdwordEax) {
@@ -660,7 +743,7 @@ NtCall EntryPoint::setNtTrap(HANDLE hProcess, HMODULE hTargetDll,
     }
   }
 
-  if (instruction[preamble] == BRKPT) {
+  if (trampolined || instruction[preamble] == BRKPT) {
     std::cerr << "Already trapping: " << name_ << std::endl;
     return {};
   } else if (preamble == 0) {
@@ -679,17 +762,40 @@ NtCall EntryPoint::setNtTrap(HANDLE hProcess, HMODULE hTargetDll,
     std::cout << "Instrumenting " << name_ << " at: " << (void *)address
               << ", ssn: 0x" << std::hex << ssn_ << std::dec << "\n";
   }
-  return insertBrkpt(hProcess, address, preamble, pre_trace ? setssn : nullptr);
+#ifdef _M_X64
+  // We need to save the volatile registers on X64: use a trampoline unless
+  // there is a pre-trace, falling back to the pre-trace if that fails
+  bool const jumped = !pre_trace && setTrampoline(hProcess, setssn);
+  if (!jumped) {
+    pre_trace = true;
+  }
+#endif // _M_X64
+  NtCall const nt =
+      insertBrkpt(hProcess, address, preamble, pre_trace ? setssn : nullptr);
+#ifdef _M_X64
+  if (jumped && nt.entryPoint_ == nullptr) {
+    // Put back the 'mov eax,<ssn>' as the entry point is not being trapped
+    if (WriteProcessMemory(hProcess, setssn, instruction + (setssn - address),
+                           or2::X64Trampoline::jumpSize, nullptr)) {
+      FlushInstructionCache(hProcess, setssn, or2::X64Trampoline::jumpSize);
+      trampoline_ = nullptr;
+    } else {
+      std::cerr << "Cannot clear trap for " << name_ << ": " << displayError()
+                << std::endl;
+    }
+  }
+#endif // _M_X64
+  return nt;
 }
 
 //////////////////////////////////////////////////////////////////////////
 // Attempt to set a trap for the entry point in the target DLL.
 bool EntryPoint::clearNtTrap(HANDLE hProcess, NtCall const &ntCall) const {
-  if (preSave_) {
+  if (unsigned char *const setssn = preSave_ ? preSave_ : trampoline_) {
     unsigned char instruction[1 + 4];
     instruction[0] = MOVdwordEax;
     memcpy(instruction + 1, &ssn_, sizeof(ssn_));
-    if (!WriteProcessMemory(hProcess, preSave_, instruction, 5, nullptr)) {
+    if (!WriteProcessMemory(hProcess, setssn, instruction, 5, nullptr)) {
       std::cerr << "Cannot clear trap for " << name_ << ": " << displayError()
                 << std::endl;
       return false;
@@ -736,6 +842,62 @@ bool EntryPoint::clearNtTrap(HANDLE hProcess, NtCall const &ntCall) const {
   return true;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Replace the 'mov eax,<ssn>' at 'setssn' with a jump to a trampoline which
+// saves the register arguments, so no pre-call breakpoint is needed on X64.
+bool EntryPoint::setTrampoline(HANDLE hProcess, unsigned char *setssn) {
+#ifdef _M_X64
+  using or2::X64Trampoline;
+  size_t const slot = (X64Trampoline::size + 15) & ~size_t(15);
+  unsigned char jump[X64Trampoline::jumpSize];
+  ProcessTrampolines &trampolines = processTrampolines[hProcess];
+  auto it = trampolines.saved.find(setssn);
+  if (it == trampolines.saved.end()) {
+    if (static_cast<size_t>(trampolines.end - trampolines.next) < slot ||
+        !X64Trampoline::jump(jump, reinterpret_cast<uint64_t>(setssn),
+                             reinterpret_cast<uint64_t>(trampolines.next))) {
+      size_t size{};
+      unsigned char *const block = allocateNear(hProcess, setssn, size);
+      if (!block) {
+        return false;
+      }
+      trampolines.next = block;
+      trampolines.end = block + size;
+    }
+    unsigned char code[X64Trampoline::size];
+    X64Trampoline::generate(code, ssn_,
+                            reinterpret_cast<uint64_t>(setssn + 1 + 4));
+    if (!WriteProcessMemory(hProcess, trampolines.next, code, sizeof(code),
+                            nullptr)) {
+      std::cerr << "Cannot write trampoline for " << name_ << ": "
+                << displayError() << std::endl;
+      return false;
+    }
+    FlushInstructionCache(hProcess, trampolines.next, sizeof(code));
+    it = trampolines.saved.emplace(setssn, trampolines.next).first;
+    trampolines.next += slot;
+  }
+
+  if (!X64Trampoline::jump(jump, reinterpret_cast<uint64_t>(setssn),
+                           reinterpret_cast<uint64_t>(it->second))) {
+    return false;
+  }
+  if (!WriteProcessMemory(hProcess, setssn, jump, sizeof(jump), nullptr)) {
+    std::cerr << "Cannot write trap for " << name_ << ": " << displayError()
+              << std::endl;
+    return false;
+  }
+  FlushInstructionCache(hProcess, setssn, sizeof(jump));
+  trampoline_ = setssn;
+  return true;
+#else
+  // Unused arguments
+  hProcess;
+  setssn;
+  return false;
+#endif // _M_X64
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Eg "NtOpenFile", 2, "POBJECT_ATTRIBUTES", "ObjectAttributes", argIN
 void EntryPoint::setArgument(size_t argNum, ArgType eArgType,
@@ -845,7 +1007,8 @@ void EntryPoint::doPreSave(HANDLE hProcess, HANDLE hThread,
 // Trace a call to the entry point
 void EntryPoint::trace(std::ostream &os, HANDLE hProcess, HANDLE hThread,
                        CONTEXT const &Context, bool with_names,
-                       bool stack_trace, bool before) const {
+                       bool stack_trace, bool before,
+                       or2::HandleTable const *handles) const {
 #ifdef _M_IX86
   DWORD stack = Context.Esp;
   DWORD returnCode = Context.Eax;
@@ -855,21 +1018,7 @@ void EntryPoint::trace(std::ostream &os, HANDLE hProcess, HANDLE hThread,
 #endif
   os << getName() << "(";
 
-  bool success(false);
-
-  switch (retType_) {
-  case retNTSTATUS:
-    success = NT_SUCCESS(returnCode);
-    break;
-  case retULONG:
-    success = (static_cast<ULONG>(returnCode) != 0);
-    break;
-  case retULONG_PTR:
-    success = (returnCode != 0);
-    break;
-  default:
-    break;
-  }
+  bool const success(isSuccess(returnCode));
 
   if (getArgumentCount()) {
     std::set<Argument::ARG> args;
@@ -889,6 +1038,11 @@ void EntryPoint::trace(std::ostream &os, HANDLE hProcess, HANDLE hThread,
       bool const dup = !args.insert(argVal).second;
       argument.showArgument(os, hProcess, argVal, !before && success, dup,
                             with_names);
+      if (handles && argument.getArgType() == argHANDLE) {
+        if (std::string const *name = handles->find(argVal)) {
+          os << " \"" << *name << '"';
+        }
+      }
     }
   }
 
@@ -910,6 +1064,96 @@ void EntryPoint::trace(std::ostream &os, HANDLE hProcess, HANDLE hThread,
   os << std::endl;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Write a call to the entry point as JSON members. Scalar arguments are
+// written as numbers (or booleans), and every argument also has the text
+// shown by the default output.
+void EntryPoint::traceJson(or2::JsonWriter &writer, HANDLE hProcess,
+                           CONTEXT const &Context, bool before,
+                           or2::HandleTable const *handles) const {
+#ifdef _M_IX86
+  DWORD stack = Context.Esp;
+  DWORD returnCode = Context.Eax;
+#elif _M_X64
+  DWORD64 const stack = Context.Rsp;
+  DWORD64 const returnCode = Context.Rax;
+#endif
+  writer.member("function", getName()).member("category", getCategory());
+
+  bool const success(!before && isSuccess(returnCode));
+
+  if (getArgumentCount()) {
+    std::vector<Argument::ARG> argv(getArgumentCount());
+    if (!ReadProcessMemory(hProcess, (LPVOID)(stack + sizeof(Argument::ARG)),
+                           &argv[0], sizeof(Argument::ARG) * argv.size(),
+                           nullptr)) {
+      writer.member("error", "read error: " + std::to_string(GetLastError()));
+      return;
+    }
+
+    std::set<Argument::ARG> args;
+    std::ostringstream text;
+    writer.key("args").beginArray();
+    for (size_t i = 0, end = getArgumentCount(); i < end; i++) {
+      Argument::ARG const argVal = argv[i];
+      Argument const &argument = getArgument(i);
+      bool const dup = !args.insert(argVal).second;
+      text.str(std::string());
+      argument.showArgument(text, hProcess, argVal, success, dup, false);
+
+      writer.beginObject()
+          .member("name", argument.getName())
+          .member("type", argument.getArgTypeName());
+      if (argument.getArgType() == argBOOLEAN) {
+        writer.member("value", argVal != 0);
+      } else {
+        writer.member("value", static_cast<uint64_t>(argVal));
+      }
+      writer.member("text", text.view());
+      if (handles && argument.getArgType() == argHANDLE) {
+        if (std::string const *name = handles->find(argVal)) {
+          writer.member("object", *name);
+        }
+      }
+      writer.endObject();
+    }
+    writer.endArray();
+  }
+
+  if (!before) {
+    writer.member("result", static_cast<uint64_t>(returnCode));
+    if (retType_ == retNTSTATUS) {
+      char status[2 + 8 + 1];
+      snprintf(status, sizeof(status), "0x%08lx",
+               static_cast<unsigned long>(returnCode));
+      writer.member("status", status);
+      if (IS_ERROR(returnCode)) {
+        const auto nt = static_cast<NTSTATUS>(returnCode);
+        std::string const message = winErrorMessage(
+            static_cast<HRESULT>(RtlNtStatusToDosError(nt)));
+        if (!message.empty()) {
+          writer.member("message", message);
+        }
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Returns true if the return code is a successful result
+bool EntryPoint::isSuccess(ULONG_PTR returnCode) const {
+  switch (retType_) {
+  case retNTSTATUS:
+    return NT_SUCCESS(returnCode);
+  case retULONG:
+    return static_cast<ULONG>(returnCode) != 0;
+  case retULONG_PTR:
+    return returnCode != 0;
+  default:
+    return false;
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Sort by category and then by name
 bool EntryPoint::operator<(EntryPoint const &rhs) const {
@@ -933,19 +1177,87 @@ void EntryPoint::stackTrace(std::ostream &os, HANDLE hProcess, HANDLE hThread) {
   }
 }
 
-namespace {
-void printStackTrace(std::ostream &os, HANDLE hProcess, HANDLE hThread,
-                     CONTEXT const &Context) {
-  static std::map<HANDLE, std::unique_ptr<or2::SymbolEngine>> engines;
+//////////////////////////////////////////////////////////////////////////
+// static
+void EntryPoint::setSymbolCacheLimit(size_t maxBytes) {
+  symbolCache.setLimit(maxBytes);
+}
 
-  auto &pEngine = engines[hProcess];
+//////////////////////////////////////////////////////////////////////////
+// static
+void EntryPoint::releaseProcess(HANDLE hProcess) {
+  processSymbols.erase(hProcess);
+#ifdef _M_X64
+  processTrampolines.erase(hProcess);
+#endif // _M_X64
+}
+
+//////////////////////////////////////////////////////////////////////////
+// static
+void EntryPoint::moduleLoaded(HANDLE hProcess, PVOID base,
+                              std::string const &name) {
+  // SizeOfImage and CheckSum are at the same offset in the 32- and 64-bit
+  // optional headers
+  IMAGE_DOS_HEADER dosHeader;
+  IMAGE_NT_HEADERS32 ntHeaders;
+  if (!ReadProcessMemory(hProcess, base, &dosHeader, sizeof(dosHeader),
+                         nullptr) ||
+      dosHeader.e_magic != IMAGE_DOS_SIGNATURE ||
+      !ReadProcessMemory(hProcess, (char *)base + dosHeader.e_lfanew,
+                         &ntHeaders, sizeof(ntHeaders), nullptr) ||
+      ntHeaders.Signature != IMAGE_NT_SIGNATURE) {
+    return;
+  }
+  processSymbols[hProcess].modules.add(
+      reinterpret_cast<uint64_t>(base), ntHeaders.OptionalHeader.SizeOfImage,
+      name, ntHeaders.FileHeader.TimeDateStamp,
+      ntHeaders.OptionalHeader.CheckSum);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// static
+void EntryPoint::moduleUnloaded(HANDLE hProcess, PVOID base) {
+  const auto it = processSymbols.find(hProcess);
+  if (it != processSymbols.end()) {
+    it->second.modules.remove(reinterpret_cast<uint64_t>(base));
+    if (it->second.engine) {
+      it->second.engine->moduleUnloaded(reinterpret_cast<DWORD64>(base));
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// static
+void EntryPoint::stackFunctions(HANDLE hProcess, HANDLE hThread,
+                                CONTEXT const &Context,
+                                std::vector<std::string> &functions) {
+  or2::SymbolEngine const &engine = getEngine(hProcess);
+  std::vector<DWORD64> frames;
+  engine.StackFrames(hThread, Context, frames);
+  functions.clear();
+  for (const DWORD64 frame : frames) {
+    functions.push_back(engine.functionName(frame));
+  }
+}
+
+namespace {
+or2::SymbolEngine &getEngine(HANDLE hProcess) {
+  auto &symbols = processSymbols[hProcess];
+  auto &pEngine = symbols.engine;
   if (!pEngine) {
     pEngine = std::make_unique<or2::SymbolEngine>(hProcess);
+    pEngine->setSymbolCache(&symbolCache);
+    pEngine->setModuleMap(&symbols.modules);
     // Ensure ntdll.dll is in place (early on dbghelp doesn't find it)
     pEngine->LoadModule64(nullptr, "ntdll.dll", nullptr,
                           (DWORD64)GetModuleHandle("ntdll.dll"), 0);
   }
-  pEngine->StackTrace(hThread, Context, os);
+  return *pEngine;
+}
+
+void printStackTrace(std::ostream &os, HANDLE hProcess, HANDLE hThread,
+                     CONTEXT const &Context) {
+  getEngine(hProcess).StackTrace(hThread, Context, os);
 }
 
 bool isBlankOrComment(std::string const &lbuf) {
@@ -0,0 +1,170 @@
+/*
+NAME
+  FileIoStats.cpp
+
+DESCRIPTION
+  Aggregation of file I/O calls by file path.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "FileIoStats.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <ostream>
+
+namespace or2 {
+
+//////////////////////////////////////////////////////////////////////////
+uint64_t FileIoStats::File::total() const {
+  uint64_t result = 0;
+  for (uint64_t count : calls) {
+    result += count;
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void FileIoStats::add(std::string const &path, Op op, uint64_t requested,
+                      uint64_t transferred, int64_t microseconds) {
+  File &file = files_[path];
+  if (file.path.empty()) {
+    file.path = path;
+  }
+  ++file.calls[op];
+  if (op == Read) {
+    file.bytesRead += transferred;
+  } else if (op == Write) {
+    file.bytesWritten += transferred;
+  }
+  if (op == Read || op == Write) {
+    ++file.sizes[bucket(requested)];
+  }
+  if (microseconds >= 0) {
+    ++file.timed;
+    file.microseconds += static_cast<uint64_t>(microseconds);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::vector<FileIoStats::File const *> FileIoStats::top(size_t count) const {
+  std::vector<File const *> result;
+  result.reserve(files_.size());
+  for (auto const &entry : files_) {
+    result.push_back(&entry.second);
+  }
+  auto const busier = [](File const *lhs, File const *rhs) {
+    uint64_t const lhsTotal = lhs->total();
+    uint64_t const rhsTotal = rhs->total();
+    return lhsTotal != rhsTotal ? lhsTotal > rhsTotal : lhs->path < rhs->path;
+  };
+  if (count < result.size()) {
+    std::partial_sort(result.begin(), result.begin() + count, result.end(),
+                      busier);
+    result.resize(count);
+  } else {
+    std::sort(result.begin(), result.end(), busier);
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+size_t FileIoStats::bucket(uint64_t requested) {
+  size_t result = 0;
+  for (uint64_t limit = 16; result + 1 != sizeBuckets && requested >= limit;
+       limit *= 16) {
+    ++result;
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+char const *FileIoStats::bucketName(size_t bucket) {
+  static char const *const names[sizeBuckets] = {"<16",  "<256", "<4K",
+                                                 "<64K", "<1M",  ">=1M"};
+  return bucket < sizeBuckets ? names[bucket] : "?";
+}
+
+//////////////////////////////////////////////////////////////////////////
+void FileIoStats::report(std::ostream &os, size_t count) const {
+  auto const flags = os.flags();
+  auto const precision = os.precision();
+  os << "\nFile I/O for " << files_.size() << " files\n";
+  os << std::setw(8) << "Calls" << std::setw(8) << "Opens" << std::setw(8)
+     << "Reads" << std::setw(8) << "Writes" << std::setw(8) << "Queries"
+     << std::setw(12) << "Read" << std::setw(12) << "Written" << std::setw(10)
+     << "Time ms"
+     << "  Path\n";
+  os << std::fixed << std::setprecision(3);
+  for (File const *file : top(count)) {
+    os << std::setw(8) << file->total() << std::setw(8) << file->calls[Open]
+       << std::setw(8) << file->calls[Read] << std::setw(8)
+       << file->calls[Write] << std::setw(8) << file->calls[Query]
+       << std::setw(12) << file->bytesRead << std::setw(12)
+       << file->bytesWritten << std::setw(10);
+    if (file->timed) {
+      os << static_cast<double>(file->microseconds) / 1000;
+    } else {
+      os << '-';
+    }
+    os << "  " << file->path << '\n';
+
+    bool sized(false);
+    for (size_t idx = 0; idx != sizeBuckets; ++idx) {
+      if (file->sizes[idx]) {
+        os << (sized ? " " : "          sizes: ") << bucketName(idx) << ':'
+           << file->sizes[idx];
+        sized = true;
+      }
+    }
+    if (sized) {
+      os << '\n';
+    }
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+
+//////////////////////////////////////////////////////////////////////////
+FileIoStats::Op FileIoStats::operation(std::string const &function) {
+  static std::map<std::string, Op> const operations = {
+      {"NtCreateFile", Open},
+      {"NtOpenFile", Open},
+      {"NtQueryInformationFile", Query},
+      {"NtReadFile", Read},
+      {"NtReadFileScatter", Read},
+      {"NtWriteFile", Write},
+      {"NtWriteFileGather", Write},
+  };
+  auto const it = operations.find(function);
+  return it == operations.end() ? OpCount : it->second;
+}
+
+} // namespace or2
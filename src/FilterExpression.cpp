@@ -0,0 +1,868 @@
+/*
+NAME
+  FilterExpression.cpp
+
+DESCRIPTION
+  Filter expressions selecting the calls to trace.
+
+NOTES
+  The grammar is:
+
+    expression := and-expr { "||" and-expr }
+    and-expr   := unary { "&&" unary }
+    unary      := "!" unary | comparison
+    comparison := primary [ op primary ]
+    primary    := "(" expression ")" | identifier | integer | string
+    op         := "==" | "!=" | "<" | "<=" | ">" | ">=" | "~" | "!~"
+
+  An identifier names a field of the call ("status", "error", "pid", "tid",
+  "function", "category", or the name of an argument). A bare identifier
+  that is not a field matches calls to the entry point of that name.
+  An identifier that is neither a field of any entry point nor the name of
+  one is reported as an error by check().
+  String comparisons ignore case and "~" matches a wildcard pattern using
+  '*' and '?'. A comparison using a field the entry point does not have, or
+  comparing a string with an integer, is false.
+
+  The expression is compiled for each entry point: fields that are constant
+  for the entry point are folded, and the operands of "&&" and "||" are
+  ordered so the cheapest are tested first.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "FilterExpression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+namespace or2 {
+
+//////////////////////////////////////////////////////////////////////////
+/** Node of the parsed expression */
+struct FilterExpression::Node {
+  enum Kind { Identifier, Integer, String, Not, And, Or, Compare };
+  enum Relation { Eq, Ne, Lt, Le, Gt, Ge, Match, NoMatch };
+
+  Kind kind;
+  Relation relation{Eq};                       // for Compare
+  std::string text;                            // for Identifier and String
+  int64_t value{};                             // for Integer
+  std::vector<std::unique_ptr<Node>> operands; // for Not, And, Or, Compare
+
+  explicit Node(Kind kind) : kind(kind) {}
+};
+
+namespace {
+
+using Node = FilterExpression::Node;
+
+//////////////////////////////////////////////////////////////////////////
+// ASCII case-insensitive comparisons (file and function names)
+
+char lower(char ch) {
+  return static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+}
+
+bool equalNoCase(std::string const &lhs, std::string const &rhs) {
+  return lhs.size() == rhs.size() &&
+         std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+                    [](char l, char r) { return lower(l) == lower(r); });
+}
+
+// Match 'text' against a pattern using '*' and '?' wildcards
+bool wildcardMatch(std::string const &pattern, std::string const &text) {
+  size_t p = 0, t = 0;
+  size_t star = std::string::npos, mark = 0;
+  while (t < text.size()) {
+    if (p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      mark = t;
+    } else if (p < pattern.size() &&
+               (pattern[p] == '?' || lower(pattern[p]) == lower(text[t]))) {
+      ++p;
+      ++t;
+    } else if (star != std::string::npos) {
+      p = star + 1;
+      t = ++mark;
+    } else {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*') {
+    ++p;
+  }
+  return p == pattern.size();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Recursive descent parser
+class Parser {
+public:
+  explicit Parser(std::string const &text) : text_(text) {}
+
+  std::unique_ptr<Node> parse() {
+    auto result = expression();
+    skipSpace();
+    if (pos_ != text_.size()) {
+      fail("unexpected text");
+    }
+    return result;
+  }
+
+private:
+  std::unique_ptr<Node> expression() {
+    return binary(Node::Or, "||", &Parser::andExpression);
+  }
+
+  std::unique_ptr<Node> andExpression() {
+    return binary(Node::And, "&&", &Parser::unary);
+  }
+
+  std::unique_ptr<Node> binary(Node::Kind kind, char const *op,
+                               std::unique_ptr<Node> (Parser::*next)()) {
+    auto lhs = (this->*next)();
+    if (!accept(op)) {
+      return lhs;
+    }
+    auto result = std::make_unique<Node>(kind);
+    result->operands.push_back(std::move(lhs));
+    do {
+      result->operands.push_back((this->*next)());
+    } while (accept(op));
+    return result;
+  }
+
+  std::unique_ptr<Node> unary() {
+    skipSpace();
+    if (peek("!") && !peek("!~") && !peek("!=")) {
+      ++pos_;
+      auto result = std::make_unique<Node>(Node::Not);
+      result->operands.push_back(unary());
+      return result;
+    }
+    return comparison();
+  }
+
+  std::unique_ptr<Node> comparison() {
+    static const std::pair<char const *, Node::Relation> relations[] = {
+        {"==", Node::Eq}, {"!=", Node::Ne},     {"<=", Node::Le},
+        {">=", Node::Ge}, {"!~", Node::NoMatch}, {"<", Node::Lt},
+        {">", Node::Gt},  {"~", Node::Match},
+    };
+    auto lhs = primary();
+    for (auto const &relation : relations) {
+      if (accept(relation.first)) {
+        auto result = std::make_unique<Node>(Node::Compare);
+        result->relation = relation.second;
+        result->operands.push_back(std::move(lhs));
+        result->operands.push_back(primary());
+        return result;
+      }
+    }
+    return lhs;
+  }
+
+  std::unique_ptr<Node> primary() {
+    skipSpace();
+    if (pos_ == text_.size()) {
+      fail("unexpected end of expression");
+    }
+    char const ch = text_[pos_];
+    if (ch == '(') {
+      ++pos_;
+      auto result = expression();
+      if (!accept(")")) {
+        fail("expected ')'");
+      }
+      return result;
+    }
+    if (ch == '"' || ch == '\'') {
+      return string(ch);
+    }
+    if (std::isdigit(static_cast<unsigned char>(ch)) ||
+        (ch == '-' && pos_ + 1 < text_.size() &&
+         std::isdigit(static_cast<unsigned char>(text_[pos_ + 1])))) {
+      return integer();
+    }
+    if (std::isalpha(static_cast<unsigned char>(ch)) || ch == '_') {
+      auto result = std::make_unique<Node>(Node::Identifier);
+      while (pos_ < text_.size() &&
+             (std::isalnum(static_cast<unsigned char>(text_[pos_])) ||
+              text_[pos_] == '_')) {
+        result->text += text_[pos_++];
+      }
+      return result;
+    }
+    fail("unexpected character");
+  }
+
+  // Backslash only escapes the quote and itself, so Windows paths can
+  // usually be written without doubling the backslashes
+  std::unique_ptr<Node> string(char quote) {
+    size_t const start = pos_++;
+    auto result = std::make_unique<Node>(Node::String);
+    for (;;) {
+      if (pos_ == text_.size()) {
+        pos_ = start;
+        fail("unterminated string");
+      }
+      char ch = text_[pos_++];
+      if (ch == quote) {
+        break;
+      }
+      if (ch == '\\' && pos_ < text_.size() &&
+          (text_[pos_] == quote || text_[pos_] == '\\')) {
+        ch = text_[pos_++];
+      }
+      result->text += ch;
+    }
+    return result;
+  }
+
+  std::unique_ptr<Node> integer() {
+    size_t const start = pos_;
+    bool const negative = text_[pos_] == '-';
+    if (negative) {
+      ++pos_;
+    }
+    int base = 10;
+    if (text_.compare(pos_, 2, "0x") == 0 || text_.compare(pos_, 2, "0X") == 0) {
+      base = 16;
+      pos_ += 2;
+    }
+    uint64_t value = 0;
+    size_t const first = pos_;
+    while (pos_ < text_.size() &&
+           std::isxdigit(static_cast<unsigned char>(text_[pos_]))) {
+      char const ch = lower(text_[pos_]);
+      unsigned const digit = std::isdigit(static_cast<unsigned char>(ch))
+                                 ? ch - '0'
+                                 : ch - 'a' + 10;
+      if (digit >= static_cast<unsigned>(base)) {
+        break;
+      }
+      if (value > (UINT64_MAX - digit) / base) {
+        pos_ = start;
+        fail("integer too large");
+      }
+      value = value * base + digit;
+      ++pos_;
+    }
+    if (pos_ == first || (pos_ < text_.size() &&
+                          (std::isalnum(static_cast<unsigned char>(text_[pos_])) ||
+                           text_[pos_] == '_'))) {
+      pos_ = start;
+      fail("invalid integer");
+    }
+    auto result = std::make_unique<Node>(Node::Integer);
+    result->value = static_cast<int64_t>(negative ? 0 - value : value);
+    return result;
+  }
+
+  void skipSpace() {
+    while (pos_ < text_.size() &&
+           std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+      ++pos_;
+    }
+  }
+
+  bool peek(char const *token) const {
+    return text_.compare(pos_, std::char_traits<char>::length(token), token) ==
+           0;
+  }
+
+  bool accept(char const *token) {
+    skipSpace();
+    if (!peek(token)) {
+      return false;
+    }
+    pos_ += std::char_traits<char>::length(token);
+    return true;
+  }
+
+  [[noreturn]] void fail(char const *message) const {
+    throw std::runtime_error(std::string("Invalid filter expression: ") +
+                             message + " at offset " + std::to_string(pos_) +
+                             " in '" + text_ + "'");
+  }
+
+  std::string const &text_;
+  size_t pos_{};
+};
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+/** Compile an expression for one entry point */
+class FilterCompiler {
+public:
+  FilterCompiler(FilterTarget const &target, FilterProgram &program)
+      : target_(target), program_(program) {}
+
+  void compile(Node const &root) {
+    emit(root);
+    program_.intStack_.resize(static_cast<size_t>(maxInts_));
+    program_.stringStack_.resize(static_cast<size_t>(maxStrings_));
+    program_.fetched_.resize(program_.stringFields_.size());
+    program_.fetchState_.resize(program_.stringFields_.size());
+  }
+
+private:
+  using Op = FilterProgram::Op;
+
+  // The value of an identifier or literal for this entry point
+  struct Operand {
+    enum Kind { Missing, IntConst, StringConst, IntField, StringField };
+    Kind kind{Missing};
+    int64_t value{};
+    std::string text;
+    unsigned field{};
+
+    bool isConst() const { return kind == IntConst || kind == StringConst; }
+    bool isString() const { return kind == StringConst || kind == StringField; }
+  };
+
+  Operand resolve(Node const &node) const {
+    Operand result;
+    if (node.kind == Node::Integer) {
+      result.kind = Operand::IntConst;
+      result.value = node.value;
+    } else if (node.kind == Node::String) {
+      result.kind = Operand::StringConst;
+      result.text = node.text;
+    } else if (node.kind == Node::Identifier) {
+      static const std::pair<char const *, unsigned> fields[] = {
+          {"status", FilterContext::fieldStatus},
+          {"error", FilterContext::fieldError},
+          {"pid", FilterContext::fieldPid},
+          {"tid", FilterContext::fieldTid},
+      };
+      for (auto const &field : fields) {
+        if (equalNoCase(node.text, field.first)) {
+          result.kind = Operand::IntField;
+          result.field = field.second;
+          return result;
+        }
+      }
+      if (equalNoCase(node.text, "function")) {
+        result.kind = Operand::StringConst;
+        result.text = target_.function;
+      } else if (equalNoCase(node.text, "category")) {
+        result.kind = Operand::StringConst;
+        result.text = target_.category;
+      } else {
+        for (size_t idx = 0; idx != target_.arguments.size(); ++idx) {
+          auto const &argument = target_.arguments[idx];
+          if (equalNoCase(node.text, argument.name)) {
+            result.kind = argument.isString ? Operand::StringField
+                                            : Operand::IntField;
+            result.field =
+                FilterContext::fieldArgument + static_cast<unsigned>(idx);
+            break;
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+  // Evaluate the node if it is constant for this entry point:
+  // returns 0 or 1, or -1 if the value depends on the call
+  int fold(Node const &node) const {
+    switch (node.kind) {
+    case Node::Integer:
+      return node.value != 0;
+    case Node::String:
+      return !node.text.empty();
+    case Node::Identifier: {
+      Operand const operand = resolve(node);
+      switch (operand.kind) {
+      case Operand::Missing:
+        return equalNoCase(node.text, target_.function);
+      case Operand::IntConst:
+        return operand.value != 0;
+      case Operand::StringConst:
+        return !operand.text.empty();
+      default:
+        return -1;
+      }
+    }
+    case Node::Not: {
+      int const value = fold(*node.operands[0]);
+      return value < 0 ? -1 : !value;
+    }
+    case Node::And:
+    case Node::Or: {
+      // The value that decides the result: 0 for && and 1 for ||
+      int const decisive = node.kind == Node::Or;
+      int result = !decisive;
+      for (auto const &operand : node.operands) {
+        int const value = fold(*operand);
+        if (value == decisive) {
+          return decisive;
+        }
+        if (value < 0) {
+          result = -1;
+        }
+      }
+      return result;
+    }
+    case Node::Compare: {
+      Operand const lhs = resolve(*node.operands[0]);
+      Operand const rhs = resolve(*node.operands[1]);
+      if (!valid(node.relation, lhs, rhs)) {
+        return 0;
+      }
+      if (!lhs.isConst() || !rhs.isConst()) {
+        return -1;
+      }
+      if (lhs.isString()) {
+        return compare(node.relation, lhs.text, rhs.text);
+      }
+      return compare(node.relation, lhs.value, rhs.value);
+    }
+    }
+    return -1;
+  }
+
+  static bool valid(Node::Relation relation, Operand const &lhs,
+                    Operand const &rhs) {
+    if (lhs.kind == Operand::Missing || rhs.kind == Operand::Missing ||
+        lhs.isString() != rhs.isString()) {
+      return false;
+    }
+    switch (relation) {
+    case Node::Lt:
+    case Node::Le:
+    case Node::Gt:
+    case Node::Ge:
+      return !lhs.isString();
+    case Node::Match:
+    case Node::NoMatch:
+      return lhs.isString();
+    default:
+      return true;
+    }
+  }
+
+  static int compare(Node::Relation relation, int64_t lhs, int64_t rhs) {
+    switch (relation) {
+    case Node::Eq:
+      return lhs == rhs;
+    case Node::Ne:
+      return lhs != rhs;
+    case Node::Lt:
+      return lhs < rhs;
+    case Node::Le:
+      return lhs <= rhs;
+    case Node::Gt:
+      return lhs > rhs;
+    case Node::Ge:
+      return lhs >= rhs;
+    default:
+      return 0;
+    }
+  }
+
+  static int compare(Node::Relation relation, std::string const &lhs,
+                     std::string const &rhs) {
+    switch (relation) {
+    case Node::Eq:
+      return equalNoCase(lhs, rhs);
+    case Node::Ne:
+      return !equalNoCase(lhs, rhs);
+    case Node::Match:
+      return wildcardMatch(rhs, lhs);
+    case Node::NoMatch:
+      return !wildcardMatch(rhs, lhs);
+    default:
+      return 0;
+    }
+  }
+
+  // Relative cost of evaluating a node that is not constant
+  int cost(Node const &node) const {
+    switch (node.kind) {
+    case Node::Identifier:
+      return resolve(node).kind == Operand::StringField ? 100 : 1;
+    case Node::Compare: {
+      int result = 1;
+      for (auto const &operand : node.operands) {
+        if (resolve(*operand).kind == Operand::StringField) {
+          result += 100;
+        }
+      }
+      return result;
+    }
+    default: {
+      int result = 1;
+      for (auto const &operand : node.operands) {
+        result += cost(*operand);
+      }
+      return result;
+    }
+    }
+  }
+
+  // Emit code leaving the (integer) value of the node on the stack
+  void emit(Node const &node) {
+    int const value = fold(node);
+    if (value >= 0) {
+      pushInt(value);
+      return;
+    }
+    switch (node.kind) {
+    case Node::Identifier: {
+      Operand const operand = resolve(node);
+      load(operand);
+      if (operand.isString()) {
+        op(Op::StrTruth, 0, 1, -1);
+      }
+      break;
+    }
+    case Node::Not:
+      emit(*node.operands[0]);
+      op(Op::Not, 0, 0, 0);
+      break;
+    case Node::And:
+    case Node::Or: {
+      // Operands that cannot decide the result are dropped (folding shows
+      // at least one is not constant) and the rest ordered by cost
+      int const decisive = node.kind == Node::Or;
+      std::vector<std::pair<int, Node const *>> operands;
+      for (auto const &operand : node.operands) {
+        if (fold(*operand) != !decisive) {
+          operands.emplace_back(cost(*operand), operand.get());
+        }
+      }
+      std::stable_sort(
+          operands.begin(), operands.end(),
+          [](auto const &lhs, auto const &rhs) { return lhs.first < rhs.first; });
+      std::vector<size_t> jumps;
+      for (size_t idx = 0; idx != operands.size(); ++idx) {
+        emit(*operands[idx].second);
+        if (idx + 1 != operands.size()) {
+          jumps.push_back(program_.code_.size());
+          op(decisive ? Op::JumpIfTrue : Op::JumpIfFalse, 0, -1, 0);
+        }
+      }
+      for (size_t jump : jumps) {
+        program_.code_[jump].operand =
+            static_cast<uint32_t>(program_.code_.size());
+      }
+      break;
+    }
+    case Node::Compare: {
+      static const Op intOps[] = {Op::Eq, Op::Ne, Op::Lt, Op::Le, Op::Gt, Op::Ge};
+      static const Op stringOps[] = {Op::StrEq, Op::StrNe, Op::StrEq,
+                                     Op::StrEq, Op::StrEq, Op::StrEq,
+                                     Op::Match, Op::NoMatch};
+      Operand const lhs = resolve(*node.operands[0]);
+      Operand const rhs = resolve(*node.operands[1]);
+      load(lhs);
+      load(rhs);
+      if (lhs.isString()) {
+        op(stringOps[node.relation], 0, 1, -2);
+      } else {
+        op(intOps[node.relation], 0, -1, 0);
+      }
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  void pushInt(int64_t value) {
+    auto &integers = program_.integers_;
+    auto it = std::find(integers.begin(), integers.end(), value);
+    if (it == integers.end()) {
+      it = integers.insert(integers.end(), value);
+    }
+    op(Op::PushInt, static_cast<uint32_t>(it - integers.begin()), 1, 0);
+  }
+
+  void load(Operand const &operand) {
+    switch (operand.kind) {
+    case Operand::IntConst:
+      pushInt(operand.value);
+      break;
+    case Operand::StringConst: {
+      auto &strings = program_.strings_;
+      auto it = std::find(strings.begin(), strings.end(), operand.text);
+      if (it == strings.end()) {
+        it = strings.insert(strings.end(), operand.text);
+      }
+      op(Op::PushString, static_cast<uint32_t>(it - strings.begin()), 0, 1);
+      break;
+    }
+    case Operand::IntField:
+      op(Op::LoadInt, operand.field, 1, 0);
+      break;
+    case Operand::StringField: {
+      auto &fields = program_.stringFields_;
+      auto it = std::find(fields.begin(), fields.end(), operand.field);
+      if (it == fields.end()) {
+        it = fields.insert(fields.end(), operand.field);
+      }
+      op(Op::LoadString, static_cast<uint32_t>(it - fields.begin()), 0, 1);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  // Add an instruction, tracking the depth of the two stacks
+  void op(Op code, uint32_t operand, int intDelta, int stringDelta) {
+    program_.code_.push_back({code, operand});
+    ints_ += intDelta;
+    strings_ += stringDelta;
+    maxInts_ = std::max(maxInts_, ints_);
+    maxStrings_ = std::max(maxStrings_, strings_);
+  }
+
+  FilterTarget const &target_;
+  FilterProgram &program_;
+  int ints_{};
+  int strings_{};
+  int maxInts_{};
+  int maxStrings_{};
+};
+
+//////////////////////////////////////////////////////////////////////////
+FilterExpression::FilterExpression(std::string const &text)
+    : text_(text), root_(Parser(text).parse()) {}
+
+FilterExpression::~FilterExpression() = default;
+
+FilterProgram FilterExpression::compile(FilterTarget const &target) const {
+  FilterProgram result;
+  FilterCompiler(target, result).compile(*root_);
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+namespace {
+// Find the first identifier in the node that no target knows
+Node const *unknownIdentifier(Node const &node,
+                              std::vector<FilterTarget> const &targets) {
+  if (node.kind != Node::Identifier) {
+    for (auto const &operand : node.operands) {
+      if (Node const *unknown = unknownIdentifier(*operand, targets)) {
+        return unknown;
+      }
+    }
+    return nullptr;
+  }
+  for (char const *field :
+       {"status", "error", "pid", "tid", "function", "category"}) {
+    if (equalNoCase(node.text, field)) {
+      return nullptr;
+    }
+  }
+  for (auto const &target : targets) {
+    if (equalNoCase(node.text, target.function)) {
+      return nullptr;
+    }
+    for (auto const &argument : target.arguments) {
+      if (equalNoCase(node.text, argument.name)) {
+        return nullptr;
+      }
+    }
+  }
+  return &node;
+}
+} // namespace
+
+void FilterExpression::check(std::vector<FilterTarget> const &targets) const {
+  if (Node const *unknown = unknownIdentifier(*root_, targets)) {
+    throw std::runtime_error("Invalid filter expression: unknown identifier '" +
+                             unknown->text + "' in '" + text_ + "'");
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool FilterProgram::evaluate(FilterContext &context) const {
+  int64_t *ints = intStack_.data();
+  std::string const **strings = stringStack_.data();
+  size_t ni = 0, ns = 0;
+  std::fill(fetchState_.begin(), fetchState_.end(), 0);
+
+  for (size_t pc = 0; pc != code_.size(); ++pc) {
+    Instruction const &instruction = code_[pc];
+    switch (instruction.op) {
+    case Op::PushInt:
+      ints[ni++] = integers_[instruction.operand];
+      break;
+    case Op::PushString:
+      strings[ns++] = &strings_[instruction.operand];
+      break;
+    case Op::LoadInt:
+      ints[ni++] = context.integer(instruction.operand);
+      break;
+    case Op::LoadString: {
+      // Each string field is read at most once per evaluation
+      unsigned const slot = instruction.operand;
+      if (fetchState_[slot] == 0) {
+        fetchState_[slot] =
+            context.string(stringFields_[slot], fetched_[slot]) ? 1 : 2;
+      }
+      strings[ns++] = fetchState_[slot] == 1 ? &fetched_[slot] : nullptr;
+      break;
+    }
+    case Op::Eq:
+      --ni;
+      ints[ni - 1] = ints[ni - 1] == ints[ni];
+      break;
+    case Op::Ne:
+      --ni;
+      ints[ni - 1] = ints[ni - 1] != ints[ni];
+      break;
+    case Op::Lt:
+      --ni;
+      ints[ni - 1] = ints[ni - 1] < ints[ni];
+      break;
+    case Op::Le:
+      --ni;
+      ints[ni - 1] = ints[ni - 1] <= ints[ni];
+      break;
+    case Op::Gt:
+      --ni;
+      ints[ni - 1] = ints[ni - 1] > ints[ni];
+      break;
+    case Op::Ge:
+      --ni;
+      ints[ni - 1] = ints[ni - 1] >= ints[ni];
+      break;
+    case Op::StrEq:
+    case Op::StrNe:
+    case Op::Match:
+    case Op::NoMatch: {
+      // An unavailable string does not match anything
+      std::string const *rhs = strings[--ns];
+      std::string const *lhs = strings[--ns];
+      bool result = false;
+      if (lhs && rhs) {
+        switch (instruction.op) {
+        case Op::StrEq:
+          result = equalNoCase(*lhs, *rhs);
+          break;
+        case Op::StrNe:
+          result = !equalNoCase(*lhs, *rhs);
+          break;
+        case Op::Match:
+          result = wildcardMatch(*rhs, *lhs);
+          break;
+        default:
+          result = !wildcardMatch(*rhs, *lhs);
+          break;
+        }
+      }
+      ints[ni++] = result;
+      break;
+    }
+    case Op::StrTruth: {
+      std::string const *value = strings[--ns];
+      ints[ni++] = value && !value->empty();
+      break;
+    }
+    case Op::Not:
+      ints[ni - 1] = !ints[ni - 1];
+      break;
+    case Op::JumpIfFalse:
+      if (ints[ni - 1] == 0) {
+        pc = instruction.operand - 1;
+      } else {
+        --ni;
+      }
+      break;
+    case Op::JumpIfTrue:
+      if (ints[ni - 1] != 0) {
+        pc = instruction.operand - 1;
+      } else {
+        --ni;
+      }
+      break;
+    }
+  }
+  return ni != 0 && ints[ni - 1] != 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool FilterProgram::alwaysFalse() const {
+  return code_.size() == 1 && code_[0].op == Op::PushInt &&
+         integers_[code_[0].operand] == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool FilterProgram::alwaysTrue() const {
+  return code_.size() == 1 && code_[0].op == Op::PushInt &&
+         integers_[code_[0].operand] != 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void FilterProgram::print(std::ostream &os) const {
+  static char const *const names[] = {
+      "PushInt", "PushString", "LoadInt", "LoadString", "Eq",
+      "Ne",      "Lt",         "Le",      "Gt",         "Ge",
+      "StrEq",   "StrNe",      "Match",   "NoMatch",    "StrTruth",
+      "Not",     "JumpIfFalse", "JumpIfTrue",
+  };
+  for (size_t pc = 0; pc != code_.size(); ++pc) {
+    Instruction const &instruction = code_[pc];
+    os << pc << ": " << names[static_cast<int>(instruction.op)];
+    switch (instruction.op) {
+    case Op::PushInt:
+      os << ' ' << integers_[instruction.operand];
+      break;
+    case Op::PushString:
+      os << " \"" << strings_[instruction.operand] << '"';
+      break;
+    case Op::LoadInt:
+      os << " field " << instruction.operand;
+      break;
+    case Op::LoadString:
+      os << " field " << stringFields_[instruction.operand];
+      break;
+    case Op::JumpIfFalse:
+    case Op::JumpIfTrue:
+      os << ' ' << instruction.operand;
+      break;
+    default:
+      break;
+    }
+    os << '\n';
+  }
+}
+
+} // namespace or2
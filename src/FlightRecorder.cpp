@@ -0,0 +1,335 @@
+/*
+NAME
+  FlightRecorder.cpp
+
+DESCRIPTION
+  Fixed size in-memory record of the most recent calls made by a process.
+
+NOTES
+  Records in the ring are stored in host byte order. A dump file is written
+  in little endian byte order:
+
+    "NTFR"    magic number
+    u32       format version (1)
+    u32       process ID
+    u64       ticks per second
+    string    reason for the dump
+    u32       number of names, followed by the names as strings
+    u32       number of records, followed by the records:
+      u64     time
+      u32     thread ID
+      u32     entry point name index
+      u64     result
+      u32     number of arguments, followed by the arguments as u64
+
+  where a string is a u32 length followed by the characters.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "FlightRecorder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+
+namespace or2 {
+namespace {
+
+char const magic[4] = {'N', 'T', 'F', 'R'};
+uint32_t const version = 1;
+
+// Limit on counts read from a dump, to reject corrupt files cheaply
+uint32_t const maxCount = 0x10000000;
+
+//////////////////////////////////////////////////////////////////////////
+// Little endian serialisation
+
+void writeU32(std::ostream &os, uint32_t value) {
+  char bytes[4];
+  for (auto &byte : bytes) {
+    byte = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+  os.write(bytes, sizeof(bytes));
+}
+
+void writeU64(std::ostream &os, uint64_t value) {
+  writeU32(os, static_cast<uint32_t>(value));
+  writeU32(os, static_cast<uint32_t>(value >> 32));
+}
+
+void writeString(std::ostream &os, std::string const &value) {
+  writeU32(os, static_cast<uint32_t>(value.size()));
+  os.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+bool readU32(std::istream &is, uint32_t &value) {
+  unsigned char bytes[4];
+  if (!is.read(reinterpret_cast<char *>(bytes), sizeof(bytes))) {
+    return false;
+  }
+  value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) |
+          (static_cast<uint32_t>(bytes[3]) << 24);
+  return true;
+}
+
+bool readU64(std::istream &is, uint64_t &value) {
+  uint32_t low{}, high{};
+  if (!readU32(is, low) || !readU32(is, high)) {
+    return false;
+  }
+  value = (static_cast<uint64_t>(high) << 32) | low;
+  return true;
+}
+
+bool readString(std::istream &is, std::string &value) {
+  uint32_t length{};
+  if (!readU32(is, length) || length > maxCount) {
+    return false;
+  }
+  value.resize(length);
+  return length == 0 || is.read(&value[0], length);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+FlightRecorder::FlightRecorder(size_t capacity) : buffer_(capacity) {}
+
+//////////////////////////////////////////////////////////////////////////
+// Make room for a record, discarding the oldest records as needed
+bool FlightRecorder::reserve(size_t length) {
+  if (length > buffer_.size()) {
+    return false;
+  }
+  while (buffer_.size() - used_ < length) {
+    uint32_t oldest{};
+    get(tail_, &oldest, sizeof(oldest));
+    tail_ = (tail_ + oldest) % buffer_.size();
+    used_ -= oldest;
+    --count_;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void FlightRecorder::putHeader(uint32_t length, uint64_t time,
+                               uint32_t threadId, uint32_t entry,
+                               uint64_t result) {
+  unsigned char header[headerSize];
+  unsigned char *ptr = header;
+  memcpy(ptr, &length, sizeof(length));
+  ptr += sizeof(length);
+  memcpy(ptr, &time, sizeof(time));
+  ptr += sizeof(time);
+  memcpy(ptr, &threadId, sizeof(threadId));
+  ptr += sizeof(threadId);
+  memcpy(ptr, &entry, sizeof(entry));
+  ptr += sizeof(entry);
+  memcpy(ptr, &result, sizeof(result));
+  put(header, sizeof(header));
+}
+
+//////////////////////////////////////////////////////////////////////////
+void FlightRecorder::putValue(uint64_t value) { put(&value, sizeof(value)); }
+
+//////////////////////////////////////////////////////////////////////////
+// Copy data into the ring at the head, wrapping at the end of the buffer
+void FlightRecorder::put(void const *data, size_t length) {
+  size_t const first = std::min(length, buffer_.size() - head_);
+  memcpy(&buffer_[head_], data, first);
+  if (first != length) {
+    memcpy(&buffer_[0], static_cast<unsigned char const *>(data) + first,
+           length - first);
+  }
+  head_ = (head_ + length) % buffer_.size();
+  used_ += length;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Copy data out of the ring, wrapping at the end of the buffer
+void FlightRecorder::get(size_t offset, void *data, size_t length) const {
+  size_t const first = std::min(length, buffer_.size() - offset);
+  memcpy(data, &buffer_[offset], first);
+  if (first != length) {
+    memcpy(static_cast<unsigned char *>(data) + first, &buffer_[0],
+           length - first);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::vector<FlightRecorder::Record> FlightRecorder::records() const {
+  std::vector<Record> result(count_);
+  size_t offset = tail_;
+  for (auto &record : result) {
+    unsigned char header[headerSize];
+    get(offset, header, sizeof(header));
+    uint32_t length{};
+    unsigned char const *ptr = header;
+    memcpy(&length, ptr, sizeof(length));
+    ptr += sizeof(length);
+    memcpy(&record.time, ptr, sizeof(record.time));
+    ptr += sizeof(record.time);
+    memcpy(&record.threadId, ptr, sizeof(record.threadId));
+    ptr += sizeof(record.threadId);
+    memcpy(&record.entry, ptr, sizeof(record.entry));
+    ptr += sizeof(record.entry);
+    memcpy(&record.result, ptr, sizeof(record.result));
+
+    record.args.resize((length - headerSize) / sizeof(uint64_t));
+    for (size_t idx = 0; idx != record.args.size(); ++idx) {
+      get((offset + headerSize + idx * sizeof(uint64_t)) % buffer_.size(),
+          &record.args[idx], sizeof(uint64_t));
+    }
+    offset = (offset + length) % buffer_.size();
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void FlightRecorder::clear() {
+  head_ = tail_ = used_ = count_ = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void FlightRecorder::write(std::ostream &os, uint32_t processId,
+                           uint64_t frequency, std::string const &reason,
+                           std::vector<std::string> const &names) const {
+  Dump dump;
+  dump.processId = processId;
+  dump.frequency = frequency;
+  dump.reason = reason;
+  dump.names = names;
+  dump.records = records();
+  write(os, dump);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void FlightRecorder::write(std::ostream &os, Dump const &dump) {
+  os.write(magic, sizeof(magic));
+  writeU32(os, version);
+  writeU32(os, dump.processId);
+  writeU64(os, dump.frequency);
+  writeString(os, dump.reason);
+  writeU32(os, static_cast<uint32_t>(dump.names.size()));
+  for (auto const &name : dump.names) {
+    writeString(os, name);
+  }
+  writeU32(os, static_cast<uint32_t>(dump.records.size()));
+  for (auto const &record : dump.records) {
+    writeU64(os, record.time);
+    writeU32(os, record.threadId);
+    writeU32(os, record.entry);
+    writeU64(os, record.result);
+    writeU32(os, static_cast<uint32_t>(record.args.size()));
+    for (uint64_t arg : record.args) {
+      writeU64(os, arg);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool FlightRecorder::read(std::istream &is, Dump &dump) {
+  char header[sizeof(magic)];
+  uint32_t fileVersion{};
+  if (!is.read(header, sizeof(header)) ||
+      memcmp(header, magic, sizeof(magic)) != 0 ||
+      !readU32(is, fileVersion) || fileVersion != version ||
+      !readU32(is, dump.processId) || !readU64(is, dump.frequency) ||
+      !readString(is, dump.reason)) {
+    return false;
+  }
+
+  uint32_t count{};
+  if (!readU32(is, count) || count > maxCount) {
+    return false;
+  }
+  dump.names.resize(count);
+  for (auto &name : dump.names) {
+    if (!readString(is, name)) {
+      return false;
+    }
+  }
+
+  if (!readU32(is, count) || count > maxCount) {
+    return false;
+  }
+  dump.records.clear();
+  for (uint32_t idx = 0; idx != count; ++idx) {
+    Record record;
+    uint32_t argCount{};
+    if (!readU64(is, record.time) || !readU32(is, record.threadId) ||
+        !readU32(is, record.entry) || !readU64(is, record.result) ||
+        !readU32(is, argCount) || argCount > 0xffff) {
+      return false;
+    }
+    record.args.resize(argCount);
+    for (auto &arg : record.args) {
+      if (!readU64(is, arg)) {
+        return false;
+      }
+    }
+    dump.records.push_back(std::move(record));
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void FlightRecorder::print(std::ostream &os, Dump const &dump) {
+  os << "Process " << dump.processId << ": " << dump.reason << '\n';
+  os << dump.records.size() << " calls\n";
+  if (dump.records.empty()) {
+    return;
+  }
+
+  uint64_t const last = dump.records.back().time;
+  auto const flags = os.flags();
+  for (auto const &record : dump.records) {
+    if (dump.frequency) {
+      os << '-' << std::fixed << std::setprecision(6)
+         << static_cast<double>(last - record.time) / dump.frequency << ' ';
+    }
+    os << '[' << record.threadId << "] ";
+    if (record.entry < dump.names.size()) {
+      os << dump.names[record.entry];
+    } else {
+      os << "#" << record.entry;
+    }
+    os << '(' << std::hex;
+    for (size_t idx = 0; idx != record.args.size(); ++idx) {
+      os << (idx ? ", 0x" : "0x") << record.args[idx];
+    }
+    os << ") => 0x" << record.result << std::dec << '\n';
+  }
+  os.flags(flags);
+}
+
+} // namespace or2
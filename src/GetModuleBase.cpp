@@ -96,36 +96,45 @@ DWORD64 CALLBACK GetModuleBase(HANDLE hProcess, DWORD64 dwAddress) {
   const auto filename = GetModuleFileNameWrapper(hProcess, hmod);
 
   if (!filename.empty()) {
-    bool bPathSet(false);
-    std::vector<char> searchpath(1024);
-    if (::SymGetSearchPath(hProcess, &searchpath[0], 1024)) {
-      // symbol files often stored with binary image
-      const auto index = filename.find_last_of('\\');
-      if (index != std::string::npos) {
-        std::string fullpath(filename.substr(0, index));
-        fullpath += ";";
-        fullpath += &searchpath[0];
-        ::SymSetSearchPath(
-            hProcess,
-            const_cast<char *>(fullpath.c_str())); // Some versions of DbgHelp.h
-                                                   // not const-correct
-        bPathSet = true;
-      }
-    }
-    // We do not need to pass a file handle - NtTrace reveals that
-    // DbgHelp simply opens the file if we don't provide a handle or
-    // duplicates the handle if we do.
-    (void)::SymLoadModule64(hProcess, nullptr, filename.c_str(), nullptr,
-                            baseAddress, 0);
-    fixSymSrv();
-    if (bPathSet) {
-      ::SymSetSearchPath(hProcess, const_cast<char *>(&searchpath[0]));
-    }
+    LoadModuleSymbols(hProcess, filename, baseAddress, 0);
   }
 
   return baseAddress;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+/// LoadModuleSymbols: load a module into the symbol engine, searching for
+/// symbol files alongside the binary image as well as on the search path.
+///
+void LoadModuleSymbols(HANDLE hProcess, std::string const &filename,
+                       DWORD64 baseAddress, DWORD size) {
+  bool bPathSet(false);
+  std::vector<char> searchpath(1024);
+  if (::SymGetSearchPath(hProcess, &searchpath[0], 1024)) {
+    // symbol files often stored with binary image
+    const auto index = filename.find_last_of('\\');
+    if (index != std::string::npos) {
+      std::string fullpath(filename.substr(0, index));
+      fullpath += ";";
+      fullpath += &searchpath[0];
+      ::SymSetSearchPath(
+          hProcess,
+          const_cast<char *>(fullpath.c_str())); // Some versions of DbgHelp.h
+                                                 // not const-correct
+      bPathSet = true;
+    }
+  }
+  // We do not need to pass a file handle - NtTrace reveals that
+  // DbgHelp simply opens the file if we don't provide a handle or
+  // duplicates the handle if we do.
+  (void)::SymLoadModule64(hProcess, nullptr, filename.c_str(), nullptr,
+                          baseAddress, size);
+  fixSymSrv();
+  if (bPathSet) {
+    ::SymSetSearchPath(hProcess, const_cast<char *>(&searchpath[0]));
+  }
+}
+
 /**
  * Get module file name, correcting for a couple of common issues.
  *
@@ -0,0 +1,167 @@
+/*
+NAME
+  HandleTable.cpp
+
+DESCRIPTION
+  Shadow copy of the handles held by a traced process.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "HandleTable.h"
+
+#include <utility>
+
+namespace or2 {
+
+//////////////////////////////////////////////////////////////////////////
+void HandleTable::opened(uint64_t handle, std::string const &name,
+                         uint64_t root) {
+  if (handle == 0) {
+    return;
+  }
+  if (name.empty()) {
+    // The handle value may have been reused after an unseen close
+    closed(handle);
+    return;
+  }
+  std::string fullName(name);
+  if (root != 0 && name[0] != '\\') {
+    if (std::string const *rootName = find(root)) {
+      fullName = *rootName + '\\' + name;
+    }
+  }
+  insert(handle, std::move(fullName));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Remove the entry, moving back any following entries in the same probe
+// sequence so that no tombstones are needed
+void HandleTable::closed(uint64_t handle) {
+  size_t hole = locate(handle);
+  if (hole == slots_.size() || slots_[hole].handle == 0) {
+    return;
+  }
+  size_t const mask = slots_.size() - 1;
+  for (size_t next = (hole + 1) & mask; slots_[next].handle != 0;
+       next = (next + 1) & mask) {
+    size_t const target = home(slots_[next].handle);
+    // Leave the entry alone if its home slot lies in (hole, next]
+    bool const inPlace =
+        hole <= next ? (hole < target && target <= next)
+                     : (hole < target || target <= next);
+    if (!inPlace) {
+      slots_[hole] = std::move(slots_[next]);
+      hole = next;
+    }
+  }
+  slots_[hole].handle = 0;
+  slots_[hole].name.clear();
+  --size_;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HandleTable::duplicated(uint64_t source, uint64_t target) {
+  std::string const *name = find(source);
+  opened(target, name ? *name : std::string());
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::string const *HandleTable::find(uint64_t handle) const {
+  size_t const idx = locate(handle);
+  if (idx == slots_.size() || slots_[idx].handle == 0) {
+    return nullptr;
+  }
+  return &slots_[idx].name;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HandleTable::clear() {
+  slots_.clear();
+  shift_ = 64;
+  size_ = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Fibonacci hashing: handle values are multiples of four, so drop the low
+// bits before scrambling
+size_t HandleTable::home(uint64_t handle) const {
+  return static_cast<size_t>(((handle >> 2) * 0x9e3779b97f4a7c15ull) >>
+                             shift_);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Find the slot holding the handle, or the empty slot ending its probe
+// sequence; returns slots_.size() if the table is empty
+size_t HandleTable::locate(uint64_t handle) const {
+  if (slots_.empty() || handle == 0) {
+    return slots_.size();
+  }
+  size_t const mask = slots_.size() - 1;
+  size_t idx = home(handle);
+  while (slots_[idx].handle != 0 && slots_[idx].handle != handle) {
+    idx = (idx + 1) & mask;
+  }
+  return idx;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HandleTable::insert(uint64_t handle, std::string name) {
+  // Keep the load factor at or below one half
+  if (2 * (size_ + 1) > slots_.size()) {
+    grow();
+  }
+  Slot &slot = slots_[locate(handle)];
+  if (slot.handle == 0) {
+    slot.handle = handle;
+    ++size_;
+  }
+  slot.name = std::move(name);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void HandleTable::grow() {
+  std::vector<Slot> old(slots_.empty() ? 64 : slots_.size() * 2);
+  old.swap(slots_);
+  shift_ = 64;
+  for (size_t n = slots_.size(); n > 1; n >>= 1) {
+    --shift_;
+  }
+  size_t const mask = slots_.size() - 1;
+  for (auto &slot : old) {
+    if (slot.handle != 0) {
+      size_t idx = home(slot.handle);
+      while (slots_[idx].handle != 0) {
+        idx = (idx + 1) & mask;
+      }
+      slots_[idx] = std::move(slot);
+    }
+  }
+}
+
+} // namespace or2
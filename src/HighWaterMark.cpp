@@ -0,0 +1,79 @@
+/*
+NAME
+  HighWaterMark.cpp
+
+DESCRIPTION
+  High-water mark of a value over time.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "HighWaterMark.h"
+
+#include <algorithm>
+
+namespace or2 {
+
+//////////////////////////////////////////////////////////////////////////
+// Update the peak and the high-water mark for the current period
+void HighWaterMark::sample(uint64_t value, uint64_t time) {
+  if (!started_) {
+    started_ = true;
+    start_ = time;
+  }
+  if (value > peak_) {
+    peak_ = value;
+    peakTime_ = time;
+  }
+  uint64_t const period = (time - start_) / interval_ * interval_;
+  if (timeline_.empty() || timeline_.back().time != period) {
+    timeline_.push_back(Mark{period, value});
+  } else {
+    timeline_.back().maximum = std::max(timeline_.back().maximum, value);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::vector<HighWaterMark::Mark> HighWaterMark::marks(size_t maxMarks) const {
+  std::vector<Mark> result;
+  if (timeline_.empty() || maxMarks == 0) {
+    return result;
+  }
+  size_t const merge = (timeline_.size() + maxMarks - 1) / maxMarks;
+  for (size_t idx = 0; idx < timeline_.size(); idx += merge) {
+    Mark mark{timeline_[idx].time, 0};
+    for (size_t next = idx; next != idx + merge && next != timeline_.size();
+         ++next) {
+      mark.maximum = std::max(mark.maximum, timeline_[next].maximum);
+    }
+    result.push_back(mark);
+  }
+  return result;
+}
+
+} // namespace or2
@@ -0,0 +1,387 @@
+/*
+NAME
+  JsonWriter.cpp
+
+DESCRIPTION
+  Streaming writer for JSON text.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "JsonWriter.h"
+
+#include <charconv>
+#include <cstring>
+#include <ostream>
+
+namespace or2 {
+namespace {
+
+// Length of the UTF-8 sequence starting at 'pos', or zero if it is not valid
+size_t utf8Length(std::string_view text, size_t pos) {
+  auto const lead = static_cast<unsigned char>(text[pos]);
+  size_t length{};
+  uint32_t minimum{};
+  uint32_t code{};
+  if (lead < 0x80) {
+    return 1;
+  } else if ((lead & 0xe0) == 0xc0) {
+    length = 2;
+    minimum = 0x80;
+    code = lead & 0x1f;
+  } else if ((lead & 0xf0) == 0xe0) {
+    length = 3;
+    minimum = 0x800;
+    code = lead & 0x0f;
+  } else if ((lead & 0xf8) == 0xf0) {
+    length = 4;
+    minimum = 0x10000;
+    code = lead & 0x07;
+  } else {
+    return 0;
+  }
+  if (text.size() - pos < length) {
+    return 0;
+  }
+  for (size_t idx = 1; idx != length; ++idx) {
+    auto const ch = static_cast<unsigned char>(text[pos + idx]);
+    if ((ch & 0xc0) != 0x80) {
+      return 0;
+    }
+    code = (code << 6) | (ch & 0x3f);
+  }
+  // Reject overlong forms, surrogates and values beyond Unicode
+  if (code < minimum || (code >= 0xd800 && code <= 0xdfff) ||
+      code > 0x10ffff) {
+    return 0;
+  }
+  return length;
+}
+
+// Runs of characters needing no escape are written in a single call
+template <typename Write> void escapeTo(std::string_view text, Write write) {
+  static char const hex[] = "0123456789abcdef";
+  size_t start = 0;
+  size_t pos = 0;
+  while (pos != text.size()) {
+    auto const ch = static_cast<unsigned char>(text[pos]);
+    size_t length = 1;
+    if (ch >= 0x20 && ch != '"' && ch != '\\' &&
+        (ch < 0x80 || (length = utf8Length(text, pos)) != 0)) {
+      pos += length;
+      continue;
+    }
+    write(text.data() + start, pos - start);
+    switch (ch) {
+    case '"':
+      write("\\\"", 2);
+      break;
+    case '\\':
+      write("\\\\", 2);
+      break;
+    case '\b':
+      write("\\b", 2);
+      break;
+    case '\f':
+      write("\\f", 2);
+      break;
+    case '\n':
+      write("\\n", 2);
+      break;
+    case '\r':
+      write("\\r", 2);
+      break;
+    case '\t':
+      write("\\t", 2);
+      break;
+    default: {
+      char const escaped[] = {'\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 0xf]};
+      write(escaped, sizeof(escaped));
+      break;
+    }
+    }
+    start = ++pos;
+  }
+  write(text.data() + start, pos - start);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// Write the comma before the second and subsequent values at each level
+void JsonWriter::separate() {
+  if (afterKey_) {
+    afterKey_ = false;
+  } else if (!first_[depth_]) {
+    put(',');
+  }
+  if (newLine_) {
+    put('\n');
+    newLine_ = false;
+  }
+  first_[depth_] = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JsonWriter::push(char open) {
+  separate();
+  put(open);
+  send();
+  if (depth_ != maxDepth) {
+    ++depth_;
+  }
+  first_[depth_] = true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JsonWriter::pop(char close) {
+  put(close);
+  send();
+  if (depth_ != 0) {
+    --depth_;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JsonWriter::put(char ch) {
+  if (used_ == sizeof(buffer_)) {
+    send();
+  }
+  buffer_[used_++] = ch;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JsonWriter::write(char const *text, size_t size) {
+  while (size > sizeof(buffer_) - used_) {
+    size_t const count = sizeof(buffer_) - used_;
+    std::memcpy(buffer_ + used_, text, count);
+    used_ += count;
+    send();
+    text += count;
+    size -= count;
+  }
+  std::memcpy(buffer_ + used_, text, size);
+  used_ += size;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Write a quoted string
+void JsonWriter::writeString(std::string_view text) {
+  put('"');
+  escapeTo(text, [this](char const *data, size_t size) { write(data, size); });
+  put('"');
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Write the collected output straight to the stream buffer; a failure to
+// write it all is reported by setting badbit, as the stream would.
+void JsonWriter::send() {
+  if (used_ != 0) {
+    auto const count = static_cast<std::streamsize>(used_);
+    auto const buf = os_.rdbuf();
+    if (!buf || buf->sputn(buffer_, count) != count) {
+      os_.setstate(std::ios_base::badbit);
+    }
+    used_ = 0;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonWriter &JsonWriter::beginObject() {
+  push('{');
+  return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonWriter &JsonWriter::endObject() {
+  pop('}');
+  return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonWriter &JsonWriter::beginArray() {
+  push('[');
+  return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonWriter &JsonWriter::endArray() {
+  pop(']');
+  return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonWriter &JsonWriter::key(std::string_view name) {
+  separate();
+  writeString(name);
+  put(':');
+  afterKey_ = true;
+  return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonWriter &JsonWriter::value(std::string_view text) {
+  separate();
+  writeString(text);
+  send();
+  return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonWriter &JsonWriter::value(uint64_t number) {
+  separate();
+  char buffer[20];
+  auto const result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+  write(buffer, static_cast<size_t>(result.ptr - buffer));
+  send();
+  return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonWriter &JsonWriter::value(int64_t number) {
+  separate();
+  char buffer[20];
+  auto const result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+  write(buffer, static_cast<size_t>(result.ptr - buffer));
+  send();
+  return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonWriter &JsonWriter::value(bool flag) {
+  separate();
+  if (flag) {
+    write("true", 4);
+  } else {
+    write("false", 5);
+  }
+  send();
+  return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonWriter &JsonWriter::null() {
+  separate();
+  write("null", 4);
+  send();
+  return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonWriter &JsonWriter::newLine() {
+  newLine_ = true;
+  return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JsonWriter::endLine() {
+  put('\n');
+  send();
+  depth_ = 0;
+  first_[0] = true;
+  afterKey_ = false;
+  newLine_ = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JsonWriter::flush() {
+  send();
+  os_.flush();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JsonWriter::escape(std::ostream &os, std::string_view text) {
+  escapeTo(text, [&os](char const *data, size_t size) {
+    os.write(data, static_cast<std::streamsize>(size));
+  });
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonTextBuf::~JsonTextBuf() {
+  if (!line_.empty()) {
+    writeLine();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JsonTextBuf::source(std::string_view time, uint32_t processId,
+                         uint32_t threadId) {
+  time_ = time;
+  processId_ = processId;
+  threadId_ = threadId;
+}
+
+//////////////////////////////////////////////////////////////////////////
+JsonTextBuf::int_type JsonTextBuf::overflow(int_type ch) {
+  if (traits_type::eq_int_type(ch, traits_type::eof())) {
+    return traits_type::not_eof(ch);
+  }
+  char const text = traits_type::to_char_type(ch);
+  (void)xsputn(&text, 1);
+  return ch;
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::streamsize JsonTextBuf::xsputn(char const *text, std::streamsize count) {
+  std::string_view remaining(text, static_cast<size_t>(count));
+  for (size_t eol; (eol = remaining.find('\n')) != std::string_view::npos;) {
+    line_.append(remaining.substr(0, eol));
+    writeLine();
+    remaining.remove_prefix(eol + 1);
+  }
+  line_.append(remaining);
+  return count;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int JsonTextBuf::sync() {
+  writer_.flush();
+  return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void JsonTextBuf::writeLine() {
+  if (!line_.empty() && line_.back() == '\r') {
+    line_.pop_back();
+  }
+  writer_.beginObject().member("event", "message");
+  if (!time_.empty()) {
+    writer_.member("time", time_);
+  }
+  if (processId_ != 0) {
+    writer_.member("pid", processId_);
+  }
+  if (threadId_ != 0) {
+    writer_.member("tid", threadId_);
+  }
+  writer_.member("text", line_).endObject();
+  writer_.endLine();
+  line_.clear();
+}
+
+} // namespace or2
@@ -0,0 +1,164 @@
+/*
+NAME
+  LeakTracker.cpp
+
+DESCRIPTION
+  Accounting of the handles opened and closed by a process.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "LeakTracker.h"
+#include "StackTable.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <ostream>
+
+namespace or2 {
+
+//////////////////////////////////////////////////////////////////////////
+LeakTracker::LeakTracker(uint64_t interval)
+    : marks_(interval) {}
+
+//////////////////////////////////////////////////////////////////////////
+void LeakTracker::opened(uint64_t handle, std::string const &type,
+                         std::string const &category, uint32_t stack,
+                         uint64_t time) {
+  // A reused handle value replaces any entry whose close was not seen
+  handles_[handle] = Handle{kind(type, category), stack};
+  marks_.sample(handles_.size(), time);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void LeakTracker::closed(uint64_t handle, uint64_t time) {
+  if (handles_.erase(handle)) {
+    marks_.sample(handles_.size(), time);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void LeakTracker::duplicated(uint64_t source, uint64_t target, uint32_t stack,
+                             uint64_t time) {
+  auto const it = handles_.find(source);
+  if (it == handles_.end()) {
+    handles_.erase(target);
+  } else {
+    handles_[target] = Handle{it->second.kind, stack};
+  }
+  marks_.sample(handles_.size(), time);
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::vector<LeakTracker::Group> LeakTracker::groups() const {
+  std::vector<std::map<uint32_t, size_t>> byKind(kinds_.size());
+  for (auto const &entry : handles_) {
+    ++byKind[entry.second.kind][entry.second.stack];
+  }
+
+  std::vector<Group> result;
+  for (size_t idx = 0; idx != kinds_.size(); ++idx) {
+    if (byKind[idx].empty()) {
+      continue;
+    }
+    Group group{kinds_[idx].first, kinds_[idx].second, 0,
+                {byKind[idx].begin(), byKind[idx].end()}};
+    for (auto const &stack : group.stacks) {
+      group.count += stack.second;
+    }
+    std::stable_sort(group.stacks.begin(), group.stacks.end(),
+                     [](auto const &lhs, auto const &rhs) {
+                       return lhs.second > rhs.second;
+                     });
+    result.push_back(std::move(group));
+  }
+  std::stable_sort(result.begin(), result.end(),
+                   [](Group const &lhs, Group const &rhs) {
+                     return lhs.count > rhs.count;
+                   });
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void LeakTracker::report(std::ostream &os, StackTable const &stacks,
+                         size_t maxStacks, size_t maxMarks) const {
+  auto const flags = os.flags();
+  auto const precision = os.precision();
+  os << std::fixed << std::setprecision(1);
+  os << "Handles still open: " << open() << " (peak " << peak() << " at "
+     << static_cast<double>(marks_.peakTime()) / 1000 << "s)\n";
+
+  for (auto const &group : groups()) {
+    os << std::setw(8) << group.count << "  " << group.type;
+    if (!group.category.empty() && group.category != group.type) {
+      os << " (" << group.category << ')';
+    }
+    os << '\n';
+    size_t shown = 0;
+    for (auto const &stack : group.stacks) {
+      if (shown++ == maxStacks) {
+        break;
+      }
+      os << std::setw(12) << stack.second << " opened at:";
+      std::vector<std::string> const &frames = stacks.frames(stack.first);
+      if (frames.empty()) {
+        os << " (no stack)";
+      }
+      os << '\n';
+      for (auto const &frame : frames) {
+        os << "              " << frame << '\n';
+      }
+    }
+  }
+
+  std::vector<Mark> const marks = marks_.marks(maxMarks);
+  if (!marks.empty()) {
+    os << "High-water mark:\n";
+    for (Mark const &mark : marks) {
+      os << std::setw(10) << static_cast<double>(mark.time) / 1000 << "s "
+         << std::setw(8) << mark.maximum << '\n';
+    }
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint32_t LeakTracker::kind(std::string const &type,
+                           std::string const &category) {
+  for (size_t idx = 0; idx != kinds_.size(); ++idx) {
+    if (kinds_[idx].first == type && kinds_[idx].second == category) {
+      return static_cast<uint32_t>(idx);
+    }
+  }
+  kinds_.emplace_back(type, category);
+  return static_cast<uint32_t>(kinds_.size() - 1);
+}
+
+} // namespace or2
@@ -0,0 +1,148 @@
+/*
+NAME
+  MappedFile.cpp
+
+DESCRIPTION
+  Read only memory mapping of a whole file.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace or2 {
+
+#ifdef _WIN32
+
+//////////////////////////////////////////////////////////////////////////
+bool MappedFile::open(std::string const &fileName, std::string &error) {
+  close();
+  HANDLE const hFile =
+      CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (hFile == INVALID_HANDLE_VALUE) {
+    error = "error " + std::to_string(GetLastError());
+    return false;
+  }
+  LARGE_INTEGER size{};
+  bool ok = GetFileSizeEx(hFile, &size) != 0;
+  if (ok && size.QuadPart != 0) {
+    if (static_cast<unsigned long long>(size.QuadPart) > SIZE_MAX) {
+      error = "file too large to map";
+      CloseHandle(hFile);
+      return false;
+    }
+    mapping_ =
+        CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    data_ = mapping_ ? static_cast<char const *>(
+                           MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0))
+                     : nullptr;
+    ok = data_ != nullptr;
+  }
+  if (ok) {
+    size_ = static_cast<size_t>(size.QuadPart);
+  } else {
+    error = "error " + std::to_string(GetLastError());
+  }
+  CloseHandle(hFile); // the mapping keeps the file open
+  if (!ok) {
+    close();
+  }
+  return ok;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void MappedFile::close() {
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_) {
+    CloseHandle(mapping_);
+  }
+  data_ = nullptr;
+  mapping_ = nullptr;
+  size_ = 0;
+}
+
+#else
+
+//////////////////////////////////////////////////////////////////////////
+bool MappedFile::open(std::string const &fileName, std::string &error) {
+  close();
+  int const fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error = std::strerror(errno);
+    return false;
+  }
+  struct stat status {};
+  bool ok = fstat(fd, &status) == 0;
+  if (ok && status.st_size != 0) {
+    void *const data = mmap(nullptr, static_cast<size_t>(status.st_size),
+                            PROT_READ, MAP_PRIVATE, fd, 0);
+    ok = data != MAP_FAILED;
+    if (ok) {
+      // The trace is read from start to end
+      (void)madvise(data, static_cast<size_t>(status.st_size),
+                    MADV_SEQUENTIAL);
+      data_ = static_cast<char const *>(data);
+      size_ = static_cast<size_t>(status.st_size);
+    }
+  }
+  if (!ok) {
+    error = std::strerror(errno);
+  }
+  ::close(fd); // the mapping keeps the file open
+  return ok;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void MappedFile::close() {
+  if (data_) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+#endif // _WIN32
+
+} // namespace or2
@@ -0,0 +1,169 @@
+/*
+NAME
+  NtFlightDump.cpp
+
+DESCRIPTION
+  Print the flight recorder dumps written by NtTrace -flight
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+EXAMPLE
+  NtFlightDump crash-1234-1.ntfr
+  NtFlightDump -chrome crash.json crash-1234-1.ntfr crash-1234-2.ntfr
+*/
+
+static char const szRCSID[] = "$Id$";
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+// or2 includes
+#include "../include/ChromeTrace.h"
+#include "../include/FlightRecorder.h"
+#include "../include/Options.h"
+
+using namespace or2;
+
+namespace {
+
+// Export a call to a Chrome trace. The recorder does not hold the duration
+// of the calls, so each is shown as a zero length slice at the time it
+// returned.
+void exportCall(ChromeTrace &chrome, FlightRecorder::Dump const &dump,
+                FlightRecorder::Record const &record, uint64_t time) {
+  std::vector<ChromeTrace::Arg> args;
+  for (size_t idx = 0; idx != record.args.size(); ++idx) {
+    std::ostringstream value;
+    value << "0x" << std::hex << record.args[idx];
+    args.push_back({"arg" + std::to_string(idx + 1), value.str()});
+  }
+  std::ostringstream result;
+  result << "0x" << std::hex << record.result;
+  args.push_back({"result", result.str()});
+  std::string name;
+  if (record.entry < dump.names.size()) {
+    name = dump.names[record.entry];
+  } else {
+    name = '#';
+    name += std::to_string(record.entry);
+  }
+  chrome.complete(dump.processId, record.threadId, time, 0, name, "call",
+                  args);
+}
+
+// Export the calls in the dumps to a Chrome trace in time order. The
+// performance counter is system wide, so dumps from several processes share
+// a timeline starting at the earliest call. The reason for each dump is
+// shown as an instant event at the time of its last call.
+void exportDumps(ChromeTrace &chrome,
+                 std::vector<FlightRecorder::Dump> const &dumps) {
+  uint64_t origin = UINT64_MAX;
+  std::vector<std::pair<uint64_t, std::pair<size_t, size_t>>> calls;
+  for (size_t dump = 0; dump != dumps.size(); ++dump) {
+    auto const &records = dumps[dump].records;
+    if (dumps[dump].frequency == 0 || records.empty()) {
+      continue;
+    }
+    origin = std::min(origin, records.front().time);
+    for (size_t idx = 0; idx != records.size(); ++idx) {
+      calls.push_back({records[idx].time, {dump, idx}});
+    }
+  }
+  std::stable_sort(calls.begin(), calls.end(),
+                   [](auto const &lhs, auto const &rhs) {
+                     return lhs.first < rhs.first;
+                   });
+
+  for (auto const &call : calls) {
+    FlightRecorder::Dump const &dump = dumps[call.second.first];
+    FlightRecorder::Record const &record = dump.records[call.second.second];
+    uint64_t const time = (record.time - origin) * 1000000 / dump.frequency;
+    exportCall(chrome, dump, record, time);
+    if (call.second.second + 1 == dump.records.size()) {
+      chrome.instant(dump.processId, record.threadId, time, dump.reason,
+                     "dump");
+    }
+  }
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  std::string chromeFile;
+  unsigned int slice(0);
+
+  Options options(szRCSID);
+  options.set("chrome", &chromeFile,
+              "Export the calls to <file> in Chrome trace-event format");
+  options.set("slice", &slice,
+              "Split the Chrome trace into files of <n> seconds each");
+  options.setArgs(1, -1, "<dump file>...");
+  if (!options.process(argc, argv, "Print NtTrace flight recorder dumps")) {
+    return 1;
+  }
+
+  int ret = 0;
+  std::vector<FlightRecorder::Dump> dumps;
+  for (auto const &fileName : options) {
+    std::ifstream ifs(fileName, std::ios::binary);
+    if (!ifs) {
+      std::cerr << "Cannot open: " << fileName << std::endl;
+      ret = 1;
+      continue;
+    }
+    FlightRecorder::Dump dump;
+    if (!FlightRecorder::read(ifs, dump)) {
+      std::cerr << "Invalid flight recorder dump: " << fileName << std::endl;
+      ret = 1;
+      continue;
+    }
+    if (chromeFile.empty()) {
+      FlightRecorder::print(std::cout, dump);
+    } else {
+      dumps.push_back(std::move(dump));
+    }
+  }
+
+  if (!chromeFile.empty()) {
+    ChromeTrace chrome(chromeFile, uint64_t(slice) * 1000000);
+    if (!chrome.good()) {
+      std::cerr << "Cannot open: " << chrome.error() << std::endl;
+      return 1;
+    }
+    exportDumps(chrome, dumps);
+    if (!chrome.close()) {
+      std::cerr << "Cannot write: " << chrome.error() << std::endl;
+      ret = 1;
+    }
+  }
+  return ret;
+}
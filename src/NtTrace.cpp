@@ -44,13 +44,18 @@ static char const szRCSID[] =
 #define WIN32_NO_STATUS
 #endif
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
 #include <map>
+#include <memory>
 #include <set>
+#include <sstream>
 #include <string>
 #include <sys/timeb.h>
 #include <vector>
@@ -60,14 +65,32 @@ static char const szRCSID[] =
 #include <psapi.h> // LOAD_DLL_DEBUG_INFO does not always give us lpImageName
 
 // or2 includes
+#include "../include/CallTotals.h"
+#include "../include/ChromeTrace.h"
 #include "../include/DebugPriv.h"
 #include "../include/DisplayError.h"
+#include "../include/FileIoStats.h"
+#include "../include/FilterExpression.h"
+#include "../include/FlightRecorder.h"
+#include "../include/FoldedStacks.h"
+#include "../include/HandleTable.h"
+#include "../include/JsonWriter.h"
+#include "../include/LeakTracker.h"
 #include "../include/MsvcExceptions.h"
 #include "../include/NtDllStruct.h"
 #include "../include/Options.h"
 #include "../include/ProcessHelper.h"
+#include "../include/ProcessInfo.h"
 #include "../include/ReadInt.h"
+#include "../include/RedundantCalls.h"
+#include "../include/RegistryProfile.h"
+#include "../include/ShardedOutput.h"
 #include "../include/SimpleTokenizer.h"
+#include "../include/SmallIoDetector.h"
+#include "../include/StackTable.h"
+#include "../include/TraceTrigger.h"
+#include "../include/VirtualMemoryMap.h"
+#include "../include/WaitProfiler.h"
 #include <GetFileNameFromHandle.h>
 #include <GetModuleBase.h>
 #include <SymbolEngine.h>
@@ -92,7 +115,11 @@ public:
    * Construct a debugger
    * @param os the output stream to write to
    */
-  explicit TrapNtDebugger(std::ostream &os) : os_(os) {}
+  explicit TrapNtDebugger(std::ostream &os) : os_(os) {
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+    epoch_ = start.QuadPart;
+  }
 
   // callbacks on events
   void OnException(DWORD processId, DWORD threadId, HANDLE hProcess,
@@ -121,6 +148,40 @@ public:
    */
   void setErrorCodes(std::string const &codeFilter);
 
+  /**
+   * Set the error codes that write a flight recorder dump
+   */
+  void setFlightCodes(std::string const &codeFilter);
+
+  /** Write flight recorder dumps for all processes */
+  void writeFlight(std::string const &reason);
+
+  /** Report the handles still open in all processes */
+  void reportLeaks();
+
+  /** Report the virtual memory activity of all processes */
+  void reportMemory();
+
+  /** Print the file I/O for the busiest files */
+  void ShowFileIo(size_t count) const { fileIo_.report(os_, count); }
+
+  /** Print the calls most often repeated with the same arguments */
+  void ShowRedundant(size_t count) const {
+    redundant_.report(os_, stacks_, count);
+  }
+
+  /** Print the registry access for the busiest keys */
+  void ShowRegistry(size_t count) const { registry_.report(os_, count); }
+
+  /** Print the handles with the most inefficient I/O */
+  void ShowSmallIo(size_t count) const { smallIo_.report(os_, count); }
+
+  /** Print the objects with the most time spent waiting */
+  void ShowWaits(size_t count) const { waits_.report(os_, stacks_, count); }
+
+  /** Write the timeline of waits */
+  void writeWaits(std::ostream &os) const { waits_.writeTimeline(os); }
+
   /**
    * Set the 'log dlls' flag.
    * @param b the new value: if true dll load/unload will be ignored
@@ -172,6 +233,59 @@ public:
     }
   }
 
+  /**
+   * Write JSON Lines rather than text
+   * @param writer the writer for the events
+   * @param text the stream buffer behind the output stream, which writes each
+   * line of other output as a message event
+   */
+  void setJson(JsonWriter &writer, JsonTextBuf &text) {
+    json_ = &writer;
+    jsonText_ = &text;
+  }
+
+  /** Write the calls and other events to a Chrome trace */
+  void setChrome(ChromeTrace &chrome) { chrome_ = &chrome; }
+
+  /**
+   * Write a file for each process or thread
+   * @param shards the stream buffer behind the output stream, which writes
+   * each line to the file for the process or thread of the last header
+   */
+  void setShards(ShardBuf &shards) { shards_ = &shards; }
+
+  /**
+   * Set the filter expression for the calls to trace
+   * @throws std::runtime_error if the expression is not valid
+   */
+  void setWhere(std::string const &where) {
+    where_ = std::make_unique<FilterExpression>(where);
+    checkFilter(*where_);
+  }
+
+  /**
+   * Set the condition for calls starting tracing
+   * @throws std::runtime_error if the expression is not valid
+   */
+  void setStart(std::string const &start) {
+    start_ = std::make_unique<FilterExpression>(start);
+    checkFilter(*start_);
+    trigger_.setStartCall(true);
+  }
+
+  /**
+   * Set the condition for calls stopping tracing
+   * @throws std::runtime_error if the expression is not valid
+   */
+  void setStop(std::string const &stop) {
+    stop_ = std::make_unique<FilterExpression>(stop);
+    checkFilter(*stop_);
+    trigger_.setStopCall(true);
+  }
+
+  /** Get the trigger starting and stopping tracing */
+  TraceTrigger &trigger() { return trigger_; }
+
   /** initialise the debugger */
   bool initialise();
 
@@ -188,12 +302,25 @@ public:
   /** Print totals */
   void ShowTotals() const;
 
+  /** Write the folded stacks for the calls traced */
+  void writeFolded(std::ostream &os) const { folded_.write(os); }
+
+  /** Write the totals of the calls traced, for comparison with a baseline */
+  void writeTotals(std::ostream &os) const {
+    CallTotals::write(os, totals_.table());
+  }
+
 private:
   bool bLogDlls_{true};
   bool bNoExcept_{false};
   bool bNoThread_{false};
   bool bShowLoaderSnaps_{false};
   std::ostream &os_;
+  JsonWriter *json_{};      // if set, write calls as JSON Lines events
+  JsonTextBuf *jsonText_{}; // if set, the buffer behind os_
+  std::vector<bool> jsonStacks_; // stacks already written as events
+  ChromeTrace *chrome_{};        // if set, timeline of the calls and events
+  ShardBuf *shards_{};           // if set, the buffer behind os_
 
   bool bActive_{true};
   static TrapNtDebugger *ctrlcTarget_;
@@ -226,13 +353,125 @@ private:
   std::set<DWORD> initialised_processes_;
   std::set<NTSTATUS> errorCodes_;
 
+  std::unique_ptr<FilterExpression> where_; // If set, filter for traced calls
+  std::map<EntryPoint const *, FilterProgram>
+      wherePrograms_; // filter compiled for each entry point
+
+  TraceTrigger trigger_;
+  std::unique_ptr<FilterExpression> start_; // If set, calls starting tracing
+  std::unique_ptr<FilterExpression> stop_;  // If set, calls stopping tracing
+  struct TriggerPrograms {
+    FilterProgram start;
+    FilterProgram stop;
+  };
+  std::map<EntryPoint const *, TriggerPrograms>
+      triggerPrograms_; // triggers compiled for each entry point
+  std::map<EntryPoint *, FilterProgram const *>
+      traced_; // entry points only trapped while tracing, with their filter
+  std::set<HANDLE> trapped_processes_; // processes with traps set
+  std::set<LPVOID> retired_; // addresses of traps removed when tracing stopped
+
   std::map<DWORD, std::map<PVOID, std::string>> dll_names_;
 
+  std::map<DWORD, FlightRecorder> flight_; // flight recorder for each process
+  std::vector<std::string> flightNames_;   // entry point names recorded
+  std::map<EntryPoint const *, uint32_t> flightIds_; // index in flightNames_
+  std::set<NTSTATUS> flightCodes_; // error codes that write a dump
+  unsigned int flightDumps_{};     // count of dumps written
+
+  std::map<DWORD, HandleTable> handles_; // shadow handle table for each process
+  std::set<EntryPoint const *>
+      handleEntryPoints_; // entry points opening or closing handles
+  std::map<DWORD, LeakTracker> leaks_; // open handles for each process
+  StackTable stacks_;                  // stacks opening the handles
+  std::set<EntryPoint const *>
+      memoryEntryPoints_; // entry points changing the address space
+  std::map<DWORD, VirtualMemoryMap> memory_; // address space of each process
+  std::map<EntryPoint const *, FileIoStats::Op>
+      fileIoOps_;      // file I/O entry points with their operation
+  FileIoStats fileIo_;       // file I/O for each file path
+  RedundantCalls redundant_; // calls repeated with the same arguments
+  std::map<EntryPoint const *, RegistryProfile::Op>
+      registryOps_;          // registry entry points with their operation
+  RegistryProfile registry_; // registry access for each key
+  std::map<EntryPoint const *, SmallIoDetector::Op>
+      smallIoOps_; // read, write and I/O control entry points
+  SmallIoDetector smallIo_{
+      SmallIoDetector::Settings{}}; // small and misaligned I/O on each handle
+  std::map<EntryPoint const *, size_t>
+      waitArgs_;       // wait entry points with the argument waited on
+  WaitProfiler waits_; // time blocked in waits
+  LONGLONG epoch_{};   // performance counter at startup
+
+  std::map<DWORD, LONGLONG> callStart_; // per thread time of the pre-call trap
+  FoldedStacks folded_;
+  CallTotals totals_; // calls by process, category and function
+  std::map<DWORD, std::string> imageNames_; // image file name of each process
+
+  void fold(HANDLE hProcess, HANDLE hThread, CONTEXT const &Context,
+            EntryPoint const &entryPoint, LONGLONG elapsed);
+  void countTotals(DWORD processId, EntryPoint const &entryPoint, NTSTATUS rc,
+                   LONGLONG elapsed);
+
   bool OnBreakpoint(DWORD processId, DWORD threadId, HANDLE hProcess,
                     HANDLE hThread, LPVOID exceptionAddress);
 
+  void record(DWORD processId, DWORD threadId, EntryPoint const &entryPoint,
+              LONGLONG time, ULONG_PTR result,
+              std::vector<Argument::ARG> const *args);
+  void traceJson(DWORD processId, DWORD threadId, HANDLE hProcess,
+                 HANDLE hThread, CONTEXT const &Context,
+                 EntryPoint const &entryPoint, bool before);
+  void chromeCall(DWORD processId, DWORD threadId, HANDLE hProcess,
+                  EntryPoint const &entryPoint, NTSTATUS rc,
+                  std::vector<Argument::ARG> const *args, LONGLONG end,
+                  LONGLONG elapsed);
+  void chromeEvent(DWORD processId, DWORD threadId, std::string const &name,
+                   std::string const &category,
+                   std::vector<ChromeTrace::Arg> const &args);
+  void writeFlight(DWORD processId, std::string const &reason);
+
+  HandleTable const *handleTable(DWORD processId);
+  void trackHandles(DWORD processId, HANDLE hProcess, HANDLE hThread,
+                    CONTEXT const &Context, EntryPoint const &entryPoint,
+                    NTSTATUS rc, std::vector<Argument::ARG> const *args,
+                    uint64_t now);
+  void reportLeaks(DWORD processId);
+  void trackMemory(DWORD processId, HANDLE hProcess, HANDLE hThread,
+                   CONTEXT const &Context, EntryPoint const &entryPoint,
+                   NTSTATUS rc, std::vector<Argument::ARG> const *args,
+                   uint64_t now);
+  void reportMemory(DWORD processId);
+  void checkRedundant(DWORD processId, DWORD threadId, HANDLE hProcess,
+                      HANDLE hThread, CONTEXT const &Context,
+                      EntryPoint const &entryPoint, NTSTATUS rc,
+                      std::vector<Argument::ARG> const *args);
+  void countFileIo(DWORD processId, HANDLE hProcess,
+                   EntryPoint const &entryPoint, FileIoStats::Op op,
+                   NTSTATUS rc, std::vector<Argument::ARG> const *args,
+                   LONGLONG elapsed);
+  void countRegistry(DWORD processId, HANDLE hProcess,
+                     EntryPoint const &entryPoint, RegistryProfile::Op op,
+                     NTSTATUS rc, std::vector<Argument::ARG> const *args);
+  void detectSmallIo(DWORD processId, HANDLE hProcess,
+                     EntryPoint const &entryPoint, SmallIoDetector::Op op,
+                     NTSTATUS rc, std::vector<Argument::ARG> const *args,
+                     LONGLONG elapsed);
+  void profileWait(DWORD processId, DWORD threadId, HANDLE hProcess,
+                   HANDLE hThread, CONTEXT const &Context,
+                   EntryPoint const &entryPoint, size_t argument,
+                   std::vector<Argument::ARG> const *args, LONGLONG end,
+                   LONGLONG elapsed);
+
   void SetDllBreakpoints(HANDLE hProcess);
+  FilterProgram const *whereProgram(EntryPoint const &entryPoint);
+  TriggerPrograms const *triggerPrograms(EntryPoint const &entryPoint);
+  bool isTrigger(EntryPoint const &entryPoint);
+  bool setTrap(HANDLE hProcess, EntryPoint &entryPoint,
+               FilterProgram const *filter, bool trace);
+  void setTracing(bool tracing);
   void showUnused(std::set<std::string> const &unused, std::string const &name);
+  void checkFilter(FilterExpression const &filter) const;
   void showModuleNameEx(HANDLE hProcess, PVOID lpModuleBase,
                         HANDLE hFile) const;
   void header(DWORD processId, DWORD threadId);
@@ -267,6 +506,22 @@ std::string now() {
   return result;
 }
 
+// Get the ID of the process that created a process, or zero if not known
+DWORD parentProcessId(HANDLE hProcess) {
+  static auto *const pfnNtQueryInformationProcess =
+      (NtQueryInformationProcess *)(uintptr_t)::GetProcAddress(
+          ::GetModuleHandle("NTDLL"), "NtQueryInformationProcess");
+
+  PROCESS_BASIC_INFORMATION ProcessInformation{};
+  if (pfnNtQueryInformationProcess == nullptr ||
+      !NT_SUCCESS(pfnNtQueryInformationProcess(
+          hProcess, ProcessBasicInformation, &ProcessInformation,
+          sizeof(ProcessInformation), nullptr))) {
+    return 0;
+  }
+  return static_cast<DWORD>(ProcessInformation.InheritedFromUniqueProcessId);
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // Return string for 'delta time' - seconds + milliseconds (+[ss]s.mmm)
 std::string delta() {
@@ -318,6 +573,44 @@ bool bNewline(false);
 std::string configFile; // override default config file
 
 std::string exportFile; // Export symbols here once loaded
+
+std::string foldedFile;  // Write folded stacks here on exit
+bool bFoldedTime(false); // Weight folded stacks by time rather than count
+
+std::string flightFile;   // Record calls and write dumps with this prefix
+unsigned int flightMB(4); // Size of the flight recorder for each process
+
+bool bHandles(false); // Annotate handle arguments with object names
+bool bLeaks(false);   // Report handles still open when a process exits
+bool bMemory(false);  // Report virtual memory activity when a process exits
+
+unsigned int fileIoTop(0);    // Report file I/O for this number of files
+unsigned int redundantTop(0); // Report this number of redundant calls
+unsigned int registryTop(0);  // Report registry access for this number of keys
+unsigned int smallIoTop(0);   // Report small I/O on this number of handles
+
+unsigned int waitTop(0);  // Report waits on this number of objects
+std::string waitTimeline; // Write the timeline of waits here on exit
+
+std::string chromeFile;       // Write a Chrome trace of the calls here
+unsigned int chromeSlice(0); // Split the Chrome trace into slices of seconds
+
+std::string totalsFile; // Write the totals of the calls here on exit
+
+bool profileWaits() { return waitTop != 0 || !waitTimeline.empty(); }
+
+// Module loads are tracked for stack walking
+bool trackModules() {
+  return bStackTrace || !foldedFile.empty() || bLeaks || bMemory ||
+         redundantTop != 0 || profileWaits();
+}
+
+// The names of open handles are needed for annotation and by the reports
+// identifying objects by name
+bool trackHandleNames() {
+  return bHandles || fileIoTop != 0 || redundantTop != 0 || registryTop != 0 ||
+         smallIoTop != 0 || profileWaits();
+}
 } // namespace
 
 //////////////////////////////////////////////////////////////////////////
@@ -445,6 +738,15 @@ void TrapNtDebugger::populateOffsets() {
 //////////////////////////////////////////////////////////////////////////
 // Print common header to trace lines
 void TrapNtDebugger::header(DWORD processId, DWORD threadId) {
+  if (shards_) {
+    shards_->source(processId, threadId);
+  }
+  if (jsonText_) {
+    // Each line is written as an event with its own time and IDs
+    jsonText_->source(now(), processId, threadId);
+    return;
+  }
+
   if (bTimestamp || bDelta) {
     if (bTimestamp)
       os_ << now();
@@ -469,6 +771,98 @@ void TrapNtDebugger::header(DWORD processId, DWORD threadId) {
   }
 }
 
+//////////////////////////////////////////////////////////////////////////
+namespace {
+// Supply the values of a trapped call to a filter program: the arguments are
+// only read from the target if the filter uses them
+class CallFilter : public FilterContext {
+public:
+  CallFilter(DWORD processId, DWORD threadId, HANDLE hProcess,
+             CONTEXT const &Context, EntryPoint const &entryPoint)
+      : processId_(processId), threadId_(threadId), hProcess_(hProcess),
+        entryPoint_(entryPoint) {
+#ifdef _M_IX86
+    stack_ = Context.Esp;
+    returnCode_ = Context.Eax;
+#elif _M_X64
+    stack_ = Context.Rsp;
+    returnCode_ = Context.Rax;
+#endif
+  }
+
+  bool evaluate(FilterProgram const &program) {
+    return program.evaluate(*this);
+  }
+
+  // Get the argument values, or nullptr if they cannot be read
+  std::vector<Argument::ARG> const *arguments() {
+    return readArguments() ? &args_ : nullptr;
+  }
+
+  int64_t integer(unsigned field) override {
+    switch (field) {
+    case fieldStatus:
+      return entryPoint_.getReturnType() == retNTSTATUS
+                 ? static_cast<ULONG>(returnCode_)
+                 : static_cast<int64_t>(returnCode_);
+    case fieldError:
+      return !NT_SUCCESS(static_cast<NTSTATUS>(returnCode_));
+    case fieldPid:
+      return processId_;
+    case fieldTid:
+      return threadId_;
+    default: {
+      size_t const idx = field - fieldArgument;
+      return readArguments() && idx < args_.size()
+                 ? static_cast<int64_t>(args_[idx])
+                 : 0;
+    }
+    }
+  }
+
+  bool string(unsigned field, std::string &value) override {
+    size_t const idx = field - fieldArgument;
+    if (field < fieldArgument || !readArguments() || idx >= args_.size()) {
+      return false;
+    }
+    switch (entryPoint_.getArgument(idx).getArgType()) {
+    case argPOBJECT_ATTRIBUTES:
+      return readObjectName(
+          hProcess_, reinterpret_cast<POBJECT_ATTRIBUTES>(args_[idx]), value);
+    case argPUNICODE_STRING:
+      return readUnicodeString(
+          hProcess_, reinterpret_cast<PUNICODE_STRING>(args_[idx]), value);
+    default:
+      return false;
+    }
+  }
+
+private:
+  bool readArguments() {
+    if (!argsRead_) {
+      argsRead_ = true;
+      args_.resize(entryPoint_.getArgumentCount());
+      argsOk_ = args_.empty() ||
+                ReadProcessMemory(hProcess_,
+                                  (LPVOID)(stack_ + sizeof(Argument::ARG)),
+                                  &args_[0], sizeof(Argument::ARG) * args_.size(),
+                                  nullptr);
+    }
+    return argsOk_;
+  }
+
+  DWORD processId_;
+  DWORD threadId_;
+  HANDLE hProcess_;
+  EntryPoint const &entryPoint_;
+  Argument::ARG stack_{};
+  Argument::ARG returnCode_{};
+  std::vector<Argument::ARG> args_;
+  bool argsRead_{};
+  bool argsOk_{};
+};
+} // namespace
+
 //////////////////////////////////////////////////////////////////////////
 // The heart of NtTrace: if this is one of our added breakpoint exceptions
 // then trace the arguments and return code for the entry point.
@@ -482,32 +876,159 @@ bool TrapNtDebugger::OnBreakpoint(DWORD processId, DWORD threadId,
     return false; // We couldn't handle this breakpoint
   }
 
+  uint64_t const now = GetTickCount64();
+  if (trigger_.tick(now)) {
+    setTracing(false);
+  }
+
+  if (retired_.count(exceptionAddress)) {
+    // The trap was removed after this breakpoint was hit, so resume at the
+    // restored instruction
+#ifdef _M_IX86
+    Context.Eip = reinterpret_cast<DWORD>(exceptionAddress);
+#elif _M_X64
+    Context.Rip = reinterpret_cast<DWORD64>(exceptionAddress);
+#endif
+    Context.ContextFlags = CONTEXT_CONTROL;
+    if (!SetThreadContext(hThread, &Context)) {
+      os_ << "Can't set thread context: " << displayError() << std::endl;
+    }
+    return true; // Breakpoint handled
+  }
+
   NTCALLS::const_iterator it = NtPreSave_.find(exceptionAddress);
   if (it != NtPreSave_.end()) {
     it->second.entryPoint_->doPreSave(hProcess, hThread, Context);
-    if (bPreTrace) {
-      header(processId, threadId);
+    if (bPreTrace && it->second.trace_ && trigger_.tracing()) {
+      if (json_) {
+        traceJson(processId, threadId, hProcess, hThread, Context,
+                  *it->second.entryPoint_, true);
+      } else {
+        header(processId, threadId);
 
-      it->second.entryPoint_->trace(os_, hProcess, hThread, Context, bNames,
-                                    bStackTrace, true);
+        it->second.entryPoint_->trace(os_, hProcess, hThread, Context, bNames,
+                                      bStackTrace, true,
+                                      handleTable(processId));
+      }
+    }
+    if (bFoldedTime || fileIoTop || smallIoTop || chrome_ ||
+        !totalsFile.empty() ||
+        waitArgs_.count(it->second.entryPoint_)) {
+      LARGE_INTEGER start;
+      QueryPerformanceCounter(&start);
+      callStart_[threadId] = start.QuadPart;
     }
     return true; // Breakpoint handled
   }
   it = NtCalls_.find(exceptionAddress);
   if (it != NtCalls_.end()) {
-    it->second.entryPoint_->countCall();
+    LARGE_INTEGER end;
+    QueryPerformanceCounter(&end);
 #ifdef _M_IX86
     const auto rc{static_cast<NTSTATUS>(Context.Eax)};
 #elif _M_X64
     const auto rc{static_cast<NTSTATUS>(Context.Rax)};
 #endif
-    if (bErrorsOnly && NT_SUCCESS(rc)) {
+    CallFilter call(processId, threadId, hProcess, Context,
+                    *it->second.entryPoint_);
+    TriggerPrograms const *const triggers =
+        trigger_.enabled() ? triggerPrograms(*it->second.entryPoint_)
+                           : nullptr;
+    if (triggers && start_ && call.evaluate(triggers->start) &&
+        trigger_.startCall(now)) {
+      setTracing(true);
+    }
+
+    // Ticks spent in the call, if the pre-call trap was hit
+    LONGLONG elapsed(-1);
+    const auto start = callStart_.find(threadId);
+    if (start != callStart_.end()) {
+      elapsed = end.QuadPart - start->second;
+      callStart_.erase(start);
+    }
+
+    bool const traced = it->second.trace_ && trigger_.tracing();
+    if (traced) {
+      it->second.entryPoint_->countCall();
+      if (!totalsFile.empty()) {
+        countTotals(processId, *it->second.entryPoint_, rc, elapsed);
+      }
+      if (redundantTop) {
+        checkRedundant(processId, threadId, hProcess, hThread, Context,
+                       *it->second.entryPoint_, rc, call.arguments());
+      }
+    }
+    if (!traced) {
       // don't trace
-    } else if (errorCodes_.empty() || (errorCodes_.count(rc) > 0)) {
-      header(processId, threadId);
+    } else if (bErrorsOnly && NT_SUCCESS(rc)) {
+      // don't trace
+    } else if (!errorCodes_.empty() && (errorCodes_.count(rc) == 0)) {
+      // don't trace
+    } else if (it->second.filter_ && !call.evaluate(*it->second.filter_)) {
+      // don't trace
+    } else {
+      if (!flightFile.empty()) {
+        record(processId, threadId, *it->second.entryPoint_, end.QuadPart,
+               static_cast<ULONG_PTR>(rc), call.arguments());
+      } else if (json_) {
+        traceJson(processId, threadId, hProcess, hThread, Context,
+                  *it->second.entryPoint_, false);
+      } else {
+        header(processId, threadId);
 
-      it->second.entryPoint_->trace(os_, hProcess, hThread, Context, bNames,
-                                    bStackTrace, false);
+        it->second.entryPoint_->trace(os_, hProcess, hThread, Context, bNames,
+                                      bStackTrace, false,
+                                      handleTable(processId));
+      }
+      if (!foldedFile.empty()) {
+        fold(hProcess, hThread, Context, *it->second.entryPoint_, elapsed);
+      }
+      if (chrome_) {
+        chromeCall(processId, threadId, hProcess, *it->second.entryPoint_, rc,
+                   call.arguments(), end.QuadPart, elapsed);
+      }
+    }
+
+    if (handleEntryPoints_.count(it->second.entryPoint_)) {
+      trackHandles(processId, hProcess, hThread, Context,
+                   *it->second.entryPoint_, rc, call.arguments(), now);
+    }
+    if (memoryEntryPoints_.count(it->second.entryPoint_)) {
+      trackMemory(processId, hProcess, hThread, Context,
+                  *it->second.entryPoint_, rc, call.arguments(), now);
+    }
+    const auto fileIo = fileIoOps_.find(it->second.entryPoint_);
+    if (fileIo != fileIoOps_.end()) {
+      countFileIo(processId, hProcess, *it->second.entryPoint_, fileIo->second,
+                  rc, call.arguments(), elapsed);
+    }
+    const auto registry = registryOps_.find(it->second.entryPoint_);
+    if (registry != registryOps_.end()) {
+      countRegistry(processId, hProcess, *it->second.entryPoint_,
+                    registry->second, rc, call.arguments());
+    }
+    const auto smallIo = smallIoOps_.find(it->second.entryPoint_);
+    if (smallIo != smallIoOps_.end()) {
+      detectSmallIo(processId, hProcess, *it->second.entryPoint_,
+                    smallIo->second, rc, call.arguments(), elapsed);
+    }
+    const auto wait = waitArgs_.find(it->second.entryPoint_);
+    if (wait != waitArgs_.end() && elapsed >= 0) {
+      profileWait(processId, threadId, hProcess, hThread, Context,
+                  *it->second.entryPoint_, wait->second, call.arguments(),
+                  end.QuadPart, elapsed);
+    }
+
+    if (traced && flightCodes_.count(rc)) {
+      std::ostringstream reason;
+      reason << it->second.entryPoint_->getName() << " returned 0x" << std::hex
+             << static_cast<ULONG>(rc);
+      writeFlight(processId, reason.str());
+    }
+
+    if (triggers && stop_ && call.evaluate(triggers->stop) &&
+        trigger_.stopCall(now)) {
+      setTracing(false);
     }
 
     if (it->second.trapType_ == NtCall::trapReturn ||
@@ -544,6 +1065,724 @@ bool TrapNtDebugger::OnBreakpoint(DWORD processId, DWORD threadId,
   return false; // Not an NtTrace breakpoint
 }
 
+//////////////////////////////////////////////////////////////////////////
+namespace {
+// Convert performance counter ticks to microseconds
+uint64_t microseconds(LONGLONG ticks) {
+  static LARGE_INTEGER frequency;
+  if (frequency.QuadPart == 0) {
+    QueryPerformanceFrequency(&frequency);
+  }
+  return static_cast<uint64_t>(ticks * 1000000 / frequency.QuadPart);
+}
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// Add a call to the totals, with its duration if the pre-call trap was hit
+void TrapNtDebugger::countTotals(DWORD processId, EntryPoint const &entryPoint,
+                                 NTSTATUS rc, LONGLONG elapsed) {
+  const auto image = imageNames_.find(processId);
+  totals_.add(image == imageNames_.end() ? std::to_string(processId)
+                                         : image->second,
+              entryPoint.getCategory(), entryPoint.getName(),
+              (static_cast<ULONG>(rc) >> 30) == 3,
+              elapsed < 0 ? -1 : static_cast<int64_t>(microseconds(elapsed)));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Add the stack for a call to the folded stacks, weighted by count or by the
+// ticks 'elapsed' since the pre-call trap
+void TrapNtDebugger::fold(HANDLE hProcess, HANDLE hThread,
+                          CONTEXT const &Context, EntryPoint const &entryPoint,
+                          LONGLONG elapsed) {
+  uint64_t weight(1);
+  if (bFoldedTime) {
+    if (elapsed < 0) {
+      return;
+    }
+    weight = microseconds(elapsed);
+  }
+
+  std::vector<std::string> functions;
+  EntryPoint::stackFunctions(hProcess, hThread, Context, functions);
+  folded_.add(entryPoint.getCategory(), entryPoint.getName(), functions,
+              weight);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Add a call to the Chrome trace as a slice on the track of its thread,
+// timed from the pre-call trap when it was hit
+void TrapNtDebugger::chromeCall(DWORD processId, DWORD threadId,
+                                HANDLE hProcess, EntryPoint const &entryPoint,
+                                NTSTATUS rc,
+                                std::vector<Argument::ARG> const *args,
+                                LONGLONG end, LONGLONG elapsed) {
+  std::vector<ChromeTrace::Arg> details;
+  if (args) {
+    HandleTable const &table = handles_[processId];
+    for (size_t idx = 0; idx != entryPoint.getArgumentCount(); ++idx) {
+      Argument const &argument = entryPoint.getArgument(idx);
+      if (idx >= args->size()) {
+        break;
+      }
+      std::ostringstream oss;
+      argument.showArgument(oss, hProcess, (*args)[idx], NT_SUCCESS(rc), false,
+                            false);
+      if (argument.getArgType() == argHANDLE) {
+        if (std::string const *name = table.find((*args)[idx])) {
+          oss << " \"" << *name << '"';
+        }
+      }
+      details.push_back({argument.getName(), oss.str()});
+    }
+  }
+  std::ostringstream result;
+  showDword(result, static_cast<ULONG_PTR>(rc));
+  details.push_back({"result", result.str()});
+
+  LONGLONG const start = elapsed < 0 ? end : end - elapsed;
+  chrome_->complete(processId, threadId, microseconds(start - epoch_),
+                    elapsed < 0 ? 0 : microseconds(elapsed),
+                    entryPoint.getName(), entryPoint.getCategory(), details);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Add a debug event to the Chrome trace at the current time
+void TrapNtDebugger::chromeEvent(DWORD processId, DWORD threadId,
+                                 std::string const &name,
+                                 std::string const &category,
+                                 std::vector<ChromeTrace::Arg> const &args) {
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  chrome_->instant(processId, threadId, microseconds(now.QuadPart - epoch_),
+                   name, category, args);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Add a call to the flight recorder for the process
+void TrapNtDebugger::record(DWORD processId, DWORD threadId,
+                            EntryPoint const &entryPoint, LONGLONG time,
+                            ULONG_PTR result,
+                            std::vector<Argument::ARG> const *args) {
+  const auto id = flightIds_.try_emplace(
+      &entryPoint, static_cast<uint32_t>(flightNames_.size()));
+  if (id.second) {
+    flightNames_.push_back(entryPoint.getName());
+  }
+  auto &recorder =
+      flight_.try_emplace(processId, size_t(flightMB) * 1024 * 1024)
+          .first->second;
+  recorder.add(static_cast<uint64_t>(time), threadId, id.first->second,
+               result, args ? args->data() : nullptr,
+               args ? args->size() : 0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Write a call as a JSON Lines event. The stack trace, if wanted, is given as
+// an id; the frames are written in a "stack" event the first time each stack
+// is seen.
+void TrapNtDebugger::traceJson(DWORD processId, DWORD threadId,
+                               HANDLE hProcess, HANDLE hThread,
+                               CONTEXT const &Context,
+                               EntryPoint const &entryPoint, bool before) {
+  uint32_t stack{};
+  if (bStackTrace && !before) {
+    std::vector<std::string> frames;
+    EntryPoint::stackFunctions(hProcess, hThread, Context, frames);
+    stack = stacks_.intern(frames);
+    if (stack >= jsonStacks_.size()) {
+      jsonStacks_.resize(stacks_.size());
+    }
+    if (stack != 0 && !jsonStacks_[stack]) {
+      jsonStacks_[stack] = true;
+      json_->beginObject().member("event", "stack").member("id", stack);
+      json_->key("frames").beginArray();
+      for (auto const &frame : frames) {
+        json_->value(frame);
+      }
+      json_->endArray().endObject();
+      json_->endLine();
+    }
+  }
+
+  json_->beginObject()
+      .member("event", before ? "pre" : "call")
+      .member("time", now())
+      .member("pid", static_cast<uint32_t>(processId))
+      .member("tid", static_cast<uint32_t>(threadId));
+  entryPoint.traceJson(*json_, hProcess, Context, before,
+                       handleTable(processId));
+  if (stack != 0) {
+    json_->member("stack", stack);
+  }
+  json_->endObject();
+  json_->endLine();
+  json_->flush();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Write the flight recorder for a process to a new dump file. The recorder
+// is then emptied so successive dumps do not repeat the same calls.
+void TrapNtDebugger::writeFlight(DWORD processId, std::string const &reason) {
+  const auto it = flight_.find(processId);
+  if (it == flight_.end() || it->second.empty()) {
+    return;
+  }
+  const std::string fileName = flightFile + "-" + std::to_string(processId) +
+                               "-" + std::to_string(++flightDumps_) + ".ntfr";
+  std::ofstream ofs(fileName, std::ios::binary);
+  if (!ofs) {
+    std::cerr << "Cannot open: " << fileName << std::endl;
+    return;
+  }
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+  it->second.write(ofs, processId, static_cast<uint64_t>(frequency.QuadPart),
+                   reason, flightNames_);
+  os_ << "Flight recorder: " << reason << ": wrote " << it->second.size()
+      << " calls to " << fileName << std::endl;
+  it->second.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TrapNtDebugger::writeFlight(std::string const &reason) {
+  for (const auto &it : flight_) {
+    writeFlight(it.first, reason);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Get the handle table for a process, or nullptr if handles are not tracked
+HandleTable const *TrapNtDebugger::handleTable(DWORD processId) {
+  return bHandles ? &handles_[processId] : nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////
+namespace {
+// Get the object type from the name of the output handle argument, for
+// example "KeyHandle" gives "Key"
+std::string objectType(std::string const &argName,
+                       std::string const &category) {
+  std::string type(argName);
+  std::string const suffix("Handle");
+  if (type.size() >= suffix.size() &&
+      type.compare(type.size() - suffix.size(), suffix.size(), suffix) == 0) {
+    type.resize(type.size() - suffix.size());
+  }
+  if (type.size() > 1 && type[0] == 'p' &&
+      isupper(static_cast<unsigned char>(type[1]))) {
+    type.erase(0, 1);
+  }
+  return type.empty() ? category : type;
+}
+
+// Read a handle returned through a PHANDLE argument
+ULONG_PTR readHandle(HANDLE hProcess, Argument::ARG pHandle) {
+  HANDLE handle{};
+  if (!ReadProcessMemory(hProcess, reinterpret_cast<LPCVOID>(pHandle), &handle,
+                         sizeof(handle), nullptr)) {
+    handle = nullptr;
+  }
+  return reinterpret_cast<ULONG_PTR>(handle);
+}
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// Update the handle table and the leak tracker for a process after a call
+// opening, duplicating or closing a handle. The names come from the arguments
+// of the call, so no further queries of the target process are needed.
+void TrapNtDebugger::trackHandles(DWORD processId, HANDLE hProcess,
+                                  HANDLE hThread, CONTEXT const &Context,
+                                  EntryPoint const &entryPoint, NTSTATUS rc,
+                                  std::vector<Argument::ARG> const *args,
+                                  uint64_t now) {
+  if (args == nullptr) {
+    return;
+  }
+  HandleTable *const table =
+      trackHandleNames() ? &handles_[processId] : nullptr;
+  LeakTracker *const leaks =
+      bLeaks ? &leaks_.try_emplace(processId).first->second : nullptr;
+  std::string const &name = entryPoint.getName();
+  if (name == "NtClose") {
+    if (NT_SUCCESS(rc) && !args->empty()) {
+      if (table) {
+        table->closed((*args)[0]);
+      }
+      if (leaks) {
+        leaks->closed((*args)[0], now);
+      }
+      if (smallIoTop) {
+        smallIo_.close(processId, (*args)[0]);
+      }
+    }
+    return;
+  }
+
+  auto const creatingStack = [&]() {
+    std::vector<std::string> frames;
+    EntryPoint::stackFunctions(hProcess, hThread, Context, frames);
+    return stacks_.intern(frames);
+  };
+
+  if (name == "NtDuplicateObject") {
+    // Only duplicates within the traced process are followed
+    Argument::ARG const currentProcess = static_cast<Argument::ARG>(-1);
+    if (args->size() < 7 || (*args)[0] != currentProcess) {
+      return;
+    }
+    Argument::ARG const source = (*args)[1];
+    if (NT_SUCCESS(rc) && (*args)[2] == currentProcess && (*args)[3]) {
+      ULONG_PTR const target = readHandle(hProcess, (*args)[3]);
+      if (table) {
+        table->duplicated(source, target);
+      }
+      if (leaks) {
+        leaks->duplicated(source, target, creatingStack(), now);
+      }
+    }
+    if ((*args)[6] & DUPLICATE_CLOSE_SOURCE) {
+      if (table) {
+        table->closed(source);
+      }
+      if (leaks) {
+        leaks->closed(source, now);
+      }
+    }
+    return;
+  }
+
+  if (!NT_SUCCESS(rc)) {
+    return;
+  }
+  // The first output handle is the new handle; the first object attributes
+  // give its name
+  Argument const *handleArgument{};
+  Argument::ARG pHandle{};
+  Argument::ARG pObjectAttributes{};
+  for (size_t idx = 0; idx != entryPoint.getArgumentCount(); ++idx) {
+    Argument const &argument = entryPoint.getArgument(idx);
+    if (!handleArgument && argument.outputOnly() &&
+        argument.getArgTypeName() == "PHANDLE") {
+      handleArgument = &argument;
+      pHandle = (*args)[idx];
+    } else if (!pObjectAttributes &&
+               argument.getArgType() == argPOBJECT_ATTRIBUTES) {
+      pObjectAttributes = (*args)[idx];
+    }
+  }
+  if (!pHandle) {
+    return;
+  }
+  ULONG_PTR const handle = readHandle(hProcess, pHandle);
+  if (table) {
+    std::string objectName;
+    HANDLE root{};
+    (void)readObjectName(
+        hProcess, reinterpret_cast<POBJECT_ATTRIBUTES>(pObjectAttributes),
+        objectName, &root);
+    table->opened(handle, objectName, reinterpret_cast<ULONG_PTR>(root));
+  }
+  if (leaks && handle) {
+    leaks->opened(handle,
+                  objectType(handleArgument->getName(),
+                             entryPoint.getCategory()),
+                  entryPoint.getCategory(), creatingStack(), now);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Check for a call repeating one made recently on the same thread. Only the
+// input arguments are compared, with handles replaced by the name of the
+// object, or a placeholder when it is not known.
+void TrapNtDebugger::checkRedundant(DWORD processId, DWORD threadId,
+                                    HANDLE hProcess, HANDLE hThread,
+                                    CONTEXT const &Context,
+                                    EntryPoint const &entryPoint, NTSTATUS rc,
+                                    std::vector<Argument::ARG> const *args) {
+  if (args == nullptr) {
+    return;
+  }
+  HandleTable const &table = handles_[processId];
+  std::vector<std::string> keys;
+  for (size_t idx = 0; idx != entryPoint.getArgumentCount(); ++idx) {
+    Argument const &argument = entryPoint.getArgument(idx);
+    if (argument.outputOnly() || idx >= args->size()) {
+      continue;
+    }
+    // Null and pseudo handles are kept as values
+    if (argument.getArgType() == argHANDLE &&
+        static_cast<LONG_PTR>((*args)[idx]) > 0) {
+      keys.push_back(
+          RedundantCalls::handleKey(table.find((*args)[idx]), (*args)[idx]));
+      continue;
+    }
+    std::ostringstream oss;
+    argument.showArgument(oss, hProcess, (*args)[idx], NT_SUCCESS(rc), false,
+                          false);
+    keys.push_back(RedundantCalls::normalize(oss.str()));
+  }
+
+  RedundantCalls::Offender *const offender =
+      redundant_.add(threadId, entryPoint.getName(), keys);
+  if (offender && offender->stack == 0) {
+    std::vector<std::string> frames;
+    EntryPoint::stackFunctions(hProcess, hThread, Context, frames);
+    offender->stack = stacks_.intern(frames);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Add a file I/O call to the statistics for the file. The handle table has
+// already been updated for a successful open.
+void TrapNtDebugger::countFileIo(DWORD processId, HANDLE hProcess,
+                                 EntryPoint const &entryPoint,
+                                 FileIoStats::Op op, NTSTATUS rc,
+                                 std::vector<Argument::ARG> const *args,
+                                 LONGLONG elapsed) {
+  if (args == nullptr) {
+    return;
+  }
+  Argument::ARG fileHandle{};
+  Argument::ARG pObjectAttributes{};
+  Argument::ARG pIoStatusBlock{};
+  Argument::ARG length{};
+  for (size_t idx = 0; idx != entryPoint.getArgumentCount(); ++idx) {
+    Argument const &argument = entryPoint.getArgument(idx);
+    if (argument.getName() == "FileHandle") {
+      fileHandle = (*args)[idx];
+    } else if (argument.getArgType() == argPOBJECT_ATTRIBUTES) {
+      pObjectAttributes = (*args)[idx];
+    } else if (argument.getArgType() == argPIO_STATUS_BLOCK) {
+      pIoStatusBlock = (*args)[idx];
+    } else if (argument.getName() == "Length" ||
+               argument.getName() == "BufferLength") {
+      length = (*args)[idx];
+    }
+  }
+
+  HandleTable const &table = handles_[processId];
+  std::string const *name{};
+  std::string objectName;
+  if (op != FileIoStats::Open) {
+    name = table.find(fileHandle);
+  } else if (NT_SUCCESS(rc) && fileHandle) {
+    name = table.find(readHandle(hProcess, fileHandle));
+  }
+  if (name == nullptr && op == FileIoStats::Open &&
+      readObjectName(hProcess,
+                     reinterpret_cast<POBJECT_ATTRIBUTES>(pObjectAttributes),
+                     objectName)) {
+    // A failed open, or one relative to an unknown directory
+    name = &objectName;
+  }
+
+  uint64_t transferred{};
+  if ((op == FileIoStats::Read || op == FileIoStats::Write) &&
+      NT_SUCCESS(rc) && rc != STATUS_PENDING && pIoStatusBlock) {
+    IO_STATUS_BLOCK ioStatusBlock{};
+    if (ReadProcessMemory(hProcess, reinterpret_cast<LPCVOID>(pIoStatusBlock),
+                          &ioStatusBlock, sizeof(ioStatusBlock), nullptr)) {
+      transferred = ioStatusBlock.Information;
+    }
+  }
+
+  fileIo_.add(name && !name->empty() ? *name : "(unknown)", op,
+              static_cast<ULONG>(length), transferred,
+              elapsed < 0 ? -1 : static_cast<int64_t>(microseconds(elapsed)));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Add a read, write or device I/O control to the small I/O detector. A call
+// still pending is assumed to transfer all the bytes requested.
+void TrapNtDebugger::detectSmallIo(DWORD processId, HANDLE hProcess,
+                                   EntryPoint const &entryPoint,
+                                   SmallIoDetector::Op op, NTSTATUS rc,
+                                   std::vector<Argument::ARG> const *args,
+                                   LONGLONG elapsed) {
+  if (args == nullptr || !NT_SUCCESS(rc)) {
+    return;
+  }
+  Argument::ARG fileHandle{};
+  Argument::ARG pIoStatusBlock{};
+  Argument::ARG pByteOffset{};
+  Argument::ARG controlCode{};
+  uint64_t requested{};
+  for (size_t idx = 0; idx != entryPoint.getArgumentCount(); ++idx) {
+    Argument const &argument = entryPoint.getArgument(idx);
+    std::string const &name = argument.getName();
+    if (name == "FileHandle") {
+      fileHandle = (*args)[idx];
+    } else if (argument.getArgType() == argPIO_STATUS_BLOCK) {
+      pIoStatusBlock = (*args)[idx];
+    } else if (name == "ByteOffset") {
+      pByteOffset = (*args)[idx];
+    } else if (name == "IoControlCode") {
+      controlCode = (*args)[idx];
+    } else if (name == "Length" || name == "InputBufferLength" ||
+               name == "OutputBufferLength") {
+      requested =
+          std::max<uint64_t>(requested, static_cast<ULONG>((*args)[idx]));
+    }
+  }
+
+  // Negative offsets ask for the end of file or the file position
+  uint64_t offset = SmallIoDetector::current;
+  LARGE_INTEGER byteOffset{};
+  if (pByteOffset &&
+      ReadProcessMemory(hProcess, reinterpret_cast<LPCVOID>(pByteOffset),
+                        &byteOffset, sizeof(byteOffset), nullptr) &&
+      byteOffset.QuadPart >= 0) {
+    offset = static_cast<uint64_t>(byteOffset.QuadPart);
+  }
+
+  uint64_t transferred = requested;
+  if (rc != STATUS_PENDING && pIoStatusBlock) {
+    IO_STATUS_BLOCK ioStatusBlock{};
+    if (ReadProcessMemory(hProcess, reinterpret_cast<LPCVOID>(pIoStatusBlock),
+                          &ioStatusBlock, sizeof(ioStatusBlock), nullptr)) {
+      transferred = ioStatusBlock.Information;
+    }
+  }
+
+  std::string const *name = handles_[processId].find(fileHandle);
+  smallIo_.add(processId, fileHandle, name ? *name : std::string(), op,
+               offset, requested, transferred,
+               elapsed < 0 ? -1 : static_cast<int64_t>(microseconds(elapsed)),
+               static_cast<uint32_t>(controlCode));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Add a registry call to the profile for the key. The handle table has
+// already been updated for a successful open.
+void TrapNtDebugger::countRegistry(DWORD processId, HANDLE hProcess,
+                                   EntryPoint const &entryPoint,
+                                   RegistryProfile::Op op, NTSTATUS rc,
+                                   std::vector<Argument::ARG> const *args) {
+  if (args == nullptr) {
+    return;
+  }
+  Argument::ARG keyHandle{};
+  Argument::ARG pObjectAttributes{};
+  Argument::ARG pValueName{};
+  std::string infoClass;
+  for (size_t idx = 0; idx != entryPoint.getArgumentCount(); ++idx) {
+    Argument const &argument = entryPoint.getArgument(idx);
+    if (argument.getName() == "KeyHandle") {
+      keyHandle = (*args)[idx];
+    } else if (argument.getArgType() == argPOBJECT_ATTRIBUTES) {
+      pObjectAttributes = (*args)[idx];
+    } else if (argument.getName() == "ValueName") {
+      pValueName = (*args)[idx];
+    } else if (argument.getName() == "KeyInformationClass" ||
+               argument.getName() == "KeyValueInformationClass") {
+      infoClass = std::to_string((*args)[idx]);
+    }
+  }
+
+  HandleTable const &table = handles_[processId];
+  std::string const *name{};
+  std::string objectName;
+  if (op != RegistryProfile::Open) {
+    name = table.find(keyHandle);
+  } else if (NT_SUCCESS(rc) && keyHandle) {
+    name = table.find(readHandle(hProcess, keyHandle));
+  }
+  HANDLE root{};
+  if (name == nullptr && op == RegistryProfile::Open &&
+      readObjectName(hProcess,
+                     reinterpret_cast<POBJECT_ATTRIBUTES>(pObjectAttributes),
+                     objectName, &root)) {
+    // A failed open, or one relative to a key opened before tracing began
+    std::string const *rootName =
+        root ? table.find(reinterpret_cast<ULONG_PTR>(root)) : nullptr;
+    if (rootName && !objectName.empty() && objectName[0] != '\\') {
+      objectName = *rootName + '\\' + objectName;
+    }
+    name = &objectName;
+  }
+
+  std::string valueName;
+  if (pValueName) {
+    (void)readUnicodeString(hProcess,
+                            reinterpret_cast<PUNICODE_STRING>(pValueName),
+                            valueName);
+  }
+
+  registry_.add(name && !name->empty() ? *name : "(unknown)", op, valueName,
+                static_cast<uint32_t>(rc), infoClass);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Add a completed wait to the profile. Handles are named from the handle
+// table when possible; the handles waited on by NtWaitForMultipleObjects are
+// read from the target process.
+void TrapNtDebugger::profileWait(DWORD processId, DWORD threadId,
+                                 HANDLE hProcess, HANDLE hThread,
+                                 CONTEXT const &Context,
+                                 EntryPoint const &entryPoint, size_t argument,
+                                 std::vector<Argument::ARG> const *args,
+                                 LONGLONG end, LONGLONG elapsed) {
+  if (args == nullptr || argument >= args->size()) {
+    return;
+  }
+  HandleTable const &table = handles_[processId];
+  auto const objectName = [&table](ULONG_PTR handle) {
+    std::string const *name = table.find(handle);
+    if (name && !name->empty()) {
+      return *name;
+    }
+    std::ostringstream oss;
+    oss << "0x" << std::hex << handle;
+    return oss.str();
+  };
+
+  std::string object;
+  if (entryPoint.getArgument(argument).getArgType() != argPHANDLE) {
+    object = objectName(static_cast<ULONG_PTR>((*args)[argument]));
+  } else if (argument != 0) {
+    // An array of handles, preceded by the count
+    bool const wow64 = entryPoint.getName() == "NtWaitForMultipleObjects32";
+    size_t const size = wow64 ? sizeof(ULONG) : sizeof(HANDLE);
+    size_t const count =
+        std::min<size_t>((*args)[argument - 1], MAXIMUM_WAIT_OBJECTS);
+    std::vector<unsigned char> buffer(count * size);
+    if (count &&
+        ReadProcessMemory(hProcess,
+                          reinterpret_cast<LPCVOID>((*args)[argument]),
+                          buffer.data(), buffer.size(), nullptr)) {
+      for (size_t idx = 0; idx != count; ++idx) {
+        ULONG_PTR handle{};
+        memcpy(&handle, &buffer[idx * size], size);
+        object += (idx ? ", " : "") + objectName(handle);
+      }
+    }
+  }
+
+  std::vector<std::string> frames;
+  EntryPoint::stackFunctions(hProcess, hThread, Context, frames);
+
+  WaitProfiler::Wait wait;
+  wait.processId = processId;
+  wait.threadId = threadId;
+  wait.start = microseconds(end - elapsed - epoch_);
+  wait.end = microseconds(end - epoch_);
+  wait.function = entryPoint.getName();
+  wait.object = object.empty() ? "(unknown)" : object;
+  wait.stack = stacks_.intern(frames);
+  waits_.add(std::move(wait));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Report the handles still open in a process
+void TrapNtDebugger::reportLeaks(DWORD processId) {
+  const auto it = leaks_.find(processId);
+  if (it != leaks_.end()) {
+    os_ << "Process " << processId << ": ";
+    it->second.report(os_, stacks_);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TrapNtDebugger::reportLeaks() {
+  for (const auto &it : leaks_) {
+    reportLeaks(it.first);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+namespace {
+// Read a pointer sized value returned through an argument
+ULONG_PTR readPointer(HANDLE hProcess, Argument::ARG pValue) {
+  ULONG_PTR value{};
+  if (!ReadProcessMemory(hProcess, reinterpret_cast<LPCVOID>(pValue), &value,
+                         sizeof(value), nullptr)) {
+    value = 0;
+  }
+  return value;
+}
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// Update the virtual memory map for a process after a successful call
+// changing its own address space. The address and size are returned through
+// pointers, except for the address of a view being unmapped.
+void TrapNtDebugger::trackMemory(DWORD processId, HANDLE hProcess,
+                                 HANDLE hThread, CONTEXT const &Context,
+                                 EntryPoint const &entryPoint, NTSTATUS rc,
+                                 std::vector<Argument::ARG> const *args,
+                                 uint64_t now) {
+  if (args == nullptr || !NT_SUCCESS(rc)) {
+    return;
+  }
+  Argument::ARG process{};
+  Argument::ARG address{};
+  Argument::ARG pSize{};
+  Argument::ARG type{};
+  Argument::ARG protection{};
+  for (size_t idx = 0; idx != entryPoint.getArgumentCount(); ++idx) {
+    std::string const &name = entryPoint.getArgument(idx).getName();
+    if (name == "ProcessHandle") {
+      process = (*args)[idx];
+    } else if (name == "lpAddress" || name == "BaseAddress") {
+      address = (*args)[idx];
+    } else if (name == "pSize" || name == "ViewSize" || name == "Size") {
+      pSize = (*args)[idx];
+    } else if (name == "flAllocationType" || name == "flFreeType") {
+      type = (*args)[idx];
+    } else if (name == "flProtect" || name == "Protect" ||
+               name == "NewProtect") {
+      protection = (*args)[idx];
+    }
+  }
+  Argument::ARG const currentProcess = static_cast<Argument::ARG>(-1);
+  if (process != currentProcess) {
+    return;
+  }
+
+  VirtualMemoryMap &map = memory_.try_emplace(processId).first->second;
+  std::string const &name = entryPoint.getName();
+  if (name.compare(0, 20, "NtUnmapViewOfSection") == 0) {
+    map.unmapView(address, now);
+    return;
+  }
+  auto const allocatingStack = [&]() {
+    std::vector<std::string> frames;
+    EntryPoint::stackFunctions(hProcess, hThread, Context, frames);
+    return stacks_.intern(frames);
+  };
+  uint64_t const base = readPointer(hProcess, address);
+  uint64_t const size = readPointer(hProcess, pSize);
+  if (name.compare(0, 23, "NtAllocateVirtualMemory") == 0) {
+    map.allocate(base, size, static_cast<uint32_t>(type),
+                 static_cast<uint32_t>(protection), allocatingStack(), now);
+  } else if (name == "NtFreeVirtualMemory") {
+    map.release(base, size, static_cast<uint32_t>(type), now);
+  } else if (name == "NtProtectVirtualMemory") {
+    map.protect(base, size, static_cast<uint32_t>(protection), now);
+  } else if (name.compare(0, 18, "NtMapViewOfSection") == 0) {
+    map.mapView(base, size, static_cast<uint32_t>(protection),
+                allocatingStack(), now);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Report the virtual memory activity of a process
+void TrapNtDebugger::reportMemory(DWORD processId) {
+  const auto it = memory_.find(processId);
+  if (it != memory_.end()) {
+    os_ << "Process " << processId << ": ";
+    it->second.report(os_, stacks_);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TrapNtDebugger::reportMemory() {
+  for (const auto &it : memory_) {
+    reportMemory(it.first);
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////
 void TrapNtDebugger::OnException(DWORD processId, DWORD threadId,
                                  HANDLE hProcess, HANDLE hThread,
@@ -551,6 +1790,17 @@ void TrapNtDebugger::OnException(DWORD processId, DWORD threadId,
                                  DWORD *pContinueFlag) {
   const auto status =
       static_cast<NTSTATUS>(Exception.ExceptionRecord.ExceptionCode);
+  if (chrome_ && status != STATUS_BREAKPOINT &&
+      Exception.ExceptionRecord.ExceptionCode != MSVC_NOTIFICATION &&
+      Exception.ExceptionRecord.ExceptionCode != CLR_NOTIFICATION) {
+    std::ostringstream code;
+    std::ostringstream address;
+    code << "0x" << std::hex << Exception.ExceptionRecord.ExceptionCode;
+    address << Exception.ExceptionRecord.ExceptionAddress;
+    chromeEvent(processId, threadId, "Exception " + code.str(), "exception",
+                {{"address", address.str()},
+                 {"chance", Exception.dwFirstChance ? "first" : "last"}});
+  }
   if (status == STATUS_BREAKPOINT) {
     if (OnBreakpoint(processId, threadId, hProcess, hThread,
                      Exception.ExceptionRecord.ExceptionAddress)) {
@@ -588,6 +1838,7 @@ void TrapNtDebugger::OnException(DWORD processId, DWORD threadId,
         << std::endl;
     if (bStackTrace)
       EntryPoint::stackTrace(os_, hProcess, hThread);
+    writeFlight(processId, "Access violation");
   } else if (status == STATUS_INVALID_HANDLE) {
     // CloseHandle raises this exception when a process is being debugged
     header(processId, threadId);
@@ -627,6 +1878,7 @@ void TrapNtDebugger::OnException(DWORD processId, DWORD threadId,
     os_ << std::endl;
     if (bStackTrace)
       EntryPoint::stackTrace(os_, hProcess, hThread);
+    writeFlight(processId, "C++ exception");
   } else if (Exception.ExceptionRecord.ExceptionCode == CLR_EXCEPTION ||
              Exception.ExceptionRecord.ExceptionCode == CLR_EXCEPTION_V4) {
     header(processId, threadId);
@@ -637,11 +1889,19 @@ void TrapNtDebugger::OnException(DWORD processId, DWORD threadId,
   } else if (Exception.ExceptionRecord.ExceptionCode == MSVC_NOTIFICATION) {
     if (Exception.ExceptionRecord.ExceptionInformation[0] == 0x1000) {
       header(processId, threadId);
-      os_ << "SetThreadName \"";
-      showString(os_, hProcess,
+      std::ostringstream name;
+      showString(name, hProcess,
                  (PVOID)Exception.ExceptionRecord.ExceptionInformation[1],
                  FALSE, MAX_PATH);
-      os_ << '"' << std::endl;
+      os_ << "SetThreadName \"" << name.str() << '"' << std::endl;
+      if (chrome_) {
+        // The thread named is given in the exception, or -1 for this thread
+        auto const named = static_cast<DWORD>(
+            Exception.ExceptionRecord.ExceptionInformation[2]);
+        chrome_->threadName(processId,
+                            named == static_cast<DWORD>(-1) ? threadId : named,
+                            name.str());
+      }
     } else {
       header(processId, threadId);
       os_ << "MSVC Notification: "
@@ -675,6 +1935,12 @@ void TrapNtDebugger::OnCreateThread(
   header(processId, threadId);
   os_ << "Created thread: " << threadId << " at " << CreateThread.lpStartAddress
       << std::endl;
+  if (chrome_) {
+    std::ostringstream address;
+    address << CreateThread.lpStartAddress;
+    chromeEvent(processId, threadId, "Created thread", "thread",
+                {{"start", address.str()}});
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -696,30 +1962,84 @@ void TrapNtDebugger::OnCreateProcess(
                      CreateProcessInfo.lpBaseOfImage, CreateProcessInfo.hFile);
   }
   os_ << std::endl;
+
+  if (chrome_) {
+    if (CreateProcessInfo.hFile) {
+      std::string const name = GetFileNameFromHandle(CreateProcessInfo.hFile);
+      if (!name.empty()) {
+        chrome_->processName(processId, name);
+      }
+    }
+    std::ostringstream commandLine;
+    commandLine << CommandLine(CreateProcessInfo.hProcess);
+    chromeEvent(processId, threadId, "Process started", "process",
+                {{"command line", commandLine.str()}});
+  }
+
+  if (!totalsFile.empty() && CreateProcessInfo.hFile) {
+    std::string const name = GetFileNameFromHandle(CreateProcessInfo.hFile);
+    imageNames_[processId] = name.substr(name.find_last_of('\\') + 1);
+  }
+
+  if (shards_) {
+    std::string name;
+    if (CreateProcessInfo.hFile) {
+      name = GetFileNameFromHandle(CreateProcessInfo.hFile);
+      name.erase(0, name.find_last_of('\\') + 1);
+    }
+    shards_->processStarted(processId,
+                            parentProcessId(CreateProcessInfo.hProcess), now(),
+                            name);
+  }
+
+  if (trackModules() && CreateProcessInfo.hFile) {
+    EntryPoint::moduleLoaded(CreateProcessInfo.hProcess,
+                             CreateProcessInfo.lpBaseOfImage,
+                             GetFileNameFromHandle(CreateProcessInfo.hFile));
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////
 void TrapNtDebugger::OnExitThread(DWORD processId, DWORD threadId,
                                   EXIT_THREAD_DEBUG_INFO const &ExitThread) {
-  if (bNoThread_) {
-    // ignore...
-    return;
+  callStart_.erase(threadId);
+  redundant_.threadExit(threadId);
+  waits_.threadExit(threadId);
+  if (!bNoThread_) {
+    header(processId, threadId);
+    os_ << "Thread " << threadId << " exit code: " << ExitThread.dwExitCode
+        << std::endl;
+  }
+  if (shards_) {
+    shards_->threadExited(processId, threadId);
   }
-  header(processId, threadId);
-  os_ << "Thread " << threadId << " exit code: " << ExitThread.dwExitCode
-      << std::endl;
 }
 
 //////////////////////////////////////////////////////////////////////////
 void TrapNtDebugger::OnExitProcess(DWORD processId, DWORD threadId,
-                                   HANDLE /*hProcess*/,
+                                   HANDLE hProcess,
                                    EXIT_PROCESS_DEBUG_INFO const &ExitProcess) {
   header(processId, threadId);
   os_ << "Process " << processId << " exit code: " << ExitProcess.dwExitCode
       << std::endl;
+  if (ExitProcess.dwExitCode != 0) {
+    writeFlight(processId,
+                "Exit code " + std::to_string(ExitProcess.dwExitCode));
+  }
+  flight_.erase(processId);
+  handles_.erase(processId);
+  reportLeaks(processId);
+  leaks_.erase(processId);
+  reportMemory(processId);
+  memory_.erase(processId);
+  EntryPoint::releaseProcess(hProcess);
+  trapped_processes_.erase(hProcess);
   processes_.erase(processId);
   initialised_processes_.erase(processId);
   dll_names_.erase(processId);
+  if (shards_) {
+    shards_->processExited(processId, now(), ExitProcess.dwExitCode);
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -745,6 +2065,28 @@ void TrapNtDebugger::OnLoadDll(DWORD processId, DWORD threadId, HANDLE hProcess,
     os_ << std::endl;
   }
 
+  if (chrome_ && LoadDll.lpBaseOfDll) {
+    const auto it = dll_names_[processId].find(LoadDll.lpBaseOfDll);
+    std::string name;
+    if (it != dll_names_[processId].end()) {
+      name = it->second;
+    } else if (LoadDll.hFile) {
+      name = GetFileNameFromHandle(LoadDll.hFile);
+    }
+    std::ostringstream base;
+    base << LoadDll.lpBaseOfDll;
+    chromeEvent(processId, threadId, "Loaded DLL", "dll",
+                {{"base", base.str()}, {"name", name}});
+  }
+
+  if (trackModules() && LoadDll.lpBaseOfDll && LoadDll.hFile) {
+    const auto it = dll_names_[processId].find(LoadDll.lpBaseOfDll);
+    EntryPoint::moduleLoaded(hProcess, LoadDll.lpBaseOfDll,
+                             it != dll_names_[processId].end()
+                                 ? it->second
+                                 : GetFileNameFromHandle(LoadDll.hFile));
+  }
+
   if (LoadDll.lpBaseOfDll == BaseOfNtDll_) {
     if (bShowLoaderSnaps_) {
       header(processId, threadId);
@@ -771,6 +2113,10 @@ void TrapNtDebugger::OnUnloadDll(DWORD processId, DWORD threadId,
     }
     os_ << std::endl;
   }
+
+  if (trackModules()) {
+    EntryPoint::moduleUnloaded(processes_[processId], UnloadDll.lpBaseOfDll);
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -781,13 +2127,24 @@ void TrapNtDebugger::OnOutputDebugString(
     // If we're not adding newlines then the header is simply confusing
     header(processId, threadId);
   }
+  std::ostringstream text;
   bool const newline =
-      showString(os_, hProcess, DebugString.lpDebugStringData,
+      showString(text, hProcess, DebugString.lpDebugStringData,
                  DebugString.fUnicode, DebugString.nDebugStringLength);
+  os_ << text.str();
   if (!newline && bNewline) {
     os_ << '\n';
   }
   os_ << std::flush;
+
+  if (chrome_) {
+    chromeEvent(processId, threadId, "OutputDebugString", "debug",
+                {{"text", text.str()}});
+  }
+
+  if (trigger_.debugString(text.str(), GetTickCount64())) {
+    setTracing(trigger_.tracing());
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -829,6 +2186,46 @@ bool TrapNtDebugger::listCategories() {
   return result;
 }
 
+//////////////////////////////////////////////////////////////////////////
+namespace {
+// Get the kind of I/O performed by an entry point, or OpCount if none
+SmallIoDetector::Op smallIoOp(EntryPoint const &entryPoint) {
+  static std::map<std::string, SmallIoDetector::Op> const ops{
+      {"NtReadFile", SmallIoDetector::Read},
+      {"NtWriteFile", SmallIoDetector::Write},
+      {"NtDeviceIoControlFile", SmallIoDetector::Control},
+  };
+  const auto it = ops.find(entryPoint.getName());
+  return it == ops.end() ? SmallIoDetector::OpCount : it->second;
+}
+
+// Returns true if the entry point can open or close a handle
+bool opensOrClosesHandles(EntryPoint const &entryPoint) {
+  if (entryPoint.getName() == "NtClose" ||
+      entryPoint.getName() == "NtDuplicateObject") {
+    return true;
+  }
+  for (size_t idx = 0; idx != entryPoint.getArgumentCount(); ++idx) {
+    Argument const &argument = entryPoint.getArgument(idx);
+    if (argument.outputOnly() && argument.getArgTypeName() == "PHANDLE") {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if the entry point can change the address space of a process
+bool changesAddressSpace(EntryPoint const &entryPoint) {
+  static std::set<std::string> const names{
+      "NtAllocateVirtualMemory", "NtAllocateVirtualMemoryEx",
+      "NtFreeVirtualMemory",     "NtMapViewOfSection",
+      "NtMapViewOfSectionEx",    "NtProtectVirtualMemory",
+      "NtUnmapViewOfSection",    "NtUnmapViewOfSectionEx",
+  };
+  return names.count(entryPoint.getName()) != 0;
+}
+} // namespace
+
 //////////////////////////////////////////////////////////////////////////
 // Set up the NT breakpoints loaded from the configuration file
 void TrapNtDebugger::SetDllBreakpoints(HANDLE hProcess) {
@@ -861,21 +2258,73 @@ void TrapNtDebugger::SetDllBreakpoints(HANDLE hProcess) {
       }
     }
 
-    if (bRequired) {
+    FilterProgram const *program = nullptr;
+    if (bRequired && where_) {
+      // No trap is needed for entry points the filter never matches
+      program = whereProgram(entryPoint);
+      if (program->alwaysFalse()) {
+        bRequired = false;
+      } else if (program->alwaysTrue()) {
+        program = nullptr;
+      }
+    }
+
+    bool const bHandleCall =
+        (trackHandleNames() || bLeaks) && opensOrClosesHandles(entryPoint);
+    if (bHandleCall) {
+      handleEntryPoints_.insert(&entryPoint);
+    }
+    FileIoStats::Op const fileOp =
+        fileIoTop ? FileIoStats::operation(entryPoint.getName())
+                  : FileIoStats::OpCount;
+    if (fileOp != FileIoStats::OpCount) {
+      fileIoOps_[&entryPoint] = fileOp;
+    }
+    SmallIoDetector::Op const smallOp =
+        smallIoTop ? smallIoOp(entryPoint) : SmallIoDetector::OpCount;
+    if (smallOp != SmallIoDetector::OpCount) {
+      smallIoOps_[&entryPoint] = smallOp;
+    }
+    RegistryProfile::Op const registryOp =
+        registryTop ? RegistryProfile::operation(entryPoint.getName())
+                    : RegistryProfile::OpCount;
+    if (registryOp != RegistryProfile::OpCount) {
+      registryOps_[&entryPoint] = registryOp;
+    }
+    bool const bMemoryCall = bMemory && changesAddressSpace(entryPoint);
+    if (bMemoryCall) {
+      memoryEntryPoints_.insert(&entryPoint);
+    }
+    size_t waitArg{};
+    bool const bWait =
+        profileWaits() && WaitProfiler::isWait(entryPoint.getName(), waitArg);
+    if (bWait) {
+      waitArgs_[&entryPoint] = waitArg;
+    }
+
+    // Triggers, and calls maintaining the handle table, the memory map or the
+    // file I/O, registry, small I/O and wait statistics, are always trapped;
+    // other entry points only while tracing
+    bool const bTrigger = trigger_.enabled() && isTrigger(entryPoint);
+    bool const bAlways = bTrigger || bHandleCall || bMemoryCall ||
+                         fileOp != FileIoStats::OpCount ||
+                         smallOp != SmallIoDetector::OpCount ||
+                         registryOp != RegistryProfile::OpCount || bWait;
+    if (bRequired || bAlways) {
       auto &ep = const_cast<EntryPoint &>(
           entryPoint); // set iterator returns const object :-(
-      NtCall const nt = ep.setNtTrap(hProcess, TargetDll_, bPreTrace,
-                                     offsets_[ep.getName()], bVerbose);
-      if (nt.entryPoint_ != nullptr) {
-        NtCalls_[ep.getAddress()] = nt;
-        if (ep.getPreSave()) {
-          NtPreSave_[ep.getPreSave()] = nt;
+      if (!bAlways) {
+        traced_[&ep] = program;
+      }
+      if (bAlways || trigger_.tracing()) {
+        if (setTrap(hProcess, ep, program, bRequired)) {
+          ++trapped;
         }
-        ++trapped;
+        ++total;
       }
-      ++total;
     }
   }
+  trapped_processes_.insert(hProcess);
 
   showUnused(unusedCategories, "category");
   showUnused(unusedFilters, "filter");
@@ -918,6 +2367,136 @@ void TrapNtDebugger::SetDllBreakpoints(HANDLE hProcess) {
   FlushInstructionCache(hProcess, nullptr, 0);
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Set the trap for an entry point in one process
+bool TrapNtDebugger::setTrap(HANDLE hProcess, EntryPoint &entryPoint,
+                             FilterProgram const *filter, bool trace) {
+  NtCall nt =
+      entryPoint.setNtTrap(hProcess, TargetDll_,
+                           bPreTrace || bFoldedTime || chrome_ ||
+                               fileIoOps_.count(&entryPoint) != 0 ||
+                               smallIoOps_.count(&entryPoint) != 0 ||
+                               waitArgs_.count(&entryPoint) != 0,
+                           offsets_[entryPoint.getName()], bVerbose);
+  if (nt.entryPoint_ == nullptr) {
+    return false;
+  }
+  nt.filter_ = filter;
+  nt.trace_ = trace;
+  NtCalls_[entryPoint.getAddress()] = nt;
+  retired_.erase(entryPoint.getAddress());
+  if (entryPoint.getPreSave()) {
+    NtPreSave_[entryPoint.getPreSave()] = nt;
+    retired_.erase(entryPoint.getPreSave());
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Start or stop tracing: the traps for entry points that are not triggers
+// are only set while tracing is active
+void TrapNtDebugger::setTracing(bool tracing) {
+  os_ << (tracing ? "Tracing started" : "Tracing stopped") << std::endl;
+
+  for (const auto &entry : traced_) {
+    EntryPoint &entryPoint = *entry.first;
+    if (tracing) {
+      for (HANDLE hProcess : trapped_processes_) {
+        (void)setTrap(hProcess, entryPoint, entry.second, true);
+      }
+      continue;
+    }
+    const auto it = NtCalls_.find(entryPoint.getAddress());
+    if (it == NtCalls_.end()) {
+      continue;
+    }
+    for (HANDLE hProcess : trapped_processes_) {
+      (void)entryPoint.clearNtTrap(hProcess, it->second);
+    }
+    // A thread may already have hit one of these traps
+    retired_.insert(entryPoint.getAddress());
+    NtCalls_.erase(it);
+    if (entryPoint.getPreSave()) {
+      retired_.insert(entryPoint.getPreSave());
+      NtPreSave_.erase(entryPoint.getPreSave());
+    }
+  }
+
+  for (HANDLE hProcess : trapped_processes_) {
+    FlushInstructionCache(hProcess, nullptr, 0);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+namespace {
+// Describe an entry point for compiling filters
+FilterTarget filterTarget(EntryPoint const &entryPoint) {
+  FilterTarget target{entryPoint.getName(), entryPoint.getCategory(), {}};
+  for (size_t idx = 0; idx != entryPoint.getArgumentCount(); ++idx) {
+    Argument const &argument = entryPoint.getArgument(idx);
+    ArgType const argType = argument.getArgType();
+    target.arguments.push_back(
+        {argument.getName(),
+         argType == argPOBJECT_ATTRIBUTES || argType == argPUNICODE_STRING});
+  }
+  return target;
+}
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// Check the identifiers in a filter against all the entry points
+void TrapNtDebugger::checkFilter(FilterExpression const &filter) const {
+  std::vector<FilterTarget> targets;
+  for (const auto &entryPoint : entryPoints_) {
+    targets.push_back(filterTarget(entryPoint));
+  }
+  filter.check(targets);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Get the trigger programs for an entry point, compiling them on first use
+TrapNtDebugger::TriggerPrograms const *
+TrapNtDebugger::triggerPrograms(EntryPoint const &entryPoint) {
+  auto it = triggerPrograms_.find(&entryPoint);
+  if (it == triggerPrograms_.end()) {
+    FilterTarget const target = filterTarget(entryPoint);
+    TriggerPrograms programs;
+    if (start_) {
+      programs.start = start_->compile(target);
+    }
+    if (stop_) {
+      programs.stop = stop_->compile(target);
+    }
+    it = triggerPrograms_.emplace(&entryPoint, std::move(programs)).first;
+  }
+  return &it->second;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Returns true if calls to the entry point can start or stop tracing
+bool TrapNtDebugger::isTrigger(EntryPoint const &entryPoint) {
+  TriggerPrograms const *programs = triggerPrograms(entryPoint);
+  return (start_ && !programs->start.alwaysFalse()) ||
+         (stop_ && !programs->stop.alwaysFalse());
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Get the filter program for an entry point, compiling it on first use
+FilterProgram const *
+TrapNtDebugger::whereProgram(EntryPoint const &entryPoint) {
+  auto it = wherePrograms_.find(&entryPoint);
+  if (it == wherePrograms_.end()) {
+    it = wherePrograms_
+             .emplace(&entryPoint, where_->compile(filterTarget(entryPoint)))
+             .first;
+    if (bVerbose && !it->second.alwaysFalse()) {
+      os_ << "Filter for " << entryPoint.getName() << ":\n";
+      it->second.print(os_);
+    }
+  }
+  return &it->second;
+}
+
 void TrapNtDebugger::showUnused(std::set<std::string> const &unused,
                                 std::string const &name) {
   if (!unused.empty()) {
@@ -1020,7 +2599,9 @@ void TrapNtDebugger::ShowTotals() const {
   }
 }
 
-void TrapNtDebugger::setErrorCodes(std::string const &codeFilter) {
+namespace {
+// Read a comma delimited list of hex status codes
+void readCodes(std::string const &codeFilter, std::set<NTSTATUS> &result) {
   std::vector<std::string> codes;
 
   SimpleTokenizer(codeFilter, &codes, ',');
@@ -1034,9 +2615,18 @@ void TrapNtDebugger::setErrorCodes(std::string const &codeFilter) {
       throw std::runtime_error("Unrecognised error code value '" + it + "'");
     }
 #pragma warning(pop)
-    errorCodes_.insert(static_cast<NTSTATUS>(code));
+    result.insert(static_cast<NTSTATUS>(code));
   }
 }
+} // namespace
+
+void TrapNtDebugger::setErrorCodes(std::string const &codeFilter) {
+  readCodes(codeFilter, errorCodes_);
+}
+
+void TrapNtDebugger::setFlightCodes(std::string const &codeFilter) {
+  readCodes(codeFilter, flightCodes_);
+}
 
 //////////////////////////////////////////////////////////////////////////
 int main(int argc, char **argv) {
@@ -1045,6 +2635,13 @@ int main(int argc, char **argv) {
   std::string category;
   std::string filter;
   std::string codeFilter;
+  std::string where;
+  std::string flightCodes;
+  std::string start;
+  std::string stop;
+  std::string startOds;
+  std::string stopOds;
+  unsigned int stopDelay(0);
   bool bOnly(false);
   bool bNoDlls(false);
   bool bNoExcept(false);
@@ -1053,6 +2650,9 @@ int main(int argc, char **argv) {
   bool bNoNames(false);
   bool bShowLoaderSnaps(false);
   bool bTotals(false);
+  unsigned int symbolCacheMB(0);
+  std::string format("text");
+  std::string shard;
 
   Options options(szRCSID);
   options.set(
@@ -1065,13 +2665,44 @@ int main(int argc, char **argv) {
               "Comma delimited list of error codes to filter on");
   options.set("export", &exportFile,
               "Export symbols once loaded [for testing]");
+  options.set("flight", &flightFile,
+              "Record calls in memory and write them to <prefix>-<pid>-<n>.ntfr "
+              "on failure");
+  options.set("flightmb", &flightMB,
+              "Size in MB of the flight recorder for each process");
+  options.set("flighterrors", &flightCodes,
+              "Comma delimited list of error codes writing a flight dump");
+  options.set("folded", &foldedFile,
+              "Write folded stacks of the calls traced, for flame graphs");
+  options.set("foldedtime", &bFoldedTime,
+              "Weight folded stacks by microseconds in the call, not count");
+  options.set("fileio", &fileIoTop,
+              "Report file I/O and its times for the <n> busiest files");
+  options.set("format", &format,
+              "Output format: text, or jsonl for one JSON object per event");
   options.set("filter", &filter,
               "Comma delimited list of substrings to filter on (leading '-' to "
               "filter off)");
   options.set("category", &category,
               "Comma delimited list of categories to trace (eg "
               "File,Process,Registry, ? for list)");
+  options.set("chrome", &chromeFile,
+              "Write the calls traced, with their durations, and other events "
+              "to <file> in Chrome trace-event format");
+  options.set("chromeslice", &chromeSlice,
+              "Split the Chrome trace into files of <n> seconds each");
+  options.set("totalsfile", &totalsFile,
+              "Write the number of calls and errors, and latencies if -pre, "
+              "by process, category and function to <file> for NtTraceTotals");
+  options.set("handles", &bHandles,
+              "Annotate handles with the names of the objects opened");
   options.set("hd", &noDebugHeap, "Don't use debug heap");
+  options.set("leaks", &bLeaks,
+              "Report handles still open, and their creating stacks, when a "
+              "process exits or on detach");
+  options.set("memory", &bMemory,
+              "Report virtual memory activity, and the allocating stacks, "
+              "when a process exits or on detach");
   options.set("nonames", &bNoNames, "Don't name arguments");
   options.set("nodlls", &bNoDlls, "Don't process DLL load/unload");
   options.set("noexcept", &bNoExcept, "Don't process exceptions");
@@ -1080,26 +2711,77 @@ int main(int argc, char **argv) {
               "Only debug the first process, don't debug child processes");
   options.set("out", &outputFile, "Output file");
   options.set("pre", &bPreTrace, "Trace pre-call as well as post-call");
+  options.set("redundant", &redundantTop,
+              "Report the <n> calls most often repeated with the same "
+              "arguments");
+  options.set("registry", &registryTop,
+              "Report registry access for the <n> busiest keys");
+  options.set("shard", &shard,
+              "Write a file for each 'process' or 'thread' beside the -out "
+              "file, with an index for NtTraceMerge");
+  options.set("smallio", &smallIoTop,
+              "Report the <n> handles with the most calls a buffer would "
+              "save, or with misaligned or alternating I/O");
   options.set("stack", &bStackTrace, "show stack trace");
+  options.set("symcache", &symbolCacheMB,
+              "Memory limit in MB for symbols shared by stack traces");
   options.set("time", &bTimestamp, "show timestamp");
   options.set("delta", &bDelta, "show delta time");
   options.set("pid", &bPid, "show process ID");
   options.set("tid", &bTid, "show thread ID");
   options.set("nl", &bNewline, "force newline on OutputDebugString");
   options.set("sls", &bShowLoaderSnaps, "Show Loader Snaps");
+  options.set("start", &start,
+              "Start tracing on a call matching an expression");
+  options.set("startods", &startOds,
+              "Start tracing on OutputDebugString containing the text");
+  options.set("stop", &stop, "Stop tracing on a call matching an expression");
+  options.set("stopods", &stopOds,
+              "Stop tracing on OutputDebugString containing the text");
+  options.set("stopdelay", &stopDelay,
+              "Milliseconds to continue tracing after a stop trigger");
   options.set("totals", &bTotals, "Show Totals");
+  options.set("waits", &waitTop,
+              "Report the <n> objects with the most time spent waiting");
+  options.set("waittimeline", &waitTimeline,
+              "Write the waits to <file> as comma separated values");
+  options.set("where", &where,
+              "Only trace calls matching an expression (eg \"NtOpenFile && "
+              "ObjectAttributes ~ '*.dll' && status != 0\")");
 
   options.setArgs(1, -1, "[pid | cmd <args>]");
   if (!options.process(argc, argv,
                        "Provide trapping for calls to NT native API")) {
     return 1;
   }
+  if (format != "text" && format != "jsonl") {
+    std::cerr << "Unknown output format: " << format << std::endl;
+    return 1;
+  }
+  if (!shard.empty() &&
+      ((shard != "process" && shard != "thread") || outputFile.empty() ||
+       format != "text")) {
+    std::cerr << "-shard needs 'process' or 'thread', -out, and text output"
+              << std::endl;
+    return 1;
+  }
   bNames = !bNoNames; // avoid double negatives
+  if (symbolCacheMB != 0) {
+    EntryPoint::setSymbolCacheLimit(size_t(symbolCacheMB) * 1024 * 1024);
+  }
 
   auto it = options.begin();
 
   std::ofstream ofs;
-  if (outputFile.length() != 0) {
+  std::unique_ptr<ShardBuf> shards;
+  if (!shard.empty()) {
+    shards = std::make_unique<ShardBuf>(
+        outputFile, shard == "thread" ? ShardBuf::Thread : ShardBuf::Process);
+    if (!shards->good()) {
+      std::cerr << "Cannot open: " << shards->error() << std::endl;
+      return 1;
+    }
+  } else if (outputFile.length() != 0) {
     ofs.open(outputFile.c_str());
     if (!ofs) {
       std::cerr << "Cannot open: " << outputFile << std::endl;
@@ -1107,11 +2789,57 @@ int main(int argc, char **argv) {
     }
   }
 
-  TrapNtDebugger debugger((outputFile.length() != 0) ? (std::ostream &)ofs
-                                                     : std::cout);
+  std::ostream &output =
+      (outputFile.length() != 0) ? (std::ostream &)ofs : std::cout;
+  JsonWriter json(output);
+  JsonTextBuf jsonText(json);
+  std::ostream jsonMessages(&jsonText);
+  bool const bJson = format == "jsonl";
+
+  std::ostream shardOutput(shards.get());
+
+  TrapNtDebugger debugger(bJson    ? jsonMessages
+                          : shards ? shardOutput
+                                   : output);
+  if (bJson) {
+    debugger.setJson(json, jsonText);
+  }
+  if (shards) {
+    debugger.setShards(*shards);
+  }
+
+  std::unique_ptr<ChromeTrace> chrome;
+  if (!chromeFile.empty()) {
+    chrome = std::make_unique<ChromeTrace>(chromeFile,
+                                           uint64_t(chromeSlice) * 1000000);
+    if (!chrome->good()) {
+      std::cerr << "Cannot open: " << chrome->error() << std::endl;
+      return 1;
+    }
+    debugger.setChrome(*chrome);
+  }
 
   if (codeFilter.length())
     debugger.setErrorCodes(codeFilter);
+  if (flightCodes.length())
+    debugger.setFlightCodes(flightCodes);
+  try {
+    if (!where.empty()) {
+      debugger.setWhere(where);
+    }
+    if (!start.empty()) {
+      debugger.setStart(start);
+    }
+    if (!stop.empty()) {
+      debugger.setStop(stop);
+    }
+  } catch (std::exception const &ex) {
+    std::cerr << ex.what() << std::endl;
+    return 1;
+  }
+  debugger.trigger().setStartText(startOds);
+  debugger.trigger().setStopText(stopOds);
+  debugger.trigger().setStopDelay(stopDelay);
   debugger.setLogDlls(!bNoDlls);
   debugger.setNoException(bNoExcept);
   debugger.setNoThread(bNoThread);
@@ -1211,9 +2939,76 @@ int main(int argc, char **argv) {
     DebugSetProcessKillOnExit(false);
   }
 
+  if (!debugger.Active()) {
+    debugger.writeFlight("Ctrl+C");
+    debugger.reportLeaks();
+    debugger.reportMemory();
+  }
+
+  if (shards) {
+    // The reports are not for any one process
+    shards->source(0, 0);
+  }
+
   if (bTotals) {
     debugger.ShowTotals();
   }
 
+  if (fileIoTop) {
+    debugger.ShowFileIo(fileIoTop);
+  }
+
+  if (redundantTop) {
+    debugger.ShowRedundant(redundantTop);
+  }
+
+  if (registryTop) {
+    debugger.ShowRegistry(registryTop);
+  }
+
+  if (smallIoTop) {
+    debugger.ShowSmallIo(smallIoTop);
+  }
+
+  if (waitTop) {
+    debugger.ShowWaits(waitTop);
+  }
+
+  if (!waitTimeline.empty()) {
+    std::ofstream timeline(waitTimeline);
+    if (timeline) {
+      debugger.writeWaits(timeline);
+    } else {
+      std::cerr << "Cannot open: " << waitTimeline << std::endl;
+    }
+  }
+
+  if (!foldedFile.empty()) {
+    std::ofstream folded(foldedFile);
+    if (folded) {
+      debugger.writeFolded(folded);
+    } else {
+      std::cerr << "Cannot open: " << foldedFile << std::endl;
+    }
+  }
+
+  if (!totalsFile.empty()) {
+    std::ofstream totals(totalsFile);
+    if (totals) {
+      debugger.writeTotals(totals);
+    } else {
+      std::cerr << "Cannot open: " << totalsFile << std::endl;
+    }
+  }
+
+  if (chrome && !chrome->close()) {
+    std::cerr << "Cannot write: " << chrome->error() << std::endl;
+    return 1;
+  }
+
+  if (shards && !shards->flush()) {
+    std::cerr << "Cannot write: " << shards->error() << std::endl;
+    return 1;
+  }
   return 0;
 }
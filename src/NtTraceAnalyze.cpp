@@ -0,0 +1,668 @@
+/*
+NAME
+  NtTraceAnalyze.cpp
+
+DESCRIPTION
+  Offline analysis of the text output of NtTrace
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+EXAMPLE
+  NtTrace -s -o trace.txt MyApp.exe
+  NtTraceAnalyze -redundant 10 trace.txt
+
+  NtTrace -pre -time -handles -stack -o trace.txt MyApp.exe
+  NtTraceAnalyze -waits 10 -timeline waits.csv trace.txt
+
+  NtTrace -category Registry -o trace.txt MyApp.exe
+  NtTraceAnalyze -registry 10 trace.txt
+
+  NtTrace -pre -time -pid -tid -o trace.txt MyApp.exe
+  NtTraceAnalyze -chrome trace.json trace.txt
+
+  NtTrace -category File -handles -o trace.txt MyApp.exe
+  NtTraceAnalyze -smallio 10 trace.txt
+
+  NtTrace -pre -time -category File -o trace.txt MyApp.exe
+  NtTraceAnalyze -fileio 10 trace.txt
+*/
+
+static char const szRCSID[] = "$Id$";
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// or2 includes
+#include "../include/ChromeTrace.h"
+#include "../include/FileIoStats.h"
+#include "../include/HandleTable.h"
+#include "../include/Options.h"
+#include "../include/RedundantCalls.h"
+#include "../include/RegistryProfile.h"
+#include "../include/SmallIoDetector.h"
+#include "../include/StackTable.h"
+#include "../include/TraceLine.h"
+#include "../include/TraceParser.h"
+#include "../include/WaitProfiler.h"
+
+using namespace or2;
+
+namespace {
+
+// Get the value of a handle or status written by NtTrace
+uint64_t numberOf(std::string const &text) {
+  return std::strtoull(text.c_str(), nullptr, 0);
+}
+
+// Get the contents of the first quoted string in the text
+bool quoted(std::string const &text, std::string &result) {
+  size_t const start = text.find('"');
+  size_t const end =
+      start == std::string::npos ? start : text.find('"', start + 1);
+  if (end == std::string::npos) {
+    return false;
+  }
+  result = text.substr(start + 1, end - start - 1);
+  return true;
+}
+
+/** The number of items to show in each report */
+struct Limits {
+  unsigned int fileIo{20};
+  unsigned int redundant{20};
+  unsigned int registry{20};
+  unsigned int smallIo{20};
+  unsigned int waits{20};
+};
+
+/** Analyses the calls in a trace */
+class Analyzer {
+public:
+  Analyzer(unsigned int window, SmallIoDetector::Settings const &settings)
+      : redundant_(window), smallIo_(settings) {}
+
+  /** Process one trace */
+  void analyse(std::istream &is);
+
+  /** Print the results */
+  void report(std::ostream &os, Limits const &limits) const {
+    if (!redundant_.empty()) {
+      redundant_.report(os, stacks_, limits.redundant);
+    }
+    if (!registry_.empty()) {
+      registry_.report(os, limits.registry);
+    }
+    if (!fileIo_.empty()) {
+      fileIo_.report(os, limits.fileIo);
+    }
+    if (!smallIo_.empty()) {
+      smallIo_.report(os, limits.smallIo);
+    }
+    if (!waits_.waits().empty()) {
+      waits_.report(os, stacks_, limits.waits);
+    }
+  }
+
+  /** Write the timeline of the waits */
+  void writeTimeline(std::ostream &os) const { waits_.writeTimeline(os); }
+
+  /** Export the calls and other events to a Chrome trace */
+  void setChrome(ChromeTrace &chrome) { chrome_ = &chrome; }
+
+private:
+  void preCall(TraceLine const &line);
+  void call(TraceLine const &line, std::vector<std::string> const &frames);
+  void event(std::string const &text);
+  void chromeCall(TraceLine const &line, uint64_t end, int64_t elapsed);
+  bool timeOf(TraceLine const &line, uint64_t &microseconds);
+  void trackHandles(TraceLine const &line);
+  void registry(TraceLine const &line);
+  void fileIo(TraceLine const &line, int64_t elapsed);
+  void smallIo(TraceLine const &line);
+  std::string keyName(TraceLine const &line, std::string const &value);
+  std::string handleName(TraceLine const &line, std::string const &value);
+  std::string redundantKey(TraceLine const &line,
+                           TraceLine::Argument const &arg);
+  std::string openedName(TraceLine const &line);
+
+  StackTable stacks_;
+  RedundantCalls redundant_;
+  std::map<uint32_t, HandleTable> handles_; // handles opened by each process
+  RegistryProfile registry_;
+  FileIoStats fileIo_;
+  SmallIoDetector smallIo_;
+  WaitProfiler waits_;
+  uint64_t lastTime_{}; // time of the previous time stamp
+  uint64_t day_{};      // offset for traces running past midnight
+  ChromeTrace *chrome_{};
+  bool haveOrigin_{};
+  uint64_t origin_{}; // time of the first event exported
+  std::map<uint32_t, uint64_t> callStart_; // per thread time of pre-call line
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Each call is processed once any stack trace following it has been read
+void Analyzer::analyse(std::istream &is) {
+  std::string text;
+  TraceLine line;
+  TraceLine pending;
+  bool havePending(false);
+  bool inStack(false);
+  std::vector<std::string> frames;
+  while (std::getline(is, text)) {
+    if (!text.empty() && text.back() == '\r') {
+      text.pop_back();
+    }
+    if (line.parse(text)) {
+      if (havePending) {
+        call(pending, frames);
+      }
+      if (line.before) {
+        preCall(line);
+      }
+      havePending = !line.before;
+      inStack = havePending;
+      pending = line;
+      frames.clear();
+    } else if (inStack && TraceParser::isFrame(text)) {
+      frames.push_back(text);
+    } else {
+      inStack = false;
+      if (chrome_) {
+        event(text);
+      }
+    }
+  }
+  if (havePending) {
+    call(pending, frames);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Get the time of a call, in microseconds from the midnight before the trace
+// started
+bool Analyzer::timeOf(TraceLine const &line, uint64_t &microseconds) {
+  uint64_t const oneDay = 24ull * 60 * 60 * 1000 * 1000;
+  if (!line.timeOfDay(microseconds)) {
+    return false;
+  }
+  microseconds += day_;
+  if (microseconds + oneDay / 2 < lastTime_) {
+    day_ += oneDay;
+    microseconds += oneDay;
+  }
+  lastTime_ = microseconds;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// The start of a call, traced with -pre
+void Analyzer::preCall(TraceLine const &line) {
+  size_t argument{};
+  uint64_t time{};
+  if (!timeOf(line, time)) {
+    return;
+  }
+  if (WaitProfiler::isWait(line.function, argument)) {
+    waits_.begin(line.sequence(), time);
+  }
+  callStart_[line.sequence()] = time;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Export a call ending at 'end' as a slice, lasting 'elapsed' microseconds
+// if the pre-call line was seen
+void Analyzer::chromeCall(TraceLine const &line, uint64_t end,
+                          int64_t elapsed) {
+  uint64_t const start = elapsed < 0 ? end : end - elapsed;
+  if (!haveOrigin_) {
+    origin_ = start;
+    haveOrigin_ = true;
+  }
+  std::vector<ChromeTrace::Arg> args;
+  for (size_t idx = 0; idx != line.args.size(); ++idx) {
+    TraceLine::Argument const &arg = line.args[idx];
+    args.push_back({arg.name.empty() ? "arg" + std::to_string(idx + 1)
+                                     : arg.name,
+                    arg.value});
+  }
+  args.push_back({"result", line.result});
+  chrome_->complete(line.processId, line.sequence(),
+                    start < origin_ ? 0 : start - origin_, end - start,
+                    line.function, "call", args);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Export a debug event with a time stamp as an instant; a thread name set
+// by the target names the track of the thread
+void Analyzer::event(std::string const &text) {
+  TraceLine line;
+  size_t const pos = line.parseHeader(text);
+  uint64_t time{};
+  if (pos == text.size() || !timeOf(line, time)) {
+    return;
+  }
+  std::string const message = text.substr(pos);
+  std::string name;
+  if (message.compare(0, 13, "SetThreadName") == 0 && quoted(message, name)) {
+    chrome_->threadName(line.processId, line.sequence(), name);
+    return;
+  }
+  char const *category = "message";
+  if (message.compare(0, 14, "Created thread") == 0 ||
+      message.compare(0, 7, "Thread ") == 0) {
+    category = "thread";
+  } else if (message.compare(0, 10, "Loaded DLL") == 0 ||
+             message.compare(0, 13, "Unload of DLL") == 0) {
+    category = "dll";
+  } else if (message.compare(0, 8, "Process ") == 0) {
+    category = "process";
+  } else if (message.find("xception") != std::string::npos ||
+             message.compare(0, 16, "Access violation") == 0) {
+    category = "exception";
+  }
+  if (!haveOrigin_) {
+    origin_ = time;
+    haveOrigin_ = true;
+  }
+  chrome_->instant(line.processId, line.sequence(),
+                   time < origin_ ? 0 : time - origin_, message, category);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Keep the names of the registry keys and files opened: the handle is the
+// value in brackets after the address of the output argument, and the name
+// is either a full path or relative to a root directory as "root:path"
+void Analyzer::trackHandles(TraceLine const &line) {
+  HandleTable &table = handles_[line.processId];
+  if (line.function == "NtClose") {
+    if (numberOf(line.result) == 0 && !line.args.empty()) {
+      table.closed(numberOf(line.args[0].value));
+      smallIo_.close(line.processId, numberOf(line.args[0].value));
+    }
+    return;
+  }
+  bool const opensFile =
+      line.function == "NtCreateFile" || line.function == "NtOpenFile";
+  if (numberOf(line.result) != 0 ||
+      (!opensFile &&
+       RegistryProfile::operation(line.function) != RegistryProfile::Open) ||
+      line.args.size() < 3) {
+    return;
+  }
+  std::string const &keyHandle = line.args[0].value;
+  std::string const &objectAttributes = line.args[2].value;
+  size_t const bracket = keyHandle.find('[');
+  std::string name;
+  if (bracket == std::string::npos || !quoted(objectAttributes, name)) {
+    return;
+  }
+  uint64_t root{};
+  if (objectAttributes[0] != '"') {
+    root = numberOf(objectAttributes);
+  }
+  table.opened(numberOf(keyHandle.substr(bracket + 1)), name, root);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Get the name of the key for a handle argument: handles annotated with
+// -handles give the name directly
+std::string Analyzer::keyName(TraceLine const &line,
+                              std::string const &value) {
+  std::string name;
+  if (quoted(value, name)) {
+    return name;
+  }
+  std::string const *found = handles_[line.processId].find(numberOf(value));
+  return found ? *found : value;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Get the name of the object for a handle argument, or an empty string if
+// the handle is unknown
+std::string Analyzer::handleName(TraceLine const &line,
+                                 std::string const &value) {
+  std::string name;
+  if (!quoted(value, name)) {
+    std::string const *found = handles_[line.processId].find(numberOf(value));
+    if (found) {
+      name = *found;
+    }
+  }
+  return name;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Get the key of an argument for the redundant call check. As in NtTrace,
+// a handle is replaced by the name of the object, or a placeholder if the
+// name is not known; an argument is taken as a handle if its name, when
+// shown, ends in "Handle", if it is annotated with a name by -handles, or
+// if it is a handle held in the handle table.
+std::string Analyzer::redundantKey(TraceLine const &line,
+                                   TraceLine::Argument const &arg) {
+  std::string const &value = arg.value;
+  size_t const space = value.find(' ');
+  std::string const number = value.substr(0, space);
+  bool const isNumber = !number.empty() &&
+                        std::isdigit(static_cast<unsigned char>(number[0])) &&
+                        value.find('[') == std::string::npos;
+  // Null and pseudo handles are kept as values
+  if (!isNumber || numberOf(number) == 0) {
+    return RedundantCalls::normalize(value);
+  }
+  bool const named = arg.name.size() >= 6 &&
+                     arg.name.compare(arg.name.size() - 6, 6, "Handle") == 0;
+  bool const annotated = space != std::string::npos &&
+                         value.compare(space, 2, " \"") == 0;
+  std::string const name = handleName(line, value);
+  if (named || annotated || (arg.name.empty() && !name.empty())) {
+    return RedundantCalls::handleKey(name.empty() ? nullptr : &name,
+                                     numberOf(number));
+  }
+  return RedundantCalls::normalize(value);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Get the name of the object opened by a call with the handle as the first
+// argument and the object attributes as the third. A successful open has
+// already been added to the handle table; a failed one takes the name from
+// the object attributes, relative to the root directory if known.
+std::string Analyzer::openedName(TraceLine const &line) {
+  std::string const &objectAttributes = line.args[2].value;
+  size_t const bracket = line.args[0].value.find('[');
+  std::string const *found =
+      numberOf(line.result) == 0 && bracket != std::string::npos
+          ? handles_[line.processId].find(
+                numberOf(line.args[0].value.substr(bracket + 1)))
+          : nullptr;
+  std::string path;
+  if (found) {
+    path = *found;
+  } else if (quoted(objectAttributes, path) && objectAttributes[0] != '"') {
+    std::string const *root =
+        handles_[line.processId].find(numberOf(objectAttributes));
+    if (root) {
+      path = *root + '\\' + path;
+    }
+  }
+  return path;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void Analyzer::registry(TraceLine const &line) {
+  RegistryProfile::Op const op = RegistryProfile::operation(line.function);
+  if (op == RegistryProfile::OpCount || line.args.empty()) {
+    return;
+  }
+  uint32_t const status = static_cast<uint32_t>(numberOf(line.result));
+  std::string path;
+  if (op == RegistryProfile::Open) {
+    if (line.args.size() < 3) {
+      return;
+    }
+    path = openedName(line);
+  } else {
+    path = keyName(line, line.args[0].value);
+  }
+
+  std::string valueName;
+  if (op == RegistryProfile::ReadValue || op == RegistryProfile::Write) {
+    if (line.args.size() > 1) {
+      (void)quoted(line.args[1].value, valueName);
+    }
+  }
+  // The information class of NtQueryKey and NtQueryValueKey, as written
+  std::string infoClass;
+  size_t const classArg = line.function == "NtQueryKey"        ? 1
+                          : line.function == "NtQueryValueKey" ? 2
+                                                               : 0;
+  if (classArg && classArg < line.args.size()) {
+    infoClass = line.args[classArg].value;
+  }
+  registry_.add(path.empty() ? "(unknown)" : path, op, valueName, status,
+                infoClass);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Add a read, write or device I/O control to the small I/O detector. The
+// transfer size is the information in the I/O status block, written as
+// "[status/information]", and the byte offset is the value in brackets; a
+// call still pending is assumed to transfer all the bytes requested.
+void Analyzer::smallIo(TraceLine const &line) {
+  SmallIoDetector::Op op = SmallIoDetector::OpCount;
+  if (line.function == "NtReadFile" && line.args.size() > 7) {
+    op = SmallIoDetector::Read;
+  } else if (line.function == "NtWriteFile" && line.args.size() > 7) {
+    op = SmallIoDetector::Write;
+  } else if (line.function == "NtDeviceIoControlFile" &&
+             line.args.size() > 9) {
+    op = SmallIoDetector::Control;
+  }
+  uint64_t const status = numberOf(line.result);
+  if (op == SmallIoDetector::OpCount || TraceParser::isError(status)) {
+    return;
+  }
+
+  uint64_t offset = SmallIoDetector::current;
+  uint64_t requested{};
+  uint32_t code{};
+  if (op == SmallIoDetector::Control) {
+    code = static_cast<uint32_t>(numberOf(line.args[5].value));
+    requested = std::max(numberOf(line.args[7].value),
+                         numberOf(line.args[9].value));
+  } else {
+    requested = numberOf(line.args[6].value);
+    std::string const &byteOffset = line.args[7].value;
+    size_t const bracket = byteOffset.find('[');
+    if (bracket != std::string::npos) {
+      // Negative values ask for the end of file or the file position
+      double const value = std::strtod(byteOffset.c_str() + bracket + 1,
+                                       nullptr);
+      if (value >= 0) {
+        offset = static_cast<uint64_t>(value);
+      }
+    }
+  }
+  uint64_t transferred = requested;
+  std::string const &ioStatusBlock = line.args[4].value;
+  size_t const slash = ioStatusBlock.find('/', ioStatusBlock.find('['));
+  if (status != 0x103 && slash != std::string::npos) {
+    transferred = numberOf(ioStatusBlock.substr(slash + 1));
+  }
+
+  smallIo_.add(line.processId, numberOf(line.args[0].value),
+               handleName(line, line.args[0].value), op, offset, requested,
+               transferred, -1, code);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Add a file I/O call to the statistics for the file, as NtTrace -fileio
+// does. Reads and writes have the length requested as the seventh argument
+// and the transfer size in the I/O status block, written as
+// "[status/information]"; the time is known if the pre-call line was seen.
+void Analyzer::fileIo(TraceLine const &line, int64_t elapsed) {
+  FileIoStats::Op const op = FileIoStats::operation(line.function);
+  if (op == FileIoStats::OpCount || line.args.empty() ||
+      (op == FileIoStats::Open && line.args.size() < 3)) {
+    return;
+  }
+  uint64_t const status = numberOf(line.result);
+  uint64_t requested{};
+  uint64_t transferred{};
+  if (op == FileIoStats::Read || op == FileIoStats::Write) {
+    if (line.args.size() < 7) {
+      return;
+    }
+    requested = numberOf(line.args[6].value);
+    std::string const &ioStatusBlock = line.args[4].value;
+    size_t const slash = ioStatusBlock.find('/', ioStatusBlock.find('['));
+    if (status < 0x80000000 && status != 0x103 && slash != std::string::npos) {
+      transferred = numberOf(ioStatusBlock.substr(slash + 1));
+    }
+  }
+  std::string const path = op == FileIoStats::Open
+                               ? openedName(line)
+                               : handleName(line, line.args[0].value);
+  fileIo_.add(path.empty() ? "(unknown)" : path, op, requested, transferred,
+              elapsed);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void Analyzer::call(TraceLine const &line,
+                    std::vector<std::string> const &frames) {
+  // The arguments are compared before a closed handle is forgotten
+  std::vector<std::string> keys;
+  keys.reserve(line.args.size());
+  for (auto const &arg : line.args) {
+    keys.push_back(redundantKey(line, arg));
+  }
+
+  // Microseconds in the call, if the pre-call line was seen
+  uint64_t end{};
+  bool const timed = timeOf(line, end);
+  int64_t elapsed{-1};
+  const auto start = callStart_.find(line.sequence());
+  if (timed && start != callStart_.end()) {
+    elapsed = static_cast<int64_t>(end - std::min(start->second, end));
+    callStart_.erase(start);
+  }
+
+  trackHandles(line);
+  registry(line);
+  fileIo(line, elapsed);
+  smallIo(line);
+  if (chrome_ && timed) {
+    chromeCall(line, end, elapsed);
+  }
+
+  size_t argument{};
+  uint64_t time{};
+  if (WaitProfiler::isWait(line.function, argument) && timeOf(line, time)) {
+    waits_.end(line.processId, line.sequence(), time, line.function,
+               argument < line.args.size() ? line.args[argument].value : "",
+               stacks_.intern(frames));
+  }
+
+  RedundantCalls::Offender *const offender =
+      redundant_.add(line.sequence(), line.function, keys);
+  if (offender && offender->stack == 0) {
+    offender->stack = stacks_.intern(frames);
+  }
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  Limits limits;
+  unsigned int window(64);
+  unsigned int smallSize(4096);
+  unsigned int bufferSize(65536);
+  std::string timelineFile;
+  std::string chromeFile;
+  unsigned int slice(0);
+
+  Options options(szRCSID);
+  options.set("chrome", &chromeFile,
+              "Export the calls, and other events with a time stamp, to "
+              "<file> in Chrome trace-event format (needs a trace made with "
+              "-time, and -pre for durations)");
+  options.set("fileio", &limits.fileIo,
+              "Report file I/O for the <n> busiest files (with times if the "
+              "trace was made with -pre and -time)");
+  options.set("redundant", &limits.redundant,
+              "Report the <n> calls most often repeated with the same "
+              "arguments");
+  options.set("registry", &limits.registry,
+              "Report registry access for the <n> busiest keys");
+  options.set("smallio", &limits.smallIo,
+              "Report the <n> handles with the most calls a buffer would "
+              "save, or with misaligned or alternating I/O");
+  options.set("smallsize", &smallSize,
+              "Size in bytes below which reads and writes are small");
+  options.set("buffersize", &bufferSize,
+              "Size in bytes of the buffer assumed for small I/O estimates");
+  options.set("slice", &slice,
+              "Split the Chrome trace into files of <n> seconds each");
+  options.set("timeline", &timelineFile,
+              "Write the waits to <file> as comma separated values");
+  options.set("waits", &limits.waits,
+              "Report the <n> objects with the most time spent waiting (needs "
+              "a trace made with -pre and -time)");
+  options.set("window", &window,
+              "Number of previous calls on each thread searched for repeats");
+  options.setArgs(1, -1, "<trace file>...");
+  if (!options.process(argc, argv, "Analyse the output of NtTrace")) {
+    return 1;
+  }
+
+  SmallIoDetector::Settings settings;
+  settings.small = smallSize;
+  settings.buffer = bufferSize;
+  Analyzer analyzer(window, settings);
+  std::unique_ptr<ChromeTrace> chrome;
+  if (!chromeFile.empty()) {
+    chrome =
+        std::make_unique<ChromeTrace>(chromeFile, uint64_t(slice) * 1000000);
+    if (!chrome->good()) {
+      std::cerr << "Cannot open: " << chrome->error() << std::endl;
+      return 1;
+    }
+    analyzer.setChrome(*chrome);
+  }
+  int ret = 0;
+  for (auto const &fileName : options) {
+    std::ifstream ifs(fileName);
+    if (!ifs) {
+      std::cerr << "Cannot open: " << fileName << std::endl;
+      ret = 1;
+      continue;
+    }
+    analyzer.analyse(ifs);
+  }
+  if (chrome && !chrome->close()) {
+    std::cerr << "Cannot write: " << chrome->error() << std::endl;
+    ret = 1;
+  }
+  analyzer.report(std::cout, limits);
+  if (!timelineFile.empty()) {
+    std::ofstream timeline(timelineFile);
+    if (timeline) {
+      analyzer.writeTimeline(timeline);
+    } else {
+      std::cerr << "Cannot open: " << timelineFile << std::endl;
+      ret = 1;
+    }
+  }
+  return ret;
+}
@@ -0,0 +1,356 @@
+/*
+NAME
+  NtTraceBench.cpp
+
+DESCRIPTION
+  Benchmarks of the portable components used by NtTrace for each traced
+  call, timed against the simpler approaches they replace
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+EXAMPLE
+  NtTraceBench
+  NtTraceBench -modules -count 100000000
+  NtTraceBench -filter
+  NtTraceBench -format -count 1000000
+*/
+
+static char const szRCSID[] = "$Id$";
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// or2 includes
+#include "../include/FilterExpression.h"
+#include "../include/JsonWriter.h"
+#include "../include/ModuleMap.h"
+#include "../include/Options.h"
+
+using namespace or2;
+
+namespace {
+
+// Results of the timed work, so that it is not optimised away
+volatile uint64_t sink;
+
+// Time 'count' calls of 'work(index)', returning the nanoseconds per call
+template <typename Work> double timePerCall(uint64_t count, Work &&work) {
+  auto const start = std::chrono::steady_clock::now();
+  for (uint64_t idx = 0; idx != count; ++idx) {
+    work(idx);
+  }
+  std::chrono::duration<double, std::nano> const elapsed =
+      std::chrono::steady_clock::now() - start;
+  return count ? elapsed.count() / static_cast<double>(count) : 0;
+}
+
+// Print the time per call of one way of doing the work
+void report(char const *name, double nanoseconds, char const *unit) {
+  auto const flags = std::cout.flags();
+  auto const precision = std::cout.precision();
+  std::cout << "  " << std::left << std::setw(28) << name << std::right
+            << std::fixed << std::setprecision(1) << std::setw(10)
+            << nanoseconds << " ns per " << unit << '\n';
+  std::cout.flags(flags);
+  std::cout.precision(precision);
+}
+
+// Look up the module of stack addresses, as done for each frame of a stack
+// trace, using the module map and using a linear scan of the modules
+void benchModules(uint64_t count) {
+  size_t const modules = 256;
+  std::mt19937_64 random(27);
+  ModuleMap map;
+  uint64_t base = 0x7ff800000000;
+  for (size_t idx = 0; idx != modules; ++idx) {
+    uint64_t const size = (random() % 64 + 1) * 0x10000;
+    std::string name("module");
+    name += std::to_string(idx);
+    map.add(base, size, name + ".dll");
+    base += size + (random() % 4) * 0x10000;
+  }
+  // Most frames are in a module; some are in generated code
+  std::vector<uint64_t> addresses(4096);
+  for (auto &address : addresses) {
+    address = 0x7ff800000000 + random() % (base - 0x7ff800000000);
+  }
+  size_t const mask = addresses.size() - 1;
+
+  uint64_t found{};
+  double const binary = timePerCall(count, [&](uint64_t idx) {
+    found += map.find(addresses[idx & mask]) != nullptr;
+  });
+  uint64_t const scans = count / 16 + 1;
+  uint64_t scanned{};
+  double const linear = timePerCall(scans, [&](uint64_t idx) {
+    uint64_t const address = addresses[idx & mask];
+    for (auto const &module : map) {
+      if (module.contains(address)) {
+        ++scanned;
+        break;
+      }
+    }
+  });
+
+  std::cout << "Module lookup: " << modules << " modules, " << count
+            << " lookups, " << found << " found\n";
+  report("binary search (ModuleMap)", binary, "lookup");
+  report("linear scan", linear, "lookup");
+  sink = scanned;
+}
+
+// The values of a call to NtCreateFile, as supplied by NtTrace from the
+// registers and the arguments read from the target
+class CreateFileCall : public FilterContext {
+public:
+  CreateFileCall(int64_t status, uint32_t threadId, std::string name)
+      : status_(status), threadId_(threadId), name_(std::move(name)) {}
+
+  int64_t integer(unsigned field) override {
+    switch (field) {
+    case fieldStatus:
+      return status_;
+    case fieldError:
+      return status_ >= 0xc0000000;
+    case fieldPid:
+      return 1234;
+    case fieldTid:
+      return threadId_;
+    default:
+      return 0x8ff5e8 + (field - fieldArgument) * 8;
+    }
+  }
+
+  bool string(unsigned field, std::string &value) override {
+    if (field != fieldArgument + 2) {
+      return false;
+    }
+    value = name_;
+    return true;
+  }
+
+private:
+  int64_t status_;
+  uint32_t threadId_;
+  std::string name_;
+};
+
+// Evaluate a filter for calls that fail it at once and for calls that need
+// every test, compiled once as NtTrace does, and parsed and compiled for each
+// call for comparison. There was no interpreter before the filter was
+// compiled: the only test of the result was the -errorcodes set, also timed.
+void benchFilter(uint64_t count) {
+  std::string const text(
+      "NtCreateFile && ObjectAttributes ~ \"*\\temp\\*\" && status != 0 "
+      "&& tid == 5678");
+  FilterTarget const target{"NtCreateFile",
+                            "File",
+                            {{"FileHandle", false},
+                             {"DesiredAccess", false},
+                             {"ObjectAttributes", true},
+                             {"IoStatusBlock", false}}};
+  FilterProgram const program = FilterExpression(text).compile(target);
+  CreateFileCall success(0, 5678, "\\??\\C:\\temp\\log.txt");
+  CreateFileCall failure(0xc0000034, 5678, "\\??\\C:\\temp\\log.txt");
+  if (program.evaluate(success) || !program.evaluate(failure)) {
+    std::cerr << "Filter gives the wrong result" << std::endl;
+    return;
+  }
+
+  uint64_t matched{};
+  double const rejected = timePerCall(
+      count, [&](uint64_t) { matched += program.evaluate(success); });
+  double const accepted = timePerCall(
+      count, [&](uint64_t) { matched += program.evaluate(failure); });
+  uint64_t const compiles = count / 64 + 1;
+  double const perCall = timePerCall(compiles, [&](uint64_t) {
+    matched += FilterExpression(text).compile(target).evaluate(failure);
+  });
+  std::set<uint32_t> const errorCodes{0xc0000034, 0xc000003a, 0xc0000022};
+  double const codes = timePerCall(count, [&](uint64_t idx) {
+    matched += errorCodes.count(idx & 1 ? 0xc0000034 : 0) != 0;
+  });
+
+  std::cout << "Filter: " << text << "\n  (" << program.size()
+            << " instructions), " << count << " calls\n";
+  report("compiled, rejected call", rejected, "call");
+  report("compiled, matching call", accepted, "call");
+  report("parsed and compiled per call", perCall, "call");
+  report("-errorcodes set only", codes, "call");
+  sink = matched;
+}
+
+// Stream buffer counting, and discarding, the characters written
+class CountingBuffer : public std::streambuf {
+public:
+  CountingBuffer() { setp(buffer_, buffer_ + sizeof(buffer_)); }
+
+  uint64_t count() const {
+    return count_ + static_cast<uint64_t>(pptr() - pbase());
+  }
+
+protected:
+  int overflow(int ch) override {
+    count_ += static_cast<uint64_t>(pptr() - pbase());
+    setp(buffer_, buffer_ + sizeof(buffer_));
+    if (ch != traits_type::eof()) {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+    }
+    return traits_type::not_eof(ch);
+  }
+
+private:
+  char buffer_[4096];
+  uint64_t count_{};
+};
+
+// Write a call as NtTrace does in the default text format and with
+// -format jsonl, to a stream discarding the output, so the formatting is
+// timed and not the file system. The arguments are given as the text shown
+// by NtTrace, which needs the target process, and both formats use this.
+void benchFormat(uint64_t count) {
+  struct Arg {
+    char const *name;
+    char const *type;
+    uint64_t value;
+    char const *text;
+  };
+  static Arg const args[] = {
+      {"FileHandle", "PHANDLE", 0x8ff5e8, "0x8ff5e8 [0x1c]"},
+      {"DesiredAccess", "ACCESS_MASK", 0x80100080,
+       "GENERIC_READ|SYNCHRONIZE|FILE_READ_ATTRIBUTES"},
+      {"ObjectAttributes", "POBJECT_ATTRIBUTES", 0x8ff5a0,
+       "\"\\??\\C:\\Windows\\System32\\kernel32.dll\""},
+      {"IoStatusBlock", "PIO_STATUS_BLOCK", 0x8ff5f0, "0x8ff5f0 [0/1]"},
+      {"AllocationSize", "PLARGE_INTEGER", 0, "null"},
+      {"FileAttributes", "ULONG", 0, "0"},
+      {"ShareAccess", "ULONG", 7, "7"},
+      {"CreateDisposition", "ULONG", 1, "1"},
+      {"CreateOptions", "ULONG", 0x60, "0x60"},
+      {"EaBuffer", "PVOID", 0, "null"},
+      {"EaLength", "ULONG", 0, "0"},
+  };
+  char const *const time = "12:34:56.789";
+  uint32_t const processId = 1234;
+  uint32_t const threadId = 5678;
+
+  CountingBuffer textBuffer;
+  std::ostream text(&textBuffer);
+  double const textTime = timePerCall(count, [&](uint64_t) {
+    text << time << ": [" << std::setw(4) << processId << '/' << std::setw(4)
+         << threadId << "] NtCreateFile(";
+    for (size_t idx = 0; idx != std::size(args); ++idx) {
+      text << (idx ? ", " : "") << args[idx].name << '=' << args[idx].text;
+    }
+    text << ") => 0" << std::endl;
+  });
+
+  CountingBuffer jsonBuffer;
+  std::ostream json(&jsonBuffer);
+  JsonWriter writer(json);
+  std::ostringstream argText;
+  double const jsonTime = timePerCall(count, [&](uint64_t) {
+    writer.beginObject()
+        .member("event", "call")
+        .member("time", time)
+        .member("pid", processId)
+        .member("tid", threadId)
+        .member("function", "NtCreateFile")
+        .member("category", "File");
+    writer.key("args").beginArray();
+    for (auto const &arg : args) {
+      argText.str(std::string());
+      argText << arg.text;
+      writer.beginObject()
+          .member("name", arg.name)
+          .member("type", arg.type)
+          .member("value", arg.value)
+          .member("text", argText.view())
+          .endObject();
+    }
+    writer.endArray().member("result", uint64_t{0});
+    writer.member("status", "0x00000000").endObject();
+    writer.endLine();
+    writer.flush();
+  });
+
+  std::cout << "Output format: " << count << " calls, "
+            << textBuffer.count() / count << " bytes per call as text, "
+            << jsonBuffer.count() / count << " as JSON Lines\n";
+  report("text", textTime, "call");
+  report("jsonl", jsonTime, "call");
+  auto const flags = std::cout.flags();
+  auto const precision = std::cout.precision();
+  std::cout << "  jsonl takes " << std::fixed << std::setprecision(0)
+            << (jsonTime / textTime - 1) * 100
+            << "% longer than text (target: within 20%)\n";
+  std::cout.flags(flags);
+  std::cout.precision(precision);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  bool filter(false);
+  bool format(false);
+  bool modules(false);
+  unsigned int count(10000000);
+
+  Options options(szRCSID);
+  options.set("count", &count, "Number of operations to time (default: 10M)");
+  options.set("filter", &filter, "Time the evaluation of a filter expression");
+  options.set("format", &format,
+              "Time the formatting of a call as text and as JSON Lines");
+  options.set("modules", &modules, "Time module lookups for stack addresses");
+  options.setArgs(0, 0);
+  if (!options.process(argc, argv,
+                       "Benchmark the components used for each traced call")) {
+    return 1;
+  }
+  // Run every benchmark if none are selected
+  bool const all = !filter && !format && !modules;
+
+  if (all || modules) {
+    benchModules(count);
+  }
+  if (all || filter) {
+    benchFilter(count);
+  }
+  if (all || format) {
+    benchFormat(count);
+  }
+  return 0;
+}
@@ -0,0 +1,95 @@
+/*
+NAME
+  NtTraceDiff.cpp
+
+DESCRIPTION
+  Compare two traces written by NtTrace, ignoring the addresses, handles,
+  IDs and times that vary from run to run
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+EXAMPLE
+  NtTraceDiff before.txt after.txt
+  NtTraceDiff -hunks 0 before.txt after.txt
+*/
+
+static char const szRCSID[] = "$Id$";
+
+#include <iostream>
+#include <string>
+#include <string_view>
+
+// or2 includes
+#include "../include/MappedFile.h"
+#include "../include/Options.h"
+#include "../include/TraceDiff.h"
+#include "../include/TraceParser.h"
+
+using namespace or2;
+
+namespace {
+
+// Add the calls in one trace
+bool load(TraceDiff &diff, TraceDiff::Side side, std::string const &fileName) {
+  MappedFile file;
+  std::string error;
+  if (!file.open(fileName, error)) {
+    std::cerr << "Cannot open: " << fileName << ": " << error << std::endl;
+    return false;
+  }
+  uint64_t line{};
+  TraceParser::forEachLine(file.text(), [&](std::string_view text) {
+    ++line;
+    TraceRecord record;
+    if (TraceParser::parse(text, record)) {
+      diff.add(side, record, line);
+    }
+  });
+  return true;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  unsigned int hunks(50);
+
+  Options options(szRCSID);
+  options.set("hunks", &hunks,
+              "Show the first <n> groups of differing calls, or 0 for all");
+  options.setArgs(2, "<old trace> <new trace>");
+  if (!options.process(argc, argv, "Compare the output of NtTrace")) {
+    return 1;
+  }
+
+  TraceDiff diff;
+  auto it = options.begin();
+  if (!load(diff, TraceDiff::Old, *it) || !load(diff, TraceDiff::New, *++it)) {
+    return 1;
+  }
+  diff.report(std::cout, hunks);
+  return 0;
+}
@@ -0,0 +1,178 @@
+/*
+NAME
+  NtTraceMerge.cpp
+
+DESCRIPTION
+  Merge the files written by NtTrace -shard back into a single trace, for
+  all the processes or only some of them, and list the processes traced
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+EXAMPLE
+  NtTrace -shard process -out trace.txt MyApp.exe
+  NtTraceMerge -out merged.txt trace.index
+  NtTraceMerge -pid 1234 -tree trace.index
+  NtTraceMerge -list trace.index
+*/
+
+static char const szRCSID[] = "$Id$";
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// or2 includes
+#include "../include/MappedFile.h"
+#include "../include/Options.h"
+#include "../include/ShardedOutput.h"
+
+using namespace or2;
+
+namespace {
+
+// Parse a comma delimited list of process IDs
+bool parseIds(std::string const &text, std::set<uint32_t> &ids) {
+  size_t start = 0;
+  while (start <= text.size()) {
+    size_t end = text.find(',', start);
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+    std::string const id = text.substr(start, end - start);
+    char *last{};
+    unsigned long const value = std::strtoul(id.c_str(), &last, 10);
+    if (id.empty() || *last != '\0' || value == 0 || value > UINT32_MAX) {
+      return false;
+    }
+    ids.insert(static_cast<uint32_t>(value));
+    start = end + 1;
+  }
+  return true;
+}
+
+// The files are named in the index without a directory, as they are written
+// alongside it
+std::string directoryOf(std::string const &fileName) {
+  size_t const slash = fileName.find_last_of("/\\");
+  return slash == std::string::npos ? "" : fileName.substr(0, slash + 1);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  std::string outFile;
+  std::string pids;
+  bool tree(false);
+  bool list(false);
+
+  Options options(szRCSID);
+  options.set("out", &outFile, "Write the merged trace to <file>");
+  options.set("pid", &pids,
+              "Comma delimited list of the process IDs to merge (default: "
+              "all, and the lines from no process)");
+  options.set("tree", &tree,
+              "Also merge the descendants of the processes given with -pid");
+  options.set("list", &list, "List the processes traced as a tree");
+  options.setArgs(1, 1, "<index file>");
+  if (!options.process(argc, argv,
+                       "Merge the files written by NtTrace -shard")) {
+    return 1;
+  }
+
+  std::string const indexFile = *options.begin();
+  std::ifstream ifs(indexFile);
+  if (!ifs) {
+    std::cerr << "Cannot open: " << indexFile << std::endl;
+    return 1;
+  }
+  ShardIndex index;
+  if (!index.read(ifs)) {
+    std::cerr << "Invalid shard index: " << indexFile << std::endl;
+    return 1;
+  }
+  if (list) {
+    index.print(std::cout);
+    return 0;
+  }
+
+  std::set<uint32_t> selected;
+  if (!pids.empty()) {
+    std::set<uint32_t> ids;
+    if (!parseIds(pids, ids)) {
+      std::cerr << "Invalid process ID list: " << pids << std::endl;
+      return 1;
+    }
+    for (uint32_t const id : ids) {
+      std::set<uint32_t> const found =
+          tree ? index.tree(id) : std::set<uint32_t>{id};
+      selected.insert(found.begin(), found.end());
+    }
+  }
+
+  int ret = 0;
+  std::vector<std::unique_ptr<MappedFile>> files;
+  std::vector<std::string_view> texts;
+  std::string const directory = directoryOf(indexFile);
+  for (auto const &shard : index.shards()) {
+    if (!selected.empty() && !selected.count(shard.processId)) {
+      continue;
+    }
+    std::string const fileName = directory + shard.fileName;
+    auto file = std::make_unique<MappedFile>();
+    std::string error;
+    if (!file->open(fileName, error)) {
+      std::cerr << "Cannot open: " << fileName << ": " << error << std::endl;
+      ret = 1;
+      continue;
+    }
+    texts.push_back(file->text());
+    files.push_back(std::move(file));
+  }
+
+  std::ofstream ofs;
+  if (!outFile.empty()) {
+    ofs.open(outFile, std::ios::binary);
+    if (!ofs) {
+      std::cerr << "Cannot open: " << outFile << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &os = outFile.empty() ? std::cout : ofs;
+  ShardIndex::merge(texts, os);
+  if (!os.flush()) {
+    std::cerr << "Cannot write: " << (outFile.empty() ? "output" : outFile)
+              << std::endl;
+    return 1;
+  }
+  return ret;
+}
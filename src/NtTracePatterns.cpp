@@ -0,0 +1,208 @@
+/*
+NAME
+  NtTracePatterns.cpp
+
+DESCRIPTION
+  Find the sequences of calls most often repeated on each thread, in the
+  output of NtTrace or in a trace store, to show the chatty code paths
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+EXAMPLE
+  NtTrace -pre -time -stack -o trace.txt MyApp.exe
+  NtTracePatterns trace.txt
+  NtTracePatterns -sort time -longest 8 -top 10 calls.nts
+*/
+
+static char const szRCSID[] = "$Id$";
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// or2 includes
+#include "../include/MappedFile.h"
+#include "../include/Options.h"
+#include "../include/PatternMiner.h"
+#include "../include/StackTable.h"
+#include "../include/TraceParser.h"
+#include "../include/TraceStore.h"
+
+using namespace or2;
+
+namespace {
+
+// Add the calls in a trace store
+bool addStore(PatternMiner &miner, TraceStoreReader const &reader) {
+  TraceColumns columns;
+  unsigned const mask = TraceColumns::Duration | TraceColumns::ProcessId |
+                        TraceColumns::ThreadId | TraceColumns::Function |
+                        TraceColumns::Before;
+  for (size_t block = 0; block != reader.blocks().size(); ++block) {
+    if (!reader.read(block, columns, mask)) {
+      return false;
+    }
+    for (size_t row = 0; row != columns.function.size(); ++row) {
+      if (columns.before[row]) {
+        continue;
+      }
+      uint64_t const duration = columns.duration[row];
+      miner.add(columns.processId[row], columns.threadId[row],
+                reader.string(columns.function[row]),
+                duration ? static_cast<int64_t>(duration - 1) : -1);
+    }
+  }
+  return true;
+}
+
+// Add the calls in the text output of NtTrace; the stack trace, if any,
+// follows the result line of each call
+void addText(PatternMiner &miner, StackTable &stacks, std::string_view text) {
+  uint64_t const oneDay = 24ull * 60 * 60 * 1000 * 1000;
+  std::map<std::pair<uint32_t, uint32_t>, uint64_t> starts; // by thread
+  TraceRecord pending;
+  int64_t duration{-1};
+  bool havePending(false);
+  std::vector<std::string> frames;
+
+  auto const flush = [&]() {
+    if (havePending) {
+      miner.add(pending.processId, pending.sequence(), pending.function,
+                duration, stacks.intern(frames));
+      havePending = false;
+    }
+    frames.clear();
+  };
+
+  TraceParser::forEachLine(text, [&](std::string_view line) {
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    TraceRecord record;
+    if (!TraceParser::parse(line, record)) {
+      if (havePending && TraceParser::isFrame(line)) {
+        frames.emplace_back(line);
+      } else {
+        flush();
+      }
+      return;
+    }
+    flush();
+    auto const key = std::make_pair(record.processId, record.sequence());
+    uint64_t time{};
+    bool const timed = TraceParser::timeOfDay(record.time, time);
+    if (record.before) {
+      if (timed) {
+        starts[key] = time;
+      }
+      return;
+    }
+    duration = -1;
+    auto const start = starts.find(key);
+    if (start != starts.end()) {
+      if (timed) {
+        duration =
+            static_cast<int64_t>((time + oneDay - start->second) % oneDay);
+      }
+      starts.erase(start);
+    }
+    pending = record;
+    havePending = true;
+  });
+  flush();
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  PatternMiner::Settings settings;
+  unsigned int shortest(2);
+  unsigned int longest(32);
+  unsigned int minimum(2);
+  std::string sort("calls");
+  unsigned int top(20);
+
+  Options options(szRCSID);
+  options.set("shortest", &shortest, "Fewest calls in a sequence");
+  options.set("longest", &longest, "Most calls in a sequence");
+  options.set("minimum", &minimum,
+              "Fewest times a sequence must be repeated to be shown");
+  options.set("sort", &sort,
+              "Order of the sequences: calls (in all the repeats), time or "
+              "count");
+  options.set("top", &top, "Number of sequences to show");
+  options.setArgs(1, -1, "<trace file or store>...");
+  if (!options.process(argc, argv,
+                       "Find the sequences of calls repeated most often")) {
+    return 1;
+  }
+
+  static std::map<std::string, PatternMiner::Order> const orders{
+      {"calls", PatternMiner::Calls},
+      {"time", PatternMiner::Time},
+      {"count", PatternMiner::Count},
+  };
+  auto const order = orders.find(sort);
+  if (order == orders.end()) {
+    std::cerr << "Unknown sort order: " << sort << std::endl;
+    return 1;
+  }
+  settings.shortest = shortest;
+  settings.longest = longest;
+  settings.minimum = minimum;
+
+  PatternMiner miner(settings);
+  StackTable stacks;
+  int ret = 0;
+  for (auto const &fileName : options) {
+    // A file that is not a store is read as text
+    TraceStoreReader reader;
+    std::string error;
+    if (reader.open(fileName, error)) {
+      if (!addStore(miner, reader)) {
+        std::cerr << "Invalid trace store: " << fileName << std::endl;
+        ret = 1;
+      }
+      continue;
+    }
+    MappedFile file;
+    if (!file.open(fileName, error)) {
+      std::cerr << "Cannot open: " << fileName << ": " << error << std::endl;
+      ret = 1;
+      continue;
+    }
+    addText(miner, stacks, file.text());
+  }
+
+  std::cout << miner.calls() << " calls\n";
+  PatternMiner::report(std::cout, stacks, miner.mine(order->second, top));
+  return ret;
+}
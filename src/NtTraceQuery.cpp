@@ -0,0 +1,385 @@
+/*
+NAME
+  NtTraceQuery.cpp
+
+DESCRIPTION
+  Filter and group-by queries over a columnar trace store written by
+  NtTraceStore
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+EXAMPLE
+  NtTraceQuery -by function calls.nts
+  NtTraceQuery -function NtReadFile -by process -bucket 60 -sort p99 calls.nts
+  NtTraceQuery -status 0xc0000022 -by function,args calls.nts
+  NtTraceQuery -bench calls.nts
+*/
+
+static char const szRCSID[] = "$Id$";
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// or2 includes
+#include "../include/Options.h"
+#include "../include/TraceParser.h"
+#include "../include/TraceQuery.h"
+#include "../include/TraceStore.h"
+
+using namespace or2;
+
+namespace {
+
+// Split a comma separated list
+std::vector<std::string_view> split(std::string_view text) {
+  std::vector<std::string_view> result;
+  while (!text.empty()) {
+    size_t const comma = text.find(',');
+    result.push_back(text.substr(0, comma));
+    text.remove_prefix(comma == std::string_view::npos ? text.size()
+                                                       : comma + 1);
+  }
+  return result;
+}
+
+// The date of the first call with a time in a store, or zero if none
+uint64_t firstDate(TraceStoreReader const &reader) {
+  uint64_t const day = 24ull * 60 * 60 * 1000000;
+  for (size_t block = 0; block != reader.blocks().size(); ++block) {
+    TraceColumns columns;
+    if (reader.blocks()[block].time.max == 0 ||
+        !reader.read(block, columns, TraceColumns::Time)) {
+      continue;
+    }
+    for (uint64_t const time : columns.time) {
+      if (time) {
+        return time / day * day;
+      }
+    }
+  }
+  return 0;
+}
+
+// Format a return value as NtTrace does
+std::string status(uint64_t value) {
+  if (value < 10) {
+    return std::to_string(value);
+  }
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "0x%llx",
+                static_cast<unsigned long long>(value));
+  return buffer;
+}
+
+// Print the groups, with the keys first and any arguments last
+void print(TraceStoreReader const &reader, TraceQuery const &query,
+           std::vector<TraceQuery::Result> const &results) {
+  if (query.bucket) {
+    std::cout << std::left << std::setw(19) << "time" << std::right << ' ';
+  }
+  if (query.keys & TraceQuery::Process) {
+    std::cout << std::setw(8) << "process" << ' ';
+  }
+  if (query.keys & TraceQuery::Thread) {
+    std::cout << std::setw(8) << "thread" << ' ';
+  }
+  if (query.keys & TraceQuery::Function) {
+    std::cout << std::left << std::setw(32) << "function" << std::right
+              << ' ';
+  }
+  if (query.keys & TraceQuery::Status) {
+    std::cout << std::setw(10) << "status" << ' ';
+  }
+  std::cout << std::setw(10) << "calls" << std::setw(10) << "errors"
+            << std::setw(12) << "total ms" << std::setw(10) << "p50 us"
+            << std::setw(10) << "p99 us" << std::setw(10) << "max us";
+  if (query.keys & TraceQuery::Args) {
+    std::cout << "  arguments";
+  }
+  std::cout << '\n';
+
+  for (auto const &result : results) {
+    TraceGroup const &group = result.first;
+    TraceTotals const &totals = result.second;
+    if (query.bucket) {
+      std::cout << TraceStoreReader::format(group.bucket).substr(0, 19) << ' ';
+    }
+    if (query.keys & TraceQuery::Process) {
+      std::cout << std::setw(8) << group.processId << ' ';
+    }
+    if (query.keys & TraceQuery::Thread) {
+      std::cout << std::setw(8) << group.threadId << ' ';
+    }
+    if (query.keys & TraceQuery::Function) {
+      std::cout << std::left << std::setw(32)
+                << reader.string(group.function) << std::right << ' ';
+    }
+    if (query.keys & TraceQuery::Status) {
+      std::cout << std::setw(10) << status(group.status) << ' ';
+    }
+    std::cout << std::setw(10) << totals.count << std::setw(10)
+              << totals.errors;
+    if (totals.durations.empty()) {
+      std::cout << std::setw(12) << '-' << std::setw(10) << '-'
+                << std::setw(10) << '-' << std::setw(10) << '-';
+    } else {
+      std::cout << std::setw(12) << totals.duration / 1000 << std::setw(10)
+                << totals.percentile(50) << std::setw(10)
+                << totals.percentile(99) << std::setw(10)
+                << totals.durations.back();
+    }
+    if (query.keys & TraceQuery::Args) {
+      std::cout << "  " << group.args;
+    }
+    std::cout << '\n';
+  }
+}
+
+// Run a query, timing it
+bool timeQuery(TraceStoreReader const &reader, TraceQuery const &query,
+               size_t threads, std::vector<TraceQuery::Result> &results,
+               TraceQuery::Stats &stats, double &seconds) {
+  auto const start = std::chrono::steady_clock::now();
+  bool const ok = query.run(reader, threads, results, stats);
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          start)
+                .count();
+  if (!ok) {
+    std::cerr << "Corrupt trace store" << std::endl;
+  }
+  return ok;
+}
+
+// Run a fixed set of queries on one thread and then on all threads
+bool bench(TraceStoreReader const &reader, size_t threads) {
+  TraceQuery byFunction;
+  byFunction.keys = TraceQuery::Function;
+  std::vector<TraceQuery::Result> results;
+  TraceQuery::Stats stats;
+  double seconds{};
+  if (!timeQuery(reader, byFunction, threads, results, stats, seconds)) {
+    return false;
+  }
+
+  TraceQuery errors;
+  errors.errors = true;
+  errors.keys = TraceQuery::Function | TraceQuery::Status;
+
+  TraceQuery latency; // of the most frequent function
+  latency.keys = TraceQuery::Process;
+  latency.bucket = 60 * 1000000;
+  if (!results.empty()) {
+    latency.functions.push_back(results.front().first.function);
+  }
+
+  TraceQuery failing;
+  failing.errors = true;
+  failing.keys = TraceQuery::Function | TraceQuery::Args;
+
+  struct {
+    char const *name;
+    TraceQuery const &query;
+  } const suite[] = {
+      {"calls by function", byFunction},
+      {"errors by function and status", errors},
+      {"latency of the top function by process and minute", latency},
+      {"failing calls by function and arguments", failing},
+  };
+  std::vector<size_t> counts{1};
+  if (threads > 1) {
+    counts.push_back(threads);
+  }
+  auto const flags = std::cout.flags();
+  for (auto const &test : suite) {
+    for (size_t const count : counts) {
+      if (!timeQuery(reader, test.query, count, results, stats, seconds)) {
+        return false;
+      }
+      std::cout << test.name << " on " << count << " thread"
+                << (count == 1 ? "" : "s") << ": " << results.size()
+                << " groups from " << stats.rows << " calls in "
+                << std::fixed << std::setprecision(3) << seconds << " s, "
+                << std::setprecision(1)
+                << (seconds > 0 ? stats.rows / 1e6 / seconds : 0)
+                << " M calls/s\n";
+      std::cout.flags(flags);
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  std::string functions;
+  unsigned int processId(0);
+  std::string status;
+  bool errors(false);
+  std::string from;
+  std::string to;
+  std::string by;
+  unsigned int bucket(0);
+  std::string sort("count");
+  unsigned int top(20);
+  unsigned int threads(std::max(1u, std::thread::hardware_concurrency()));
+  bool benchmark(false);
+
+  Options options(szRCSID);
+  options.set("function", &functions,
+              "Include only calls to the comma separated functions");
+  options.set("process", &processId, "Include only calls from process <n>");
+  options.set("status", &status, "Include only calls returning <value>");
+  options.set("errors", &errors, "Include only calls returning an error");
+  options.set("from", &from,
+              "Include only calls from HH:MM:SS.mmm on the first day");
+  options.set("to", &to, "Include only calls up to HH:MM:SS.mmm");
+  options.set("by", &by,
+              "Group by the comma separated keys: function, process, "
+              "thread, status, args");
+  options.set("bucket", &bucket, "Group by time in buckets of <n> seconds");
+  options.set("sort", &sort, "Sort by count, errors, time or p99");
+  options.set("top", &top, "Show the first <n> groups, or 0 for all");
+  options.set("threads", &threads, "Number of threads to use");
+  options.set("bench", &benchmark, "Time a fixed set of queries");
+  options.setArgs(1, 1, "<trace store>");
+  if (!options.process(argc, argv,
+                       "Query a trace store written by NtTraceStore")) {
+    return 1;
+  }
+  threads = std::max(1u, threads);
+
+  TraceStoreReader reader;
+  std::string const fileName = *options.begin();
+  std::string error;
+  if (!reader.open(fileName, error)) {
+    std::cerr << "Cannot open: " << fileName << ": " << error << std::endl;
+    return 1;
+  }
+  if (benchmark) {
+    return bench(reader, threads) ? 0 : 1;
+  }
+
+  TraceQuery query;
+  for (auto const key : split(by)) {
+    if (key == "function") {
+      query.keys |= TraceQuery::Function;
+    } else if (key == "process") {
+      query.keys |= TraceQuery::Process;
+    } else if (key == "thread") {
+      query.keys |= TraceQuery::Thread;
+    } else if (key == "status") {
+      query.keys |= TraceQuery::Status;
+    } else if (key == "args") {
+      query.keys |= TraceQuery::Args;
+    } else {
+      std::cerr << "Unknown key: " << key << std::endl;
+      return 1;
+    }
+  }
+  for (auto const name : split(functions)) {
+    // An unknown function matches no calls
+    query.functions.push_back(reader.find(name));
+  }
+  if (processId) {
+    query.processId = processId;
+  }
+  if (!status.empty()) {
+    uint64_t value{};
+    if (!TraceParser::number(status, value)) {
+      std::cerr << "Invalid status: " << status << std::endl;
+      return 1;
+    }
+    query.status = value;
+  }
+  query.errors = errors;
+  if ((!from.empty() && !TraceParser::timeOfDay(from, query.from)) ||
+      (!to.empty() && !TraceParser::timeOfDay(to, query.to))) {
+    std::cerr << "Times must be of the form HH:MM:SS.mmm" << std::endl;
+    return 1;
+  }
+  // The times are on the date of the first call, and the range may span
+  // midnight
+  uint64_t const date = firstDate(reader);
+  if (!from.empty()) {
+    query.from += date;
+  }
+  if (!to.empty()) {
+    query.to += date;
+    if (query.to < query.from) {
+      query.to += 24ull * 60 * 60 * 1000000;
+    }
+  }
+  query.bucket = uint64_t(bucket) * 1000000;
+
+  std::vector<TraceQuery::Result> results;
+  TraceQuery::Stats stats;
+  double seconds{};
+  if (!timeQuery(reader, query, threads, results, stats, seconds)) {
+    return 1;
+  }
+
+  auto const order = [&sort](TraceTotals const &totals) -> uint64_t {
+    if (sort == "errors") {
+      return totals.errors;
+    }
+    if (sort == "time") {
+      return totals.duration;
+    }
+    if (sort == "p99") {
+      return totals.percentile(99);
+    }
+    return totals.count;
+  };
+  if (sort != "count" && sort != "errors" && sort != "time" &&
+      sort != "p99") {
+    std::cerr << "Unknown sort: " << sort << std::endl;
+    return 1;
+  }
+  std::stable_sort(results.begin(), results.end(),
+                   [&order](TraceQuery::Result const &lhs,
+                            TraceQuery::Result const &rhs) {
+                     return order(lhs.second) > order(rhs.second);
+                   });
+  if (top && results.size() > top) {
+    results.resize(top);
+  }
+  print(reader, query, results);
+
+  std::cout << stats.matched << " calls matched; " << stats.rows
+            << " calls scanned in " << stats.blocks << " blocks, "
+            << stats.skipped << " blocks skipped, in " << std::fixed
+            << std::setprecision(3) << seconds << " s\n";
+  return 0;
+}
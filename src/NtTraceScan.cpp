@@ -0,0 +1,275 @@
+/*
+NAME
+  NtTraceScan.cpp
+
+DESCRIPTION
+  Fast scan of the text output of NtTrace using all cores, which also
+  serves as a benchmark of the trace parser
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+EXAMPLE
+  NtTraceScan trace.txt
+  NtTraceScan -threads 8 -top 20 trace1.txt trace2.txt
+  NtTraceScan -bench 1024
+  NtTraceScan -bench 256 -save bench.txt
+*/
+
+static char const szRCSID[] = "$Id$";
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// or2 includes
+#include "../include/MappedFile.h"
+#include "../include/Options.h"
+#include "../include/TraceParser.h"
+
+using namespace or2;
+
+namespace {
+
+/** Counts for the lines of a trace, or a chunk of a trace */
+struct Counts {
+  uint64_t bytes{};
+  uint64_t lines{};
+  uint64_t calls{};
+  uint64_t preCalls{};
+  uint64_t failures{};
+  uint64_t arguments{};
+  std::unordered_map<std::string_view, uint64_t> functions; // calls by name
+
+  void add(Counts const &other) {
+    bytes += other.bytes;
+    lines += other.lines;
+    calls += other.calls;
+    preCalls += other.preCalls;
+    failures += other.failures;
+    arguments += other.arguments;
+    for (auto const &function : other.functions) {
+      functions[function.first] += function.second;
+    }
+  }
+};
+
+// Returns true if the result is an NTSTATUS error
+bool isFailure(std::string_view result) {
+  uint64_t value{};
+  return TraceParser::number(result, value) && TraceParser::isError(value);
+}
+
+// Parse a line fully, including the arguments
+void scan(Counts &counts, std::string_view line) {
+  counts.bytes += line.size() + 1;
+  ++counts.lines;
+  TraceRecord record;
+  if (!TraceParser::parse(line, record)) {
+    return;
+  }
+  TraceArgument argument;
+  while (TraceParser::nextArgument(record.args, argument)) {
+    ++counts.arguments;
+  }
+  if (record.before) {
+    ++counts.preCalls;
+    return;
+  }
+  ++counts.calls;
+  ++counts.functions[record.function];
+  if (isFailure(record.result)) {
+    ++counts.failures;
+  }
+}
+
+// Scan a trace on several threads, printing the throughput
+Counts scanText(std::string const &name, std::string_view text,
+                size_t threads) {
+  auto const start = std::chrono::steady_clock::now();
+  Counts total;
+  for (auto const &counts :
+       TraceParser::parallel<Counts>(text, threads, scan)) {
+    total.add(counts);
+  }
+  std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  auto const flags = std::cout.flags();
+  auto const precision = std::cout.precision();
+  std::cout << name << ": " << total.lines << " lines, " << total.calls
+            << " calls (" << total.failures << " failed), " << total.preCalls
+            << " pre-calls, " << total.arguments << " arguments\n";
+  std::cout << "  " << std::fixed << std::setprecision(1)
+            << text.size() / 1e6 << " MB in " << std::setprecision(3)
+            << elapsed.count() << " s on " << threads << " thread"
+            << (threads == 1 ? "" : "s") << ": " << std::setprecision(1)
+            << (elapsed.count() > 0 ? text.size() / 1e6 / elapsed.count() : 0)
+            << " MB/s\n";
+  std::cout.flags(flags);
+  std::cout.precision(precision);
+  return total;
+}
+
+// Print the functions called most often
+void showTop(Counts const &total, size_t count) {
+  std::vector<std::pair<std::string_view, uint64_t>> ranked(
+      total.functions.begin(), total.functions.end());
+  std::sort(ranked.begin(), ranked.end(), [](auto const &lhs, auto const &rhs) {
+    return lhs.second != rhs.second ? lhs.second > rhs.second
+                                    : lhs.first < rhs.first;
+  });
+  if (ranked.size() > count) {
+    ranked.resize(count);
+  }
+  if (!ranked.empty()) {
+    std::cout << "Calls by function:\n";
+  }
+  for (auto const &function : ranked) {
+    std::cout << std::setw(12) << function.second << "  " << function.first
+              << '\n';
+  }
+}
+
+// Make a synthetic trace of about 'megabytes' MB, in the format written by
+// NtTrace -time -pid -tid. The handles and addresses vary from call to call,
+// as in a real trace.
+std::string makeTrace(size_t megabytes) {
+  // Each is formatted with a handle and then an address
+  static char const *const bodies[] = {
+      "NtCreateFile(FileHandle=0x8ff5e8 [0x%x], DesiredAccess=GENERIC_READ|"
+      "SYNCHRONIZE|FILE_READ_ATTRIBUTES, ObjectAttributes=\"\\??\\C:\\"
+      "Windows\\System32\\kernel32.dll\", IoStatusBlock=0x%x [0/1], "
+      "AllocationSize=null, FileAttributes=0, ShareAccess=7, "
+      "CreateDisposition=1, CreateOptions=0x60, EaBuffer=null, EaLength=0) "
+      "=> 0",
+      "NtQueryValueKey(KeyHandle=0x%x, ValueName=\"Disable\", "
+      "KeyValueInformationClass=2 [KeyValuePartialInformation], "
+      "KeyValueInformation=0x%x, Length=0x90, ResultLength=0x8ff2fc) "
+      "=> 0xc0000034 [2 'The system cannot find the file specified.']",
+      "NtClose(Handle=0x%x) => 0",
+      "NtWaitForSingleObject(Handle=0x%x, Alertable=false, TimeOut=null) ...",
+      "NtWaitForSingleObject(Handle=0x%x, Alertable=false, TimeOut=null) "
+      "=> 0",
+      "NtAllocateVirtualMemory(ProcessHandle=0x%x, lpAddress=0x%x "
+      "[0x00a40000], ZeroBits=0, pSize=0x8ff4a8 [0x00010000], "
+      "flAllocationType=0x1000, flProtect=4) => 0",
+  };
+  std::string text;
+  text.reserve(megabytes * 1000000 + 1000);
+  char header[64];
+  char body[512];
+  for (uint64_t line = 0; text.size() < megabytes * 1000000; ++line) {
+    uint64_t const ms = line / 16;
+    int length = std::snprintf(
+        header, sizeof(header), "%02u:%02u:%02u.%03u: [%4u/%4u] ",
+        static_cast<unsigned>(ms / 3600000 % 24),
+        static_cast<unsigned>(ms / 60000 % 60),
+        static_cast<unsigned>(ms / 1000 % 60),
+        static_cast<unsigned>(ms % 1000), 1234u,
+        static_cast<unsigned>(5000 + line % 7));
+    text.append(header, static_cast<size_t>(length));
+    // The same handle for each cycle of the bodies, so a wait and its
+    // result match
+    size_t const index = line % std::size(bodies);
+    auto const handle =
+        static_cast<unsigned>(4 * (7 + line / std::size(bodies) % 997));
+    auto const address =
+        static_cast<unsigned>(0x8f0000 + line * 0x38 % 0x10000);
+    length = std::snprintf(body, sizeof(body), bodies[index], handle, address);
+    text.append(body, static_cast<size_t>(length));
+    text.push_back('\n');
+  }
+  return text;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  unsigned int threads(std::max(1u, std::thread::hardware_concurrency()));
+  unsigned int top(10);
+  unsigned int bench(0);
+  std::string saveFile;
+
+  Options options(szRCSID);
+  options.set("bench", &bench,
+              "Benchmark the parser on a synthetic trace of <n> MB, using one "
+              "thread and then all threads");
+  options.set("save", &saveFile,
+              "Write the synthetic trace used by -bench to <file>");
+  options.set("threads", &threads, "Number of threads to use");
+  options.set("top", &top, "Show the <n> functions called most often");
+  options.setArgs(0, -1, "<trace file>...");
+  if (!options.process(argc, argv, "Scan the output of NtTrace")) {
+    return 1;
+  }
+  threads = std::max(1u, threads);
+
+  if (bench) {
+    std::string const text = makeTrace(bench);
+    (void)scanText("Single thread", text, 1);
+    (void)scanText("All threads", text, threads);
+    if (!saveFile.empty()) {
+      std::ofstream ofs(saveFile, std::ios::binary);
+      if (!(ofs << text) || !ofs.flush()) {
+        std::cerr << "Cannot write: " << saveFile << std::endl;
+        return 1;
+      }
+    }
+    return 0;
+  }
+  if (options.begin() == options.end()) {
+    std::cerr << "No trace files specified" << std::endl;
+    return 1;
+  }
+
+  int ret = 0;
+  Counts total;
+  std::vector<MappedFile> files(
+      static_cast<size_t>(std::distance(options.begin(), options.end())));
+  auto file = files.begin();
+  for (auto const &fileName : options) {
+    std::string error;
+    if (!file->open(fileName, error)) {
+      std::cerr << "Cannot open: " << fileName << ": " << error << std::endl;
+      ret = 1;
+      continue;
+    }
+    total.add(scanText(fileName, file->text(), threads));
+    ++file;
+  }
+  showTop(total, top);
+  return ret;
+}
@@ -0,0 +1,213 @@
+/*
+NAME
+  NtTraceStore.cpp
+
+DESCRIPTION
+  Convert the text output of NtTrace into a columnar trace store, and show
+  the contents of trace stores
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+EXAMPLE
+  NtTraceStore -out calls.nts trace1.txt trace2.txt
+  NtTraceStore -blocks calls.nts
+*/
+
+static char const szRCSID[] = "$Id$";
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+// or2 includes
+#include "../include/MappedFile.h"
+#include "../include/Options.h"
+#include "../include/TraceParser.h"
+#include "../include/TraceStore.h"
+
+using namespace or2;
+
+namespace {
+
+// The date of the first call in a trace: the trace is taken to end on the
+// local date the file was last written, and to start less than a day
+// before that
+uint64_t startDate(std::string const &fileName, std::string_view text) {
+  std::error_code ec;
+  auto const written = std::filesystem::last_write_time(fileName, ec);
+  if (ec) {
+    return 0;
+  }
+  std::time_t const seconds = std::chrono::system_clock::to_time_t(
+      std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+          std::chrono::file_clock::to_sys(written)));
+  std::tm tm{};
+#ifdef _WIN32
+  if (localtime_s(&tm, &seconds) != 0) {
+    return 0;
+  }
+#else
+  if (!localtime_r(&seconds, &tm)) {
+    return 0;
+  }
+#endif
+  uint64_t date = TraceStoreWriter::date(tm.tm_year + 1900,
+                                         static_cast<unsigned>(tm.tm_mon + 1),
+                                         static_cast<unsigned>(tm.tm_mday));
+
+  // The time of the first line with a time stamp
+  uint64_t first{};
+  bool found{};
+  TraceParser::forEachLine(text, [&](std::string_view line) {
+    TraceRecord record;
+    if (!found && TraceParser::parse(line, record) &&
+        TraceParser::timeOfDay(record.time, first)) {
+      found = true;
+    }
+  });
+  uint64_t const last =
+      ((uint64_t(tm.tm_hour) * 60 + uint64_t(tm.tm_min)) * 60 +
+       uint64_t(tm.tm_sec) + 1) *
+      1000000;
+  if (found && first > last) {
+    date -= 24ull * 60 * 60 * 1000000;
+  }
+  return date;
+}
+
+// Add the calls in the text output of NtTrace to a store
+bool convert(TraceStoreWriter &writer, std::string const &fileName) {
+  MappedFile file;
+  std::string error;
+  if (!file.open(fileName, error)) {
+    std::cerr << "Cannot open: " << fileName << ": " << error << std::endl;
+    return false;
+  }
+  writer.beginFile(startDate(fileName, file.text()));
+  TraceParser::forEachLine(file.text(), [&writer](std::string_view line) {
+    TraceRecord record;
+    if (TraceParser::parse(line, record)) {
+      writer.add(record);
+    }
+  });
+  return true;
+}
+
+// Print a summary of a store, and optionally the statistics of each block
+bool show(std::string const &fileName, bool showBlocks) {
+  TraceStoreReader reader;
+  std::string error;
+  if (!reader.open(fileName, error)) {
+    std::cerr << "Cannot open: " << fileName << ": " << error << std::endl;
+    return false;
+  }
+  uint64_t bytes{};
+  TraceBlock::Range time{UINT64_MAX, 0};
+  for (auto const &block : reader.blocks()) {
+    bytes += block.size;
+    time.min = std::min(time.min, block.time.min);
+    time.max = std::max(time.max, block.time.max);
+  }
+  uint64_t const rows = reader.rows();
+  std::cout << fileName << ": " << rows << " calls in "
+            << reader.blocks().size() << " blocks, " << reader.strings()
+            << " distinct strings";
+  if (rows) {
+    std::cout << ", " << bytes / rows << " bytes per call in the blocks, "
+              << TraceStoreReader::format(time.min) << " to "
+              << TraceStoreReader::format(time.max);
+  }
+  std::cout << '\n';
+
+  if (showBlocks) {
+    size_t index{};
+    for (auto const &block : reader.blocks()) {
+      std::cout << "  block " << index++ << ": " << block.rows
+                << " calls, " << block.size << " bytes, "
+                << TraceStoreReader::format(block.time.min) << " to "
+                << TraceStoreReader::format(block.time.max) << ", processes "
+                << block.processId.min << " to " << block.processId.max
+                << ", threads " << block.threadId.min << " to "
+                << block.threadId.max << '\n';
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  std::string outFile;
+  unsigned int blockRows(65536);
+  bool showBlocks(false);
+
+  Options options(szRCSID);
+  options.set("out", &outFile,
+              "Convert the trace files into a trace store in <file>");
+  options.set("block", &blockRows, "Number of calls in each block");
+  options.set("blocks", &showBlocks, "Show the statistics of each block");
+  options.setArgs(1, -1, "<trace file or store>...");
+  if (!options.process(argc, argv,
+                       "Convert NtTrace output to a columnar trace store")) {
+    return 1;
+  }
+
+  int ret = 0;
+  if (outFile.empty()) {
+    for (auto const &fileName : options) {
+      if (!show(fileName, showBlocks)) {
+        ret = 1;
+      }
+    }
+    return ret;
+  }
+
+  TraceStoreWriter writer(outFile, blockRows);
+  if (!writer.good()) {
+    std::cerr << "Cannot open: " << outFile << std::endl;
+    return 1;
+  }
+  for (auto const &fileName : options) {
+    if (!convert(writer, fileName)) {
+      ret = 1;
+    }
+  }
+  writer.close();
+  if (!writer.good()) {
+    std::cerr << "Cannot write: " << outFile << std::endl;
+    return 1;
+  }
+  if (!show(outFile, showBlocks)) {
+    ret = 1;
+  }
+  return ret;
+}
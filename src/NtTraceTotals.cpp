@@ -0,0 +1,239 @@
+/*
+NAME
+  NtTraceTotals.cpp
+
+DESCRIPTION
+  Make a totals file from the text output of NtTrace, and compare the
+  totals of a run with a baseline, failing if the number of calls or errors
+  has grown beyond the tolerance
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+EXAMPLE
+  NtTraceTotals -out run.tot trace.txt
+  NtTraceTotals -baseline baseline.tot -tolerance 20 run.tot
+  NtTraceTotals -baseline baseline.tot -tolerances startup.txt run.tot
+*/
+
+static char const szRCSID[] = "$Id$";
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// or2 includes
+#include "../include/CallTotals.h"
+#include "../include/MappedFile.h"
+#include "../include/Options.h"
+#include "../include/TraceParser.h"
+
+using namespace or2;
+
+namespace {
+
+// Add the calls in the text output of NtTrace: processes are not named in
+// the text and categories are not shown, so the totals are by function
+bool addTrace(CallTotals &totals, std::string const &fileName) {
+  MappedFile file;
+  std::string error;
+  if (!file.open(fileName, error)) {
+    std::cerr << "Cannot open: " << fileName << ": " << error << std::endl;
+    return false;
+  }
+  uint64_t const oneDay = 24ull * 60 * 60 * 1000 * 1000;
+  std::map<std::pair<uint32_t, uint32_t>, uint64_t> starts; // by thread
+  TraceParser::forEachLine(file.text(), [&](std::string_view line) {
+    TraceRecord record;
+    if (!TraceParser::parse(line, record)) {
+      return;
+    }
+    auto const key = std::make_pair(record.processId, record.sequence());
+    uint64_t time{};
+    bool const timed = TraceParser::timeOfDay(record.time, time);
+    if (record.before) {
+      if (timed) {
+        starts[key] = time;
+      }
+      return;
+    }
+    int64_t duration = -1;
+    auto const start = starts.find(key);
+    if (start != starts.end()) {
+      if (timed) {
+        duration =
+            static_cast<int64_t>((time + oneDay - start->second) % oneDay);
+      }
+      starts.erase(start);
+    }
+    uint64_t status{};
+    bool const error = TraceParser::number(record.result, status) &&
+                       TraceParser::isError(status);
+    totals.add("*", "*", std::string(record.function), error, duration);
+  });
+  return true;
+}
+
+bool readTotals(std::string const &fileName, CallTotals::Table &table) {
+  std::ifstream ifs(fileName);
+  if (!ifs) {
+    std::cerr << "Cannot open: " << fileName << std::endl;
+    return false;
+  }
+  std::string error;
+  if (!CallTotals::read(ifs, table, error)) {
+    std::cerr << fileName << ": " << error << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Print changes from the baseline
+void print(char const *title, std::vector<CallTotals::Change> const &changes) {
+  if (changes.empty()) {
+    return;
+  }
+  std::cout << title << ":\n";
+  for (auto const &change : changes) {
+    auto const &[process, category, function] = change.key;
+    char line[80];
+    std::snprintf(line, sizeof(line), "  %-6s %10llu -> %-10llu", change.what,
+                  static_cast<unsigned long long>(change.baseline),
+                  static_cast<unsigned long long>(change.current));
+    std::cout << line;
+    if (change.baseline) {
+      std::snprintf(line, sizeof(line), " (%+.1f%%)",
+                    (static_cast<double>(change.current) -
+                     static_cast<double>(change.baseline)) *
+                        100 / static_cast<double>(change.baseline));
+      std::cout << line;
+    }
+    std::cout << "  " << process << ' ' << category << ' ' << function
+              << '\n';
+  }
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  std::string outFile;
+  std::string baselineFile;
+  std::string tolerancesFile;
+  CallTotals::Tolerance tolerance;
+  unsigned int slack(0);
+  bool showImprovements(false);
+
+  Options options(szRCSID);
+  options.set("out", &outFile,
+              "Write the totals of the calls in the trace files to <file>");
+  options.set("baseline", &baselineFile,
+              "Compare the totals file with the baseline totals in <file>, "
+              "exiting with 2 on regression");
+  options.set("tolerance", &tolerance.percent,
+              "Allowed percentage increase over the baseline");
+  options.set("slack", &slack,
+              "Allowed increase in the number of calls or errors, however "
+              "large as a percentage");
+  options.set("latency", &tolerance.latency,
+              "Allowed percentage increase in the 99th percentile latency");
+  options.set("tolerances", &tolerancesFile,
+              "Read the tolerances for functions or categories from <file>, "
+              "one per line as: <name> <percent> [<slack> [<latency>]]");
+  options.set("improvements", &showImprovements,
+              "Show the values lower than the baseline");
+  options.setArgs(1, -1, "<trace file>... | <totals file>");
+  if (!options.process(argc, argv,
+                       "Make and compare totals of the calls in a trace")) {
+    return 1;
+  }
+  tolerance.slack = slack;
+
+  if (outFile.empty() == baselineFile.empty()) {
+    std::cerr << "Specify one of -out or -baseline" << std::endl;
+    return 1;
+  }
+
+  if (!outFile.empty()) {
+    CallTotals totals;
+    for (auto const &fileName : options) {
+      if (!addTrace(totals, fileName)) {
+        return 1;
+      }
+    }
+    std::ofstream ofs(outFile);
+    CallTotals::write(ofs, totals.table());
+    if (!ofs.flush()) {
+      std::cerr << "Cannot write: " << outFile << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (std::distance(options.begin(), options.end()) != 1) {
+    std::cerr << "Specify one totals file to compare with the baseline"
+              << std::endl;
+    return 1;
+  }
+  std::map<std::string, CallTotals::Tolerance> tolerances;
+  if (!tolerancesFile.empty()) {
+    std::ifstream ifs(tolerancesFile);
+    std::string error;
+    if (!ifs) {
+      std::cerr << "Cannot open: " << tolerancesFile << std::endl;
+      return 1;
+    }
+    if (!CallTotals::readTolerances(ifs, tolerances, error)) {
+      std::cerr << tolerancesFile << ": " << error << std::endl;
+      return 1;
+    }
+  }
+  CallTotals::Table baseline;
+  CallTotals::Table current;
+  if (!readTotals(baselineFile, baseline) ||
+      !readTotals(*options.begin(), current)) {
+    return 1;
+  }
+  std::vector<CallTotals::Change> regressions;
+  std::vector<CallTotals::Change> improvements;
+  CallTotals::compare(baseline, current, tolerance, tolerances, regressions,
+                      improvements);
+  print("Regressions", regressions);
+  if (showImprovements) {
+    print("Improvements", improvements);
+  }
+  if (!regressions.empty()) {
+    return 2;
+  }
+  std::cout << "No regressions\n";
+  return 0;
+}
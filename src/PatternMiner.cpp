@@ -0,0 +1,487 @@
+/*
+NAME
+  PatternMiner.cpp
+
+DESCRIPTION
+  Mining of the sequences of calls repeated on each thread.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "PatternMiner.h"
+#include "StackTable.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <set>
+#include <utility>
+
+namespace or2 {
+namespace {
+
+// Calls are held as 32-bit positions in the joined sequence, leaving room
+// for the separators between threads
+uint64_t const maxCalls = 0xf0000000;
+
+// Sort the suffixes of 'text' by their first 'depth' symbols by prefix
+// doubling, as in Larsson and Sadakane, "Faster suffix sorting" (2007): once
+// sorted by the first 'sorted' symbols, each group of suffixes sharing those
+// symbols is sorted by the group of the suffix 'sorted' symbols later, and
+// groups of one suffix are not sorted again. Suffixes with the same first
+// 'depth' symbols are in no particular order.
+std::vector<uint32_t> suffixArray(std::vector<uint32_t> const &text,
+                                  uint32_t symbols, size_t depth) {
+  size_t const size = text.size();
+  std::vector<uint32_t> sa(size);
+  std::vector<uint32_t> group(size); // position in 'sa' of the group end
+
+  // Counting sort by the first two symbols, or by the first symbol if there
+  // are too many pairs
+  size_t const width = depth > 1 && symbols <= 4096 ? 2 : 1;
+  auto const key = [&](size_t pos) {
+    if (width == 1) {
+      return size_t(text[pos]);
+    }
+    return size_t(text[pos]) * symbols + (pos + 1 < size ? text[pos + 1] : 0);
+  };
+  std::vector<uint32_t> count(width == 1 ? size_t(symbols) + 1
+                                         : size_t(symbols) * symbols + 1);
+  for (size_t pos = 0; pos != size; ++pos) {
+    ++count[key(pos) + 1];
+  }
+  for (size_t idx = 1; idx != count.size(); ++idx) {
+    count[idx] += count[idx - 1];
+  }
+  for (size_t pos = 0; pos != size; ++pos) {
+    sa[count[key(pos)]++] = static_cast<uint32_t>(pos);
+  }
+  for (size_t pos = 0; pos != size; ++pos) {
+    group[pos] = count[key(pos)] - 1;
+  }
+  count = std::vector<uint32_t>();
+
+  // The groups of more than one suffix, as [first, last] in 'sa'
+  std::vector<std::pair<uint32_t, uint32_t>> unsorted;
+  for (size_t first = 0; first != size;) {
+    size_t const last = group[sa[first]];
+    if (last != first) {
+      unsorted.emplace_back(static_cast<uint32_t>(first),
+                            static_cast<uint32_t>(last));
+    }
+    first = last + 1;
+  }
+
+  std::vector<std::pair<uint32_t, uint32_t>> keys;
+  std::vector<std::pair<uint32_t, uint32_t>> next;
+  for (size_t sorted = width; sorted < depth && !unsorted.empty();
+       sorted *= 2) {
+    next.clear();
+    for (auto const &[first, last] : unsorted) {
+      // Key by the group 'sorted' symbols on, or zero past the end
+      keys.clear();
+      for (size_t idx = first; idx <= last; ++idx) {
+        uint32_t const pos = sa[idx];
+        keys.emplace_back(pos + sorted < size ? group[pos + sorted] + 1 : 0,
+                          pos);
+      }
+      std::sort(keys.begin(), keys.end());
+      // Split into groups; the group ends keep the order of the groups
+      size_t begin = 0;
+      for (size_t idx = 0; idx != keys.size(); ++idx) {
+        sa[first + idx] = keys[idx].second;
+        if (idx + 1 == keys.size() || keys[idx + 1].first != keys[idx].first) {
+          uint32_t const end = static_cast<uint32_t>(first + idx);
+          for (size_t member = begin; member <= idx; ++member) {
+            group[keys[member].second] = end;
+          }
+          if (begin != idx) {
+            next.emplace_back(static_cast<uint32_t>(first + begin), end);
+          }
+          begin = idx + 1;
+        }
+      }
+    }
+    unsorted.swap(next);
+  }
+  return sa;
+}
+
+// Get the shortest period of a pattern, from the longest proper prefix that
+// is also a suffix; occurrences of the pattern can overlap unless the period
+// is the whole length
+size_t period(uint32_t const *pattern, size_t length) {
+  std::vector<size_t> border(length);
+  for (size_t idx = 1; idx < length; ++idx) {
+    size_t matched = border[idx - 1];
+    while (matched && pattern[idx] != pattern[matched]) {
+      matched = border[matched - 1];
+    }
+    border[idx] = matched + (pattern[idx] == pattern[matched]);
+  }
+  return length ? length - border[length - 1] : 0;
+}
+
+// Get the lexicographically least rotation of a pattern
+std::vector<uint32_t> leastRotation(uint32_t const *pattern, size_t length) {
+  size_t first = 0;
+  size_t second = 1;
+  size_t matched = 0;
+  while (first < length && second < length && matched < length) {
+    uint32_t const lhs = pattern[(first + matched) % length];
+    uint32_t const rhs = pattern[(second + matched) % length];
+    if (lhs == rhs) {
+      ++matched;
+      continue;
+    }
+    (lhs > rhs ? first : second) += matched + 1;
+    if (first == second) {
+      ++second;
+    }
+    matched = 0;
+  }
+  size_t const start = std::min(first, second);
+  std::vector<uint32_t> result(pattern + start, pattern + length);
+  result.insert(result.end(), pattern, pattern + start);
+  return result;
+}
+
+// Count the occurrences of a pattern in some text, including any overlaps
+uint64_t occurrences(uint32_t const *pattern, size_t length,
+                     uint32_t const *text, size_t size) {
+  uint64_t result = 0;
+  for (size_t pos = 0; pos + length <= size; ++pos) {
+    result += std::equal(pattern, pattern + length, text + pos);
+  }
+  return result;
+}
+
+/** A pattern found in the suffix array */
+struct Candidate {
+  uint32_t start{};  // position of the earliest occurrence
+  uint32_t length{}; // number of calls
+  uint32_t first{};  // first occurrence in the suffix array
+  uint32_t last{};   // last occurrence in the suffix array
+  uint64_t count{};
+  uint64_t microseconds{};
+  uint64_t looped{}; // occurrences followed at once by another
+
+  uint64_t calls() const { return count * length; }
+};
+
+// Returns the value by which candidates are ranked
+uint64_t rankOf(Candidate const &candidate, PatternMiner::Order order) {
+  switch (order) {
+  case PatternMiner::Time:
+    return candidate.microseconds;
+  case PatternMiner::Count:
+    return candidate.count;
+  default:
+    return candidate.calls();
+  }
+}
+
+// Returns true if 'lhs' is ranked above 'rhs'
+bool ranksAbove(Candidate const &lhs, Candidate const &rhs,
+                PatternMiner::Order order) {
+  uint64_t const left = rankOf(lhs, order);
+  uint64_t const right = rankOf(rhs, order);
+  if (left != right) {
+    return left > right;
+  }
+  if (lhs.calls() != rhs.calls()) {
+    return lhs.calls() > rhs.calls();
+  }
+  return lhs.start < rhs.start;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+void PatternMiner::add(uint32_t processId, uint32_t threadId,
+                       std::string_view function, int64_t microseconds,
+                       uint32_t stack) {
+  if (calls_ + threads_.size() >= maxCalls) {
+    return;
+  }
+  uint64_t const key = (uint64_t(processId) << 32) | threadId;
+  if (last_ == SIZE_MAX || threads_[last_].processId != processId ||
+      threads_[last_].threadId != threadId) {
+    auto const found = threadIndex_.emplace(key, threads_.size());
+    if (found.second) {
+      threads_.push_back({processId, threadId, {}, {}, {}});
+    }
+    last_ = found.first->second;
+  }
+  Thread &thread = threads_[last_];
+
+  auto id = ids_.find(function);
+  if (id == ids_.end()) {
+    names_.emplace_back(function);
+    id = ids_.emplace(names_.back(), static_cast<uint32_t>(names_.size() - 1))
+             .first;
+  }
+  thread.functions.push_back(id->second + 1);
+  thread.durations.push_back(
+      microseconds < 0
+          ? 0
+          : static_cast<uint32_t>(
+                std::min<int64_t>(microseconds, UINT32_MAX - 1) + 1));
+  if (stack || !thread.stacks.empty()) {
+    thread.stacks.resize(thread.functions.size());
+    thread.stacks.back() = stack;
+  }
+  ++calls_;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Each interval of the suffix array in which adjacent suffixes share at
+// least 'lcp' calls is the set of occurrences of the pattern of that many
+// calls; the intervals are visited bottom up using a stack, as in
+// Abouelhoda, Kurtz and Ohlebusch, "Replacing suffix trees with enhanced
+// suffix arrays" (2004).
+std::vector<PatternMiner::Pattern> PatternMiner::mine(Order order,
+                                                      size_t count) const {
+  size_t const longest = std::max<size_t>(settings_.longest, 1);
+  size_t const shortest = std::max<size_t>(settings_.shortest, 1);
+
+  // Join the threads, ending each with a separator of zero
+  std::vector<uint32_t> text;
+  std::vector<uint32_t> starts; // position of the first call of each thread
+  text.reserve(calls_ + threads_.size());
+  for (Thread const &thread : threads_) {
+    starts.push_back(static_cast<uint32_t>(text.size()));
+    text.insert(text.end(), thread.functions.begin(), thread.functions.end());
+    text.push_back(0);
+  }
+  std::vector<uint32_t> const sa =
+      suffixArray(text, static_cast<uint32_t>(names_.size() + 1), longest);
+
+  // Total time of the calls before each position
+  std::vector<uint64_t> elapsed(text.size() + 1);
+  bool timed(false);
+  for (size_t idx = 0; idx != threads_.size(); ++idx) {
+    size_t pos = starts[idx];
+    for (uint32_t const duration : threads_[idx].durations) {
+      elapsed[pos + 1] = elapsed[pos] + (duration ? duration - 1 : 0);
+      timed = timed || duration;
+      ++pos;
+    }
+    elapsed[pos + 1] = elapsed[pos];
+  }
+
+  // Calls in common at the start of two suffixes, up to 'longest'
+  auto const common = [&](uint32_t lhs, uint32_t rhs) {
+    size_t length = 0;
+    while (length != longest && text[lhs + length] &&
+           text[lhs + length] == text[rhs + length]) {
+      ++length;
+    }
+    return length;
+  };
+  struct Interval {
+    size_t lcp;
+    size_t lb;
+  };
+  std::vector<Candidate> candidates;
+  std::vector<uint32_t> positions;
+  auto const found = [&](Interval const &interval, size_t rb) {
+    size_t const length = interval.lcp;
+    if (length < shortest || rb - interval.lb + 1 < settings_.minimum) {
+      return;
+    }
+    // A pattern that can overlap itself is only of interest as the shortest
+    // repetition of a pattern too short to report, such as A A; other such
+    // patterns extend a pattern that is reported
+    size_t const step = period(&text[sa[interval.lb]], length);
+    bool const repeated = step != length;
+    if (repeated && (length % step || length - step >= shortest)) {
+      return;
+    }
+    positions.assign(sa.begin() + interval.lb, sa.begin() + rb + 1);
+    if (repeated) {
+      std::sort(positions.begin(), positions.end());
+    }
+    Candidate candidate;
+    candidate.start = UINT32_MAX;
+    candidate.length = static_cast<uint32_t>(length);
+    candidate.first = static_cast<uint32_t>(interval.lb);
+    candidate.last = static_cast<uint32_t>(rb);
+    uint64_t end = 0;
+    for (uint32_t const pos : positions) {
+      if (pos < end) {
+        continue; // overlaps the previous occurrence counted
+      }
+      end = repeated ? pos + length : 0;
+      ++candidate.count;
+      candidate.start = std::min(candidate.start, pos);
+      candidate.microseconds += elapsed[pos + length] - elapsed[pos];
+    }
+    if (candidate.count >= settings_.minimum) {
+      candidates.push_back(candidate);
+    }
+  };
+
+  std::vector<Interval> stack{{0, 0}};
+  for (size_t idx = 1; idx <= sa.size(); ++idx) {
+    size_t const lcp = idx == sa.size() ? 0 : common(sa[idx - 1], sa[idx]);
+    size_t lb = idx - 1;
+    while (lcp < stack.back().lcp) {
+      found(stack.back(), idx - 1);
+      lb = stack.back().lb;
+      stack.pop_back();
+    }
+    if (lcp > stack.back().lcp) {
+      stack.push_back({lcp, lb});
+    }
+  }
+
+  // Keep the highest ranked rotation of each pattern. A pattern is not
+  // kept if most of its occurrences could be within those of a pattern
+  // already kept, or where one occurrence of such a pattern follows another
+  // as in a loop; for example B C within a loop of A B C, or C A across it.
+  // Nor is a pattern containing two turns of such a loop kept, as the loop
+  // with the calls before or after it.
+  std::sort(candidates.begin(), candidates.end(),
+            [order](Candidate const &lhs, Candidate const &rhs) {
+              return ranksAbove(lhs, rhs, order);
+            });
+  std::set<std::vector<uint32_t>> rotations;
+  std::vector<Candidate> unique;
+  std::vector<std::vector<uint32_t>> doubled; // each kept pattern, twice
+  std::vector<std::vector<uint32_t>> least;   // least rotation of each
+  auto const within = [&](Candidate const &candidate) {
+    uint32_t const *const pattern = &text[candidate.start];
+    size_t const length = candidate.length;
+    for (size_t idx = 0; idx != unique.size(); ++idx) {
+      Candidate const &kept = unique[idx];
+      auto const &twice = doubled[idx];
+      uint64_t const inner =
+          occurrences(pattern, length, twice.data(), kept.length);
+      uint64_t const across =
+          occurrences(pattern, length, twice.data(), twice.size()) - 2 * inner;
+      uint64_t const inside = inner * kept.count + across * kept.looped;
+      if (candidate.count * 9 <= inside * 10) {
+        return true;
+      }
+      for (size_t pos = 0; pos + 2 * kept.length <= length; ++pos) {
+        uint32_t const *const turn = pattern + pos;
+        if (std::equal(turn, turn + kept.length, turn + kept.length) &&
+            leastRotation(turn, kept.length) == least[idx]) {
+          return true;
+        }
+      }
+    }
+    return false;
+  };
+  for (Candidate &candidate : candidates) {
+    if (unique.size() == count) {
+      break;
+    }
+    uint32_t const *const pattern = &text[candidate.start];
+    auto rotation = leastRotation(pattern, candidate.length);
+    if (!rotations.insert(rotation).second || within(candidate)) {
+      continue;
+    }
+    positions.assign(sa.begin() + candidate.first,
+                     sa.begin() + candidate.last + 1);
+    std::sort(positions.begin(), positions.end());
+    for (uint32_t const pos : positions) {
+      candidate.looped += std::binary_search(
+          positions.begin(), positions.end(), pos + candidate.length);
+    }
+    unique.push_back(candidate);
+    doubled.emplace_back(pattern, pattern + candidate.length);
+    doubled.back().insert(doubled.back().end(), pattern,
+                          pattern + candidate.length);
+    least.push_back(std::move(rotation));
+  }
+
+  std::vector<Pattern> patterns;
+  for (Candidate const &candidate : unique) {
+    size_t const index = static_cast<size_t>(
+        std::upper_bound(starts.begin(), starts.end(), candidate.start) -
+        starts.begin() - 1);
+    Thread const &thread = threads_[index];
+    size_t const offset = candidate.start - starts[index];
+    Pattern pattern;
+    for (size_t idx = 0; idx != candidate.length; ++idx) {
+      pattern.functions.push_back(names_[text[candidate.start + idx] - 1]);
+    }
+    pattern.count = candidate.count;
+    pattern.calls = candidate.calls();
+    pattern.timed = timed;
+    pattern.microseconds = candidate.microseconds;
+    pattern.processId = thread.processId;
+    pattern.threadId = thread.threadId;
+    pattern.stack = thread.stacks.empty() ? 0 : thread.stacks[offset];
+    patterns.push_back(std::move(pattern));
+  }
+  return patterns;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// static
+void PatternMiner::report(std::ostream &os, StackTable const &stacks,
+                          std::vector<Pattern> const &patterns) {
+  auto const flags = os.flags();
+  auto const precision = os.precision();
+  os << "\nRepeated call sequences\n";
+  os << std::setw(10) << "Count" << std::setw(10) << "Calls" << std::setw(12)
+     << "Time ms"
+     << "  Sequence\n";
+  os << std::fixed << std::setprecision(3);
+  for (Pattern const &pattern : patterns) {
+    os << std::setw(10) << pattern.count << std::setw(10) << pattern.calls
+       << std::setw(12);
+    if (pattern.timed) {
+      os << static_cast<double>(pattern.microseconds) / 1000;
+    } else {
+      os << '-';
+    }
+    char const *separator = "  ";
+    for (auto const &function : pattern.functions) {
+      os << separator << function;
+      separator = " -> ";
+    }
+    os << "\n            e.g. thread ";
+    if (pattern.processId) {
+      os << pattern.processId << '/';
+    }
+    os << pattern.threadId << '\n';
+    char const *prefix = "              at: ";
+    for (auto const &frame : stacks.frames(pattern.stack)) {
+      os << prefix << frame << '\n';
+      prefix = "                  ";
+    }
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+
+} // namespace or2
@@ -0,0 +1,227 @@
+/*
+NAME
+  RedundantCalls.cpp
+
+DESCRIPTION
+  Detection of calls repeated with the same arguments on the same thread.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "RedundantCalls.h"
+#include "StackTable.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+namespace or2 {
+namespace {
+
+// FNV-1a
+uint64_t hash(uint64_t value, std::string const &text) {
+  for (char ch : text) {
+    value ^= static_cast<unsigned char>(ch);
+    value *= 0x100000001b3ull;
+  }
+  return value;
+}
+
+// NtTrace shows pointers in hex without padding, and other values of 0x10000
+// and over padded to 8 or 16 digits
+bool isPointer(std::string const &digits) {
+  return digits.size() > 4 &&
+         !((digits.size() == 8 || digits.size() == 16) && digits[0] == '0');
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+RedundantCalls::RedundantCalls(size_t window) : window_(window ? window : 1) {}
+
+//////////////////////////////////////////////////////////////////////////
+RedundantCalls::Offender *
+RedundantCalls::add(uint32_t threadId, std::string const &function,
+                    std::vector<std::string> const &keys) {
+  uint64_t const print = fingerprint(function, keys);
+  Window &thread = threads_[threadId];
+  uint32_t &inWindow = thread.count[print];
+  bool const repeat = inWindow != 0;
+  ++inWindow;
+  thread.order.push_back(print);
+  if (thread.order.size() > window_) {
+    const auto oldest = thread.count.find(thread.order.front());
+    if (--oldest->second == 0) {
+      thread.count.erase(oldest);
+    }
+    thread.order.pop_front();
+  }
+
+  auto it = offenders_.find(print);
+  if (it == offenders_.end()) {
+    if (!repeat) {
+      // Only calls that repeat are kept: count the first call when the
+      // repeat is seen
+      return nullptr;
+    }
+    it = offenders_.emplace(print, Offender{function, keys, 1, 0, 0}).first;
+  }
+  Offender &offender = it->second;
+  ++offender.calls;
+  if (!repeat) {
+    return nullptr;
+  }
+  ++offender.repeats;
+  return &offender;
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::vector<RedundantCalls::Offender const *>
+RedundantCalls::worst(size_t count) const {
+  std::vector<Offender const *> result;
+  result.reserve(offenders_.size());
+  for (auto const &entry : offenders_) {
+    result.push_back(&entry.second);
+  }
+  auto const worse = [](Offender const *lhs, Offender const *rhs) {
+    if (lhs->repeats != rhs->repeats) {
+      return lhs->repeats > rhs->repeats;
+    }
+    if (lhs->function != rhs->function) {
+      return lhs->function < rhs->function;
+    }
+    return lhs->keys < rhs->keys;
+  };
+  if (count < result.size()) {
+    std::partial_sort(result.begin(), result.begin() + count, result.end(),
+                      worse);
+    result.resize(count);
+  } else {
+    std::sort(result.begin(), result.end(), worse);
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void RedundantCalls::report(std::ostream &os, StackTable const &stacks,
+                            size_t count) const {
+  os << "\nRedundant calls (repeated within " << window_
+     << " calls on the same thread)\n";
+  os << std::setw(8) << "Repeats" << std::setw(8) << "Calls"
+     << "  Call\n";
+  for (Offender const *offender : worst(count)) {
+    os << std::setw(8) << offender->repeats << std::setw(8) << offender->calls
+       << "  " << offender->function << '(';
+    for (size_t idx = 0; idx != offender->keys.size(); ++idx) {
+      os << (idx ? ", " : "")
+         << (offender->keys[idx].empty() ? "*" : offender->keys[idx]);
+    }
+    os << ")\n";
+    char const *prefix = "                  at: ";
+    for (auto const &frame : stacks.frames(offender->stack)) {
+      os << prefix << frame << '\n';
+      prefix = "                      ";
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint64_t RedundantCalls::fingerprint(std::string const &function,
+                                     std::vector<std::string> const &keys) {
+  uint64_t value = hash(0xcbf29ce484222325ull, function);
+  for (auto const &key : keys) {
+    // Separate the keys so that ("ab", "c") and ("a", "bc") differ
+    value = hash(value, key);
+    value = (value ^ 0xff) * 0x100000001b3ull;
+  }
+  return value;
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::string RedundantCalls::normalize(std::string const &value) {
+  std::string result;
+  int depth = 0;
+  bool quoted = false;
+  for (size_t pos = 0; pos != value.size(); ++pos) {
+    char const ch = value[pos];
+    if (quoted) {
+      result += ch;
+      quoted = ch != '"';
+    } else if (ch == '[') {
+      ++depth;
+    } else if (ch == ']' && depth) {
+      --depth;
+    } else if (depth) {
+      // output value or decoded flags
+    } else if (ch == '"') {
+      result += ch;
+      quoted = true;
+    } else if (value.compare(pos, 2, "0x") == 0 &&
+               (pos == 0 || !isalnum(static_cast<unsigned char>(
+                                value[pos - 1])))) {
+      size_t end = pos + 2;
+      while (end != value.size() &&
+             isxdigit(static_cast<unsigned char>(value[end]))) {
+        ++end;
+      }
+      if (!isPointer(value.substr(pos + 2, end - pos - 2))) {
+        result.append(value, pos, end - pos);
+      }
+      pos = end - 1;
+    } else {
+      result += ch;
+    }
+  }
+
+  // Tidy up the spaces left behind
+  std::string tidy;
+  for (char ch : result) {
+    if (ch != ' ' || (!tidy.empty() && tidy.back() != ' ')) {
+      tidy += ch;
+    }
+  }
+  while (!tidy.empty() && tidy.back() == ' ') {
+    tidy.pop_back();
+  }
+  return tidy;
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::string RedundantCalls::handleKey(std::string const *name,
+                                      uint64_t handle) {
+  if (name) {
+    return '"' + *name + '"';
+  }
+  std::ostringstream oss;
+  oss << "(handle 0x" << std::hex << handle << ')';
+  return oss.str();
+}
+
+} // namespace or2
@@ -0,0 +1,179 @@
+/*
+NAME
+  RegistryProfile.cpp
+
+DESCRIPTION
+  Registry access statistics for each key.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "RegistryProfile.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+namespace or2 {
+namespace {
+
+uint32_t const statusObjectNameNotFound = 0xC0000034;
+uint32_t const statusObjectPathNotFound = 0xC000003A;
+
+// Returns true for an NTSTATUS of error severity; warnings such as
+// STATUS_BUFFER_OVERFLOW are returned when probing for the size of a value
+bool isError(uint32_t status) { return status >= 0xC0000000; }
+
+// Returns true for an NTSTATUS of success or information severity
+bool isSuccess(uint32_t status) { return status < 0x80000000; }
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+uint64_t RegistryProfile::Key::total() const {
+  uint64_t result{};
+  for (uint64_t count : calls) {
+    result += count;
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void RegistryProfile::add(std::string const &path, Op op,
+                          std::string const &valueName, uint32_t status,
+                          std::string const &infoClass) {
+  Entry &entry = keys_[path];
+  Key &key = entry.key;
+  if (key.path.empty()) {
+    key.path = path;
+  }
+  ++key.calls[op];
+  if (isError(status)) {
+    ++key.failures;
+    if (status == statusObjectNameNotFound ||
+        status == statusObjectPathNotFound) {
+      ++key.notFound;
+    }
+  }
+  if (op == ReadValue) {
+    ++key.values[valueName];
+  }
+  // A size probe failing with STATUS_BUFFER_OVERFLOW and the query that
+  // follows it are one read, and queries for different information differ
+  if ((op == Query || op == ReadValue) && isSuccess(status) &&
+      !entry.seen.emplace(op, valueName, infoClass).second) {
+    ++key.repeats;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::vector<RegistryProfile::Key const *>
+RegistryProfile::top(size_t count) const {
+  std::vector<Key const *> result;
+  result.reserve(keys_.size());
+  for (auto const &entry : keys_) {
+    result.push_back(&entry.second.key);
+  }
+  auto const busier = [](Key const *lhs, Key const *rhs) {
+    uint64_t const lhsTotal = lhs->total();
+    uint64_t const rhsTotal = rhs->total();
+    return lhsTotal != rhsTotal ? lhsTotal > rhsTotal : lhs->path < rhs->path;
+  };
+  if (count < result.size()) {
+    std::partial_sort(result.begin(), result.begin() + count, result.end(),
+                      busier);
+    result.resize(count);
+  } else {
+    std::sort(result.begin(), result.end(), busier);
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void RegistryProfile::report(std::ostream &os, size_t count) const {
+  // Number of value names listed for each key
+  size_t const maxValues = 5;
+
+  os << "\nRegistry access for " << keys_.size() << " keys\n";
+  os << std::setw(8) << "Calls" << std::setw(8) << "Opens" << std::setw(8)
+     << "Queries" << std::setw(8) << "Enums" << std::setw(8) << "Reads"
+     << std::setw(8) << "Writes" << std::setw(8) << "Failed" << std::setw(9)
+     << "NotFound" << std::setw(8) << "Repeats"
+     << "  Key\n";
+  for (Key const *key : top(count)) {
+    os << std::setw(8) << key->total() << std::setw(8) << key->calls[Open]
+       << std::setw(8) << key->calls[Query] << std::setw(8)
+       << key->calls[Enumerate] << std::setw(8) << key->calls[ReadValue]
+       << std::setw(8) << key->calls[Write] << std::setw(8) << key->failures
+       << std::setw(9) << key->notFound << std::setw(8) << key->repeats
+       << "  " << key->path << '\n';
+
+    std::vector<std::pair<std::string, uint64_t>> values(key->values.begin(),
+                                                         key->values.end());
+    std::stable_sort(values.begin(), values.end(),
+                     [](auto const &lhs, auto const &rhs) {
+                       return lhs.second > rhs.second;
+                     });
+    if (values.size() > maxValues) {
+      values.resize(maxValues);
+    }
+    char const *prefix = "          values: ";
+    for (auto const &value : values) {
+      os << prefix << (value.first.empty() ? "(default)" : value.first)
+         << ':' << value.second;
+      prefix = " ";
+    }
+    if (!values.empty()) {
+      os << '\n';
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+RegistryProfile::Op RegistryProfile::operation(std::string const &function) {
+  static std::map<std::string, Op> const operations = {
+      {"NtCreateKey", Open},
+      {"NtCreateKeyTransacted", Open},
+      {"NtDeleteKey", Write},
+      {"NtDeleteValueKey", Write},
+      {"NtEnumerateKey", Enumerate},
+      {"NtEnumerateValueKey", Enumerate},
+      {"NtOpenKey", Open},
+      {"NtOpenKeyEx", Open},
+      {"NtOpenKeyTransacted", Open},
+      {"NtOpenKeyTransactedEx", Open},
+      {"NtQueryKey", Query},
+      {"NtQueryMultipleValueKey", ReadValue},
+      {"NtQueryValueKey", ReadValue},
+      {"NtSetValueKey", Write},
+  };
+  auto const it = operations.find(function);
+  return it == operations.end() ? OpCount : it->second;
+}
+
+} // namespace or2
@@ -0,0 +1,419 @@
+/*
+NAME
+  ShardedOutput.cpp
+
+DESCRIPTION
+  Output split into a file for each process or thread, and its merge.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "ShardedOutput.h"
+
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <queue>
+#include <sstream>
+
+namespace or2 {
+namespace {
+
+char const indexHeader[] = "# NtTrace shard index";
+
+// Get the part of a file name after any directory
+std::string baseName(std::string const &fileName) {
+  size_t const slash = fileName.find_last_of("/\\");
+  return slash == std::string::npos ? fileName : fileName.substr(slash + 1);
+}
+
+// Split a file name into the name and any extension
+std::pair<std::string, std::string>
+splitExtension(std::string const &fileName) {
+  size_t const slash = fileName.find_last_of("/\\");
+  size_t const dot = fileName.rfind('.');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+    return {fileName, ""};
+  }
+  return {fileName.substr(0, dot), fileName.substr(dot)};
+}
+
+// Returns true if the line is a marker, and sets its sequence number
+bool isMarker(std::string_view line, uint64_t &sequence) {
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+  if (line.size() < 2 || line[0] != '#') {
+    return false;
+  }
+  sequence = 0;
+  for (char const ch : line.substr(1)) {
+    if (ch < '0' || ch > '9') {
+      return false;
+    }
+    sequence = sequence * 10 + static_cast<uint64_t>(ch - '0');
+  }
+  return true;
+}
+
+// Get the next line of a text, without the end of line, advancing 'pos'
+std::string_view nextLine(std::string_view text, size_t &pos) {
+  size_t const start = pos;
+  void const *const eol =
+      std::memchr(text.data() + pos, '\n', text.size() - pos);
+  if (eol == nullptr) {
+    pos = text.size();
+    return text.substr(start);
+  }
+  pos = static_cast<size_t>(static_cast<char const *>(eol) - text.data()) + 1;
+  return text.substr(start, pos - 1 - start);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+ShardBuf::ShardBuf(std::string const &fileName, Mode mode, size_t bufferSize)
+    : fileName_(fileName), mode_(mode), bufferSize_(bufferSize),
+      index_(indexName(fileName)) {
+  if (!index_) {
+    error_ = indexName(fileName);
+    return;
+  }
+  index_ << indexHeader << '\n';
+  write(shard({}));
+}
+
+//////////////////////////////////////////////////////////////////////////
+ShardBuf::~ShardBuf() { (void)flush(); }
+
+//////////////////////////////////////////////////////////////////////////
+bool ShardBuf::flush() {
+  for (auto &entry : shards_) {
+    write(entry.second);
+  }
+  if (!index_.flush() && error_.empty()) {
+    error_ = indexName(fileName_);
+  }
+  return good();
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::string ShardBuf::shardName(std::string const &fileName,
+                                uint32_t processId, uint32_t threadId) {
+  if (processId == 0) {
+    return fileName;
+  }
+  auto const parts = splitExtension(fileName);
+  std::string result = parts.first + '-' + std::to_string(processId);
+  if (threadId != 0) {
+    result += '-' + std::to_string(threadId);
+  }
+  return result + parts.second;
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::string ShardBuf::indexName(std::string const &fileName) {
+  return splitExtension(fileName).first + ".index";
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ShardBuf::source(uint32_t processId, uint32_t threadId) {
+  source_ = {processId, mode_ == Thread ? threadId : 0};
+}
+
+//////////////////////////////////////////////////////////////////////////
+// A file is created, and added to the index, the first time it is used; a
+// file used again after its thread or process exited is appended to
+ShardBuf::Shard &ShardBuf::shard(Key const &key) {
+  auto const it = shards_.find(key);
+  if (it != shards_.end()) {
+    return it->second;
+  }
+  Shard &result = shards_[key];
+  result.fileName = shardName(fileName_, key.first, key.second);
+  if (created_.insert(result.fileName).second) {
+    result.truncate = true;
+    index_ << "shard " << key.first << ' ' << key.second << ' '
+           << baseName(result.fileName) << std::endl;
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ShardBuf::write(Shard &shard) {
+  if (shard.buffer.empty() && !shard.truncate) {
+    return;
+  }
+  std::ofstream os(shard.fileName,
+                   shard.truncate ? std::ios::out : std::ios::app);
+  os.write(shard.buffer.data(),
+           static_cast<std::streamsize>(shard.buffer.size()));
+  if (!os && error_.empty()) {
+    error_ = shard.fileName;
+  }
+  shard.buffer.clear();
+  shard.truncate = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ShardBuf::erase(std::map<Key, Shard>::iterator first,
+                     std::map<Key, Shard>::iterator last) {
+  for (auto it = first; it != last; ++it) {
+    write(it->second);
+    if (last_ == &it->second) {
+      last_ = nullptr;
+    }
+  }
+  shards_.erase(first, last);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ShardBuf::processStarted(uint32_t processId, uint32_t parentId,
+                              std::string_view time, std::string_view image) {
+  index_ << "start " << processId << ' ' << parentId << ' '
+         << (time.empty() ? "-" : time) << ' ' << image << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ShardBuf::processExited(uint32_t processId, std::string_view time,
+                             uint32_t exitCode) {
+  index_ << "exit " << processId << ' ' << (time.empty() ? "-" : time) << ' '
+         << exitCode << std::endl;
+  if (processId != 0) {
+    erase(shards_.lower_bound({processId, 0}),
+          shards_.upper_bound({processId, UINT32_MAX}));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ShardBuf::threadExited(uint32_t processId, uint32_t threadId) {
+  if (mode_ == Thread && processId != 0) {
+    auto const it = shards_.find({processId, threadId});
+    if (it != shards_.end()) {
+      erase(it, std::next(it));
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+ShardBuf::int_type ShardBuf::overflow(int_type ch) {
+  if (traits_type::eq_int_type(ch, traits_type::eof())) {
+    return traits_type::not_eof(ch);
+  }
+  char const text = traits_type::to_char_type(ch);
+  (void)xsputn(&text, 1);
+  return ch;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// A block starts with a marker whenever the output moves to another file
+std::streamsize ShardBuf::xsputn(char const *text, std::streamsize count) {
+  Shard &target = shard(source_);
+  if (&target != last_) {
+    if (!target.lineStart) {
+      target.buffer += '\n';
+    }
+    target.buffer += '#';
+    target.buffer += std::to_string(++sequence_);
+    target.buffer += '\n';
+    target.lineStart = true;
+    last_ = &target;
+  }
+  std::string_view remaining(text, static_cast<size_t>(count));
+  while (!remaining.empty()) {
+    if (target.lineStart && remaining.front() == '#') {
+      target.buffer += '#';
+    }
+    size_t const eol = remaining.find('\n');
+    size_t const length = eol == std::string_view::npos ? remaining.size()
+                                                        : eol + 1;
+    target.buffer.append(remaining.substr(0, length));
+    target.lineStart = eol != std::string_view::npos;
+    remaining.remove_prefix(length);
+  }
+  if (target.buffer.size() >= bufferSize_) {
+    write(target);
+  }
+  return count;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// The files are only written when their buffer is full, so that flushing
+// the stream after each line does not open a file each time
+int ShardBuf::sync() {
+  index_.flush();
+  return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool ShardIndex::read(std::istream &is) {
+  processes_.clear();
+  shards_.clear();
+  std::string line;
+  if (!std::getline(is, line) || line.rfind(indexHeader, 0) != 0) {
+    return false;
+  }
+  while (std::getline(is, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    std::istringstream iss(line);
+    std::string kind;
+    iss >> kind;
+    if (kind == "shard") {
+      Shard shard;
+      iss >> shard.processId >> shard.threadId >> std::ws;
+      std::getline(iss, shard.fileName);
+      if (iss && !shard.fileName.empty()) {
+        shards_.push_back(shard);
+      }
+    } else if (kind == "start") {
+      Process process;
+      iss >> process.processId >> process.parentId >> process.start >>
+          std::ws;
+      std::getline(iss, process.image);
+      if (process.processId != 0) {
+        processes_.push_back(process);
+      }
+    } else if (kind == "exit") {
+      uint32_t processId{};
+      std::string time;
+      uint32_t exitCode{};
+      iss >> processId >> time >> exitCode;
+      // Process IDs can be reused, so the latest start is the one exiting
+      for (auto it = processes_.rbegin(); it != processes_.rend(); ++it) {
+        if (it->processId == processId) {
+          if (it->exit.empty()) {
+            it->exit = time;
+            it->exitCode = exitCode;
+          }
+          break;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::set<uint32_t> ShardIndex::tree(uint32_t processId) const {
+  std::set<uint32_t> result{processId};
+  for (bool added = true; added;) {
+    added = false;
+    for (Process const &process : processes_) {
+      if (result.count(process.parentId) &&
+          result.insert(process.processId).second) {
+        added = true;
+      }
+    }
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ShardIndex::print(std::ostream &os) const {
+  std::set<uint32_t> known;
+  for (Process const &process : processes_) {
+    known.insert(process.processId);
+  }
+  std::set<uint32_t> shown;
+  for (Process const &process : processes_) {
+    if (!known.count(process.parentId) ||
+        process.parentId == process.processId) {
+      print(os, process, 0, shown);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ShardIndex::print(std::ostream &os, Process const &process, size_t depth,
+                       std::set<uint32_t> &shown) const {
+  if (!shown.insert(process.processId).second) {
+    return;
+  }
+  os << std::string(depth * 2, ' ') << process.processId << ' '
+     << process.image << "  started " << process.start;
+  if (!process.exit.empty()) {
+    os << ", exited " << process.exit << " with code " << process.exitCode;
+  }
+  os << '\n';
+  for (Process const &child : processes_) {
+    if (child.parentId == process.processId &&
+        child.processId != process.processId) {
+      print(os, child, depth + 1, shown);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Each file holds blocks in ascending order of sequence number, so a k-way
+// merge of the blocks restores the order the lines were written
+void ShardIndex::merge(std::vector<std::string_view> const &texts,
+                       std::ostream &os) {
+  using Next = std::pair<uint64_t, size_t>; // sequence number and text
+  std::priority_queue<Next, std::vector<Next>, std::greater<Next>> queue;
+  std::vector<size_t> positions(texts.size());
+
+  // Any lines before the first marker are taken to come first
+  for (size_t idx = 0; idx != texts.size(); ++idx) {
+    size_t pos = 0;
+    uint64_t sequence{};
+    if (isMarker(nextLine(texts[idx], pos), sequence)) {
+      positions[idx] = pos;
+    } else {
+      sequence = 0;
+    }
+    if (positions[idx] != texts[idx].size()) {
+      queue.push({sequence, idx});
+    }
+  }
+
+  while (!queue.empty()) {
+    size_t const idx = queue.top().second;
+    queue.pop();
+    std::string_view const text = texts[idx];
+    size_t &pos = positions[idx];
+    while (pos != text.size()) {
+      size_t const start = pos;
+      std::string_view const line = nextLine(text, pos);
+      uint64_t sequence{};
+      if (isMarker(line, sequence)) {
+        queue.push({sequence, idx});
+        break;
+      }
+      // Lines of the trace starting with '#' have an extra one
+      size_t const skip = line.empty() || line[0] != '#' ? 0 : 1;
+      os.write(text.data() + start + skip,
+               static_cast<std::streamsize>(pos - start - skip));
+    }
+  }
+}
+
+} // namespace or2
@@ -357,6 +357,49 @@ void showUnicodeString(std::ostream &os, HANDLE hProcess,
   }
 }
 
+//////////////////////////////////////////////////////////////////////////
+bool readUnicodeString(HANDLE hProcess, PUNICODE_STRING pTargetUnicodeString,
+                       std::string &result) {
+  result.clear();
+  UNICODE_STRING unicodeString{};
+  if (pTargetUnicodeString == nullptr ||
+      !readHelper(hProcess, pTargetUnicodeString, unicodeString)) {
+    return false;
+  }
+  size_t const nStringLength = unicodeString.Length / sizeof(wchar_t);
+  if (nStringLength == 0) {
+    return true;
+  }
+  std::vector<wchar_t> chVector(nStringLength);
+  if (!ReadProcessMemory(hProcess, unicodeString.Buffer, &chVector[0],
+                         nStringLength * sizeof(wchar_t), nullptr)) {
+    return false;
+  }
+  size_t const mbLen =
+      or2::Utf16ToMbs(nullptr, 0, &chVector[0], nStringLength);
+  if (mbLen == 0) {
+    return false;
+  }
+  result.resize(mbLen);
+  (void)or2::Utf16ToMbs(&result[0], mbLen, &chVector[0], nStringLength);
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool readObjectName(HANDLE hProcess, POBJECT_ATTRIBUTES pObjectAttributes,
+                    std::string &result, HANDLE *pRoot) {
+  OBJECT_ATTRIBUTES objectAttributes{};
+  result.clear();
+  if (pObjectAttributes == nullptr ||
+      !readHelper(hProcess, pObjectAttributes, objectAttributes)) {
+    return false;
+  }
+  if (pRoot) {
+    *pRoot = objectAttributes.RootDirectory;
+  }
+  return readUnicodeString(hProcess, objectAttributes.ObjectName, result);
+}
+
 //////////////////////////////////////////////////////////////////////////
 void showPointer(std::ostream &os, HANDLE /*hProcess*/, ULONG_PTR argVal) {
   if (argVal == 0)
@@ -624,9 +667,8 @@ void showPLargeInteger(std::ostream &os, HANDLE hProcess,
     LARGE_INTEGER largeInteger{};
     readHelper(hProcess, pLargeInteger, largeInteger);
 
-    os << " [";
-    os << largeInteger;
-    os << "]";
+    // Written exactly, as a double cannot hold every file offset
+    os << " [" << largeInteger.QuadPart << "]";
   }
 }
 
@@ -736,8 +778,8 @@ void showUserProcessParams(std::ostream &os, HANDLE hProcess,
 }
 
 //////////////////////////////////////////////////////////////////////////
-// Convert windows NT error into a text string, if possible.
-void showWinError(std::ostream &os, HRESULT hResult) {
+// Get the message text for a windows error, without the trailing newline
+std::string winErrorMessage(HRESULT hResult) {
   char *pszMsg = nullptr;
   HMODULE hmod = nullptr;
 
@@ -747,6 +789,7 @@ void showWinError(std::ostream &os, HRESULT hResult) {
                 hmod, hResult, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
                 reinterpret_cast<LPTSTR>(&pszMsg), 0, nullptr);
 
+  std::string result;
   if (pszMsg != nullptr) {
     size_t const nLen = strlen(pszMsg);
     if (nLen > 1 && pszMsg[nLen - 1] == '\n') {
@@ -755,13 +798,22 @@ void showWinError(std::ostream &os, HRESULT hResult) {
         pszMsg[nLen - 2] = 0;
       }
     }
+    result = pszMsg;
+    ::LocalFree(pszMsg);
+  }
+  return result;
+}
 
+//////////////////////////////////////////////////////////////////////////
+// Convert windows NT error into a text string, if possible.
+void showWinError(std::ostream &os, HRESULT hResult) {
+  std::string const message = winErrorMessage(hResult);
+  if (!message.empty()) {
     if (hResult < 0)
       os << " [0x" << std::hex << hResult << std::dec;
     else
       os << " [" << hResult;
-    os << " '" << pszMsg << "']";
-    ::LocalFree(pszMsg);
+    os << " '" << message << "']";
   }
 }
 
@@ -0,0 +1,215 @@
+/*
+NAME
+  SmallIoDetector.cpp
+
+DESCRIPTION
+  Detection of small sequential, misaligned and alternating I/O on a handle.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "SmallIoDetector.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+namespace or2 {
+
+//////////////////////////////////////////////////////////////////////////
+SmallIoDetector::SmallIoDetector(Settings const &settings)
+    : settings_(settings) {
+  settings_.buffer = std::max<uint64_t>(1, settings_.buffer);
+  settings_.alignment = std::max<uint64_t>(1, settings_.alignment);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Add the estimate for the current run to the stream and start a new run
+void SmallIoDetector::endRun(Stream &stream) const {
+  if (stream.runCalls > 1 &&
+      stream.runBytes < settings_.small * stream.runCalls) {
+    stream.small += stream.runCalls;
+    stream.buffered +=
+        std::max<uint64_t>(1, (stream.runBytes + settings_.buffer - 1) /
+                                  settings_.buffer);
+  } else {
+    stream.buffered += stream.runCalls;
+  }
+  stream.runCalls = 0;
+  stream.runBytes = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SmallIoDetector::add(uint32_t processId, uint64_t handle,
+                          std::string const &name, Op op, uint64_t offset,
+                          uint64_t requested, uint64_t transferred,
+                          int64_t microseconds, uint32_t code) {
+  Stream &stream = open_[{processId, handle}];
+  if (stream.total() == 0) {
+    stream.processId = processId;
+    stream.handle = handle;
+  }
+  if (stream.name.empty()) {
+    stream.name = name;
+  }
+
+  // A call continues the run if it does the same thing where the last one
+  // ended; device I/O controls have no offset. Small calls are bound to be
+  // misaligned, so only calls of at least the alignment are checked.
+  bool sequential = op == stream.op && (op != Control || code == stream.code);
+  if (op != Control && offset != current) {
+    if (stream.positioned && offset != stream.position) {
+      sequential = false;
+    }
+    if (offset % settings_.alignment &&
+        std::max(requested, transferred) >= settings_.alignment) {
+      ++stream.misaligned;
+    }
+    stream.positioned = true;
+    stream.position = offset;
+  }
+  if (!sequential) {
+    endRun(stream);
+  }
+  if (op == Read && stream.op == Write) {
+    ++stream.turns;
+  }
+  stream.op = op;
+  stream.code = code;
+  if (op != Control) {
+    stream.position += transferred;
+  }
+
+  uint64_t const size = std::max(requested, transferred);
+  ++stream.calls[op];
+  stream.bytes += size;
+  ++stream.runCalls;
+  stream.runBytes += size;
+  if (microseconds >= 0) {
+    ++stream.timed;
+    stream.microseconds += static_cast<uint64_t>(microseconds);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Only streams worth reporting are kept once closed, so a process opening
+// many files does not use memory without limit
+void SmallIoDetector::close(uint32_t processId, uint64_t handle) {
+  const auto it = open_.find({processId, handle});
+  if (it == open_.end()) {
+    return;
+  }
+  Stream &stream = it->second;
+  endRun(stream);
+  if (stream.saved() >= settings_.minimum ||
+      stream.misaligned >= settings_.minimum ||
+      stream.turns >= settings_.minimum) {
+    closed_.push_back(std::move(stream));
+  }
+  open_.erase(it);
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::vector<SmallIoDetector::Stream>
+SmallIoDetector::worst(size_t count) const {
+  std::vector<Stream> result;
+  auto const keep = [&](Stream const &stream) {
+    if (stream.saved() >= settings_.minimum ||
+        stream.misaligned >= settings_.minimum ||
+        stream.turns >= settings_.minimum) {
+      result.push_back(stream);
+    }
+  };
+  for (auto const &entry : open_) {
+    Stream stream = entry.second;
+    endRun(stream);
+    keep(stream);
+  }
+  for (Stream const &stream : closed_) {
+    keep(stream);
+  }
+  auto const worse = [](Stream const &lhs, Stream const &rhs) {
+    if (lhs.saved() != rhs.saved()) {
+      return lhs.saved() > rhs.saved();
+    }
+    if (lhs.turns + lhs.misaligned != rhs.turns + rhs.misaligned) {
+      return lhs.turns + lhs.misaligned > rhs.turns + rhs.misaligned;
+    }
+    return lhs.name < rhs.name;
+  };
+  std::stable_sort(result.begin(), result.end(), worse);
+  if (count < result.size()) {
+    result.resize(count);
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void SmallIoDetector::report(std::ostream &os, size_t count) const {
+  auto const flags = os.flags();
+  auto const precision = os.precision();
+  std::vector<Stream> const streams = worst(count);
+  os << "\nSmall I/O on " << streams.size() << " handles (small < "
+     << settings_.small << ", buffer " << settings_.buffer << ", alignment "
+     << settings_.alignment << " bytes)\n";
+  os << std::setw(8) << "Calls" << std::setw(8) << "Small" << std::setw(9)
+     << "Buffered" << std::setw(8) << "Saved" << std::setw(9) << "Avg size"
+     << std::setw(11) << "Misaligned" << std::setw(8) << "Turns"
+     << std::setw(10) << "Time ms"
+     << "  Handle\n";
+  os << std::fixed << std::setprecision(3);
+  for (Stream const &stream : streams) {
+    os << std::setw(8) << stream.total() << std::setw(8) << stream.small
+       << std::setw(9) << stream.buffered << std::setw(8) << stream.saved()
+       << std::setw(9) << stream.bytes / std::max<uint64_t>(1, stream.total())
+       << std::setw(11) << stream.misaligned << std::setw(8) << stream.turns
+       << std::setw(10);
+    if (stream.timed) {
+      os << static_cast<double>(stream.microseconds) / 1000;
+    } else {
+      os << '-';
+    }
+    os << "  [" << stream.processId << "] 0x" << std::hex << stream.handle
+       << std::dec;
+    if (!stream.name.empty()) {
+      os << ' ' << stream.name;
+    }
+    os << "\n          calls:";
+    static char const *const names[OpCount] = {"read", "write", "control"};
+    for (size_t op = 0; op != OpCount; ++op) {
+      if (stream.calls[op]) {
+        os << ' ' << names[op] << ':' << stream.calls[op];
+      }
+    }
+    os << '\n';
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+
+} // namespace or2
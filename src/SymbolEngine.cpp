@@ -50,16 +50,23 @@ COPYRIGHT
 #pragma comment(lib, "comsupp.lib")
 
 // stl
+#include <algorithm>
+#include <cctype>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <set>
 #include <sstream>
 #include <typeinfo>
 
+#include "../include/ModuleMap.h"
 #include "../include/MsvcExceptions.h"
 #include "../include/ReadPartialMemory.h"
 #include "../include/StrFromWchar.h"
+#include "../include/SymbolCache.h"
 #include "../include/Utf16ToMbs.h"
+#include "../include/X64Unwinder.h"
 
 #include "GetModuleBase.h"
 
@@ -71,6 +78,11 @@ namespace {
 // fix for problem with resource leak in symsrv
 void fixSymSrv();
 
+#ifdef _M_X64
+// Largest amount of stack copied for the native unwinder
+DWORD64 const maxStackCopy = 1024 * 1024;
+#endif // _M_X64
+
 // Show function/SEH parameters
 template <typename WORDSIZE>
 void addParams(std::ostream &os, WORDSIZE *pParams, size_t maxParams) {
@@ -215,6 +227,10 @@ void showInlineVariablesAt(std::ostream &os, DWORD64 codeOffset,
                            DWORD64 frameOffset, const CONTEXT &context,
                            DWORD inline_context, SymbolEngine const &eng);
 
+// Image relative addresses are 32-bit, so this bit keeps the function names
+// in the symbol cache apart from the names from addressToName
+constexpr uint64_t functionKey = uint64_t{1} << 63;
+
 //////////////////////////////////////////////////////////
 // Helper function: getBaseType maps PDB type + length to C++ name
 std::string getBaseType(DWORD baseType, ULONG64 length);
@@ -231,8 +247,98 @@ BOOL getWow64ThreadContext(HANDLE hThread, WOW64_CONTEXT *pWowContext);
 struct SymbolEngine::Impl {
   std::map<DWORD64, std::string> addressMap;
   std::map<std::pair<DWORD64, DWORD>, std::string> inlineMap;
+
+  // Shared module-relative cache, if any
+  SymbolCache *sharedCache{};
+
+  // Modules identified in the shared cache, keyed by base address
+  struct Module {
+    DWORD64 size;
+    uint32_t id;
+  };
+  std::map<DWORD64, Module> modules;
+
+  // Modules loaded in the process, if known
+  ModuleMap const *moduleMap{};
+
+  // Serial numbers of the modules from the map with symbols loaded
+  std::set<uint64_t> loaded;
+
+  // Identifiers in the shared cache, keyed by module serial number
+  std::map<uint64_t, uint32_t> moduleIds;
+
+  // Native unwinder, used with the module map for x64 stacks
+  std::unique_ptr<X64Unwinder> unwinder;
+
+  bool findModule(HANDLE hProcess, DWORD64 address, DWORD64 &base,
+                  uint32_t &id);
 };
 
+/////////////////////////////////////////////////////////////////////////////////////
+// Find the module containing address, and its identifier in the shared cache
+bool SymbolEngine::Impl::findModule(HANDLE hProcess, DWORD64 address,
+                                    DWORD64 &base, uint32_t &id) {
+  if (moduleMap) {
+    ModuleMap::Module const *module = moduleMap->find(address);
+    if (module && !module->name.empty()) {
+      auto found = moduleIds.find(module->serial);
+      if (found == moduleIds.end()) {
+        std::string const identity =
+            SymbolCache::identity(module->name, module->size,
+                                  module->timeStamp, module->checkSum);
+        found = moduleIds
+                    .emplace(module->serial, sharedCache->moduleId(identity))
+                    .first;
+      }
+      base = module->base;
+      id = found->second;
+      return true;
+    }
+  }
+
+  auto it = modules.upper_bound(address);
+  if (it != modules.begin()) {
+    --it;
+    if (address - it->first < it->second.size) {
+      base = it->first;
+      id = it->second.id;
+      return true;
+    }
+  }
+
+  MEMORY_BASIC_INFORMATION mbInfo;
+  if (!::VirtualQueryEx(hProcess, (PVOID)address, &mbInfo, sizeof mbInfo) ||
+      ((mbInfo.State & MEM_FREE) != 0) || ((mbInfo.Type & MEM_IMAGE) == 0)) {
+    return false;
+  }
+  const auto hmod = static_cast<HMODULE>(mbInfo.AllocationBase);
+  MODULEINFO moduleInfo{};
+  std::string const fileName = GetModuleFileNameWrapper(hProcess, hmod);
+  if (fileName.empty() ||
+      !::GetModuleInformation(hProcess, hmod, &moduleInfo,
+                              sizeof(moduleInfo))) {
+    return false;
+  }
+
+  // CheckSum is at the same offset in the 32- and 64-bit optional headers
+  IMAGE_DOS_HEADER dosHeader{};
+  IMAGE_NT_HEADERS32 ntHeaders{};
+  if (!ReadProcessMemory(hProcess, hmod, &dosHeader, sizeof(dosHeader),
+                         nullptr) ||
+      !ReadProcessMemory(hProcess, (char *)hmod + dosHeader.e_lfanew,
+                         &ntHeaders, sizeof(ntHeaders), nullptr) ||
+      ntHeaders.Signature != IMAGE_NT_SIGNATURE) {
+    return false;
+  }
+
+  base = reinterpret_cast<DWORD64>(hmod);
+  id = sharedCache->moduleId(SymbolCache::identity(
+      fileName, moduleInfo.SizeOfImage, ntHeaders.FileHeader.TimeDateStamp,
+      ntHeaders.OptionalHeader.CheckSum));
+  modules[base] = Module{moduleInfo.SizeOfImage, id};
+  return true;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////
 #pragma warning(push)
 #pragma warning(disable : 4996)
@@ -296,6 +402,16 @@ int SymbolEngine::getSehDepth() const { return maxSehDepth_; }
 
 /////////////////////////////////////////////////////////////////////////////////////
 DWORD64 SymbolEngine::GetModuleBase(DWORD64 dwAddress) const {
+  if (pImpl_->moduleMap) {
+    ModuleMap::Module const *module = pImpl_->moduleMap->find(dwAddress);
+    if (module && !module->name.empty()) {
+      if (pImpl_->loaded.insert(module->serial).second) {
+        LoadModuleSymbols(GetProcess(), module->name, module->base,
+                          static_cast<DWORD>(module->size));
+      }
+      return module->base;
+    }
+  }
   return ::GetModuleBase(GetProcess(), dwAddress);
 }
 
@@ -309,9 +425,19 @@ bool SymbolEngine::printAddress(DWORD64 address, std::ostream &os) const {
 
   ///////////////////////////////
   // Log the module + offset
+  ModuleMap::Module const *module =
+      pImpl_->moduleMap ? pImpl_->moduleMap->find(address) : nullptr;
   MEMORY_BASIC_INFORMATION mbInfo;
-  if (::VirtualQueryEx(GetProcess(), (PVOID)address, &mbInfo, sizeof mbInfo) &&
-      ((mbInfo.State & MEM_FREE) == 0) && ((mbInfo.Type & MEM_IMAGE) != 0)) {
+  if (module && !module->name.empty()) {
+    std::ostringstream str;
+    str << module->name.substr(module->name.find_last_of('\\') + 1);
+    str << " + 0x" << std::hex << (address - module->base) << std::dec;
+
+    os << std::setw(30) << std::left << str.str() << std::right;
+  } else if (::VirtualQueryEx(GetProcess(), (PVOID)address, &mbInfo,
+                              sizeof mbInfo) &&
+             ((mbInfo.State & MEM_FREE) == 0) &&
+             ((mbInfo.Type & MEM_IMAGE) != 0)) {
     std::ostringstream str;
     const auto hmod = static_cast<HMODULE>(mbInfo.AllocationBase);
 
@@ -432,9 +558,109 @@ void SymbolEngine::printInlineAddress(DWORD64 address, DWORD inline_context,
 #endif // DBGHELP_6_2_APIS
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+// Print the function containing an address, return true if information
+// cacheable
+bool SymbolEngine::printFunction(DWORD64 address, std::ostream &os) const {
+  const DWORD64 base = GetModuleBase(address);
+  DbgInit<IMAGEHLP_MODULE64> moduleInfo;
+  if (base && GetModuleInfo64(address, &moduleInfo)) {
+    os << moduleInfo.ModuleName;
+  } else {
+    os << (PVOID)address;
+    return false;
+  }
+
+#ifdef DBGHELP_6_1_APIS
+  struct {
+    DbgInit<SYMBOL_INFO> symInfo;
+    char name[4 * 256];
+  } SymInfo{};
+
+  PSYMBOL_INFO pSym = &SymInfo.symInfo;
+  pSym->MaxNameLen = sizeof(SymInfo.name);
+
+  DWORD64 dwDisplacement64(0);
+  if (SymFromAddr(address, &dwDisplacement64, pSym))
+#else
+  struct {
+    DbgInit<IMAGEHLP_SYMBOL64> symInfo;
+    char name[4 * 256];
+  } SymInfo{};
+
+  PIMAGEHLP_SYMBOL64 pSym = &SymInfo.symInfo;
+  pSym->MaxNameLength = sizeof(SymInfo.name);
+
+  DWORD64 dwDisplacement64;
+  if (GetSymFromAddr64(address, &dwDisplacement64, pSym))
+#endif
+  {
+    os << '!' << pSym->Name;
+  } else {
+    os << "+0x" << std::hex << (address - base) << std::dec;
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Get the name of the function containing an address, as 'module!function'
+std::string SymbolEngine::functionName(DWORD64 address) const {
+  DWORD64 base(0);
+  uint32_t module(0);
+  if (pImpl_->sharedCache &&
+      pImpl_->findModule(GetProcess(), address, base, module)) {
+    return pImpl_->sharedCache->lookup(
+        module, (address - base) | functionKey, [&](std::string &name) {
+          std::ostringstream oss;
+          const bool cacheable = printFunction(address, oss);
+          name = oss.str();
+          return cacheable;
+        });
+  }
+
+  std::ostringstream oss;
+  printFunction(address, oss);
+  return oss.str();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Share address to name conversions through a module-relative cache
+void SymbolEngine::setSymbolCache(SymbolCache *cache) {
+  pImpl_->sharedCache = cache;
+  pImpl_->modules.clear();
+  pImpl_->moduleIds.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Resolve addresses to modules using a map kept up to date by the caller
+void SymbolEngine::setModuleMap(ModuleMap const *modules) {
+  pImpl_->moduleMap = modules;
+  pImpl_->loaded.clear();
+  pImpl_->moduleIds.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// A different module may later be loaded at the same address
+void SymbolEngine::moduleUnloaded(DWORD64 base) {
+  pImpl_->modules.erase(base);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////
 // Convert address to a string.
 std::string SymbolEngine::addressToName(DWORD64 address) const {
+  DWORD64 base(0);
+  uint32_t module(0);
+  if (pImpl_->sharedCache &&
+      pImpl_->findModule(GetProcess(), address, base, module)) {
+    return pImpl_->sharedCache->lookup(
+        module, address - base, [&](std::string &name) {
+          std::ostringstream oss;
+          const bool cacheable = printAddress(address, oss);
+          name = oss.str();
+          return cacheable;
+        });
+  }
+
   auto it = pImpl_->addressMap.find(address);
   if (it == pImpl_->addressMap.end()) {
     std::ostringstream oss;
@@ -470,6 +696,122 @@ std::string SymbolEngine::inlineToName(DWORD64 address,
 // StackTrace: try to trace the stack to the given output stream
 void SymbolEngine::StackTrace(HANDLE hThread, const CONTEXT &context,
                               std::ostream &os) const {
+#ifdef _M_X64
+  std::vector<DWORD64> frames;
+  if (!showParams_ && !showVariables_ && unwindFrames(context, frames)) {
+    for (const DWORD64 pc : frames) {
+      const DWORD inline_count = printFrame(pc, 0, os);
+
+      // Expand inline frames
+      if (inline_count) {
+        DWORD inline_context(0), frame_index(0);
+        if (QueryInlineTrace(pc, 0, pc, pc, &inline_context, &frame_index)) {
+          for (DWORD i = 0; i < inline_count; i++, inline_context++) {
+            os << std::setw(31) << std::left << "[inline frame]"
+               << inlineToName(pc, inline_context) << '\n';
+          }
+        }
+      }
+    }
+    os.flush();
+    return;
+  }
+#endif // _M_X64
+
+  walkStack(hThread, context, os,
+            [&](STACKFRAME64 const &stackFrame, CONTEXT const &rwContext,
+                DWORD nonExec) {
+              const DWORD64 pc = stackFrame.AddrPC.Offset;
+              const DWORD inline_count = printFrame(pc, nonExec, os);
+
+#if 0
+              os << "AddrPC: " << (PVOID)stackFrame.AddrPC.Offset
+                 << " AddrReturn: " << (PVOID)stackFrame.AddrReturn.Offset
+                 << " AddrFrame: " << (PVOID)stackFrame.AddrFrame.Offset
+                 << " AddrStack: " << (PVOID)stackFrame.AddrStack.Offset
+                 << " FuncTableEntry: " << (PVOID)stackFrame.FuncTableEntry
+                 << " Far: " << stackFrame.Far
+                 << " Virtual: " << stackFrame.Virtual
+                 << " AddrBStore: " << (PVOID)stackFrame.AddrBStore.Offset
+                 << "\n";
+#endif
+
+              if (showParams_) {
+                os << "  " << (PVOID)stackFrame.AddrFrame.Offset << ":";
+                addParams(os, stackFrame.Params,
+                          sizeof(stackFrame.Params) /
+                              sizeof(stackFrame.Params[0]));
+                os << "\n";
+              }
+              if (showVariables_) {
+                showVariablesAt(os, stackFrame.AddrPC.Offset,
+                                stackFrame.AddrFrame.Offset, rwContext, *this);
+              }
+
+              // Expand inline frames
+              if (inline_count) {
+                DWORD inline_context(0), frame_index(0);
+                if (QueryInlineTrace(pc, 0, pc, pc, &inline_context,
+                                     &frame_index)) {
+                  for (DWORD i = 0; i < inline_count; i++, inline_context++) {
+                    os << std::setw(31) << std::left << "[inline frame]"
+                       << inlineToName(pc, inline_context) << '\n';
+                    if (showVariables_) {
+                      showInlineVariablesAt(os, stackFrame.AddrPC.Offset,
+                                            stackFrame.AddrFrame.Offset,
+                                            rwContext, inline_context, *this);
+                    }
+                  }
+                }
+              }
+            });
+
+  os.flush();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Get the addresses of the frames on the stack, innermost first
+void SymbolEngine::StackFrames(HANDLE hThread, const CONTEXT &context,
+                               std::vector<DWORD64> &frames) const {
+  frames.clear();
+#ifdef _M_X64
+  if (unwindFrames(context, frames)) {
+    return;
+  }
+#endif // _M_X64
+
+  std::ostringstream ignored;
+  walkStack(hThread, context, ignored,
+            [&frames](STACKFRAME64 const &stackFrame, CONTEXT const &, DWORD) {
+              frames.push_back(stackFrame.AddrPC.Offset);
+            });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Print the line for one frame of a stack trace, returning the count of inline
+// frames at the address
+DWORD SymbolEngine::printFrame(DWORD64 pc, DWORD nonExec,
+                               std::ostream &os) const {
+  const DWORD inline_count = AddrIncludeInlineTrace(pc);
+
+  os << addressToName(pc);
+
+  if (inline_count) {
+    os << " (" << inline_count << " inlined)";
+  }
+
+  if (nonExec) {
+    os << " (non executable)";
+  }
+
+  os << "\n";
+  return inline_count;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Walk the stack using StackWalk64, calling 'fn' for each frame to be shown
+void SymbolEngine::walkStack(HANDLE hThread, const CONTEXT &context,
+                             std::ostream &os, FrameCallback const &fn) const {
   STACKFRAME64 stackFrame{};
   CONTEXT rwContext{};
   try {
@@ -581,63 +923,65 @@ void SymbolEngine::StackTrace(HANDLE hThread, const CONTEXT &context,
     }
 
     // We now think we have a frame worth processing
+    fn(stackFrame, rwContext, nonExec);
+  }
+}
 
-    const DWORD inline_count = AddrIncludeInlineTrace(pc);
-
-    os << addressToName(pc);
-
-    if (inline_count) {
-      os << " (" << inline_count << " inlined)";
-    }
+#ifdef _M_X64
+/////////////////////////////////////////////////////////////////////////////////////
+// Get the frames to show using the unwind data in the loaded modules,
+// returning false if StackWalk64 should be used instead.
+bool SymbolEngine::unwindFrames(const CONTEXT &context,
+                                std::vector<DWORD64> &frames) const {
+  BOOL bWow64(false);
+  if (!pImpl_->moduleMap ||
+      (IsWow64Process(GetProcess(), &bWow64) && bWow64)) {
+    return false;
+  }
+  if (!pImpl_->unwinder) {
+    pImpl_->unwinder = std::make_unique<X64Unwinder>(
+        [this](uint64_t address, void *buffer, size_t size) {
+          return ReadMemory((LPCVOID)address, buffer, size);
+        });
+  }
 
-    if (nonExec) {
-      os << " (non executable)";
+  // The stack is committed from the stack pointer up to the stack base, so
+  // copy it in one read
+  X64Unwinder::Stack stack;
+  stack.address = context.Rsp;
+  MEMORY_BASIC_INFORMATION mbInfo;
+  if (::VirtualQueryEx(GetProcess(), (PVOID)context.Rsp, &mbInfo,
+                       sizeof mbInfo)) {
+    const DWORD64 top = (DWORD64)mbInfo.BaseAddress + mbInfo.RegionSize;
+    stack.bytes.resize(
+        static_cast<size_t>(std::min<DWORD64>(top - context.Rsp, maxStackCopy)));
+    if (!ReadMemory((LPCVOID)context.Rsp, stack.bytes.data(),
+                    stack.bytes.size())) {
+      stack.bytes.clear();
     }
+  }
 
-    os << "\n";
-
-#if 0
-    os << "AddrPC: " << (PVOID)stackFrame.AddrPC.Offset
-       << " AddrReturn: " << (PVOID)stackFrame.AddrReturn.Offset
-       << " AddrFrame: " << (PVOID)stackFrame.AddrFrame.Offset
-       << " AddrStack: " << (PVOID)stackFrame.AddrStack.Offset
-       << " FuncTableEntry: " << (PVOID)stackFrame.FuncTableEntry
-       << " Far: " << stackFrame.Far
-       << " Virtual: " << stackFrame.Virtual
-       << " AddrBStore: " << (PVOID)stackFrame.AddrBStore.Offset
-       << "\n";
-#endif
-
-    if (showParams_) {
-      os << "  " << (PVOID)stackFrame.AddrFrame.Offset << ":";
-      addParams(os, stackFrame.Params,
-                sizeof(stackFrame.Params) / sizeof(stackFrame.Params[0]));
-      os << "\n";
-    }
-    if (showVariables_) {
-      showVariablesAt(os, stackFrame.AddrPC.Offset, stackFrame.AddrFrame.Offset,
-                      rwContext, *this);
-    }
+  // CONTEXT holds the integer registers in unwind code order
+  X64Unwinder::Context regs;
+  regs.rip = context.Rip;
+  std::copy_n(&context.Rax, 16, regs.regs);
 
-    // Expand inline frames
-    if (inline_count) {
-      DWORD inline_context(0), frame_index(0);
-      if (QueryInlineTrace(pc, 0, pc, pc, &inline_context, &frame_index)) {
-        for (DWORD i = 0; i < inline_count; i++, inline_context++) {
-          os << std::setw(31) << std::left << "[inline frame]"
-             << inlineToName(pc, inline_context) << '\n';
-          if (showVariables_) {
-            showInlineVariablesAt(os, stackFrame.AddrPC.Offset,
-                                  stackFrame.AddrFrame.Offset, rwContext,
-                                  inline_context, *this);
-          }
-        }
-      }
-    }
+  std::vector<X64Unwinder::Frame> unwound;
+  const size_t maxFrames =
+      maxStackDepth_ < 0 ? 1000 : size_t(skipCount_ + maxStackDepth_);
+  if (!pImpl_->unwinder->unwind(regs, stack, *pImpl_->moduleMap, unwound,
+                                maxFrames)) {
+    return false;
   }
 
-  os.flush();
+  frames.clear();
+  for (size_t idx = size_t(skipCount_); idx < unwound.size(); ++idx) {
+    GetModuleBase(unwound[idx].rip);
+    frames.push_back(unwound[idx].rip);
+  }
+  return true;
 }
+#endif // _M_X64
 
 //////////////////////////////////////////////////////////
 // GetCurrentThreadContext
@@ -1029,6 +1373,12 @@ std::string SymbolEngine::getString(PVOID address, BOOL unicode,
 bool SymbolEngine::isExecutable(DWORD64 address) const {
   bool ret(false);
 
+  // Addresses inside a loaded image are taken to be code, which is all the
+  // stack walk needs to detect a wandering stack
+  if (pImpl_->moduleMap && pImpl_->moduleMap->find(address)) {
+    return true;
+  }
+
   static const DWORD AnyExecute = PAGE_EXECUTE | PAGE_EXECUTE_READ |
                                   PAGE_EXECUTE_READWRITE |
                                   PAGE_EXECUTE_WRITECOPY;
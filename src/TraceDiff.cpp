@@ -0,0 +1,606 @@
+/*
+NAME
+  TraceDiff.cpp
+
+DESCRIPTION
+  Structural comparison of two traces.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "TraceDiff.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+
+#include "RedundantCalls.h"
+
+namespace or2 {
+namespace {
+
+// Comparisons needing more than this many steps use a heuristic
+constexpr ptrdiff_t tooExpensive = 1024;
+
+bool isHandle(std::string_view name) {
+  return name.size() >= 6 && name.substr(name.size() - 6) == "Handle";
+}
+
+// Get the contents of the first quoted string in the text
+bool quoted(std::string_view text, std::string_view &result) {
+  size_t const start = text.find('"');
+  size_t const end =
+      start == std::string_view::npos ? start : text.find('"', start + 1);
+  if (end == std::string_view::npos) {
+    return false;
+  }
+  result = text.substr(start + 1, end - start - 1);
+  return true;
+}
+
+// Get the value of the number at the start of the text
+uint64_t numberOf(std::string_view text) {
+  size_t const end = text.find_first_of(" :[]");
+  uint64_t value{};
+  return TraceParser::number(text.substr(0, end), value) ? value : 0;
+}
+
+// The name of the object for a handle, or a placeholder
+std::string handleName(HandleTable const &handles, std::string_view value) {
+  if (value.substr(0, 1) == "-") {
+    return std::string(value); // a pseudo handle
+  }
+  std::string const *name = handles.find(numberOf(value));
+  return name ? '"' + *name + '"' : "<handle>";
+}
+
+/** Shortest edit script for two sequences, after Myers and GNU diff */
+class EditScript {
+public:
+  EditScript(std::vector<uint32_t> const &a, std::vector<uint32_t> const &b,
+             std::vector<bool> &removed, std::vector<bool> &inserted)
+      : a_(a.data()), b_(b.data()), removed_(removed), inserted_(inserted),
+        offset_(static_cast<ptrdiff_t>(b.size()) + 1),
+        forward_(a.size() + b.size() + 3),
+        backward_(a.size() + b.size() + 3) {}
+
+  void compare(ptrdiff_t xoff, ptrdiff_t xlim, ptrdiff_t yoff,
+               ptrdiff_t ylim);
+
+private:
+  void middle(ptrdiff_t xoff, ptrdiff_t xlim, ptrdiff_t yoff, ptrdiff_t ylim,
+              ptrdiff_t &xmid, ptrdiff_t &ymid);
+
+  ptrdiff_t &fd(ptrdiff_t diagonal) {
+    return forward_[static_cast<size_t>(diagonal + offset_)];
+  }
+  ptrdiff_t &bd(ptrdiff_t diagonal) {
+    return backward_[static_cast<size_t>(diagonal + offset_)];
+  }
+
+  uint32_t const *a_;
+  uint32_t const *b_;
+  std::vector<bool> &removed_;
+  std::vector<bool> &inserted_;
+  ptrdiff_t offset_; // so the lowest diagonal, -(size of b) - 1, is zero
+  std::vector<ptrdiff_t> forward_;  // furthest x on each diagonal
+  std::vector<ptrdiff_t> backward_; // ditto, searching backwards
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Compare a[xoff, xlim) with b[yoff, ylim), splitting at the middle of a
+// shortest edit script
+void EditScript::compare(ptrdiff_t xoff, ptrdiff_t xlim, ptrdiff_t yoff,
+                         ptrdiff_t ylim) {
+  while (xoff < xlim && yoff < ylim && a_[xoff] == b_[yoff]) {
+    ++xoff;
+    ++yoff;
+  }
+  while (xoff < xlim && yoff < ylim && a_[xlim - 1] == b_[ylim - 1]) {
+    --xlim;
+    --ylim;
+  }
+  if (xoff == xlim) {
+    for (; yoff < ylim; ++yoff) {
+      inserted_[static_cast<size_t>(yoff)] = true;
+    }
+  } else if (yoff == ylim) {
+    for (; xoff < xlim; ++xoff) {
+      removed_[static_cast<size_t>(xoff)] = true;
+    }
+  } else {
+    ptrdiff_t xmid{};
+    ptrdiff_t ymid{};
+    middle(xoff, xlim, yoff, ylim, xmid, ymid);
+    compare(xoff, xmid, yoff, ymid);
+    compare(xmid, xlim, ymid, ylim);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Find the point where the forward and backward searches for a shortest
+// edit script meet; diagonal k holds the points with x - y == k
+void EditScript::middle(ptrdiff_t xoff, ptrdiff_t xlim, ptrdiff_t yoff,
+                        ptrdiff_t ylim, ptrdiff_t &xmid, ptrdiff_t &ymid) {
+  ptrdiff_t const dmin = xoff - ylim;
+  ptrdiff_t const dmax = xlim - yoff;
+  ptrdiff_t const fmid = xoff - yoff;
+  ptrdiff_t const bmid = xlim - ylim;
+  ptrdiff_t fmin = fmid;
+  ptrdiff_t fmax = fmid;
+  ptrdiff_t bmin = bmid;
+  ptrdiff_t bmax = bmid;
+  bool const odd = (fmid - bmid) & 1;
+
+  fd(fmid) = xoff;
+  bd(bmid) = xlim;
+  for (ptrdiff_t cost = 1;; ++cost) {
+    // Extend the forward search by one edit
+    if (fmin > dmin) {
+      fd(--fmin - 1) = -1;
+    } else {
+      ++fmin;
+    }
+    if (fmax < dmax) {
+      fd(++fmax + 1) = -1;
+    } else {
+      --fmax;
+    }
+    for (ptrdiff_t d = fmax; d >= fmin; d -= 2) {
+      ptrdiff_t const tlo = fd(d - 1);
+      ptrdiff_t const thi = fd(d + 1);
+      ptrdiff_t x = tlo >= thi ? tlo + 1 : thi;
+      ptrdiff_t y = x - d;
+      while (x < xlim && y < ylim && a_[x] == b_[y]) {
+        ++x;
+        ++y;
+      }
+      fd(d) = x;
+      if (odd && bmin <= d && d <= bmax && bd(d) <= x) {
+        xmid = x;
+        ymid = y;
+        return;
+      }
+    }
+
+    // Extend the backward search by one edit
+    if (bmin > dmin) {
+      bd(--bmin - 1) = PTRDIFF_MAX;
+    } else {
+      ++bmin;
+    }
+    if (bmax < dmax) {
+      bd(++bmax + 1) = PTRDIFF_MAX;
+    } else {
+      --bmax;
+    }
+    for (ptrdiff_t d = bmax; d >= bmin; d -= 2) {
+      ptrdiff_t const tlo = bd(d - 1);
+      ptrdiff_t const thi = bd(d + 1);
+      ptrdiff_t x = tlo < thi ? tlo : thi - 1;
+      ptrdiff_t y = x - d;
+      while (x > xoff && y > yoff && a_[x - 1] == b_[y - 1]) {
+        --x;
+        --y;
+      }
+      bd(d) = x;
+      if (!odd && fmin <= d && d <= fmax && x <= fd(d)) {
+        xmid = x;
+        ymid = y;
+        return;
+      }
+    }
+
+    if (cost >= tooExpensive) {
+      // Give up on a shortest script, and split at the furthest point
+      // reached by either search
+      ptrdiff_t fxybest = -1;
+      ptrdiff_t fxbest = 0;
+      for (ptrdiff_t d = fmax; d >= fmin; d -= 2) {
+        ptrdiff_t x = std::min(fd(d), xlim);
+        ptrdiff_t y = x - d;
+        if (ylim < y) {
+          x = ylim + d;
+          y = ylim;
+        }
+        if (fxybest < x + y) {
+          fxybest = x + y;
+          fxbest = x;
+        }
+      }
+      ptrdiff_t bxybest = PTRDIFF_MAX;
+      ptrdiff_t bxbest = 0;
+      for (ptrdiff_t d = bmax; d >= bmin; d -= 2) {
+        ptrdiff_t x = std::max(xoff, bd(d));
+        ptrdiff_t y = x - d;
+        if (y < yoff) {
+          x = yoff + d;
+          y = yoff;
+        }
+        if (x + y < bxybest) {
+          bxybest = x + y;
+          bxbest = x;
+        }
+      }
+      if ((xlim + ylim) - bxybest < fxybest - (xoff + yoff)) {
+        xmid = fxbest;
+        ymid = fxybest - fxbest;
+      } else {
+        xmid = bxbest;
+        ymid = bxybest - bxbest;
+      }
+      return;
+    }
+  }
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// Elements with no match in the other sequence are certainly removed or
+// inserted, so they are set aside before the comparison, which is much
+// faster when the sequences share few elements
+void TraceDiff::diff(std::vector<uint32_t> const &a,
+                     std::vector<uint32_t> const &b, std::vector<bool> &removed,
+                     std::vector<bool> &inserted) {
+  removed.assign(a.size(), true);
+  inserted.assign(b.size(), true);
+  std::unordered_map<uint32_t, uint8_t> present; // bit 0 for a, bit 1 for b
+  present.reserve(a.size() + b.size());
+  for (uint32_t const value : a) {
+    present[value] |= 1;
+  }
+  for (uint32_t const value : b) {
+    present[value] |= 2;
+  }
+  std::vector<uint32_t> x;
+  std::vector<size_t> xIndex;
+  for (size_t idx = 0; idx != a.size(); ++idx) {
+    if (present[a[idx]] == 3) {
+      x.push_back(a[idx]);
+      xIndex.push_back(idx);
+    }
+  }
+  std::vector<uint32_t> y;
+  std::vector<size_t> yIndex;
+  for (size_t idx = 0; idx != b.size(); ++idx) {
+    if (present[b[idx]] == 3) {
+      y.push_back(b[idx]);
+      yIndex.push_back(idx);
+    }
+  }
+
+  std::vector<bool> xRemoved(x.size());
+  std::vector<bool> yInserted(y.size());
+  EditScript script(x, y, xRemoved, yInserted);
+  script.compare(0, static_cast<ptrdiff_t>(x.size()), 0,
+                 static_cast<ptrdiff_t>(y.size()));
+  for (size_t idx = 0; idx != x.size(); ++idx) {
+    removed[xIndex[idx]] = xRemoved[idx];
+  }
+  for (size_t idx = 0; idx != y.size(); ++idx) {
+    inserted[yIndex[idx]] = yInserted[idx];
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TraceDiff::add(Side side, TraceRecord const &record, uint64_t line) {
+  if (record.before) {
+    return;
+  }
+  Trace &trace = traces_[side];
+  HandleTable &handles = trace.handles[record.processId];
+  uint32_t const call = intern(normalize(handles, record));
+  trackHandles(handles, record);
+
+  auto const key = std::make_pair(record.processId, record.sequence());
+  auto it = trace.ordinals.find(key);
+  if (it == trace.ordinals.end()) {
+    uint32_t const process =
+        trace.processes
+            .emplace(record.processId,
+                     static_cast<uint32_t>(trace.processes.size()))
+            .first->second;
+    it = trace.ordinals
+             .emplace(key, std::make_pair(process,
+                                          trace.threadCounts[process]++))
+             .first;
+  }
+  Thread &thread = trace.threads[it->second];
+  thread.processId = record.processId;
+  thread.threadId = record.sequence();
+  thread.calls.push_back(call);
+  thread.lines.push_back(line);
+
+  auto function = trace.functions.find(record.function);
+  if (function == trace.functions.end()) {
+    function = trace.functions.emplace(std::string(record.function), 0).first;
+  }
+  ++function->second;
+  ++trace.calls;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Keep the names of the objects opened: the handle is the value in
+// brackets after the address of the output argument, and the name is either
+// a full path or relative to a root directory as "root:path"
+void TraceDiff::trackHandles(HandleTable &handles, TraceRecord const &record) {
+  uint64_t status{};
+  if (!TraceParser::number(record.result, status) || status != 0) {
+    return;
+  }
+  std::string_view args = record.args;
+  TraceArgument argument;
+  if (record.function == "NtClose") {
+    if (TraceParser::nextArgument(args, argument)) {
+      handles.closed(numberOf(argument.value));
+    }
+    return;
+  }
+  uint64_t handle{};
+  std::string_view name;
+  uint64_t root{};
+  while (TraceParser::nextArgument(args, argument)) {
+    size_t const bracket = argument.value.find('[');
+    if (!handle && isHandle(argument.name) &&
+        bracket != std::string_view::npos) {
+      handle = numberOf(argument.value.substr(bracket + 1));
+    } else if (argument.name == "ObjectAttributes" &&
+               quoted(argument.value, name) &&
+               argument.value.front() != '"') {
+      root = numberOf(argument.value);
+    }
+  }
+  if (handle && !name.empty()) {
+    handles.opened(handle, std::string(name), root);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Input handles are named, and other arguments normalized as for finding
+// redundant calls
+std::string TraceDiff::normalize(HandleTable const &handles,
+                                 TraceRecord const &record) {
+  std::string result(record.function);
+  result += '(';
+  std::string_view args = record.args;
+  TraceArgument argument;
+  bool first = true;
+  while (TraceParser::nextArgument(args, argument)) {
+    if (!first) {
+      result += ", ";
+    }
+    first = false;
+    if (!argument.name.empty()) {
+      result += argument.name;
+      result += '=';
+    }
+    std::string_view name;
+    if (isHandle(argument.name) &&
+        argument.value.find('[') == std::string_view::npos) {
+      if (quoted(argument.value, name)) {
+        result += '"';
+        result += name;
+        result += '"';
+      } else {
+        result += handleName(handles, argument.value);
+      }
+    } else if (quoted(argument.value, name) &&
+               argument.value.front() != '"' &&
+               argument.value.find(':') < argument.value.find('"')) {
+      // A name relative to a root directory handle
+      result += handleName(handles, argument.value);
+      result += ':';
+      result += argument.value.substr(argument.value.find(':') + 1);
+    } else {
+      result += RedundantCalls::normalize(std::string(argument.value));
+    }
+  }
+  result += ") => ";
+  result += record.result;
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint32_t TraceDiff::intern(std::string const &call) {
+  auto const result =
+      ids_.try_emplace(call, static_cast<uint32_t>(calls_.size()));
+  if (result.second) {
+    calls_.push_back(call);
+  }
+  return result.first->second;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TraceDiff::report(std::ostream &os, size_t maxHunks) const {
+  Trace const &before = traces_[Old];
+  Trace const &after = traces_[New];
+
+  // Call counts by function
+  std::map<std::string_view, std::pair<uint64_t, uint64_t>> counts;
+  for (auto const &entry : before.functions) {
+    counts[entry.first].first = entry.second;
+  }
+  for (auto const &entry : after.functions) {
+    counts[entry.first].second = entry.second;
+  }
+  std::vector<std::pair<std::string_view, std::pair<uint64_t, uint64_t>>>
+      changed;
+  for (auto const &entry : counts) {
+    if (entry.second.first != entry.second.second) {
+      changed.push_back(entry);
+    }
+  }
+  auto const change = [](std::pair<uint64_t, uint64_t> const &count) {
+    return count.first > count.second ? count.first - count.second
+                                      : count.second - count.first;
+  };
+  std::stable_sort(changed.begin(), changed.end(),
+                   [&change](auto const &lhs, auto const &rhs) {
+                     return change(lhs.second) > change(rhs.second);
+                   });
+  os << "Calls: " << before.calls << " old, " << after.calls << " new\n";
+  if (!changed.empty()) {
+    os << "\nCall counts changed:\n";
+    os << "       old        new     change  function\n";
+    for (auto const &entry : changed) {
+      char line[64];
+      std::snprintf(line, sizeof(line), "%10llu %10llu %+10lld  ",
+                    static_cast<unsigned long long>(entry.second.first),
+                    static_cast<unsigned long long>(entry.second.second),
+                    static_cast<long long>(entry.second.second) -
+                        static_cast<long long>(entry.second.first));
+      os << line << entry.first << '\n';
+    }
+  }
+
+  // Differences in each thread
+  std::map<std::pair<uint32_t, uint32_t>,
+           std::pair<Thread const *, Thread const *>>
+      threads;
+  for (auto const &entry : before.threads) {
+    threads[entry.first].first = &entry.second;
+  }
+  for (auto const &entry : after.threads) {
+    threads[entry.first].second = &entry.second;
+  }
+  Thread const none;
+  size_t hunks{};
+  uint64_t totalRemoved{};
+  uint64_t totalInserted{};
+  uint64_t totalReordered{};
+  for (auto const &entry : threads) {
+    Thread const &a = entry.second.first ? *entry.second.first : none;
+    Thread const &b = entry.second.second ? *entry.second.second : none;
+    std::vector<bool> removed;
+    std::vector<bool> inserted;
+    diff(a.calls, b.calls, removed, inserted);
+
+    // Calls both removed and inserted are taken as reordered
+    std::unordered_map<uint32_t, std::pair<uint64_t, uint64_t>> moved;
+    for (size_t idx = 0; idx != removed.size(); ++idx) {
+      if (removed[idx]) {
+        ++moved[a.calls[idx]].first;
+      }
+    }
+    for (size_t idx = 0; idx != inserted.size(); ++idx) {
+      if (inserted[idx]) {
+        ++moved[b.calls[idx]].second;
+      }
+    }
+    uint64_t removedCount{};
+    uint64_t insertedCount{};
+    uint64_t reordered{};
+    for (auto &count : moved) {
+      uint64_t const both = std::min(count.second.first, count.second.second);
+      removedCount += count.second.first - both;
+      insertedCount += count.second.second - both;
+      reordered += both;
+      count.second = {both, both}; // budget for marking as reordered
+    }
+    if (!removedCount && !insertedCount && !reordered) {
+      continue;
+    }
+    totalRemoved += removedCount;
+    totalInserted += insertedCount;
+    totalReordered += reordered;
+
+    os << "\nThread " << entry.first.first + 1 << '.'
+       << entry.first.second + 1 << " (";
+    if (entry.second.first) {
+      os << "old " << a.processId << '/' << a.threadId;
+    }
+    if (entry.second.first && entry.second.second) {
+      os << ", ";
+    }
+    if (entry.second.second) {
+      os << "new " << b.processId << '/' << b.threadId;
+    }
+    if (!entry.second.first || !entry.second.second) {
+      os << (entry.second.first ? ", only in old" : ", only in new");
+    }
+    os << "): " << removedCount << " removed, " << insertedCount
+       << " inserted, " << reordered << " reordered\n";
+
+    size_t x = 0;
+    size_t y = 0;
+    while (x != removed.size() || y != inserted.size()) {
+      if (x != removed.size() && y != inserted.size() && !removed[x] &&
+          !inserted[y]) {
+        ++x;
+        ++y;
+        continue;
+      }
+      bool const show = maxHunks == 0 || hunks < maxHunks;
+      ++hunks;
+      if (show) {
+        os << "@@ old ";
+        if (x != a.lines.size()) {
+          os << "line " << a.lines[x];
+        } else {
+          os << "end";
+        }
+        os << ", new ";
+        if (y != b.lines.size()) {
+          os << "line " << b.lines[y];
+        } else {
+          os << "end";
+        }
+        os << '\n';
+      }
+      for (; x != removed.size() && removed[x]; ++x) {
+        uint64_t &budget = moved[a.calls[x]].first;
+        if (show) {
+          os << (budget ? "< " : "- ") << calls_[a.calls[x]] << '\n';
+        }
+        if (budget) {
+          --budget;
+        }
+      }
+      for (; y != inserted.size() && inserted[y]; ++y) {
+        uint64_t &budget = moved[b.calls[y]].second;
+        if (show) {
+          os << (budget ? "> " : "+ ") << calls_[b.calls[y]] << '\n';
+        }
+        if (budget) {
+          --budget;
+        }
+      }
+    }
+  }
+  if (maxHunks && hunks > maxHunks) {
+    os << "\n(" << hunks - maxHunks << " more groups of differences)\n";
+  }
+  os << "\nCalls: " << totalRemoved << " removed, " << totalInserted
+     << " inserted, " << totalReordered
+     << " reordered (shown as < where moved from and > where moved to)\n";
+}
+
+} // namespace or2
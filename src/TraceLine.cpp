@@ -0,0 +1,85 @@
+/*
+NAME
+  TraceLine.cpp
+
+DESCRIPTION
+  Lines of text written by NtTrace, parsed into strings.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "TraceLine.h"
+
+#include "TraceParser.h"
+
+namespace or2 {
+namespace {
+
+// Copy the fields of a parsed line
+void assign(TraceLine &line, TraceRecord const &record) {
+  line.time = record.time;
+  line.processId = record.processId;
+  line.threadId = record.threadId;
+  line.id = record.id;
+  line.function = record.function;
+  line.result = record.result;
+  line.before = record.before;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+size_t TraceLine::parseHeader(std::string const &line) {
+  TraceRecord record;
+  size_t const pos = TraceParser::parseHeader(line, record);
+  *this = TraceLine();
+  assign(*this, record);
+  return pos;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool TraceLine::parse(std::string const &line) {
+  TraceRecord record;
+  *this = TraceLine();
+  if (!TraceParser::parse(line, record)) {
+    return false;
+  }
+  assign(*this, record);
+  TraceArgument arg;
+  while (TraceParser::nextArgument(record.args, arg)) {
+    args.push_back({std::string(arg.name), std::string(arg.value)});
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool TraceLine::timeOfDay(uint64_t &microseconds) const {
+  return TraceParser::timeOfDay(time, microseconds);
+}
+
+} // namespace or2
@@ -0,0 +1,287 @@
+/*
+NAME
+  TraceParser.cpp
+
+DESCRIPTION
+  Fast parser for the text written by NtTrace.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "TraceParser.h"
+
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+
+namespace or2 {
+namespace {
+
+bool isIdentifier(char ch) {
+  return isalnum(static_cast<unsigned char>(ch)) || ch == '_';
+}
+
+bool isDigit(char ch) { return ch >= '0' && ch <= '9'; }
+
+// Parse the digits of an ID, advancing 'pos'
+bool parseId(std::string_view line, size_t &pos, uint32_t &value) {
+  while (pos != line.size() && line[pos] == ' ') {
+    ++pos;
+  }
+  size_t const start = pos;
+  value = 0;
+  while (pos != line.size() && isDigit(line[pos])) {
+    value = value * 10 + static_cast<uint32_t>(line[pos++] - '0');
+  }
+  return pos != start;
+}
+
+// Returns true if the text before the first ": " is a time stamp and/or
+// delta, and not part of the function name or arguments
+bool isTime(std::string_view text) {
+  for (char const ch : text) {
+    if (!isDigit(ch) && ch != ':' && ch != '.' && ch != '+' && ch != '<' &&
+        ch != ' ') {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The characters that need attention when scanning a list of arguments
+constexpr std::array<bool, 256> special = [] {
+  std::array<bool, 256> table{};
+  for (unsigned char const ch : std::string_view("\"[](){},")) {
+    table[ch] = true;
+  }
+  return table;
+}();
+
+// Find the first 'stop' character at or after 'pos' that is outside
+// brackets and quoted strings; ordinary characters are skipped using a
+// table and quoted strings using memchr.
+size_t findOutside(std::string_view text, size_t pos, char stop) {
+  int depth = 0;
+  while (pos < text.size()) {
+    char const ch = text[pos];
+    if (!special[static_cast<unsigned char>(ch)]) {
+      ++pos;
+      continue;
+    }
+    if (ch == '"') {
+      void const *const quote =
+          std::memchr(text.data() + pos + 1, '"', text.size() - pos - 1);
+      if (!quote) {
+        return text.size();
+      }
+      pos = static_cast<size_t>(static_cast<char const *>(quote) -
+                                text.data());
+    } else if (ch == '[' || ch == '(' || ch == '{') {
+      ++depth;
+    } else if ((ch == ']' || ch == '}' || ch == ')') && depth) {
+      --depth;
+    } else if (depth == 0 && ch == stop) {
+      return pos;
+    }
+    ++pos;
+  }
+  return text.size();
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+size_t TraceParser::parseHeader(std::string_view line, TraceRecord &record) {
+  record = TraceRecord();
+  size_t pos = 0;
+
+  // Optional time stamp and/or delta, ending in ": "; the time stamp is
+  // short, so only the start of the line need be searched
+  size_t const colon = line.substr(0, 32).find(": ");
+  if (colon != std::string_view::npos && isTime(line.substr(0, colon))) {
+    record.time = line.substr(0, colon);
+    pos = colon + 2;
+  }
+
+  // Optional process and/or thread ID
+  if (pos != line.size() && line[pos] == '[') {
+    size_t idPos = pos + 1;
+    uint32_t first{};
+    uint32_t second{};
+    if (!parseId(line, idPos, first)) {
+      return pos;
+    }
+    bool const both = idPos != line.size() && line[idPos] == '/';
+    if (both && !parseId(line, ++idPos, second)) {
+      return pos;
+    }
+    if (line.substr(idPos, 2) != "] ") {
+      return pos;
+    }
+    if (both) {
+      record.processId = first;
+      record.threadId = second;
+    } else {
+      record.id = first;
+    }
+    pos = idPos + 2;
+  }
+  return pos;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool TraceParser::parse(std::string_view line, TraceRecord &record) {
+  size_t pos = parseHeader(line, record);
+
+  // Function name
+  size_t const nameStart = pos;
+  while (pos != line.size() && isIdentifier(line[pos])) {
+    ++pos;
+  }
+  if (pos == nameStart || pos == line.size() || line[pos] != '(' ||
+      isDigit(line[nameStart])) {
+    return false;
+  }
+  record.function = line.substr(nameStart, pos - nameStart);
+  size_t const argStart = ++pos;
+
+  // Arguments: up to the closing bracket outside brackets and quoted strings
+  pos = findOutside(line, pos, ')');
+  if (pos == line.size()) {
+    return false;
+  }
+  record.args = line.substr(argStart, pos - argStart);
+  ++pos;
+
+  if (line.substr(pos, 4) == " ...") {
+    record.before = true;
+    return true;
+  }
+  if (line.substr(pos, 4) != " => ") {
+    return false;
+  }
+  pos += 4;
+  record.result = line.substr(pos, line.find(' ', pos) - pos);
+  return !record.result.empty();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Arguments are separated by ", " outside brackets and quoted strings; a
+// name is only recognised before any quote, bracket or space in the value
+bool TraceParser::nextArgument(std::string_view &args,
+                               TraceArgument &argument) {
+  size_t pos = findOutside(args, 0, ',');
+  while (pos != args.size() &&
+         (pos + 1 == args.size() || args[pos + 1] != ' ')) {
+    pos = findOutside(args, pos + 1, ',');
+  }
+  if (args.empty()) {
+    return false;
+  }
+  std::string_view const text = args.substr(0, pos);
+  args.remove_prefix(pos == args.size() ? pos : pos + 2);
+
+  argument = TraceArgument();
+  size_t equals = 0;
+  while (equals != text.size() && text[equals] != '=' &&
+         text[equals] != '"' && text[equals] != '[' && text[equals] != ' ') {
+    ++equals;
+  }
+  if (equals != text.size() && text[equals] == '=' && equals != 0 &&
+      isIdentifier(text[0])) {
+    argument.name = text.substr(0, equals);
+    argument.value = text.substr(equals + 1);
+  } else {
+    argument.value = text;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool TraceParser::timeOfDay(std::string_view time, uint64_t &microseconds) {
+  // HH:MM:SS.mmm
+  static char const format[] = "00:00:00.000";
+  size_t const length = sizeof(format) - 1;
+  if (time.size() < length || (time.size() > length && time[length] != ' ')) {
+    return false;
+  }
+  uint64_t fields[4]{};
+  size_t field = 0;
+  for (size_t idx = 0; idx != length; ++idx) {
+    char const ch = time[idx];
+    if (format[idx] == '0') {
+      if (!isDigit(ch)) {
+        return false;
+      }
+      fields[field] = fields[field] * 10 + static_cast<uint64_t>(ch - '0');
+    } else if (ch != format[idx]) {
+      return false;
+    } else {
+      ++field;
+    }
+  }
+  microseconds =
+      (((fields[0] * 60 + fields[1]) * 60 + fields[2]) * 1000 + fields[3]) *
+      1000;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool TraceParser::number(std::string_view text, uint64_t &value) {
+  int base = 10;
+  if (text.substr(0, 2) == "0x") {
+    text.remove_prefix(2);
+    base = 16;
+  }
+  auto const end = text.data() + text.size();
+  return !text.empty() &&
+         std::from_chars(text.data(), end, value, base).ptr == end;
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::vector<std::string_view> TraceParser::chunks(std::string_view text,
+                                                  size_t count) {
+  std::vector<std::string_view> result;
+  if (count == 0) {
+    count = 1;
+  }
+  size_t const target = text.size() / count + 1;
+  while (!text.empty()) {
+    size_t end = text.size();
+    if (target < text.size()) {
+      size_t const eol = text.find('\n', target);
+      end = eol == std::string_view::npos ? text.size() : eol + 1;
+    }
+    result.push_back(text.substr(0, end));
+    text.remove_prefix(end);
+  }
+  return result;
+}
+
+} // namespace or2
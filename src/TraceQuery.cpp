@@ -0,0 +1,291 @@
+/*
+NAME
+  TraceQuery.cpp
+
+DESCRIPTION
+  Filter and group-by queries over a columnar trace store.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "TraceQuery.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+namespace or2 {
+namespace {
+
+struct GroupHash {
+  size_t operator()(TraceGroup const &group) const {
+    uint64_t hash = group.bucket * 0x9e3779b97f4a7c15ull ^ group.status;
+    hash = hash * 0x9e3779b97f4a7c15ull ^
+           (uint64_t(group.function) << 32 | group.processId);
+    hash = hash * 0x9e3779b97f4a7c15ull ^ group.threadId;
+    hash = hash * 0x9e3779b97f4a7c15ull ^
+           std::hash<std::string>()(group.args);
+    return static_cast<size_t>(hash ^ hash >> 29);
+  }
+};
+
+using Groups = std::unordered_map<TraceGroup, TraceTotals, GroupHash>;
+
+// The groups and work of one thread
+struct Part {
+  Groups groups;
+  TraceQuery::Stats stats;
+  bool ok{true};
+};
+
+// Clear the selection of each call whose value does not match
+template <typename T, typename Predicate>
+void filter(std::vector<uint8_t> &selected, std::vector<T> const &values,
+            Predicate predicate) {
+  size_t const size = selected.size();
+  uint8_t *const out = selected.data();
+  T const *const in = values.data();
+  for (size_t idx = 0; idx != size; ++idx) {
+    out[idx] &= static_cast<uint8_t>(predicate(in[idx]));
+  }
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+void TraceTotals::add(TraceTotals &&other) {
+  count += other.count;
+  errors += other.errors;
+  duration += other.duration;
+  if (durations.empty()) {
+    durations = std::move(other.durations);
+  } else {
+    durations.insert(durations.end(), other.durations.begin(),
+                     other.durations.end());
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TraceTotals::finish() { std::sort(durations.begin(), durations.end()); }
+
+//////////////////////////////////////////////////////////////////////////
+// Uses the nearest rank method
+uint64_t TraceTotals::percentile(double percent) const {
+  if (durations.empty()) {
+    return 0;
+  }
+  auto rank = static_cast<size_t>(
+      std::ceil(percent / 100 * static_cast<double>(durations.size())));
+  rank = std::clamp<size_t>(rank, 1, durations.size());
+  return durations[rank - 1];
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool TraceQuery::skip(TraceBlock const &block) const {
+  if (!block.time.overlaps(from, to)) {
+    return true;
+  }
+  if (processId && !block.processId.overlaps(*processId, *processId)) {
+    return true;
+  }
+  if (status && !block.status.overlaps(*status, *status)) {
+    return true;
+  }
+  if (errors && !block.status.overlaps(0xc0000000, 0xffffffff)) {
+    return true;
+  }
+  if (!functions.empty() &&
+      std::none_of(functions.begin(), functions.end(), [&block](uint32_t id) {
+        return block.function.overlaps(id, id);
+      })) {
+    return true;
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool TraceQuery::run(TraceStoreReader const &reader, size_t threads,
+                     std::vector<Result> &results, Stats &stats) const {
+  // The columns needed by the filters and keys
+  unsigned mask = TraceColumns::Before | TraceColumns::Duration |
+                  TraceColumns::Status;
+  if (bucket || from != 0 || to != UINT64_MAX) {
+    mask |= TraceColumns::Time;
+  }
+  if ((keys & Function) || !functions.empty()) {
+    mask |= TraceColumns::Function;
+  }
+  if ((keys & Process) || processId) {
+    mask |= TraceColumns::ProcessId;
+  }
+  if (keys & Thread) {
+    mask |= TraceColumns::ThreadId;
+  }
+  if (keys & Args) {
+    mask |= TraceColumns::Args;
+  }
+  std::vector<uint8_t> wanted; // by function identifier
+  if (!functions.empty()) {
+    wanted.resize(reader.strings());
+    for (uint32_t const id : functions) {
+      if (id < wanted.size()) {
+        wanted[id] = 1;
+      }
+    }
+  }
+
+  auto const &blocks = reader.blocks();
+  threads = std::clamp<size_t>(threads, 1, std::max<size_t>(blocks.size(), 1));
+  std::vector<Part> parts(threads);
+  std::atomic<size_t> next{0};
+  auto const work = [&](Part &part) {
+    TraceColumns columns;
+    std::vector<uint8_t> selected;
+    for (size_t index; (index = next++) < blocks.size();) {
+      if (skip(blocks[index])) {
+        ++part.stats.skipped;
+        continue;
+      }
+      if (!reader.read(index, columns, mask)) {
+        part.ok = false;
+        return;
+      }
+      ++part.stats.blocks;
+      part.stats.rows += blocks[index].rows;
+
+      selected.assign(columns.before.size(), 1);
+      filter(selected, columns.before, [](uint8_t before) { return !before; });
+      if (!functions.empty()) {
+        filter(selected, columns.function,
+               [&wanted](uint32_t id) { return wanted[id] != 0; });
+      }
+      if (processId) {
+        uint32_t const value = *processId;
+        filter(selected, columns.processId,
+               [value](uint32_t id) { return id == value; });
+      }
+      if (status) {
+        uint64_t const value = *status;
+        filter(selected, columns.status,
+               [value](uint64_t result) { return result == value; });
+      }
+      if (errors) {
+        filter(selected, columns.status, TraceParser::isError);
+      }
+      if (mask & TraceColumns::Time) {
+        uint64_t const low = from;
+        uint64_t const high = to;
+        filter(selected, columns.time, [low, high](uint64_t time) {
+          return (time >= low) & (time <= high);
+        });
+      }
+
+      for (size_t idx = 0; idx != selected.size(); ++idx) {
+        if (!selected[idx]) {
+          continue;
+        }
+        TraceGroup group;
+        if (bucket) {
+          group.bucket = columns.time[idx] / bucket * bucket;
+        }
+        if (keys & Status) {
+          group.status = columns.status[idx];
+        }
+        if (keys & Function) {
+          group.function = columns.function[idx];
+        }
+        if (keys & Process) {
+          group.processId = columns.processId[idx];
+        }
+        if (keys & Thread) {
+          group.threadId = columns.threadId[idx];
+        }
+        if (keys & Args) {
+          group.args = std::move(columns.args[idx]);
+        }
+        TraceTotals &totals = part.groups[group];
+        ++totals.count;
+        totals.errors += TraceParser::isError(columns.status[idx]);
+        if (uint64_t const duration = columns.duration[idx]) {
+          totals.duration += duration - 1;
+          totals.durations.push_back(duration - 1);
+        }
+        ++part.stats.matched;
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t idx = 1; idx < threads; ++idx) {
+    workers.emplace_back(work, std::ref(parts[idx]));
+  }
+  work(parts[0]);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  Groups &groups = parts[0].groups;
+  stats = Stats();
+  bool ok = true;
+  for (auto &part : parts) {
+    ok = ok && part.ok;
+    stats.blocks += part.stats.blocks;
+    stats.skipped += part.stats.skipped;
+    stats.rows += part.stats.rows;
+    stats.matched += part.stats.matched;
+    if (&part.groups != &groups) {
+      for (auto &entry : part.groups) {
+        groups[entry.first].add(std::move(entry.second));
+      }
+    }
+  }
+
+  results.clear();
+  results.reserve(groups.size());
+  for (auto &entry : groups) {
+    entry.second.finish();
+    results.emplace_back(entry.first, std::move(entry.second));
+  }
+  std::sort(results.begin(), results.end(),
+            [](Result const &lhs, Result const &rhs) {
+              if (lhs.second.count != rhs.second.count) {
+                return lhs.second.count > rhs.second.count;
+              }
+              auto const key = [](TraceGroup const &group) {
+                return std::tie(group.bucket, group.function, group.processId,
+                                group.threadId, group.status, group.args);
+              };
+              return key(lhs.first) < key(rhs.first);
+            });
+  return ok;
+}
+
+} // namespace or2
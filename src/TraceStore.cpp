@@ -0,0 +1,569 @@
+/*
+NAME
+  TraceStore.cpp
+
+DESCRIPTION
+  Columnar store for NtTrace calls.
+
+  The file starts with the magic string and then holds the blocks; each
+  block holds the length and encoded values of each column in turn. The
+  string heap and the block statistics follow the blocks, and the file
+  ends with the offset of these and the magic string again. All integers
+  are variable length, seven bits per byte, apart from the final offset.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "TraceStore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+
+namespace or2 {
+namespace {
+
+constexpr std::string_view magic("NTSTORE3");
+constexpr size_t trailerSize = 8 + magic.size();
+constexpr uint64_t microsecondsPerDay = 24ull * 60 * 60 * 1000 * 1000;
+
+void putVarint(std::string &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+bool getVarint(std::string_view &in, uint64_t &value) {
+  value = 0;
+  for (unsigned shift = 0; shift < 64 && !in.empty(); shift += 7) {
+    auto const byte = static_cast<unsigned char>(in.front());
+    in.remove_prefix(1);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Each value as the difference from the one before
+std::string encodeDelta(std::vector<uint64_t> const &values) {
+  std::string out;
+  uint64_t previous = 0;
+  for (uint64_t const value : values) {
+    putVarint(out, zigzag(static_cast<int64_t>(value - previous)));
+    previous = value;
+  }
+  return out;
+}
+
+bool decodeDelta(std::string_view in, size_t rows,
+                 std::vector<uint64_t> &values) {
+  values.resize(rows);
+  uint64_t previous = 0;
+  for (auto &value : values) {
+    uint64_t delta{};
+    if (!getVarint(in, delta)) {
+      return false;
+    }
+    value = previous += static_cast<uint64_t>(unzigzag(delta));
+  }
+  return in.empty();
+}
+
+// Each value in turn
+template <typename T> std::string encodePlain(std::vector<T> const &values) {
+  std::string out;
+  for (T const value : values) {
+    putVarint(out, value);
+  }
+  return out;
+}
+
+template <typename T>
+bool decodePlain(std::string_view in, size_t rows, std::vector<T> &values) {
+  values.resize(rows);
+  for (auto &value : values) {
+    uint64_t raw{};
+    if (!getVarint(in, raw) || raw > std::numeric_limits<T>::max()) {
+      return false;
+    }
+    value = static_cast<T>(raw);
+  }
+  return in.empty();
+}
+
+// The distinct values, in ascending order as differences, followed by runs
+// of index into these and length
+template <typename T>
+std::string encodeDictionary(std::vector<T> const &values) {
+  std::vector<T> dictionary(values);
+  std::sort(dictionary.begin(), dictionary.end());
+  dictionary.erase(std::unique(dictionary.begin(), dictionary.end()),
+                   dictionary.end());
+
+  std::string out;
+  putVarint(out, dictionary.size());
+  T previous{};
+  for (T const value : dictionary) {
+    putVarint(out, value - previous);
+    previous = value;
+  }
+  for (size_t idx = 0; idx != values.size();) {
+    size_t end = idx + 1;
+    while (end != values.size() && values[end] == values[idx]) {
+      ++end;
+    }
+    auto const it =
+        std::lower_bound(dictionary.begin(), dictionary.end(), values[idx]);
+    putVarint(out, static_cast<uint64_t>(it - dictionary.begin()));
+    putVarint(out, end - idx);
+    idx = end;
+  }
+  return out;
+}
+
+template <typename T>
+bool decodeDictionary(std::string_view in, size_t rows,
+                      std::vector<T> &values) {
+  uint64_t size{};
+  if (!getVarint(in, size) || size > in.size()) {
+    return false;
+  }
+  std::vector<T> dictionary(size);
+  uint64_t previous{};
+  for (auto &value : dictionary) {
+    uint64_t delta{};
+    if (!getVarint(in, delta)) {
+      return false;
+    }
+    previous += delta;
+    if (previous > std::numeric_limits<T>::max()) {
+      return false;
+    }
+    value = static_cast<T>(previous);
+  }
+  values.clear();
+  values.reserve(rows);
+  while (!in.empty()) {
+    uint64_t index{};
+    uint64_t length{};
+    if (!getVarint(in, index) || !getVarint(in, length) || index >= size ||
+        length > rows - values.size()) {
+      return false;
+    }
+    values.insert(values.end(), length, dictionary[index]);
+  }
+  return values.size() == rows;
+}
+
+// The text of the arguments of each call, as the number of quoted strings
+// followed by the text before the first of these, and then each string as
+// an identifier in the string heap followed by the text after it
+bool decodeArgs(std::string_view in, size_t rows,
+                std::vector<std::string_view> const &strings,
+                std::vector<std::string> &values) {
+  values.resize(rows);
+  auto const text = [&in](std::string &value) {
+    uint64_t size{};
+    if (!getVarint(in, size) || size > in.size()) {
+      return false;
+    }
+    value.append(in.data(), size);
+    in.remove_prefix(size);
+    return true;
+  };
+  for (auto &value : values) {
+    uint64_t count{};
+    if (!getVarint(in, count) || !text(value)) {
+      return false;
+    }
+    for (uint64_t idx = 0; idx != count; ++idx) {
+      uint64_t id{};
+      if (!getVarint(in, id) || id >= strings.size()) {
+        return false;
+      }
+      value += strings[id];
+      if (!text(value)) {
+        return false;
+      }
+    }
+  }
+  return in.empty();
+}
+
+template <typename T> TraceBlock::Range range(std::vector<T> const &values) {
+  auto const minmax = std::minmax_element(values.begin(), values.end());
+  return {*minmax.first, *minmax.second};
+}
+
+void putRange(std::string &out, TraceBlock::Range const &range) {
+  putVarint(out, range.min);
+  putVarint(out, range.max);
+}
+
+bool getRange(std::string_view &in, TraceBlock::Range &range) {
+  return getVarint(in, range.min) && getVarint(in, range.max);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+TraceStoreWriter::TraceStoreWriter(std::string const &fileName,
+                                   size_t blockRows)
+    : blockRows_(std::max<size_t>(blockRows, 1)),
+      os_(fileName, std::ios::binary) {
+  os_ << magic;
+}
+
+//////////////////////////////////////////////////////////////////////////
+TraceStoreWriter::~TraceStoreWriter() { close(); }
+
+//////////////////////////////////////////////////////////////////////////
+void TraceStoreWriter::beginFile(uint64_t date) {
+  pending_.clear();
+  date_ = date;
+  timeOfDay_ = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TraceStoreWriter::add(TraceRecord const &record) {
+  uint64_t time{};
+  bool const timed = TraceParser::timeOfDay(record.time, time);
+  if (timed) {
+    // The trace has passed midnight
+    if (time + microsecondsPerDay / 2 < timeOfDay_) {
+      date_ += microsecondsPerDay;
+    }
+    timeOfDay_ = time;
+    time += date_;
+  }
+  uint64_t duration{};
+  auto const key = std::make_pair(record.processId, record.sequence());
+  if (record.before) {
+    if (timed) {
+      pending_[key] = time;
+    }
+  } else {
+    auto const it = pending_.find(key);
+    if (it != pending_.end()) {
+      if (timed && time >= it->second) {
+        duration = time - it->second + 1;
+      }
+      pending_.erase(it);
+    }
+  }
+  uint64_t status{};
+  if (!TraceParser::number(record.result, status)) {
+    status = 0;
+  }
+
+  block_.time.push_back(time);
+  block_.duration.push_back(duration);
+  block_.processId.push_back(record.processId);
+  block_.threadId.push_back(record.sequence());
+  block_.function.push_back(intern(record.function));
+  block_.status.push_back(status);
+  block_.before.push_back(record.before ? 1 : 0);
+  addArgs(record.args);
+  ++rows_;
+  if (block_.time.size() == blockRows_) {
+    flush();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TraceStoreWriter::close() {
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+  flush();
+
+  uint64_t const footer = static_cast<uint64_t>(os_.tellp());
+  std::string out;
+  putVarint(out, strings_.size());
+  for (auto const &text : strings_) {
+    putVarint(out, text.size());
+    out += text;
+  }
+  putVarint(out, blocks_.size());
+  for (auto const &block : blocks_) {
+    putVarint(out, block.offset);
+    putVarint(out, block.size);
+    putVarint(out, block.rows);
+    putRange(out, block.time);
+    putRange(out, block.duration);
+    putRange(out, block.processId);
+    putRange(out, block.threadId);
+    putRange(out, block.function);
+    putRange(out, block.status);
+  }
+  for (unsigned byte = 0; byte != 8; ++byte) {
+    out.push_back(static_cast<char>(footer >> (byte * 8)));
+  }
+  out += magic;
+  os_ << out;
+  os_.close();
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint64_t TraceStoreWriter::date(int year, unsigned month, unsigned day) {
+  std::chrono::sys_days const days = std::chrono::year(year) /
+                                     std::chrono::month(month) /
+                                     std::chrono::day(day);
+  return static_cast<uint64_t>(days.time_since_epoch().count()) *
+         microsecondsPerDay;
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint32_t TraceStoreWriter::intern(std::string_view text) {
+  auto const it = ids_.find(text);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  auto const id = static_cast<uint32_t>(strings_.size());
+  ids_.emplace(strings_.emplace_back(text), id);
+  return id;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Only the quoted strings are interned, as the rest of the text usually
+// contains addresses and handles and so is rarely repeated
+void TraceStoreWriter::addArgs(std::string_view args) {
+  // Each quoted string, as the position of its opening and closing quotes
+  auto const next = [args](size_t pos, size_t &close) {
+    size_t const open = args.find('"', pos);
+    close = open == std::string_view::npos ? open : args.find('"', open + 1);
+    return close == std::string_view::npos ? close : open;
+  };
+  size_t count{};
+  size_t close{};
+  for (size_t pos = 0; next(pos, close) != std::string_view::npos;
+       pos = close + 1) {
+    ++count;
+  }
+  putVarint(args_, count);
+  size_t pos = 0;
+  for (size_t open; (open = next(pos, close)) != std::string_view::npos;
+       pos = close + 1) {
+    putVarint(args_, open - pos);
+    args_ += args.substr(pos, open - pos);
+    putVarint(args_, intern(args.substr(open, close + 1 - open)));
+  }
+  putVarint(args_, args.size() - pos);
+  args_ += args.substr(pos);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TraceStoreWriter::flush() {
+  if (block_.time.empty()) {
+    return;
+  }
+  TraceBlock block;
+  block.offset = static_cast<uint64_t>(os_.tellp());
+  block.rows = block_.time.size();
+  block.time = range(block_.time);
+  block.duration = range(block_.duration);
+  block.processId = range(block_.processId);
+  block.threadId = range(block_.threadId);
+  block.function = range(block_.function);
+  block.status = range(block_.status);
+
+  std::string const columns[TraceColumns::count] = {
+      encodeDelta(block_.time),           encodePlain(block_.duration),
+      encodeDictionary(block_.processId), encodeDictionary(block_.threadId),
+      encodeDictionary(block_.function),  encodeDictionary(block_.status),
+      encodeDictionary(block_.before),    std::move(args_),
+  };
+  std::string out;
+  for (auto const &column : columns) {
+    putVarint(out, column.size());
+    out += column;
+  }
+  os_ << out;
+  block.size = out.size();
+  blocks_.push_back(block);
+  block_ = TraceColumns();
+  args_.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool TraceStoreReader::open(std::string const &fileName, std::string &error) {
+  blocks_.clear();
+  strings_.clear();
+  ids_.clear();
+  if (!file_.open(fileName, error)) {
+    return false;
+  }
+  std::string_view const text = file_.text();
+  if (text.size() < magic.size() + trailerSize ||
+      text.substr(0, magic.size()) != magic ||
+      text.substr(text.size() - magic.size()) != magic) {
+    error = "not a trace store";
+    return false;
+  }
+  uint64_t footer{};
+  for (unsigned byte = 0; byte != 8; ++byte) {
+    footer |= static_cast<uint64_t>(static_cast<unsigned char>(
+                  text[text.size() - trailerSize + byte]))
+              << (byte * 8);
+  }
+  if (footer < magic.size() || footer > text.size() - trailerSize) {
+    error = "corrupt trace store";
+    return false;
+  }
+  std::string_view in =
+      text.substr(footer, text.size() - trailerSize - footer);
+
+  uint64_t count{};
+  bool ok = getVarint(in, count) && count <= in.size();
+  for (uint64_t idx = 0; ok && idx != count; ++idx) {
+    uint64_t size{};
+    ok = getVarint(in, size) && size <= in.size();
+    if (ok) {
+      ids_.emplace(in.substr(0, size), static_cast<uint32_t>(idx));
+      strings_.push_back(in.substr(0, size));
+      in.remove_prefix(size);
+    }
+  }
+  ok = ok && getVarint(in, count) && count <= in.size();
+  for (uint64_t idx = 0; ok && idx != count; ++idx) {
+    TraceBlock block;
+    ok = getVarint(in, block.offset) && getVarint(in, block.size) &&
+         getVarint(in, block.rows) && getRange(in, block.time) &&
+         getRange(in, block.duration) && getRange(in, block.processId) &&
+         getRange(in, block.threadId) && getRange(in, block.function) &&
+         getRange(in, block.status) && block.offset <= footer &&
+         block.size <= footer - block.offset;
+    blocks_.push_back(block);
+  }
+  if (!ok || !in.empty()) {
+    error = "corrupt trace store";
+    return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint32_t TraceStoreReader::find(std::string_view text) const {
+  auto const it = ids_.find(text);
+  return it == ids_.end() ? static_cast<uint32_t>(strings_.size())
+                          : it->second;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool TraceStoreReader::read(size_t block, TraceColumns &columns,
+                            unsigned mask) const {
+  columns = TraceColumns();
+  TraceBlock const &info = blocks_[block];
+  std::string_view in = file_.text().substr(info.offset, info.size);
+  size_t const rows = info.rows;
+  for (size_t idx = 0; idx != TraceColumns::count; ++idx) {
+    uint64_t size{};
+    if (!getVarint(in, size) || size > in.size()) {
+      return false;
+    }
+    std::string_view const data = in.substr(0, size);
+    in.remove_prefix(size);
+    if (!(mask & (1u << idx))) {
+      continue;
+    }
+    bool ok{};
+    switch (1u << idx) {
+    case TraceColumns::Time:
+      ok = decodeDelta(data, rows, columns.time);
+      break;
+    case TraceColumns::Duration:
+      ok = decodePlain(data, rows, columns.duration);
+      break;
+    case TraceColumns::ProcessId:
+      ok = decodeDictionary(data, rows, columns.processId);
+      break;
+    case TraceColumns::ThreadId:
+      ok = decodeDictionary(data, rows, columns.threadId);
+      break;
+    case TraceColumns::Function:
+      ok = decodeDictionary(data, rows, columns.function);
+      break;
+    case TraceColumns::Status:
+      ok = decodeDictionary(data, rows, columns.status);
+      break;
+    case TraceColumns::Before:
+      ok = decodeDictionary(data, rows, columns.before);
+      break;
+    case TraceColumns::Args:
+      ok = decodeArgs(data, rows, strings_, columns.args);
+      break;
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+  return in.empty();
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint64_t TraceStoreReader::rows() const {
+  uint64_t total{};
+  for (auto const &block : blocks_) {
+    total += block.rows;
+  }
+  return total;
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::string TraceStoreReader::format(uint64_t time) {
+  std::chrono::year_month_day const date{std::chrono::sys_days(
+      std::chrono::days(static_cast<int>(time / microsecondsPerDay)))};
+  uint64_t const ms = time % microsecondsPerDay / 1000;
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u %02u:%02u:%02u.%03u",
+                static_cast<int>(date.year()),
+                static_cast<unsigned>(date.month()),
+                static_cast<unsigned>(date.day()),
+                static_cast<unsigned>(ms / 3600000),
+                static_cast<unsigned>(ms / 60000 % 60),
+                static_cast<unsigned>(ms / 1000 % 60),
+                static_cast<unsigned>(ms % 1000));
+  return buffer;
+}
+
+} // namespace or2
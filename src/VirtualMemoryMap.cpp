@@ -0,0 +1,433 @@
+/*
+NAME
+  VirtualMemoryMap.cpp
+
+DESCRIPTION
+  Map of the virtual address space of a process.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "VirtualMemoryMap.h"
+#include "StackTable.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+#include <ostream>
+#include <string>
+
+namespace or2 {
+namespace {
+
+uint64_t const pageSize = 0x1000;
+uint64_t const allocationGranularity = 0x10000;
+
+// Allocation types
+uint32_t const memCommit = 0x1000;
+uint32_t const memReserve = 0x2000;
+uint32_t const memDecommit = 0x4000;
+uint32_t const memRelease = 0x8000;
+
+// Page protections
+uint32_t const pageExecuteReadWrite = 0x40;
+uint32_t const pageExecuteWriteCopy = 0x80;
+
+uint64_t pageStart(uint64_t address) { return address & ~(pageSize - 1); }
+
+uint64_t pageEnd(uint64_t address) {
+  return (address + pageSize - 1) & ~(pageSize - 1);
+}
+
+// Show a number of bytes in KB
+double kilobytes(uint64_t bytes) { return static_cast<double>(bytes) / 1024; }
+
+void showStack(std::ostream &os, StackTable const &stacks, uint32_t stack) {
+  std::vector<std::string> const &frames = stacks.frames(stack);
+  if (frames.empty()) {
+    os << " (no stack)";
+  }
+  os << '\n';
+  for (auto const &frame : frames) {
+    os << "              " << frame << '\n';
+  }
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+VirtualMemoryMap::VirtualMemoryMap(uint64_t churnTime, uint64_t interval)
+    : churnTime_(churnTime), marks_(interval) {}
+
+//////////////////////////////////////////////////////////////////////////
+void VirtualMemoryMap::allocate(uint64_t base, uint64_t size, uint32_t type,
+                                uint32_t protection, uint32_t stack,
+                                uint64_t time) {
+  uint64_t const begin = pageStart(base);
+  uint64_t const end = pageEnd(base + size);
+  if (begin == end) {
+    return;
+  }
+  if (type & memReserve) {
+    erase(begin, end);
+    Block block;
+    block.base = block.allocationBase = begin;
+    block.size = end - begin;
+    block.protection = protection;
+    block.stack = stack;
+    block.time = time;
+    blocks_.emplace(begin, block);
+    allocations_[begin] = Allocation{end - begin, time, stack};
+  }
+  if (type & memCommit) {
+    commit(begin, end, protection, stack, time);
+  }
+  marks_.sample(committed_, time);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VirtualMemoryMap::release(uint64_t base, uint64_t size, uint32_t type,
+                               uint64_t time) {
+  uint64_t const begin = pageStart(base);
+  uint64_t const end = size ? pageEnd(base + size) : allocationEnd(begin);
+  if (type & memRelease) {
+    freed(begin, time);
+    erase(begin, end);
+  } else if (type & memDecommit) {
+    split(begin);
+    split(end);
+    for (auto it = blocks_.lower_bound(begin);
+         it != blocks_.end() && it->first < end; ++it) {
+      setCommitted(it->second, false);
+    }
+    merge(begin, end);
+  }
+  marks_.sample(committed_, time);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VirtualMemoryMap::protect(uint64_t base, uint64_t size,
+                               uint32_t protection, uint64_t time) {
+  uint64_t const begin = pageStart(base);
+  uint64_t const end = pageEnd(base + size);
+  split(begin);
+  split(end);
+  for (auto it = blocks_.lower_bound(begin);
+       it != blocks_.end() && it->first < end; ++it) {
+    it->second.protection = protection;
+  }
+  merge(begin, end);
+  marks_.sample(committed_, time);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VirtualMemoryMap::mapView(uint64_t base, uint64_t size,
+                               uint32_t protection, uint32_t stack,
+                               uint64_t time) {
+  uint64_t const begin = pageStart(base);
+  uint64_t const end = pageEnd(base + size);
+  if (begin == end) {
+    return;
+  }
+  erase(begin, end);
+  Block block;
+  block.base = block.allocationBase = begin;
+  block.size = end - begin;
+  block.kind = Mapped;
+  block.protection = protection;
+  block.stack = stack;
+  block.time = time;
+  setCommitted(blocks_.emplace(begin, block).first->second, true);
+  allocations_[begin] = Allocation{end - begin, time, stack};
+  marks_.sample(committed_, time);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VirtualMemoryMap::unmapView(uint64_t base, uint64_t time) {
+  uint64_t const begin = pageStart(base);
+  uint64_t const end = allocationEnd(begin);
+  freed(begin, time);
+  erase(begin, end);
+  marks_.sample(committed_, time);
+}
+
+//////////////////////////////////////////////////////////////////////////
+VirtualMemoryMap::Block const *VirtualMemoryMap::find(uint64_t address) const {
+  auto it = blocks_.upper_bound(address);
+  if (it == blocks_.begin()) {
+    return nullptr;
+  }
+  --it;
+  return address < it->first + it->second.size ? &it->second : nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::vector<VirtualMemoryMap::Block> VirtualMemoryMap::blocks() const {
+  std::vector<Block> result;
+  result.reserve(blocks_.size());
+  for (auto const &entry : blocks_) {
+    result.push_back(entry.second);
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint64_t VirtualMemoryMap::reserved() const {
+  uint64_t result{};
+  for (auto const &entry : blocks_) {
+    result += entry.second.size;
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::vector<VirtualMemoryMap::Block const *>
+VirtualMemoryMap::writableExecutable() const {
+  std::vector<Block const *> result;
+  for (auto const &entry : blocks_) {
+    if (isWritableExecutable(entry.second.protection)) {
+      result.push_back(&entry.second);
+    }
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+std::vector<VirtualMemoryMap::Churn>
+VirtualMemoryMap::churn(size_t count) const {
+  std::vector<Churn> result;
+  result.reserve(churn_.size());
+  for (auto const &entry : churn_) {
+    result.push_back(entry.second);
+  }
+  std::stable_sort(result.begin(), result.end(),
+                   [](Churn const &lhs, Churn const &rhs) {
+                     return lhs.count > rhs.count;
+                   });
+  if (count < result.size()) {
+    result.resize(count);
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VirtualMemoryMap::report(std::ostream &os, StackTable const &stacks,
+                              size_t maxItems, size_t maxMarks) const {
+  auto const flags = os.flags();
+  auto const precision = os.precision();
+  os << std::fixed << std::setprecision(1);
+  os << "Virtual memory: " << allocations_.size() << " allocations, "
+     << kilobytes(reserved()) << " KB reserved, " << kilobytes(committed_)
+     << " KB committed (peak " << kilobytes(peak()) << " KB at "
+     << static_cast<double>(marks_.peakTime()) / 1000 << "s)\n";
+
+  // Address space is reserved in units of the allocation granularity, so
+  // the rest of the unit is unusable after a smaller reservation
+  size_t small{};
+  uint64_t unusable{};
+  for (auto const &allocation : allocations_) {
+    uint64_t const size = allocation.second.size;
+    if (size % allocationGranularity) {
+      ++small;
+      unusable += allocationGranularity - size % allocationGranularity;
+    }
+  }
+  os << "Fragmentation: " << blocks_.size() << " regions; " << small
+     << " allocations are not a multiple of 64 KB, leaving "
+     << kilobytes(unusable) << " KB of address space unusable\n";
+
+  std::vector<Block const *> const rwx = writableExecutable();
+  if (!rwx.empty()) {
+    os << "Writable and executable regions: " << rwx.size() << '\n';
+    size_t shown = 0;
+    for (Block const *block : rwx) {
+      if (shown++ == maxItems) {
+        break;
+      }
+      os << std::hex << "    0x" << block->base << std::dec << ' '
+         << kilobytes(block->size) << " KB, protection 0x" << std::hex
+         << block->protection << std::dec << ", allocated at:";
+      showStack(os, stacks, block->stack);
+    }
+  }
+
+  std::vector<Churn> const churned = churn(maxItems);
+  if (!churned.empty()) {
+    os << "Churn (freed within " << churnTime_ << " ms of allocation):\n";
+    for (Churn const &entry : churned) {
+      os << std::setw(8) << entry.count << " x " << kilobytes(entry.size)
+         << " KB allocated at:";
+      showStack(os, stacks, entry.stack);
+    }
+  }
+
+  std::vector<Mark> const marks = marks_.marks(maxMarks);
+  if (!marks.empty()) {
+    os << "Committed KB high-water mark:\n";
+    for (Mark const &mark : marks) {
+      os << std::setw(10) << static_cast<double>(mark.time) / 1000 << "s "
+         << std::setw(10) << kilobytes(mark.maximum) << '\n';
+    }
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VirtualMemoryMap::isWritableExecutable(uint32_t protection) {
+  uint32_t const access = protection & 0xff; // ignore the modifiers
+  return access == pageExecuteReadWrite || access == pageExecuteWriteCopy;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Make sure a block starts at the address, if it is inside a block
+void VirtualMemoryMap::split(uint64_t address) {
+  auto it = blocks_.upper_bound(address);
+  if (it == blocks_.begin()) {
+    return;
+  }
+  Block &block = (--it)->second;
+  uint64_t const end = block.base + block.size;
+  if (address == block.base || address >= end) {
+    return;
+  }
+  Block tail = block;
+  tail.base = address;
+  tail.size = end - address;
+  block.size = address - block.base;
+  blocks_.emplace_hint(std::next(it), address, tail);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Remove the blocks in a range of addresses
+void VirtualMemoryMap::erase(uint64_t begin, uint64_t end) {
+  split(begin);
+  split(end);
+  auto it = blocks_.lower_bound(begin);
+  while (it != blocks_.end() && it->first < end) {
+    setCommitted(it->second, false);
+    it = blocks_.erase(it);
+  }
+  allocations_.erase(allocations_.lower_bound(begin),
+                     allocations_.lower_bound(end));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Commit a range of addresses; any part not already known was reserved
+// before tracing began
+void VirtualMemoryMap::commit(uint64_t begin, uint64_t end,
+                              uint32_t protection, uint32_t stack,
+                              uint64_t time) {
+  split(begin);
+  split(end);
+  auto it = blocks_.lower_bound(begin);
+  for (uint64_t next = begin; next < end; ++it) {
+    if (it == blocks_.end() || it->first > next) {
+      Block block;
+      block.base = block.allocationBase = next;
+      uint64_t const gapEnd =
+          it == blocks_.end() ? end : std::min(end, it->first);
+      block.size = gapEnd - next;
+      block.stack = stack;
+      block.time = time;
+      it = blocks_.emplace_hint(it, next, block);
+    }
+    setCommitted(it->second, true);
+    it->second.protection = protection;
+    next = it->first + it->second.size;
+  }
+  merge(begin, end);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Join adjacent blocks in and around a range that differ only in size
+void VirtualMemoryMap::merge(uint64_t begin, uint64_t end) {
+  auto it = blocks_.lower_bound(begin);
+  if (it != blocks_.begin()) {
+    --it;
+  }
+  while (it != blocks_.end() && it->first <= end) {
+    auto const next = std::next(it);
+    if (next == blocks_.end()) {
+      break;
+    }
+    Block &block = it->second;
+    Block const &following = next->second;
+    if (block.base + block.size == following.base &&
+        block.allocationBase == following.allocationBase &&
+        block.kind == following.kind &&
+        block.committed == following.committed &&
+        block.protection == following.protection) {
+      block.size += following.size;
+      blocks_.erase(next);
+    } else {
+      it = next;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VirtualMemoryMap::setCommitted(Block &block, bool committed) {
+  if (block.committed != committed) {
+    block.committed = committed;
+    if (committed) {
+      committed_ += block.size;
+    } else {
+      committed_ -= block.size;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Get the end of the allocation starting at an address; if it is not known
+// the end of the block containing the address is used
+uint64_t VirtualMemoryMap::allocationEnd(uint64_t base) const {
+  auto const allocation = allocations_.find(base);
+  if (allocation != allocations_.end()) {
+    return base + allocation->second.size;
+  }
+  Block const *block = find(base);
+  return block ? block->base + block->size : base;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// An allocation is being freed: check for churn
+void VirtualMemoryMap::freed(uint64_t base, uint64_t time) {
+  auto const allocation = allocations_.find(base);
+  if (allocation != allocations_.end() &&
+      time - allocation->second.time <= churnTime_) {
+    Churn &entry = churn_[allocation->second.size];
+    entry.size = allocation->second.size;
+    ++entry.count;
+    if (entry.stack == 0) {
+      entry.stack = allocation->second.stack;
+    }
+  }
+}
+
+} // namespace or2
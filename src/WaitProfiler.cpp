@@ -0,0 +1,281 @@
+/*
+NAME
+  WaitProfiler.cpp
+
+DESCRIPTION
+  Profile of the time threads spend blocked in wait calls.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "WaitProfiler.h"
+#include "StackTable.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <set>
+#include <tuple>
+
+namespace or2 {
+namespace {
+
+//////////////////////////////////////////////////////////////////////////
+// Count the convoys in the waits on one object: a convoy is a run of
+// successive releases, by at least 'minimum' different threads, in which
+// each waiter is woken after the previous one and was already waiting when
+// it was woken. Waiters woken at the same time as the previous one, as by a
+// broadcast, do not extend the run.
+void countConvoys(std::vector<WaitProfiler::Wait const *> &waits,
+                  size_t minimum, WaitProfiler::Object &object) {
+  std::sort(waits.begin(), waits.end(),
+            [](WaitProfiler::Wait const *lhs, WaitProfiler::Wait const *rhs) {
+              return std::tie(lhs->end, lhs->start) <
+                     std::tie(rhs->end, rhs->start);
+            });
+  std::set<uint32_t> threads;
+  uint64_t released{}; // time the previous waiter in the run was woken
+  auto const endRun = [&]() {
+    if (threads.size() >= minimum) {
+      ++object.convoys;
+      object.convoyThreads = std::max(object.convoyThreads, threads.size());
+    }
+    threads.clear();
+  };
+  for (WaitProfiler::Wait const *wait : waits) {
+    if (!threads.empty()) {
+      if (wait->end == released) {
+        continue;
+      }
+      if (wait->start >= released) {
+        endRun();
+      }
+    }
+    threads.insert(wait->threadId);
+    released = wait->end;
+  }
+  endRun();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Write a field of comma separated values, quoted if necessary
+void writeField(std::ostream &os, std::string const &value) {
+  if (value.find_first_of(",\"\r\n") == std::string::npos) {
+    os << value;
+    return;
+  }
+  os << '"';
+  for (char const ch : value) {
+    if (ch == '"') {
+      os << '"';
+    }
+    os << ch;
+  }
+  os << '"';
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+WaitProfiler::WaitProfiler(size_t convoyThreads)
+    : convoyThreads_(convoyThreads) {}
+
+//////////////////////////////////////////////////////////////////////////
+void WaitProfiler::begin(uint32_t threadId, uint64_t time) {
+  pending_[threadId] = time;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool WaitProfiler::end(uint32_t processId, uint32_t threadId, uint64_t time,
+                       std::string const &function, std::string const &object,
+                       uint32_t stack) {
+  auto const it = pending_.find(threadId);
+  if (it == pending_.end()) {
+    return false;
+  }
+  Wait wait;
+  wait.processId = processId;
+  wait.threadId = threadId;
+  wait.start = it->second;
+  wait.end = std::max(time, it->second);
+  wait.function = function;
+  wait.object = object;
+  wait.stack = stack;
+  pending_.erase(it);
+  add(std::move(wait));
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WaitProfiler::add(Wait wait) { waits_.push_back(std::move(wait)); }
+
+//////////////////////////////////////////////////////////////////////////
+std::vector<WaitProfiler::Object> WaitProfiler::ranked(size_t count) const {
+  std::map<std::pair<uint32_t, std::string>, std::vector<Wait const *>>
+      objects;
+  for (auto const &wait : waits_) {
+    objects[{wait.processId, wait.object}].push_back(&wait);
+  }
+
+  std::vector<Object> result;
+  result.reserve(objects.size());
+  for (auto &entry : objects) {
+    Object object;
+    object.processId = entry.first.first;
+    object.name = entry.first.second;
+    object.waits = entry.second.size();
+    std::set<uint32_t> threads;
+    std::map<uint32_t, uint64_t> stacks; // blocked time by stack
+    for (Wait const *wait : entry.second) {
+      uint64_t const duration = wait->end - wait->start;
+      object.microseconds += duration;
+      object.longest = std::max(object.longest, duration);
+      threads.insert(wait->threadId);
+      stacks[wait->stack] += duration;
+    }
+    object.threads = threads.size();
+    uint64_t stackTime{};
+    for (auto const &stack : stacks) {
+      if (stack.first != 0 && stack.second >= stackTime) {
+        object.stack = stack.first;
+        stackTime = stack.second;
+      }
+    }
+    countConvoys(entry.second, convoyThreads_, object);
+    result.push_back(std::move(object));
+  }
+
+  auto const worse = [](Object const &lhs, Object const &rhs) {
+    if (lhs.microseconds != rhs.microseconds) {
+      return lhs.microseconds > rhs.microseconds;
+    }
+    if (lhs.waits != rhs.waits) {
+      return lhs.waits > rhs.waits;
+    }
+    return std::tie(lhs.processId, lhs.name) <
+           std::tie(rhs.processId, rhs.name);
+  };
+  std::sort(result.begin(), result.end(), worse);
+  if (count < result.size()) {
+    result.resize(count);
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WaitProfiler::report(std::ostream &os, StackTable const &stacks,
+                          size_t count) const {
+  uint64_t total{};
+  std::set<std::pair<uint32_t, std::string>> objects;
+  for (auto const &wait : waits_) {
+    total += wait.end - wait.start;
+    objects.emplace(wait.processId, wait.object);
+  }
+
+  auto const flags = os.flags();
+  auto const precision = os.precision();
+  os << std::fixed << std::setprecision(3);
+  os << "\nWaits: " << waits_.size() << " on " << objects.size()
+     << " objects, " << static_cast<double>(total) / 1000 << " ms blocked\n";
+  os << std::setw(8) << "Waits" << std::setw(8) << "Threads" << std::setw(12)
+     << "Time ms" << std::setw(12) << "Longest ms"
+     << "  Object\n";
+  for (Object const &object : ranked(count)) {
+    os << std::setw(8) << object.waits << std::setw(8) << object.threads
+       << std::setw(12) << static_cast<double>(object.microseconds) / 1000
+       << std::setw(12) << static_cast<double>(object.longest) / 1000 << "  ";
+    if (object.processId) {
+      os << '[' << object.processId << "] ";
+    }
+    os << object.name << '\n';
+    if (object.convoys) {
+      os << "         convoys: " << object.convoys << ", up to "
+         << object.convoyThreads << " threads\n";
+    }
+    char const *prefix = "              at: ";
+    for (auto const &frame : stacks.frames(object.stack)) {
+      os << prefix << frame << '\n';
+      prefix = "                  ";
+    }
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void WaitProfiler::writeTimeline(std::ostream &os) const {
+  std::vector<Wait const *> sorted;
+  sorted.reserve(waits_.size());
+  for (auto const &wait : waits_) {
+    sorted.push_back(&wait);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](Wait const *lhs, Wait const *rhs) {
+                     return lhs->start < rhs->start;
+                   });
+
+  os << "process,thread,start,end,function,object\n";
+  for (Wait const *wait : sorted) {
+    os << wait->processId << ',' << wait->threadId << ',' << wait->start << ','
+       << wait->end << ',';
+    writeField(os, wait->function);
+    os << ',';
+    writeField(os, wait->object);
+    os << '\n';
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool WaitProfiler::isWait(std::string const &function, size_t &argument) {
+  static struct {
+    char const *name;
+    size_t argument;
+  } const waits[] = {
+      {"NtRemoveIoCompletion", 0},
+      {"NtRemoveIoCompletionEx", 0},
+      {"NtSignalAndWaitForSingleObject", 1},
+      {"NtWaitForAlertByThreadId", 0},
+      {"NtWaitForKeyedEvent", 0},
+      {"NtWaitForMultipleObjects", 1},
+      {"NtWaitForMultipleObjects32", 1},
+      {"NtWaitForSingleObject", 0},
+      {"NtWaitForWorkViaWorkerFactory", 0},
+      {"NtWaitHighEventPair", 0},
+      {"NtWaitLowEventPair", 0},
+  };
+  for (auto const &wait : waits) {
+    if (function == wait.name) {
+      argument = wait.argument;
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace or2
@@ -0,0 +1,90 @@
+/*
+NAME
+  X64Trampoline.cpp
+
+DESCRIPTION
+  Generator for the x64 register-save trampoline.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "X64Trampoline.h"
+
+#include <cstring>
+
+namespace or2 {
+namespace {
+
+// Save the four register arguments in their home area
+unsigned char const saveArgs[] = {
+    0x48, 0x89, 0x4c, 0x24, 0x08, // mov qword ptr [rsp+8],rcx
+    0x48, 0x89, 0x54, 0x24, 0x10, // mov qword ptr [rsp+10h],rdx
+    0x4c, 0x89, 0x44, 0x24, 0x18, // mov qword ptr [rsp+18h],r8
+    0x4c, 0x89, 0x4c, 0x24, 0x20, // mov qword ptr [rsp+20h],r9
+};
+
+unsigned char const MOVdwordEax = 0xb8; // mov eax,dword
+unsigned char const JMP = 0xe9;         // jmp rel32
+
+// jmp qword ptr [rip], followed by the target address
+unsigned char const jumpIndirect[] = {0xff, 0x25, 0, 0, 0, 0};
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+void X64Trampoline::generate(unsigned char (&code)[size], uint32_t ssn,
+                             uint64_t resume) {
+  unsigned char *pos = code;
+  memcpy(pos, saveArgs, sizeof(saveArgs));
+  pos += sizeof(saveArgs);
+  *pos++ = MOVdwordEax;
+  memcpy(pos, &ssn, sizeof(ssn));
+  pos += sizeof(ssn);
+  memcpy(pos, jumpIndirect, sizeof(jumpIndirect));
+  pos += sizeof(jumpIndirect);
+  memcpy(pos, &resume, sizeof(resume));
+  static_assert(sizeof(saveArgs) + 1 + sizeof(uint32_t) +
+                        sizeof(jumpIndirect) + sizeof(uint64_t) ==
+                    size,
+                "Trampoline size");
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool X64Trampoline::jump(unsigned char (&code)[jumpSize], uint64_t from,
+                         uint64_t to) {
+  int64_t const offset = static_cast<int64_t>(to - (from + jumpSize));
+  if (offset < INT32_MIN || offset > INT32_MAX) {
+    return false;
+  }
+  int32_t const rel32 = static_cast<int32_t>(offset);
+  code[0] = JMP;
+  memcpy(code + 1, &rel32, sizeof(rel32));
+  return true;
+}
+
+} // namespace or2
@@ -0,0 +1,520 @@
+/*
+NAME
+  X64Unwinder.cpp
+
+DESCRIPTION
+  Stack unwinder for x64 code using the unwind information in the .pdata and
+  .xdata sections of the loaded modules.
+
+NOTES
+  The unwind data formats are described in the Microsoft documentation for
+  "x64 exception handling". Only the integer registers are tracked, which is
+  all that is needed to walk the stack.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "X64Unwinder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <utility>
+
+namespace or2 {
+namespace {
+
+// Unwind operation codes
+enum UnwindOp {
+  UWOP_PUSH_NONVOL = 0,
+  UWOP_ALLOC_LARGE = 1,
+  UWOP_ALLOC_SMALL = 2,
+  UWOP_SET_FPREG = 3,
+  UWOP_SAVE_NONVOL = 4,
+  UWOP_SAVE_NONVOL_FAR = 5,
+  UWOP_EPILOG = 6, // UWOP_SAVE_XMM in version 1
+  UWOP_SPARE_CODE = 7,
+  UWOP_SAVE_XMM128 = 8,
+  UWOP_SAVE_XMM128_FAR = 9,
+  UWOP_PUSH_MACHFRAME = 10,
+};
+
+// Unwind information flags
+unsigned char const UNW_FLAG_CHAININFO = 4;
+
+// Number of 16-bit slots used by an unwind code, or zero if invalid
+size_t slotCount(unsigned int op, unsigned int opInfo) {
+  switch (op) {
+  case UWOP_PUSH_NONVOL:
+  case UWOP_ALLOC_SMALL:
+  case UWOP_SET_FPREG:
+  case UWOP_PUSH_MACHFRAME:
+    return 1;
+  case UWOP_ALLOC_LARGE:
+    return opInfo == 0 ? 2 : 3;
+  case UWOP_SAVE_NONVOL:
+  case UWOP_EPILOG:
+  case UWOP_SAVE_XMM128:
+    return 2;
+  case UWOP_SAVE_NONVOL_FAR:
+  case UWOP_SPARE_CODE:
+  case UWOP_SAVE_XMM128_FAR:
+    return 3;
+  }
+  return 0;
+}
+
+// Little-endian values from a byte buffer
+uint16_t get16(unsigned char const *p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t get32(unsigned char const *p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+X64Unwinder::X64Unwinder(ReadMemory read) : read_(std::move(read)) {}
+
+//////////////////////////////////////////////////////////////////////////
+bool X64Unwinder::unwind(Context context, Stack const &stack,
+                         ModuleMap const &modules, std::vector<Frame> &frames,
+                         size_t maxFrames) {
+  frames.clear();
+  const uint64_t stackEnd = stack.address + stack.bytes.size();
+  while (frames.size() < maxFrames) {
+    if (context.rip == 0) {
+      return true; // reached the outermost frame
+    }
+    const uint64_t rsp = context.regs[RSP];
+    frames.push_back(Frame{context.rip, rsp});
+
+    if (!step(context, stack, modules, frames.size() == 1)) {
+      return false;
+    }
+    if (context.regs[RSP] <= rsp) {
+      return false; // the stack must unwind upwards
+    }
+    if (context.regs[RSP] >= stackEnd) {
+      return true; // run off the top of the stack
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool X64Unwinder::step(Context &context, Stack const &stack,
+                       ModuleMap const &modules, bool innermost) {
+  uint64_t &rsp = context.regs[RSP];
+
+  // A return address may be the first byte after the calling function
+  const uint64_t pc = innermost ? context.rip : context.rip - 1;
+  ModuleMap::Module const *module = modules.find(pc);
+  if (!module) {
+    return false;
+  }
+  ModuleInfo &info = moduleInfo(*module, modules);
+  const uint64_t base = module->base;
+  const auto rva = static_cast<uint32_t>(pc - base);
+
+  const auto it = std::upper_bound(
+      info.functions.begin(), info.functions.end(), rva,
+      [](uint32_t lhs, Function const &rhs) { return lhs < rhs.begin; });
+  if (it == info.functions.begin() || rva >= std::prev(it)->end) {
+    // Leaf function: the return address is on the top of the stack
+    if (!read(stack, rsp, context.rip)) {
+      return false;
+    }
+    rsp += 8;
+    return true;
+  }
+
+  Function function = *std::prev(it);
+  for (int indirect = 0; function.unwindInfo & 1; ++indirect) {
+    // The entry refers to another function table entry
+    if (indirect == 4 || !read_(base + (function.unwindInfo & ~1u),
+                                &function, sizeof(function))) {
+      return false;
+    }
+  }
+  UnwindInfo const *unwind = unwindInfo(info, base, function.unwindInfo);
+  if (!unwind) {
+    return false;
+  }
+
+  uint32_t offset = static_cast<uint32_t>(context.rip - base) - function.begin;
+  if (innermost && offset >= unwind->prologSize &&
+      unwindEpilog(context, function, *unwind, base, stack)) {
+    return true;
+  }
+
+  bool machineFrame(false);
+  for (int chain = 0;; ++chain) {
+    const bool inProlog = offset < unwind->prologSize;
+    std::vector<uint16_t> const &codes = unwind->codes;
+
+    // Saved registers are addressed from the frame pointer, if one is used
+    // and has been set, otherwise from the stack pointer
+    uint64_t frame = rsp;
+    if (unwind->frameRegister) {
+      bool frameSet = !inProlog;
+      for (size_t i = 0; !frameSet && i < codes.size();
+           i += std::max<size_t>(1, slotCount((codes[i] >> 8) & 0xf,
+                                              codes[i] >> 12))) {
+        frameSet = ((codes[i] >> 8) & 0xf) == UWOP_SET_FPREG &&
+                   (codes[i] & 0xff) <= offset;
+      }
+      if (frameSet) {
+        frame = context.regs[unwind->frameRegister] -
+                16ull * unwind->frameOffset;
+      }
+    }
+
+    for (size_t i = 0; i < codes.size();) {
+      const unsigned int codeOffset = codes[i] & 0xff;
+      const unsigned int op = (codes[i] >> 8) & 0xf;
+      const unsigned int opInfo = codes[i] >> 12;
+      const size_t slots = slotCount(op, opInfo);
+      if (slots == 0 || i + slots > codes.size()) {
+        return false;
+      }
+      if ((op == UWOP_EPILOG && unwind->version >= 2) ||
+          (inProlog && codeOffset > offset)) {
+        // Epilog descriptor, or not yet executed in the prolog
+        i += slots;
+        continue;
+      }
+
+      switch (op) {
+      case UWOP_PUSH_NONVOL:
+        if (!read(stack, rsp, context.regs[opInfo])) {
+          return false;
+        }
+        rsp += 8;
+        break;
+      case UWOP_ALLOC_LARGE:
+        rsp += opInfo == 0
+                   ? codes[i + 1] * 8ull
+                   : codes[i + 1] | (static_cast<uint64_t>(codes[i + 2]) << 16);
+        break;
+      case UWOP_ALLOC_SMALL:
+        rsp += opInfo * 8ull + 8;
+        break;
+      case UWOP_SET_FPREG:
+        rsp = context.regs[unwind->frameRegister] - 16ull * unwind->frameOffset;
+        break;
+      case UWOP_SAVE_NONVOL:
+        if (!read(stack, frame + codes[i + 1] * 8ull, context.regs[opInfo])) {
+          return false;
+        }
+        break;
+      case UWOP_SAVE_NONVOL_FAR:
+        if (!read(stack,
+                  frame + (codes[i + 1] |
+                           (static_cast<uint64_t>(codes[i + 2]) << 16)),
+                  context.regs[opInfo])) {
+          return false;
+        }
+        break;
+      case UWOP_PUSH_MACHFRAME: {
+        // Hardware frame: [error code,] rip, cs, eflags, rsp, ss
+        const uint64_t machine = rsp + (opInfo ? 8 : 0);
+        uint64_t callerRsp(0);
+        if (!read(stack, machine, context.rip) ||
+            !read(stack, machine + 24, callerRsp)) {
+          return false;
+        }
+        rsp = callerRsp;
+        machineFrame = true;
+        break;
+      }
+      default:
+        break; // XMM registers are not tracked
+      }
+      i += slots;
+    }
+
+    if (!unwind->chained) {
+      break;
+    }
+    // The prolog of the parent function has always completed
+    Function parent = unwind->chain;
+    for (int indirect = 0; parent.unwindInfo & 1; ++indirect) {
+      if (indirect == 4 || !read_(base + (parent.unwindInfo & ~1u), &parent,
+                                  sizeof(parent))) {
+        return false;
+      }
+    }
+    if (chain == 32 ||
+        (unwind = unwindInfo(info, base, parent.unwindInfo)) == nullptr) {
+      return false;
+    }
+    offset = UINT32_MAX;
+  }
+
+  if (!machineFrame) {
+    if (!read(stack, rsp, context.rip)) {
+      return false;
+    }
+    rsp += 8;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void X64Unwinder::clear() { modules_.clear(); }
+
+//////////////////////////////////////////////////////////////////////////
+// Get the information for a module, reading the function table on first use
+X64Unwinder::ModuleInfo &
+X64Unwinder::moduleInfo(ModuleMap::Module const &module,
+                        ModuleMap const &modules) {
+  auto it = modules_.find(module.serial);
+  if (it == modules_.end()) {
+    if (modules_.size() > 2 * modules.size() + 16) {
+      // Discard information for modules that have been unloaded
+      std::set<uint64_t> loaded;
+      for (auto const &entry : modules) {
+        loaded.insert(entry.serial);
+      }
+      std::erase_if(modules_, [&loaded](auto const &entry) {
+        return loaded.count(entry.first) == 0;
+      });
+    }
+    it = modules_.emplace(module.serial, ModuleInfo{}).first;
+    readFunctions(module.base, it->second.functions);
+  }
+  return it->second;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Read the function table from the exception directory of a 64-bit image
+bool X64Unwinder::readFunctions(uint64_t base,
+                                std::vector<Function> &functions) const {
+  static_assert(sizeof(Function) == 12, "Function must match RUNTIME_FUNCTION");
+
+  unsigned char dosHeader[64];
+  if (!read_(base, dosHeader, sizeof(dosHeader)) || dosHeader[0] != 'M' ||
+      dosHeader[1] != 'Z') {
+    return false;
+  }
+  // Signature, file header, and the PE32+ optional header
+  unsigned char ntHeaders[4 + 20 + 240];
+  const uint64_t ntOffset = get32(dosHeader + 0x3c);
+  if (!read_(base + ntOffset, ntHeaders, sizeof(ntHeaders)) ||
+      std::memcmp(ntHeaders, "PE\0\0", 4) != 0) {
+    return false;
+  }
+  unsigned char const *optional = ntHeaders + 24;
+  if (get16(optional) != 0x20b) {
+    return false; // not a 64-bit image
+  }
+  const uint32_t directories = get32(optional + 108);
+  const int IMAGE_DIRECTORY_ENTRY_EXCEPTION = 3;
+  if (directories <= IMAGE_DIRECTORY_ENTRY_EXCEPTION) {
+    return false;
+  }
+  unsigned char const *exception =
+      optional + 112 + 8 * IMAGE_DIRECTORY_ENTRY_EXCEPTION;
+  const uint32_t rva = get32(exception);
+  const uint32_t size = get32(exception + 4);
+  if (rva == 0 || size < sizeof(Function)) {
+    return false;
+  }
+
+  // The table is in the (little-endian) byte order of the x64 host
+  functions.resize(size / sizeof(Function));
+  if (!read_(base + rva, functions.data(),
+             functions.size() * sizeof(Function))) {
+    functions.clear();
+    return false;
+  }
+  auto const byBegin = [](Function const &lhs, Function const &rhs) {
+    return lhs.begin < rhs.begin;
+  };
+  if (!std::is_sorted(functions.begin(), functions.end(), byBegin)) {
+    std::sort(functions.begin(), functions.end(), byBegin);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Get the unwind information at an RVA, parsing it on first use
+X64Unwinder::UnwindInfo const *
+X64Unwinder::unwindInfo(ModuleInfo &info, uint64_t base, uint32_t rva) const {
+  const auto it = info.unwindInfo.find(rva);
+  if (it != info.unwindInfo.end()) {
+    return &it->second;
+  }
+
+  unsigned char header[4];
+  if (!read_(base + rva, header, sizeof(header))) {
+    return nullptr;
+  }
+  UnwindInfo result{};
+  result.version = header[0] & 7;
+  if (result.version != 1 && result.version != 2) {
+    return nullptr;
+  }
+  result.chained = (header[0] >> 3) & UNW_FLAG_CHAININFO;
+  result.prologSize = header[1];
+  result.frameRegister = header[3] & 0xf;
+  result.frameOffset = header[3] >> 4;
+
+  // The codes are padded to an even count before any chained entry
+  const size_t count = header[2];
+  std::vector<unsigned char> data(((count + 1) & ~size_t(1)) * 2 +
+                                  (result.chained ? sizeof(Function) : 0));
+  if (!data.empty() && !read_(base + rva + 4, data.data(), data.size())) {
+    return nullptr;
+  }
+  result.codes.resize(count);
+  for (size_t i = 0; i != count; ++i) {
+    result.codes[i] = get16(&data[i * 2]);
+  }
+  if (result.chained) {
+    unsigned char const *chain = &data[data.size() - sizeof(Function)];
+    result.chain = Function{get32(chain), get32(chain + 4), get32(chain + 8)};
+  }
+
+  return &info.unwindInfo.emplace(rva, std::move(result)).first->second;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// If the innermost frame is stopped in an epilog, complete the epilog
+bool X64Unwinder::unwindEpilog(Context &context, Function const &function,
+                               UnwindInfo const &info, uint64_t base,
+                               Stack const &stack) const {
+  unsigned char code[32];
+  size_t length = sizeof(code);
+  if (!read_(context.rip, code, length)) {
+    // May be near the end of the readable code
+    length = 16;
+    if (!read_(context.rip, code, length)) {
+      return false;
+    }
+  }
+
+  // Optional stack adjustment: add rsp, imm or lea rsp, [frame + disp]
+  size_t pos = 0;
+  enum { none, add, lea } adjustment = none;
+  int64_t displacement = 0;
+  if (code[0] == 0x48 && code[1] == 0x83 && code[2] == 0xc4) {
+    adjustment = add;
+    displacement = static_cast<int8_t>(code[3]);
+    pos = 4;
+  } else if (code[0] == 0x48 && code[1] == 0x81 && code[2] == 0xc4) {
+    adjustment = add;
+    displacement = static_cast<int32_t>(get32(code + 3));
+    pos = 7;
+  } else if ((code[0] & 0xfe) == 0x48 && code[1] == 0x8d) {
+    const unsigned int mod = code[2] >> 6;
+    const unsigned int reg = (code[2] >> 3) & 7;
+    const unsigned int rm = (code[2] & 7) | ((code[0] & 1) << 3);
+    if (reg != RSP || (code[2] & 7) == 4 || rm != info.frameRegister ||
+        (mod != 1 && mod != 2)) {
+      return false;
+    }
+    adjustment = lea;
+    displacement = mod == 1 ? static_cast<int8_t>(code[3])
+                            : static_cast<int32_t>(get32(code + 3));
+    pos = mod == 1 ? 4 : 7;
+  }
+
+  // Register pops
+  unsigned int pops[16];
+  size_t popCount = 0;
+  while (pos < length && popCount < 16) {
+    if ((code[pos] & 0xf8) == 0x58) {
+      pops[popCount++] = code[pos] & 7;
+      pos += 1;
+    } else if (code[pos] == 0x41 && pos + 1 < length &&
+               (code[pos + 1] & 0xf8) == 0x58) {
+      pops[popCount++] = 8 + (code[pos + 1] & 7);
+      pos += 2;
+    } else {
+      break;
+    }
+  }
+
+  // The epilog must end with a return or a tail call
+  if (pos + 6 > length) {
+    return false;
+  }
+  bool terminated = code[pos] == 0xc3 || code[pos] == 0xc2 ||
+                    (code[pos] == 0xf3 && code[pos + 1] == 0xc3) ||
+                    (code[pos] == 0xff && code[pos + 1] == 0x25) ||
+                    (code[pos] == 0x48 && code[pos + 1] == 0xff &&
+                     code[pos + 2] == 0x25);
+  if (code[pos] == 0xe9 || code[pos] == 0xeb) {
+    const bool near = code[pos] == 0xe9;
+    const int64_t relative = near ? static_cast<int32_t>(get32(code + pos + 1))
+                                  : static_cast<int8_t>(code[pos + 1]);
+    const uint64_t target = context.rip + pos + (near ? 5 : 2) + relative;
+    terminated = target - base - function.begin >=
+                 static_cast<uint64_t>(function.end - function.begin);
+  }
+  if (!terminated) {
+    return false;
+  }
+
+  uint64_t &rsp = context.regs[RSP];
+  if (adjustment == add) {
+    rsp += displacement;
+  } else if (adjustment == lea) {
+    rsp = context.regs[info.frameRegister] + displacement;
+  }
+  for (size_t i = 0; i != popCount; ++i) {
+    if (!read(stack, rsp, context.regs[pops[i]])) {
+      return false;
+    }
+    rsp += 8;
+  }
+  if (!read(stack, rsp, context.rip)) {
+    return false;
+  }
+  rsp += 8;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Read a 64-bit value, from the copy of the stack if possible
+bool X64Unwinder::read(Stack const &stack, uint64_t address,
+                       uint64_t &value) const {
+  if (stack.contains(address) && stack.contains(address + 7)) {
+    std::memcpy(&value, &stack.bytes[address - stack.address], sizeof(value));
+    return true;
+  }
+  return read_(address, &value, sizeof(value));
+}
+
+} // namespace or2
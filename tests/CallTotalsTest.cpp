@@ -0,0 +1,195 @@
+/*
+NAME
+  CallTotalsTest.cpp
+
+DESCRIPTION
+  Unit tests for the call totals and their comparison.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "CallTotals.h"
+
+#include "Check.h"
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using or2::CallTotals;
+
+namespace {
+
+using Key = CallTotals::Key;
+
+void testTable() {
+  CallTotals totals;
+  CHECK(totals.empty());
+  totals.add("app.exe", "file", "NtReadFile", false, 5);
+  totals.add("app.exe", "file", "NtReadFile", true, 7);
+  totals.add("app.exe", "file", "NtWriteFile", false);
+  totals.add("other.exe", "registry", "NtOpenKey", true, 100);
+  CHECK(!totals.empty());
+
+  CallTotals::Table const table = totals.table();
+  auto const &read = table.at(Key("app.exe", "file", "NtReadFile"));
+  CHECK_EQUAL(read.calls, 2u);
+  CHECK_EQUAL(read.errors, 1u);
+  CHECK(read.timed);
+  CHECK_EQUAL(read.p50, 5u);
+  CHECK_EQUAL(read.p99, 7u);
+  CHECK(!table.at(Key("app.exe", "file", "NtWriteFile")).timed);
+
+  auto const &category = table.at(Key("app.exe", "file", "*"));
+  CHECK_EQUAL(category.calls, 3u);
+  CHECK_EQUAL(category.errors, 1u);
+  CHECK_EQUAL(table.at(Key("app.exe", "*", "*")).calls, 3u);
+  CHECK_EQUAL(table.at(Key("*", "registry", "NtOpenKey")).calls, 1u);
+  CHECK_EQUAL(table.at(Key("*", "*", "*")).calls, 4u);
+  CHECK_EQUAL(table.at(Key("*", "*", "*")).errors, 2u);
+  CHECK_EQUAL(table.size(), 13u);
+
+  // Latencies above 16us are rounded down to one of eight buckets per
+  // power of two
+  auto const &open = table.at(Key("other.exe", "registry", "NtOpenKey"));
+  CHECK_EQUAL(open.p50, 96u);
+}
+
+void testPercentiles() {
+  CallTotals totals;
+  for (int64_t value = 1; value <= 100; ++value) {
+    totals.add("p", "c", "f", false, value % 10);
+  }
+  auto const row = totals.table().at(Key("p", "c", "f"));
+  CHECK_EQUAL(row.p50, 4u);
+  CHECK_EQUAL(row.p90, 8u);
+  CHECK_EQUAL(row.p99, 9u);
+}
+
+void testFile() {
+  CallTotals totals;
+  totals.add("app.exe", "file", "NtReadFile", true, 3);
+  totals.add("app.exe", "file", "NtClose", false);
+  CallTotals::Table const table = totals.table();
+  std::ostringstream os;
+  CallTotals::write(os, table);
+  CHECK(os.str().find("app.exe\tfile\tNtClose\t1\t0\t-\t-\t-\n") !=
+        std::string::npos);
+  CHECK(os.str().find("app.exe\tfile\tNtReadFile\t1\t1\t3\t3\t3\n") !=
+        std::string::npos);
+
+  std::istringstream is(os.str());
+  CallTotals::Table copy;
+  std::string error;
+  CHECK(CallTotals::read(is, copy, error));
+  CHECK_EQUAL(copy.size(), table.size());
+  auto const &row = copy.at(Key("app.exe", "file", "NtReadFile"));
+  CHECK(row.timed);
+  CHECK_EQUAL(row.errors, 1u);
+  CHECK_EQUAL(row.p90, 3u);
+
+  std::istringstream bad("# comment\r\n\r\n"
+                         "app.exe\tfile\tNtClose\t1\tx\t-\t-\t-\n");
+  CHECK(!CallTotals::read(bad, copy, error));
+  CHECK_EQUAL(error, "invalid totals at line 3");
+}
+
+void testTolerances() {
+  std::istringstream is("# name percent slack latency\n"
+                        "registry 50\n"
+                        "NtReadFile 0 2 20\n");
+  std::map<std::string, CallTotals::Tolerance> tolerances;
+  std::string error;
+  CHECK(CallTotals::readTolerances(is, tolerances, error));
+  CHECK_EQUAL(tolerances.size(), 2u);
+  CHECK_EQUAL(tolerances["registry"].percent, 50.0);
+  CHECK_EQUAL(tolerances["registry"].slack, 0u);
+  CHECK_EQUAL(tolerances["registry"].latency, -1.0);
+  CHECK_EQUAL(tolerances["NtReadFile"].slack, 2u);
+  CHECK_EQUAL(tolerances["NtReadFile"].latency, 20.0);
+
+  std::istringstream bad("file ten\n");
+  CHECK(!CallTotals::readTolerances(bad, tolerances, error));
+  CHECK_EQUAL(error, "invalid tolerance at line 1");
+}
+
+void testCompare() {
+  CallTotals::Table baseline;
+  baseline[Key("p", "file", "NtReadFile")] = {10, 0, true, 5, 10, 100};
+  baseline[Key("p", "file", "NtClose")] = {10, 0, false, 0, 0, 0};
+  baseline[Key("p", "registry", "NtOpenKey")] = {10, 2, false, 0, 0, 0};
+  baseline[Key("p", "file", "NtFlushBuffersFile")] = {1, 0, false, 0, 0, 0};
+
+  CallTotals::Table current;
+  // Within the slack of 2, but the latency is more than 20% higher
+  current[Key("p", "file", "NtReadFile")] = {12, 0, true, 5, 10, 130};
+  // More than the default 10%
+  current[Key("p", "file", "NtClose")] = {12, 0, false, 0, 0, 0};
+  // Within the 50% allowed for the category, but fewer errors
+  current[Key("p", "registry", "NtOpenKey")] = {15, 1, false, 0, 0, 0};
+  // A new function
+  current[Key("p", "file", "NtDeleteFile")] = {1, 1, false, 0, 0, 0};
+
+  std::map<std::string, CallTotals::Tolerance> tolerances;
+  tolerances["registry"] = {50, 0, -1};
+  tolerances["NtReadFile"] = {0, 2, 20};
+  std::vector<CallTotals::Change> regressions;
+  std::vector<CallTotals::Change> improvements;
+  CallTotals::compare(baseline, current, CallTotals::Tolerance(), tolerances,
+                      regressions, improvements);
+
+  std::vector<std::string> found;
+  for (auto const &change : regressions) {
+    found.push_back(std::get<2>(change.key) + ' ' + change.what + ' ' +
+                    std::to_string(change.baseline) + ' ' +
+                    std::to_string(change.current));
+  }
+  CHECK(found == std::vector<std::string>({"NtClose calls 10 12",
+                                           "NtDeleteFile calls 0 1",
+                                           "NtDeleteFile errors 0 1",
+                                           "NtReadFile p99 us 100 130"}));
+  found.clear();
+  for (auto const &change : improvements) {
+    found.push_back(std::get<2>(change.key) + ' ' + change.what);
+  }
+  CHECK(found == std::vector<std::string>({"NtFlushBuffersFile calls",
+                                           "NtOpenKey errors"}));
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testTable();
+  testPercentiles();
+  testFile();
+  testTolerances();
+  testCompare();
+  return or2::test::result();
+}
@@ -0,0 +1,86 @@
+#ifndef OR2_CHECK_H
+#define OR2_CHECK_H
+
+/**@file
+
+  Minimal checks for the unit tests: each failure is reported with its file
+  and line, and the test program returns non-zero if any check failed.
+
+  @author Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+  Copyright &copy; 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+
+  $Revision$
+*/
+
+// $Id$
+
+#include <iostream>
+
+namespace or2 {
+namespace test {
+
+/** Number of failed checks */
+inline int &failures() {
+  static int count{};
+  return count;
+}
+
+/** Report a failed check */
+inline bool fail(char const *expression, char const *file, int line) {
+  std::cerr << file << '(' << line << "): check failed: " << expression
+            << std::endl;
+  ++failures();
+  return false;
+}
+
+/** Check two values are equal, reporting both if not */
+template <typename Lhs, typename Rhs>
+bool equal(Lhs const &lhs, Rhs const &rhs, char const *expression,
+           char const *file, int line) {
+  if (lhs == rhs) {
+    return true;
+  }
+  fail(expression, file, line);
+  std::cerr << "  actual:   " << lhs << "\n  expected: " << rhs << std::endl;
+  return false;
+}
+
+/** Result for main: the number of failed checks, reported if non-zero */
+inline int result() {
+  if (failures()) {
+    std::cerr << failures() << " check" << (failures() == 1 ? "" : "s")
+              << " failed" << std::endl;
+  }
+  return failures();
+}
+
+} // namespace test
+} // namespace or2
+
+#define CHECK(expr)                                                            \
+  ((expr) ? true : or2::test::fail(#expr, __FILE__, __LINE__))
+
+#define CHECK_EQUAL(lhs, rhs)                                                  \
+  or2::test::equal((lhs), (rhs), #lhs " == " #rhs, __FILE__, __LINE__)
+
+#endif // OR2_CHECK_H
@@ -0,0 +1,162 @@
+/*
+NAME
+  ChromeTraceTest.cpp
+
+DESCRIPTION
+  Unit tests for the Chrome trace-event writer.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "ChromeTrace.h"
+
+#include "Check.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using or2::ChromeTrace;
+
+namespace {
+
+// A directory for the files written by a test, removed afterwards
+class TempDir {
+public:
+  explicit TempDir(char const *name)
+      : path_(std::filesystem::temp_directory_path() / name) {
+    std::filesystem::remove_all(path_);
+    std::filesystem::create_directory(path_);
+  }
+  ~TempDir() {
+    std::error_code ec;
+    std::filesystem::remove_all(path_, ec);
+  }
+  std::string file(char const *name) const { return (path_ / name).string(); }
+
+private:
+  std::filesystem::path path_;
+};
+
+std::string contents(std::string const &fileName) {
+  std::ifstream ifs(fileName);
+  std::ostringstream os;
+  os << ifs.rdbuf();
+  return os.str();
+}
+
+void testSliceName() {
+  CHECK_EQUAL(ChromeTrace::sliceName("trace.json", 0), "trace-0.json");
+  CHECK_EQUAL(ChromeTrace::sliceName("trace", 2), "trace-2");
+  CHECK_EQUAL(ChromeTrace::sliceName("a.b/trace", 1), "a.b/trace-1");
+  CHECK_EQUAL(ChromeTrace::sliceName("a.b\\trace.x.json", 3),
+              "a.b\\trace.x-3.json");
+}
+
+void testEvents() {
+  TempDir dir("ChromeTraceTest.events");
+  std::string const fileName = dir.file("trace.json");
+  ChromeTrace chrome(fileName);
+  CHECK(chrome.good());
+  chrome.processName(10, "app.exe");
+  chrome.complete(10, 20, 5, 7, "NtClose", "call", {{"Handle", "0x40"}});
+  chrome.instant(10, 20, 15, "Loaded DLL", "dll");
+  CHECK(chrome.close());
+  // Events after closing are discarded
+  chrome.instant(10, 20, 16, "late", "dll");
+
+  CHECK_EQUAL(contents(fileName),
+              "[\n"
+              "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":10,\"tid\":0,"
+              "\"args\":{\"name\":\"app.exe\"}},\n"
+              "{\"name\":\"NtClose\",\"ph\":\"X\",\"pid\":10,\"tid\":20,"
+              "\"cat\":\"call\",\"ts\":5,\"dur\":7,"
+              "\"args\":{\"Handle\":\"0x40\"}},\n"
+              "{\"name\":\"Loaded DLL\",\"ph\":\"i\",\"pid\":10,\"tid\":20,"
+              "\"cat\":\"dll\",\"s\":\"t\",\"ts\":15}]\n");
+}
+
+void testSlices() {
+  TempDir dir("ChromeTraceTest.slices");
+  std::string const fileName = dir.file("trace.json");
+  {
+    ChromeTrace chrome(fileName, 1000);
+    chrome.threadName(10, 20, "worker");
+    chrome.instant(10, 20, 500, "first", "message");
+    chrome.instant(10, 20, 2500, "second", "message");
+    // An event earlier than the current slice stays in the current file
+    chrome.instant(10, 20, 100, "late", "message");
+    CHECK(chrome.good());
+  }
+  std::string const first = contents(ChromeTrace::sliceName(fileName, 0));
+  std::string const third = contents(ChromeTrace::sliceName(fileName, 2));
+  CHECK(first.find("\"first\"") != std::string::npos);
+  CHECK(first.find("\"second\"") == std::string::npos);
+  CHECK(third.find("\"second\"") != std::string::npos);
+  CHECK(third.find("\"late\"") != std::string::npos);
+  // The names are repeated in each file
+  CHECK(third.find("\"worker\"") != std::string::npos);
+  CHECK(!std::filesystem::exists(ChromeTrace::sliceName(fileName, 1)));
+  CHECK(!std::filesystem::exists(fileName));
+}
+
+void testOpenFailure() {
+  TempDir dir("ChromeTraceTest.failure");
+  std::string const missing = dir.file("missing/trace.json");
+  ChromeTrace bad(missing);
+  CHECK(!bad.good());
+  CHECK_EQUAL(bad.error(), missing);
+  CHECK(!bad.close());
+
+  // A slice file that cannot be opened is reported
+  std::string const fileName = dir.file("trace.json");
+  std::string const blocked = ChromeTrace::sliceName(fileName, 1);
+  std::filesystem::create_directory(blocked);
+  ChromeTrace chrome(fileName, 1000);
+  chrome.instant(10, 20, 500, "first", "message");
+  CHECK(chrome.good());
+  chrome.instant(10, 20, 1500, "second", "message");
+  CHECK(!chrome.good());
+  CHECK_EQUAL(chrome.error(), blocked);
+  chrome.instant(10, 20, 2500, "third", "message");
+  CHECK(!chrome.close());
+  CHECK_EQUAL(chrome.error(), blocked);
+  CHECK(contents(ChromeTrace::sliceName(fileName, 0)).find("\"first\"") !=
+        std::string::npos);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testSliceName();
+  testEvents();
+  testSlices();
+  testOpenFailure();
+  return or2::test::result();
+}
@@ -0,0 +1,146 @@
+/*
+NAME
+  FileIoStatsTest.cpp
+
+DESCRIPTION
+  Unit tests for the file I/O statistics.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "FileIoStats.h"
+
+#include "Check.h"
+
+#include <sstream>
+
+using or2::FileIoStats;
+
+namespace {
+
+void testOperation() {
+  CHECK_EQUAL(FileIoStats::operation("NtCreateFile"), FileIoStats::Open);
+  CHECK_EQUAL(FileIoStats::operation("NtOpenFile"), FileIoStats::Open);
+  CHECK_EQUAL(FileIoStats::operation("NtReadFileScatter"), FileIoStats::Read);
+  CHECK_EQUAL(FileIoStats::operation("NtWriteFileGather"), FileIoStats::Write);
+  CHECK_EQUAL(FileIoStats::operation("NtQueryInformationFile"),
+              FileIoStats::Query);
+  CHECK_EQUAL(FileIoStats::operation("NtClose"), FileIoStats::OpCount);
+}
+
+void testBuckets() {
+  CHECK_EQUAL(FileIoStats::bucket(0), 0u);
+  CHECK_EQUAL(FileIoStats::bucket(15), 0u);
+  CHECK_EQUAL(FileIoStats::bucket(16), 1u);
+  CHECK_EQUAL(FileIoStats::bucket(4095), 2u);
+  CHECK_EQUAL(FileIoStats::bucket(4096), 3u);
+  CHECK_EQUAL(FileIoStats::bucket(1 << 20), 5u);
+  CHECK_EQUAL(FileIoStats::bucket(uint64_t(1) << 40), 5u);
+  CHECK_EQUAL(std::string(FileIoStats::bucketName(2)), "<4K");
+  CHECK_EQUAL(std::string(FileIoStats::bucketName(5)), ">=1M");
+  CHECK_EQUAL(std::string(FileIoStats::bucketName(6)), "?");
+}
+
+void testAdd() {
+  FileIoStats stats;
+  CHECK(stats.empty());
+  stats.add("a.txt", FileIoStats::Open, 0, 0, 100);
+  stats.add("a.txt", FileIoStats::Read, 4096, 100, -1);
+  stats.add("a.txt", FileIoStats::Write, 10, 10, 50);
+  stats.add("a.txt", FileIoStats::Query, 24, 24, -1);
+  CHECK_EQUAL(stats.size(), 1u);
+
+  std::vector<FileIoStats::File const *> const top = stats.top(5);
+  CHECK_EQUAL(top.size(), 1u);
+  FileIoStats::File const &file = *top[0];
+  CHECK_EQUAL(file.path, "a.txt");
+  CHECK_EQUAL(file.total(), 4u);
+  CHECK_EQUAL(file.calls[FileIoStats::Open], 1u);
+  CHECK_EQUAL(file.calls[FileIoStats::Query], 1u);
+  // Bytes are those transferred, sizes those requested
+  CHECK_EQUAL(file.bytesRead, 100u);
+  CHECK_EQUAL(file.bytesWritten, 10u);
+  CHECK_EQUAL(file.sizes[3], 1u);
+  CHECK_EQUAL(file.sizes[0], 1u);
+  CHECK_EQUAL(file.sizes[1], 0u); // queries are not sized
+  CHECK_EQUAL(file.timed, 2u);
+  CHECK_EQUAL(file.microseconds, 150u);
+}
+
+void testTop() {
+  FileIoStats stats;
+  stats.add("b", FileIoStats::Read, 1, 1, -1);
+  stats.add("c", FileIoStats::Read, 1, 1, -1);
+  stats.add("c", FileIoStats::Read, 1, 1, -1);
+  stats.add("a", FileIoStats::Read, 1, 1, -1);
+  stats.add("d", FileIoStats::Read, 1, 1, -1);
+
+  // Busiest first, then by path
+  std::vector<FileIoStats::File const *> top = stats.top(10);
+  CHECK_EQUAL(top.size(), 4u);
+  CHECK_EQUAL(top[0]->path, "c");
+  CHECK_EQUAL(top[1]->path, "a");
+  CHECK_EQUAL(top[2]->path, "b");
+  CHECK_EQUAL(top[3]->path, "d");
+
+  top = stats.top(2);
+  CHECK_EQUAL(top.size(), 2u);
+  CHECK_EQUAL(top[0]->path, "c");
+  CHECK_EQUAL(top[1]->path, "a");
+}
+
+void testReport() {
+  FileIoStats stats;
+  stats.add("C:\\a.txt", FileIoStats::Read, 4096, 4096, 1500);
+  stats.add("C:\\a.txt", FileIoStats::Read, 100, 50, 500);
+  stats.add("C:\\b.txt", FileIoStats::Open, 0, 0, -1);
+
+  std::ostringstream os;
+  stats.report(os, 5);
+  CHECK_EQUAL(os.str(),
+              "\nFile I/O for 2 files\n"
+              "   Calls   Opens   Reads  Writes Queries        Read     "
+              "Written   Time ms  Path\n"
+              "       2       0       2       0       0        4146     "
+              "      0     2.000  C:\\a.txt\n"
+              "          sizes: <256:1 <64K:1\n"
+              "       1       1       0       0       0           0     "
+              "      0         -  C:\\b.txt\n");
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testOperation();
+  testBuckets();
+  testAdd();
+  testTop();
+  testReport();
+  return or2::test::result();
+}
@@ -0,0 +1,244 @@
+/*
+NAME
+  FilterExpressionTest.cpp
+
+DESCRIPTION
+  Unit tests for parsing, compiling and evaluating filter expressions.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "FilterExpression.h"
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+
+using or2::FilterContext;
+using or2::FilterExpression;
+using or2::FilterProgram;
+using or2::FilterTarget;
+
+namespace {
+
+// NtCreateFile(FileHandle, DesiredAccess, ObjectAttributes, ...)
+FilterTarget const createFile{"NtCreateFile",
+                              "File",
+                              {{"FileHandle", false},
+                               {"DesiredAccess", false},
+                               {"ObjectAttributes", true}}};
+
+FilterTarget const setEvent{"NtSetEvent",
+                            "Event",
+                            {{"EventHandle", false}, {"PreviousState", false}}};
+
+// The values of one call, counting the string fetches
+class Call : public FilterContext {
+public:
+  Call(int64_t status, std::string name = "\\??\\C:\\temp\\log.txt")
+      : status_(status), name_(std::move(name)) {}
+
+  int64_t integer(unsigned field) override {
+    switch (field) {
+    case fieldStatus:
+      return status_;
+    case fieldError:
+      return status_ < 0;
+    case fieldPid:
+      return 100;
+    case fieldTid:
+      return 200;
+    default:
+      return 0x1000 + (field - fieldArgument);
+    }
+  }
+
+  bool string(unsigned field, std::string &value) override {
+    ++fetches;
+    if (field != fieldArgument + 2 || name_.empty()) {
+      return false;
+    }
+    value = name_;
+    return true;
+  }
+
+  int fetches{};
+
+private:
+  int64_t status_;
+  std::string name_;
+};
+
+bool evaluate(std::string const &text, FilterTarget const &target,
+              Call &&call) {
+  return FilterExpression(text).compile(target).evaluate(call);
+}
+
+bool evaluate(std::string const &text, Call &&call = Call(0)) {
+  return evaluate(text, createFile, std::move(call));
+}
+
+// Returns the error message for an invalid expression, or empty if valid
+std::string parseError(std::string const &text) {
+  try {
+    FilterExpression const expression(text);
+  } catch (std::runtime_error const &ex) {
+    return ex.what();
+  }
+  return {};
+}
+
+void testComparisons() {
+  CHECK(evaluate("status == 0"));
+  CHECK(!evaluate("status != 0"));
+  CHECK(evaluate("status < 0", Call(-1)));
+  CHECK(evaluate("status <= -1", Call(-1)));
+  CHECK(evaluate("status > 0x10", Call(0x11)));
+  CHECK(!evaluate("status >= 0x12", Call(0x11)));
+  CHECK(evaluate("error", Call(-1)));
+  CHECK(!evaluate("error"));
+  CHECK(evaluate("pid == 100 && tid == 200"));
+  CHECK(evaluate("DesiredAccess == 0x1001"));
+  CHECK(evaluate("desiredaccess == 4097"));
+
+  // Strings ignore case, and '~' matches a wildcard pattern
+  CHECK(evaluate("function == 'ntcreatefile'"));
+  CHECK(evaluate("category == \"File\""));
+  CHECK(evaluate("ObjectAttributes ~ '*\\temp\\*.TXT'"));
+  CHECK(!evaluate("ObjectAttributes ~ '*.log'"));
+  CHECK(evaluate("ObjectAttributes !~ '*.lo?'"));
+  CHECK(evaluate("ObjectAttributes ~ '*.tx?'"));
+  CHECK(evaluate("ObjectAttributes"));
+  CHECK(!evaluate("ObjectAttributes", Call(0, "")));
+  CHECK(!evaluate("ObjectAttributes == 'x'", Call(0, "")));
+
+  // A bare name matches that entry point
+  CHECK(evaluate("NtCreateFile"));
+  CHECK(!evaluate("NtSetEvent"));
+  CHECK(evaluate("NtSetEvent", setEvent, Call(0)));
+}
+
+void testPrecedence() {
+  // ! binds tighter than &&, which binds tighter than ||
+  CHECK(evaluate("status == 1 || status == 0 && pid == 100"));
+  CHECK(!evaluate("(status == 1 || status == 0) && pid == 101"));
+  CHECK(evaluate("status == 1 || pid == 100 && tid == 200"));
+  CHECK(!evaluate("status == 0 && pid == 101 || tid == 201"));
+  CHECK(evaluate("!status == 1"));
+  CHECK(!evaluate("!(status == 0)"));
+  CHECK(evaluate("!!error", Call(-1)));
+  CHECK(evaluate("!error && !(pid != 100)"));
+}
+
+void testMismatches() {
+  // Comparisons with a missing field or of different types are false
+  CHECK(!evaluate("EventHandle == 0"));
+  CHECK(evaluate("!(EventHandle == 0)"));
+  CHECK(!evaluate("ObjectAttributes == 1"));
+  CHECK(!evaluate("status ~ 'x'"));
+  CHECK(!evaluate("ObjectAttributes < 'x'"));
+}
+
+void testFolding() {
+  // Fields constant for the entry point are folded
+  FilterExpression const expression("category == 'File' && status < 0");
+  CHECK(expression.compile(setEvent).alwaysFalse());
+  FilterProgram const program = expression.compile(createFile);
+  CHECK(!program.alwaysFalse());
+  CHECK(!program.alwaysTrue());
+
+  CHECK(FilterExpression("function ~ 'Nt*' || status").compile(setEvent)
+            .alwaysTrue());
+
+  // Integer tests are ordered before the string fetch
+  Call call(-1);
+  CHECK(!FilterExpression("ObjectAttributes ~ '*.txt' && status == 0")
+             .compile(createFile)
+             .evaluate(call));
+  CHECK_EQUAL(call.fetches, 0);
+
+  // A string field used twice is fetched once
+  Call twice(0);
+  CHECK(FilterExpression("ObjectAttributes ~ '*.txt' && ObjectAttributes != "
+                         "'x'")
+            .compile(createFile)
+            .evaluate(twice));
+  CHECK_EQUAL(twice.fetches, 1);
+}
+
+void testErrors() {
+  CHECK(parseError("status == 0").empty());
+  CHECK(parseError("") != "");
+  CHECK(parseError("status ==") != "");
+  CHECK(parseError("(status == 0") != "");
+  CHECK(parseError("status == 0)") != "");
+  CHECK(parseError("name == 'unterminated") != "");
+  CHECK(parseError("status == 12ab") != "");
+  CHECK(parseError("status == 0x10000000000000000") != "");
+  CHECK(parseError("status # 1") != "");
+  CHECK(parseError("status == 0 &&") != "");
+  CHECK_EQUAL(parseError("status = 1"),
+              "Invalid filter expression: unexpected text at offset 7 "
+              "in 'status = 1'");
+}
+
+void testCheck() {
+  std::vector<FilterTarget> const targets{createFile, setEvent};
+  auto checkError = [&](std::string const &text) -> std::string {
+    try {
+      FilterExpression(text).check(targets);
+    } catch (std::runtime_error const &ex) {
+      return ex.what();
+    }
+    return {};
+  };
+  CHECK(checkError("status == 0 && EventHandle == 4").empty());
+  CHECK(checkError("NtSetEvent || objectattributes ~ '*.txt'").empty());
+  CHECK(checkError("Function == 'x' && category == 'y'").empty());
+  CHECK_EQUAL(checkError("status == 0 && !(ObjectAtributes ~ '*.txt')"),
+              "Invalid filter expression: unknown identifier "
+              "'ObjectAtributes' in 'status == 0 && !(ObjectAtributes ~ "
+              "'*.txt')'");
+  CHECK(checkError("NtSetEvnt") != "");
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testComparisons();
+  testPrecedence();
+  testMismatches();
+  testFolding();
+  testErrors();
+  testCheck();
+  return or2::test::result();
+}
@@ -0,0 +1,175 @@
+/*
+NAME
+  FlightRecorderTest.cpp
+
+DESCRIPTION
+  Unit tests for the flight recorder ring and its dump files.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "FlightRecorder.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+
+using or2::FlightRecorder;
+
+namespace {
+
+// Header of a record: size, time, thread, entry and result
+size_t const headerSize = 4 + 8 + 4 + 4 + 8;
+
+void add(FlightRecorder &recorder, uint64_t time,
+         std::vector<uint64_t> const &args) {
+  recorder.add(time, static_cast<uint32_t>(time + 1000),
+               static_cast<uint32_t>(time % 3), time * 2, args.data(),
+               args.size());
+}
+
+void testRecords() {
+  FlightRecorder recorder(1024);
+  CHECK(recorder.empty());
+  add(recorder, 1, {10, 11});
+  uint32_t const args32[] = {0xffffffff, 7};
+  recorder.add(2, 3, 4, 5, args32, 2);
+  CHECK_EQUAL(recorder.size(), 2u);
+
+  auto const records = recorder.records();
+  CHECK_EQUAL(records.size(), 2u);
+  if (records.size() == 2) {
+    CHECK_EQUAL(records[0].time, 1u);
+    CHECK_EQUAL(records[0].threadId, 1001u);
+    CHECK_EQUAL(records[0].entry, 1u);
+    CHECK_EQUAL(records[0].result, 2u);
+    CHECK(records[0].args == std::vector<uint64_t>({10, 11}));
+    CHECK_EQUAL(records[1].threadId, 3u);
+    CHECK(records[1].args == std::vector<uint64_t>({0xffffffff, 7}));
+  }
+
+  recorder.clear();
+  CHECK(recorder.empty());
+  CHECK(recorder.records().empty());
+}
+
+void testWrap() {
+  // Room for three records of two arguments, plus part of a fourth, so
+  // records and their fields are split at the end of the buffer
+  size_t const record = headerSize + 2 * 8;
+  FlightRecorder recorder(record * 3 + 20);
+  for (uint64_t time = 0; time != 50; ++time) {
+    add(recorder, time, {time * 10, time * 10 + 1});
+    auto const records = recorder.records();
+    size_t const expected = time < 3 ? time + 1 : 3;
+    CHECK_EQUAL(records.size(), expected);
+    // The newest records are kept, oldest first
+    for (size_t idx = 0; idx != records.size(); ++idx) {
+      uint64_t const wanted = time + 1 - records.size() + idx;
+      CHECK_EQUAL(records[idx].time, wanted);
+      CHECK(records[idx].args ==
+            std::vector<uint64_t>({wanted * 10, wanted * 10 + 1}));
+    }
+  }
+
+  // Records of different sizes discard as many old records as needed
+  add(recorder, 100, {1, 2, 3, 4, 5});
+  auto records = recorder.records();
+  CHECK_EQUAL(records.size(), 2u);
+  CHECK_EQUAL(records.front().time, 49u);
+  CHECK_EQUAL(records.back().args.size(), 5u);
+  add(recorder, 101, {});
+  add(recorder, 102, {});
+  records = recorder.records();
+  CHECK_EQUAL(records.size(), 3u);
+  CHECK_EQUAL(records.front().time, 100u);
+
+  // A record larger than the ring is not kept
+  std::vector<uint64_t> const large(20, 1);
+  add(recorder, 103, large);
+  CHECK_EQUAL(recorder.records().back().time, 102u);
+}
+
+void testDump() {
+  FlightRecorder recorder(256);
+  add(recorder, 1000, {1, 0x123456789abcdef0});
+  add(recorder, 3000, {});
+  std::vector<std::string> const names{"NtOpenFile", "NtClose"};
+
+  std::stringstream ss;
+  recorder.write(ss, 1234, 1000, "exception c0000005", names);
+
+  FlightRecorder::Dump dump;
+  CHECK(FlightRecorder::read(ss, dump));
+  CHECK_EQUAL(dump.processId, 1234u);
+  CHECK_EQUAL(dump.frequency, 1000u);
+  CHECK_EQUAL(dump.reason, "exception c0000005");
+  CHECK(dump.names == names);
+  CHECK_EQUAL(dump.records.size(), 2u);
+  if (dump.records.size() == 2) {
+    CHECK_EQUAL(dump.records[0].args[1], 0x123456789abcdef0u);
+    CHECK(dump.records[1].args.empty());
+  }
+
+  std::ostringstream os;
+  FlightRecorder::print(os, dump);
+  CHECK_EQUAL(os.str(), "Process 1234: exception c0000005\n"
+                        "2 calls\n"
+                        "-2.000000 [2000] NtClose(0x1, 0x123456789abcdef0) "
+                        "=> 0x7d0\n"
+                        "-0.000000 [4000] NtOpenFile() => 0x1770\n");
+}
+
+void testCorrupt() {
+  FlightRecorder recorder(256);
+  add(recorder, 1, {2});
+  std::ostringstream os;
+  recorder.write(os, 1, 1, "reason", {"NtClose"});
+  std::string const good = os.str();
+
+  FlightRecorder::Dump dump;
+  std::istringstream magic("XTFR" + good.substr(4));
+  CHECK(!FlightRecorder::read(magic, dump));
+  for (size_t length = 0; length != good.size(); ++length) {
+    std::istringstream truncated(good.substr(0, length));
+    CHECK(!FlightRecorder::read(truncated, dump));
+  }
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testRecords();
+  testWrap();
+  testDump();
+  testCorrupt();
+  return or2::test::result();
+}
@@ -0,0 +1,89 @@
+/*
+NAME
+  FoldedStacksTest.cpp
+
+DESCRIPTION
+  Unit tests for the folded stacks written for flame graphs.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "FoldedStacks.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+
+using or2::FoldedStacks;
+
+namespace {
+
+void testFold() {
+  FoldedStacks stacks;
+  CHECK(stacks.empty());
+
+  // Frames are given innermost first and written outermost first
+  std::vector<std::string> const frames{"ntdll!NtReadFile",
+                                        "KERNELBASE!ReadFile", "app!main"};
+  stacks.add("File", "NtReadFile", frames, 1);
+  stacks.add("File", "NtReadFile", frames, 2);
+  stacks.add("File", "NtWriteFile", {"app!main"}, 5);
+  stacks.add("Event", "NtSetEvent", {}, 7);
+  CHECK_EQUAL(stacks.size(), 3u);
+
+  std::ostringstream os;
+  stacks.write(os);
+  CHECK_EQUAL(os.str(),
+              "Event;NtSetEvent 7\n"
+              "File;app!main;KERNELBASE!ReadFile;ntdll!NtReadFile;NtReadFile "
+              "3\n"
+              "File;app!main;NtWriteFile 5\n");
+
+  stacks.clear();
+  CHECK(stacks.empty());
+}
+
+void testSeparators() {
+  // Separators and line breaks in names must not split the stack
+  FoldedStacks stacks;
+  stacks.add("File", "NtReadFile", {"a;b", "line\r\nbreak"}, 1);
+  std::ostringstream os;
+  stacks.write(os);
+  CHECK_EQUAL(os.str(), "File;line  break;a:b;NtReadFile 1\n");
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testFold();
+  testSeparators();
+  return or2::test::result();
+}
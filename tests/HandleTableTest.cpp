@@ -0,0 +1,163 @@
+/*
+NAME
+  HandleTableTest.cpp
+
+DESCRIPTION
+  Unit tests for the table of open handle names.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "HandleTable.h"
+
+#include "Check.h"
+
+#include <string>
+
+using or2::HandleTable;
+
+namespace {
+
+std::string nameOf(HandleTable const &table, uint64_t handle) {
+  std::string const *name = table.find(handle);
+  return name ? *name : "<none>";
+}
+
+void testOpenClose() {
+  HandleTable table;
+  CHECK(table.find(4) == nullptr);
+  table.closed(4); // closing in an empty table is harmless
+
+  table.opened(4, "\\Device\\HarddiskVolume1\\a.txt");
+  table.opened(8, "\\Registry\\Machine\\Software");
+  CHECK_EQUAL(table.size(), 2u);
+  CHECK_EQUAL(nameOf(table, 4), "\\Device\\HarddiskVolume1\\a.txt");
+  CHECK_EQUAL(nameOf(table, 8), "\\Registry\\Machine\\Software");
+  CHECK(table.find(12) == nullptr);
+
+  table.closed(4);
+  CHECK_EQUAL(table.size(), 1u);
+  CHECK(table.find(4) == nullptr);
+  CHECK_EQUAL(nameOf(table, 8), "\\Registry\\Machine\\Software");
+
+  // Zero is never a valid handle
+  table.opened(0, "zero");
+  CHECK_EQUAL(table.size(), 1u);
+  CHECK(table.find(0) == nullptr);
+
+  table.clear();
+  CHECK_EQUAL(table.size(), 0u);
+  CHECK(table.find(8) == nullptr);
+}
+
+void testReopen() {
+  HandleTable table;
+  table.opened(4, "first");
+  table.opened(4, "second");
+  CHECK_EQUAL(table.size(), 1u);
+  CHECK_EQUAL(nameOf(table, 4), "second");
+
+  // An unnamed object reusing the value removes the stale name
+  table.opened(4, "");
+  CHECK_EQUAL(table.size(), 0u);
+  CHECK(table.find(4) == nullptr);
+}
+
+void testRelative() {
+  HandleTable table;
+  table.opened(4, "\\Registry\\Machine");
+  table.opened(8, "Software", 4);
+  CHECK_EQUAL(nameOf(table, 8), "\\Registry\\Machine\\Software");
+
+  // An absolute name ignores the root
+  table.opened(12, "\\??\\C:\\x", 4);
+  CHECK_EQUAL(nameOf(table, 12), "\\??\\C:\\x");
+
+  // An unknown root leaves the name as given
+  table.opened(16, "relative", 100);
+  CHECK_EQUAL(nameOf(table, 16), "relative");
+}
+
+void testDuplicate() {
+  HandleTable table;
+  table.opened(4, "object");
+  table.duplicated(4, 40);
+  CHECK_EQUAL(nameOf(table, 40), "object");
+  table.closed(4);
+  CHECK_EQUAL(nameOf(table, 40), "object");
+
+  // Duplicating an unknown handle forgets any stale name at the target
+  table.opened(44, "stale");
+  table.duplicated(400, 44);
+  CHECK(table.find(44) == nullptr);
+}
+
+// Many handles force the table to grow and removals to move back entries
+// in the same probe sequence; every remaining handle must still be found
+void testGrowAndRemove() {
+  HandleTable table;
+  unsigned int const count = 1000;
+  auto const name = [](unsigned int idx) {
+    std::string result("h");
+    result += std::to_string(idx);
+    return result;
+  };
+  for (unsigned int idx = 1; idx <= count; ++idx) {
+    table.opened(idx * 4, name(idx));
+  }
+  CHECK_EQUAL(table.size(), count);
+  for (unsigned int idx = 1; idx <= count; idx += 3) {
+    table.closed(idx * 4);
+  }
+  size_t expected{};
+  bool allFound{true};
+  for (unsigned int idx = 1; idx <= count; ++idx) {
+    bool const closed = (idx - 1) % 3 == 0;
+    std::string const *found = table.find(idx * 4);
+    if (closed) {
+      allFound = allFound && found == nullptr;
+    } else {
+      ++expected;
+      allFound = allFound && found && *found == name(idx);
+    }
+  }
+  CHECK(allFound);
+  CHECK_EQUAL(table.size(), expected);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testOpenClose();
+  testReopen();
+  testRelative();
+  testDuplicate();
+  testGrowAndRemove();
+  return or2::test::result();
+}
@@ -0,0 +1,93 @@
+/*
+NAME
+  HighWaterMarkTest.cpp
+
+DESCRIPTION
+  Unit tests for the high-water mark timeline.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "HighWaterMark.h"
+
+#include "Check.h"
+
+#include <vector>
+
+using or2::HighWaterMark;
+
+namespace {
+
+void testSample() {
+  HighWaterMark marks(1000);
+  CHECK(marks.timeline().empty());
+  marks.sample(1, 5000);
+  marks.sample(3, 5200);
+  marks.sample(2, 5900);
+  marks.sample(3, 7200);
+  marks.sample(0, 7300);
+
+  // Periods are relative to the first sample; only periods with samples
+  // are recorded
+  std::vector<HighWaterMark::Mark> const &timeline = marks.timeline();
+  CHECK_EQUAL(timeline.size(), 2u);
+  CHECK_EQUAL(timeline[0].time, 0u);
+  CHECK_EQUAL(timeline[0].maximum, 3u);
+  CHECK_EQUAL(timeline[1].time, 2000u);
+  CHECK_EQUAL(timeline[1].maximum, 3u);
+
+  // The peak is the first time the largest value was reached
+  CHECK_EQUAL(marks.peak(), 3u);
+  CHECK_EQUAL(marks.peakTime(), 200u);
+}
+
+void testMarks() {
+  HighWaterMark marks(1000);
+  for (uint64_t idx = 0; idx != 5; ++idx) {
+    marks.sample(idx * 10 % 30, idx * 1000);
+  }
+  CHECK_EQUAL(marks.marks(5).size(), 5u);
+  CHECK(marks.marks(0).empty());
+
+  // Adjacent periods are merged, keeping the start of the first
+  std::vector<HighWaterMark::Mark> const merged = marks.marks(2);
+  CHECK_EQUAL(merged.size(), 2u);
+  CHECK_EQUAL(merged[0].time, 0u);
+  CHECK_EQUAL(merged[0].maximum, 20u);
+  CHECK_EQUAL(merged[1].time, 3000u);
+  CHECK_EQUAL(merged[1].maximum, 10u);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testSample();
+  testMarks();
+  return or2::test::result();
+}
@@ -0,0 +1,155 @@
+/*
+NAME
+  JsonWriterTest.cpp
+
+DESCRIPTION
+  Unit tests for the JSON writer.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "JsonWriter.h"
+
+#include "Check.h"
+
+#include <limits>
+#include <ostream>
+#include <sstream>
+
+using or2::JsonTextBuf;
+using or2::JsonWriter;
+
+namespace {
+
+std::string escaped(std::string_view text) {
+  std::ostringstream os;
+  JsonWriter::escape(os, text);
+  return os.str();
+}
+
+void testValues() {
+  std::ostringstream os;
+  JsonWriter writer(os);
+  writer.beginArray()
+      .value("text")
+      .value(uint64_t{42})
+      .value(int64_t{-7})
+      .value(uint32_t{3})
+      .value(int32_t{-3})
+      .value(true)
+      .value(false)
+      .null()
+      .value(std::numeric_limits<uint64_t>::max())
+      .value(std::numeric_limits<int64_t>::min())
+      .endArray();
+  writer.endLine();
+  CHECK_EQUAL(os.str(), "[\"text\",42,-7,3,-3,true,false,null,"
+                        "18446744073709551615,-9223372036854775808]\n");
+}
+
+void testNesting() {
+  std::ostringstream os;
+  JsonWriter writer(os);
+  writer.beginObject().member("function", "NtClose").key("args").beginArray();
+  CHECK_EQUAL(writer.depth(), 2u);
+  writer.beginObject().member("name", "Handle").member("value", 64u);
+  writer.endObject();
+  writer.beginObject().endObject();
+  writer.beginArray().endArray();
+  writer.endArray().member("result", 0u).endObject();
+  CHECK_EQUAL(writer.depth(), 0u);
+  writer.endLine();
+
+  // Each line is a separate top level value
+  writer.beginObject().member("event", "exit").endObject();
+  writer.endLine();
+  CHECK_EQUAL(os.str(), "{\"function\":\"NtClose\",\"args\":[{\"name\":"
+                        "\"Handle\",\"value\":64},{},[]],\"result\":0}\n"
+                        "{\"event\":\"exit\"}\n");
+}
+
+void testNewLine() {
+  std::ostringstream os;
+  JsonWriter writer(os);
+  writer.beginArray().value(1u).newLine().value(2u).endArray();
+  writer.endLine();
+  CHECK_EQUAL(os.str(), "[1,\n2]\n");
+}
+
+void testEscape() {
+  CHECK_EQUAL(escaped("plain"), "plain");
+  CHECK_EQUAL(escaped("say \"hi\"\\"), "say \\\"hi\\\"\\\\");
+  CHECK_EQUAL(escaped("\b\f\n\r\t"), "\\b\\f\\n\\r\\t");
+  CHECK_EQUAL(escaped(std::string_view("\0\x1f", 2)), "\\u0000\\u001f");
+  // Valid UTF-8 is kept
+  CHECK_EQUAL(escaped("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80"),
+              "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80");
+  // Other bytes are taken as Latin-1
+  CHECK_EQUAL(escaped("caf\xe9"), "caf\\u00e9");
+  CHECK_EQUAL(escaped("\xc3"), "\\u00c3");      // truncated sequence
+  CHECK_EQUAL(escaped("\xc0\xaf"), "\\u00c0\\u00af"); // overlong form
+  CHECK_EQUAL(escaped("\xed\xa0\x80"), "\\u00ed\\u00a0\\u0080"); // surrogate
+}
+
+void testKeys() {
+  std::ostringstream os;
+  JsonWriter writer(os);
+  writer.beginObject().member("a\"b", "c\nd").endObject();
+  CHECK_EQUAL(os.str(), "{\"a\\\"b\":\"c\\nd\"}");
+}
+
+void testTextBuf() {
+  std::ostringstream os;
+  JsonWriter writer(os);
+  {
+    JsonTextBuf buf(writer);
+    std::ostream text(&buf);
+    text << "Process 1234 starting\r\n";
+    buf.source("12:34:56.789", 1234, 5678);
+    text << "Thread 5678 exit code: " << 0 << '\n' << "partial";
+  }
+  CHECK_EQUAL(os.str(),
+              "{\"event\":\"message\",\"text\":\"Process 1234 starting\"}\n"
+              "{\"event\":\"message\",\"time\":\"12:34:56.789\",\"pid\":1234,"
+              "\"tid\":5678,\"text\":\"Thread 5678 exit code: 0\"}\n"
+              "{\"event\":\"message\",\"time\":\"12:34:56.789\",\"pid\":1234,"
+              "\"tid\":5678,\"text\":\"partial\"}\n");
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testValues();
+  testNesting();
+  testNewLine();
+  testEscape();
+  testKeys();
+  testTextBuf();
+  return or2::test::result();
+}
@@ -0,0 +1,176 @@
+/*
+NAME
+  LeakTrackerTest.cpp
+
+DESCRIPTION
+  Unit tests for the tracking of open handles.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "LeakTracker.h"
+#include "StackTable.h"
+
+#include "Check.h"
+
+#include <sstream>
+
+using or2::LeakTracker;
+using or2::StackTable;
+
+namespace {
+
+void testOpenClose() {
+  LeakTracker tracker;
+  tracker.opened(4, "Key", "Registry", 1, 100);
+  tracker.opened(8, "Key", "Registry", 1, 200);
+  tracker.opened(12, "Event", "Synchronization", 2, 300);
+  CHECK_EQUAL(tracker.open(), 3u);
+  CHECK_EQUAL(tracker.peak(), 3u);
+
+  tracker.closed(8, 400);
+  CHECK_EQUAL(tracker.open(), 2u);
+
+  // Handles open before tracing began are ignored
+  tracker.closed(100, 500);
+  CHECK_EQUAL(tracker.open(), 2u);
+
+  // A reused handle value replaces the entry whose close was not seen
+  tracker.opened(4, "File", "File", 3, 600);
+  CHECK_EQUAL(tracker.open(), 2u);
+  CHECK_EQUAL(tracker.peak(), 3u);
+
+  std::vector<LeakTracker::Group> const groups = tracker.groups();
+  CHECK_EQUAL(groups.size(), 2u);
+  bool key{};
+  for (auto const &group : groups) {
+    key = key || group.type == "Key";
+  }
+  CHECK(!key);
+}
+
+void testDuplicate() {
+  LeakTracker tracker;
+  tracker.opened(4, "Section", "Memory", 1, 0);
+  tracker.duplicated(4, 8, 2, 10);
+  CHECK_EQUAL(tracker.open(), 2u);
+  tracker.closed(4, 20);
+  CHECK_EQUAL(tracker.open(), 1u);
+
+  std::vector<LeakTracker::Group> const groups = tracker.groups();
+  CHECK_EQUAL(groups.size(), 1u);
+  CHECK_EQUAL(groups[0].type, "Section");
+  CHECK_EQUAL(groups[0].stacks.size(), 1u);
+  CHECK_EQUAL(groups[0].stacks[0].first, 2u);
+
+  // Duplicating an unknown source forgets the target
+  tracker.duplicated(100, 8, 3, 30);
+  CHECK_EQUAL(tracker.open(), 0u);
+}
+
+void testGroups() {
+  LeakTracker tracker;
+  uint64_t handle = 4;
+  for (int idx = 0; idx != 3; ++idx) {
+    tracker.opened(handle += 4, "Event", "Synchronization", 1, 0);
+  }
+  for (int idx = 0; idx != 5; ++idx) {
+    tracker.opened(handle += 4, "Key", "Registry", 2, 0);
+  }
+  for (int idx = 0; idx != 2; ++idx) {
+    tracker.opened(handle += 4, "Key", "Registry", 3, 0);
+  }
+  tracker.opened(handle += 4, "Key", "Other", 3, 0);
+
+  std::vector<LeakTracker::Group> const groups = tracker.groups();
+  CHECK_EQUAL(groups.size(), 3u);
+  // Largest group first, with its largest stack first
+  CHECK_EQUAL(groups[0].type, "Key");
+  CHECK_EQUAL(groups[0].category, "Registry");
+  CHECK_EQUAL(groups[0].count, 7u);
+  CHECK_EQUAL(groups[0].stacks.size(), 2u);
+  CHECK_EQUAL(groups[0].stacks[0].first, 2u);
+  CHECK_EQUAL(groups[0].stacks[0].second, 5u);
+  CHECK_EQUAL(groups[1].type, "Event");
+  CHECK_EQUAL(groups[1].count, 3u);
+  CHECK_EQUAL(groups[2].category, "Other");
+  CHECK_EQUAL(groups[2].count, 1u);
+}
+
+void testTimeline() {
+  LeakTracker tracker(1000);
+  tracker.opened(4, "Key", "Registry", 0, 5000);
+  tracker.opened(8, "Key", "Registry", 0, 5500);
+  tracker.closed(4, 5900);
+  tracker.closed(8, 7200);
+  tracker.opened(12, "Key", "Registry", 0, 7300);
+
+  // Periods are relative to the first event; only periods with changes
+  // are recorded
+  std::vector<LeakTracker::Mark> const &marks = tracker.timeline();
+  CHECK_EQUAL(marks.size(), 2u);
+  CHECK_EQUAL(marks[0].time, 0u);
+  CHECK_EQUAL(marks[0].maximum, 2u);
+  CHECK_EQUAL(marks[1].time, 2000u);
+  CHECK_EQUAL(marks[1].maximum, 1u);
+  CHECK_EQUAL(tracker.peak(), 2u);
+}
+
+void testReport() {
+  StackTable stacks;
+  uint32_t const stack = stacks.intern({"NtCreateKey", "main"});
+  LeakTracker tracker;
+  tracker.opened(4, "Key", "Registry", stack, 1000);
+  tracker.opened(8, "Key", "Registry", stack, 1500);
+  tracker.opened(12, "Event", "Event", 0, 2500);
+
+  std::ostringstream os;
+  tracker.report(os, stacks);
+  CHECK_EQUAL(os.str(), "Handles still open: 3 (peak 3 at 1.5s)\n"
+                        "       2  Key (Registry)\n"
+                        "           2 opened at:\n"
+                        "              NtCreateKey\n"
+                        "              main\n"
+                        "       1  Event\n"
+                        "           1 opened at: (no stack)\n"
+                        "High-water mark:\n"
+                        "       0.0s        2\n"
+                        "       1.0s        3\n");
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testOpenClose();
+  testDuplicate();
+  testGroups();
+  testTimeline();
+  testReport();
+  return or2::test::result();
+}
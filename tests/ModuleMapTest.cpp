@@ -0,0 +1,108 @@
+/*
+NAME
+  ModuleMapTest.cpp
+
+DESCRIPTION
+  Unit tests for the interval map of loaded modules.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "ModuleMap.h"
+
+#include "Check.h"
+
+using or2::ModuleMap;
+
+namespace {
+
+void testFind() {
+  ModuleMap map;
+  CHECK(map.empty());
+  CHECK(map.find(0x1000) == nullptr);
+
+  map.add(0x20000, 0x1000, "b.dll");
+  map.add(0x10000, 0x2000, "a.dll", 0x1234, 0x5678);
+  map.add(0x40000, 0x1000, "c.dll");
+  CHECK_EQUAL(map.size(), 3u);
+
+  // Modules are held in address order
+  CHECK_EQUAL(map.begin()->name, "a.dll");
+  CHECK_EQUAL(map.begin()->timeStamp, 0x1234u);
+  CHECK_EQUAL(map.begin()->checkSum, 0x5678u);
+
+  CHECK(map.find(0xffff) == nullptr);
+  CHECK(map.find(0x10000) != nullptr && map.find(0x10000)->name == "a.dll");
+  CHECK(map.find(0x11fff) != nullptr && map.find(0x11fff)->name == "a.dll");
+  CHECK(map.find(0x12000) == nullptr);
+  CHECK(map.find(0x20800) != nullptr && map.find(0x20800)->name == "b.dll");
+  CHECK(map.find(0x41000) == nullptr);
+}
+
+void testReplace() {
+  ModuleMap map;
+  uint64_t const first = map.add(0x10000, 0x1000, "a.dll").serial;
+  map.add(0x11000, 0x1000, "b.dll");
+  map.add(0x13000, 0x1000, "c.dll");
+
+  // A module overlapping the end of one and all of another replaces both
+  ModuleMap::Module const &added = map.add(0x10800, 0x1000, "d.dll");
+  CHECK(added.serial != first);
+  CHECK_EQUAL(map.size(), 2u);
+  CHECK(map.find(0x10000) == nullptr);
+  CHECK(map.find(0x11000) != nullptr && map.find(0x11000)->name == "d.dll");
+  CHECK(map.find(0x13000) != nullptr && map.find(0x13000)->name == "c.dll");
+
+  // Reloading at the same base gives a new serial number
+  uint64_t const serial = map.find(0x13000)->serial;
+  map.add(0x13000, 0x1000, "c.dll");
+  CHECK(map.find(0x13000)->serial != serial);
+}
+
+void testRemove() {
+  ModuleMap map;
+  map.add(0x10000, 0x1000, "a.dll");
+  map.add(0x20000, 0x1000, "b.dll");
+  CHECK(!map.remove(0x10800));
+  CHECK(map.remove(0x10000));
+  CHECK(!map.remove(0x10000));
+  CHECK(map.find(0x10000) == nullptr);
+  CHECK(map.find(0x20000) != nullptr);
+  map.clear();
+  CHECK(map.empty());
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testFind();
+  testReplace();
+  testRemove();
+  return or2::test::result();
+}
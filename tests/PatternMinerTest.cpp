@@ -0,0 +1,191 @@
+/*
+NAME
+  PatternMinerTest.cpp
+
+DESCRIPTION
+  Unit tests for the repeated call sequence miner.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "PatternMiner.h"
+#include "StackTable.h"
+
+#include "Check.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using or2::PatternMiner;
+using or2::StackTable;
+
+namespace {
+
+using Functions = std::vector<std::string>;
+
+void add(PatternMiner &miner, uint32_t threadId,
+         std::vector<char const *> const &functions) {
+  for (char const *function : functions) {
+    miner.add(1, threadId, function);
+  }
+}
+
+void testLoop() {
+  PatternMiner miner({});
+  for (int idx = 0; idx != 5; ++idx) {
+    miner.add(1, 2, "A", 10);
+    miner.add(1, 2, "B", 20);
+    miner.add(1, 2, "C");
+  }
+  CHECK_EQUAL(miner.calls(), 15u);
+  // The rotations B C A and C A B are not reported
+  auto const patterns = miner.mine(PatternMiner::Calls, 10);
+  CHECK_EQUAL(patterns.size(), 1u);
+  CHECK(patterns[0].functions == Functions({"A", "B", "C"}));
+  CHECK_EQUAL(patterns[0].count, 5u);
+  CHECK_EQUAL(patterns[0].calls, 15u);
+  CHECK(patterns[0].timed);
+  CHECK_EQUAL(patterns[0].microseconds, 150u);
+  CHECK_EQUAL(patterns[0].processId, 1u);
+  CHECK_EQUAL(patterns[0].threadId, 2u);
+}
+
+void testLonger() {
+  // A -> B is always preceded by X, so only X -> A -> B is reported
+  PatternMiner miner({});
+  add(miner, 2, {"X", "A", "B", "Y", "X", "A", "B", "Z"});
+  auto patterns = miner.mine(PatternMiner::Calls, 10);
+  CHECK_EQUAL(patterns.size(), 1u);
+  CHECK(patterns[0].functions == Functions({"X", "A", "B"}));
+  CHECK_EQUAL(patterns[0].count, 2u);
+  CHECK(!patterns[0].timed);
+
+  PatternMiner often({2, 32, 3});
+  add(often, 2, {"X", "A", "B", "Y", "X", "A", "B", "Z"});
+  CHECK(often.mine(PatternMiner::Calls, 10).empty());
+}
+
+void testRepeats() {
+  // Repetitions of one call are counted without overlaps
+  PatternMiner miner({});
+  add(miner, 2, {"A", "A", "A", "A", "A"});
+  auto patterns = miner.mine(PatternMiner::Calls, 10);
+  CHECK_EQUAL(patterns.size(), 1u);
+  CHECK(patterns[0].functions == Functions({"A", "A"}));
+  CHECK_EQUAL(patterns[0].count, 2u);
+  CHECK_EQUAL(patterns[0].calls, 4u);
+
+  // A -> B is too short, so its shortest repetition is reported
+  PatternMiner longer({3, 32, 2});
+  add(longer, 2, {"A", "B", "A", "B", "A", "B", "A", "B", "C"});
+  add(longer, 2, {"P", "Q", "R", "P", "Q", "R"});
+  patterns = longer.mine(PatternMiner::Calls, 10);
+  CHECK_EQUAL(patterns.size(), 2u);
+  CHECK(patterns[0].functions == Functions({"A", "B", "A", "B"}));
+  CHECK_EQUAL(patterns[0].count, 2u);
+  CHECK(patterns[1].functions == Functions({"P", "Q", "R"}));
+}
+
+void testThreads() {
+  // Sequences do not cross from one thread to another
+  PatternMiner miner({});
+  miner.add(1, 2, "A");
+  miner.add(1, 3, "B");
+  miner.add(1, 2, "B");
+  miner.add(1, 3, "A");
+  CHECK(miner.mine(PatternMiner::Calls, 10).empty());
+
+  // but the calls of each thread are kept together
+  PatternMiner interleaved({});
+  for (int idx = 0; idx != 3; ++idx) {
+    interleaved.add(1, 2, "A");
+    interleaved.add(1, 3, "A");
+    interleaved.add(1, 2, "B");
+    interleaved.add(1, 3, "B");
+  }
+  auto const patterns = interleaved.mine(PatternMiner::Calls, 10);
+  CHECK_EQUAL(patterns.size(), 1u);
+  CHECK(patterns[0].functions == Functions({"A", "B"}));
+  CHECK_EQUAL(patterns[0].count, 6u);
+}
+
+void testOrder() {
+  PatternMiner miner({});
+  for (int idx = 0; idx != 4; ++idx) {
+    miner.add(1, 2, "A", 1);
+    miner.add(1, 2, "B", 1);
+    miner.add(1, 2, "Sync");
+  }
+  for (int idx = 0; idx != 2; ++idx) {
+    miner.add(1, 2, "C", 100);
+    miner.add(1, 2, "D", 100);
+    miner.add(1, 2, "E", 100);
+    miner.add(1, 2, "F", 100);
+    miner.add(1, 2, "Sync");
+  }
+  auto patterns = miner.mine(PatternMiner::Count, 1);
+  CHECK_EQUAL(patterns.size(), 1u);
+  CHECK(patterns[0].functions == Functions({"A", "B", "Sync"}));
+  patterns = miner.mine(PatternMiner::Time, 1);
+  CHECK_EQUAL(patterns.size(), 1u);
+  CHECK_EQUAL(patterns[0].functions.front(), "C");
+  CHECK_EQUAL(patterns[0].microseconds, 800u);
+}
+
+void testReport() {
+  StackTable stacks;
+  uint32_t const stack = stacks.intern({"app!main", "app!start"});
+  PatternMiner miner({});
+  for (int idx = 0; idx != 2; ++idx) {
+    miner.add(7, 8, "NtOpenKey", 1500, stack);
+    miner.add(7, 8, "NtClose", 500);
+  }
+  std::ostringstream os;
+  PatternMiner::report(os, stacks, miner.mine(PatternMiner::Calls, 10));
+  CHECK_EQUAL(os.str(), "\nRepeated call sequences\n"
+                        "     Count     Calls     Time ms  Sequence\n"
+                        "         2         4       4.000  NtOpenKey -> "
+                        "NtClose\n"
+                        "            e.g. thread 7/8\n"
+                        "              at: app!main\n"
+                        "                  app!start\n");
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testLoop();
+  testLonger();
+  testRepeats();
+  testThreads();
+  testOrder();
+  testReport();
+  return or2::test::result();
+}
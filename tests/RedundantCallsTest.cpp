@@ -0,0 +1,159 @@
+/*
+NAME
+  RedundantCallsTest.cpp
+
+DESCRIPTION
+  Unit tests for the detection of redundant calls.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "RedundantCalls.h"
+#include "StackTable.h"
+
+#include "Check.h"
+
+#include <sstream>
+
+using or2::RedundantCalls;
+using or2::StackTable;
+
+namespace {
+
+void testNormalize() {
+  // Output values in brackets and pointers are removed
+  CHECK_EQUAL(RedundantCalls::normalize("0x12ff40 [0x40]"), "");
+  CHECK_EQUAL(RedundantCalls::normalize("0x7ffe0000"), "");
+  // Small values, and larger values padded to 8 or 16 digits, are kept
+  CHECK_EQUAL(RedundantCalls::normalize("0x100"), "0x100");
+  CHECK_EQUAL(RedundantCalls::normalize("0x00020019"), "0x00020019");
+  CHECK_EQUAL(RedundantCalls::normalize("0x0000000080000000"),
+              "0x0000000080000000");
+  CHECK_EQUAL(RedundantCalls::normalize("12"), "12");
+  // Quoted strings are kept, even with brackets or hex in them
+  CHECK_EQUAL(RedundantCalls::normalize("\"a [b] 0x123456\""),
+              "\"a [b] 0x123456\"");
+  CHECK_EQUAL(RedundantCalls::normalize("0x40:\"name\""), "0x40:\"name\"");
+  // Spaces left behind are tidied
+  CHECK_EQUAL(RedundantCalls::normalize("0x12ff40 [1] FLAG"), "FLAG");
+}
+
+void testHandleKey() {
+  std::string const name("\\Registry\\Machine\\Software");
+  CHECK_EQUAL(RedundantCalls::handleKey(&name, 0x40),
+              "\"\\Registry\\Machine\\Software\"");
+  // Unnamed handles are told apart by their values
+  CHECK_EQUAL(RedundantCalls::handleKey(nullptr, 0x1c), "(handle 0x1c)");
+  CHECK(RedundantCalls::handleKey(nullptr, 0x1c) !=
+        RedundantCalls::handleKey(nullptr, 0x20));
+}
+
+void testFingerprint() {
+  CHECK_EQUAL(RedundantCalls::fingerprint("NtClose", {"a"}),
+              RedundantCalls::fingerprint("NtClose", {"a"}));
+  CHECK(RedundantCalls::fingerprint("NtClose", {"a"}) !=
+        RedundantCalls::fingerprint("NtOpenKey", {"a"}));
+  CHECK(RedundantCalls::fingerprint("Nt", {"ab", "c"}) !=
+        RedundantCalls::fingerprint("Nt", {"a", "bc"}));
+}
+
+void testWindow() {
+  RedundantCalls redundant(2);
+  std::vector<std::string> const a{"\"a\""};
+  std::vector<std::string> const b{"\"b\""};
+  std::vector<std::string> const c{"\"c\""};
+  CHECK(redundant.add(1, "NtQueryKey", a) == nullptr);
+  // Another thread has its own window
+  CHECK(redundant.add(2, "NtQueryKey", b) == nullptr);
+  CHECK(redundant.add(1, "NtQueryKey", b) == nullptr);
+
+  RedundantCalls::Offender *offender = redundant.add(1, "NtQueryKey", a);
+  CHECK(offender != nullptr);
+  if (offender) {
+    CHECK_EQUAL(offender->calls, 2u);
+    CHECK_EQUAL(offender->repeats, 1u);
+    CHECK_EQUAL(offender->stack, 0u);
+  }
+
+  // 'a' drops out of the window of two calls
+  CHECK(redundant.add(1, "NtQueryKey", c) == nullptr);
+  CHECK(redundant.add(1, "NtQueryKey", b) == nullptr);
+  offender = redundant.add(1, "NtQueryKey", a);
+  CHECK(offender == nullptr);
+
+  // An exited thread starts again
+  redundant.threadExit(2);
+  CHECK(redundant.add(2, "NtQueryKey", b) == nullptr);
+  CHECK(redundant.add(2, "NtQueryKey", b) != nullptr);
+}
+
+void testReport() {
+  RedundantCalls redundant;
+  StackTable stacks;
+  std::vector<std::string> const key{"\"\\Registry\\A\"", "\"Value\"", ""};
+  for (int idx = 0; idx != 3; ++idx) {
+    RedundantCalls::Offender *offender =
+        redundant.add(1, "NtQueryValueKey", key);
+    if (offender && offender->stack == 0) {
+      offender->stack = stacks.intern({"main"});
+    }
+  }
+  redundant.add(1, "NtClose", {"(handle 0x1c)"});
+  redundant.add(1, "NtClose", {"(handle 0x1c)"});
+
+  std::vector<RedundantCalls::Offender const *> const worst =
+      redundant.worst(5);
+  CHECK_EQUAL(worst.size(), 2u);
+  CHECK_EQUAL(worst[0]->function, "NtQueryValueKey");
+  CHECK_EQUAL(worst[0]->calls, 3u);
+  CHECK_EQUAL(worst[0]->repeats, 2u);
+  CHECK_EQUAL(redundant.worst(1).size(), 1u);
+
+  std::ostringstream os;
+  redundant.report(os, stacks, 5);
+  CHECK_EQUAL(os.str(),
+              "\nRedundant calls (repeated within 64 calls on the same "
+              "thread)\n"
+              " Repeats   Calls  Call\n"
+              "       2       3  NtQueryValueKey(\"\\Registry\\A\", "
+              "\"Value\", *)\n"
+              "                  at: main\n"
+              "       1       2  NtClose((handle 0x1c))\n");
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testNormalize();
+  testHandleKey();
+  testFingerprint();
+  testWindow();
+  testReport();
+  return or2::test::result();
+}
@@ -0,0 +1,148 @@
+/*
+NAME
+  RegistryProfileTest.cpp
+
+DESCRIPTION
+  Unit tests for the registry access profile.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "RegistryProfile.h"
+
+#include "Check.h"
+
+#include <sstream>
+
+using or2::RegistryProfile;
+
+namespace {
+
+uint32_t const success = 0;
+uint32_t const bufferOverflow = 0x80000005;
+uint32_t const nameNotFound = 0xC0000034;
+uint32_t const accessDenied = 0xC0000022;
+
+std::string const key("\\Registry\\Machine\\Software\\A");
+
+void testOperation() {
+  CHECK_EQUAL(RegistryProfile::operation("NtOpenKeyEx"), RegistryProfile::Open);
+  CHECK_EQUAL(RegistryProfile::operation("NtQueryKey"), RegistryProfile::Query);
+  CHECK_EQUAL(RegistryProfile::operation("NtEnumerateValueKey"),
+              RegistryProfile::Enumerate);
+  CHECK_EQUAL(RegistryProfile::operation("NtQueryValueKey"),
+              RegistryProfile::ReadValue);
+  CHECK_EQUAL(RegistryProfile::operation("NtDeleteValueKey"),
+              RegistryProfile::Write);
+  CHECK_EQUAL(RegistryProfile::operation("NtClose"), RegistryProfile::OpCount);
+}
+
+void testCounts() {
+  RegistryProfile profile;
+  CHECK(profile.empty());
+  profile.add(key, RegistryProfile::Open, "", success);
+  profile.add(key, RegistryProfile::Open, "", accessDenied);
+  profile.add(key, RegistryProfile::ReadValue, "Missing", nameNotFound);
+  profile.add(key, RegistryProfile::Enumerate, "", success);
+  profile.add(key, RegistryProfile::Write, "Written", success);
+  CHECK_EQUAL(profile.size(), 1u);
+
+  RegistryProfile::Key const &counts = *profile.top(1)[0];
+  CHECK_EQUAL(counts.path, key);
+  CHECK_EQUAL(counts.total(), 5u);
+  CHECK_EQUAL(counts.calls[RegistryProfile::Open], 2u);
+  CHECK_EQUAL(counts.failures, 2u);
+  CHECK_EQUAL(counts.notFound, 1u);
+  // Only reads are counted by value name
+  CHECK_EQUAL(counts.values.size(), 1u);
+  CHECK_EQUAL(counts.values.count("Missing"), 1u);
+  CHECK_EQUAL(counts.values.count("Written"), 0u);
+}
+
+void testRepeats() {
+  RegistryProfile profile;
+  // A size probe then the read itself is not a repeat
+  profile.add(key, RegistryProfile::ReadValue, "Value", bufferOverflow, "2");
+  profile.add(key, RegistryProfile::ReadValue, "Value", success, "2");
+  CHECK_EQUAL(profile.top(1)[0]->repeats, 0u);
+  // Nor is a read of different information about the value
+  profile.add(key, RegistryProfile::ReadValue, "Value", success, "1");
+  CHECK_EQUAL(profile.top(1)[0]->repeats, 0u);
+  // Nor a failed read
+  profile.add(key, RegistryProfile::ReadValue, "Value", nameNotFound, "2");
+  CHECK_EQUAL(profile.top(1)[0]->repeats, 0u);
+  // Reading the same again is
+  profile.add(key, RegistryProfile::ReadValue, "Value", success, "2");
+  CHECK_EQUAL(profile.top(1)[0]->repeats, 1u);
+  CHECK_EQUAL(profile.top(1)[0]->values.at("Value"), 5u);
+
+  // Key queries are told apart by information class
+  profile.add(key, RegistryProfile::Query, "", success, "0");
+  profile.add(key, RegistryProfile::Query, "", success, "2");
+  CHECK_EQUAL(profile.top(1)[0]->repeats, 1u);
+  profile.add(key, RegistryProfile::Query, "", success, "2");
+  CHECK_EQUAL(profile.top(1)[0]->repeats, 2u);
+
+  // Repeats are per key
+  profile.add("\\Registry\\Machine\\B", RegistryProfile::Query, "", success,
+              "2");
+  CHECK_EQUAL(profile.top(2)[1]->repeats, 0u);
+}
+
+void testReport() {
+  RegistryProfile profile;
+  profile.add(key, RegistryProfile::Open, "", success);
+  profile.add(key, RegistryProfile::ReadValue, "", success, "2");
+  profile.add(key, RegistryProfile::ReadValue, "", success, "2");
+  profile.add(key, RegistryProfile::ReadValue, "Name", nameNotFound, "2");
+  profile.add("\\Registry\\Machine\\B", RegistryProfile::Open, "",
+              nameNotFound);
+
+  std::ostringstream os;
+  profile.report(os, 5);
+  CHECK_EQUAL(os.str(),
+              "\nRegistry access for 2 keys\n"
+              "   Calls   Opens Queries   Enums   Reads  Writes  Failed "
+              "NotFound Repeats  Key\n"
+              "       4       1       0       0       3       0       1 "
+              "       1       1  \\Registry\\Machine\\Software\\A\n"
+              "          values: (default):2 Name:1\n"
+              "       1       1       0       0       0       0       1 "
+              "       1       0  \\Registry\\Machine\\B\n");
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testOperation();
+  testCounts();
+  testRepeats();
+  testReport();
+  return or2::test::result();
+}
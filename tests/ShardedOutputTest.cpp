@@ -0,0 +1,235 @@
+/*
+NAME
+  ShardedOutputTest.cpp
+
+DESCRIPTION
+  Unit tests for the sharded output files and their merge.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "ShardedOutput.h"
+
+#include "Check.h"
+
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using or2::ShardBuf;
+using or2::ShardIndex;
+
+namespace {
+
+// A directory for the files written by a test, removed afterwards
+class TempDir {
+public:
+  explicit TempDir(char const *name)
+      : path_(std::filesystem::temp_directory_path() / name) {
+    std::filesystem::remove_all(path_);
+    std::filesystem::create_directory(path_);
+  }
+  ~TempDir() {
+    std::error_code ec;
+    std::filesystem::remove_all(path_, ec);
+  }
+  std::string file(char const *name) const { return (path_ / name).string(); }
+
+private:
+  std::filesystem::path path_;
+};
+
+std::string contents(std::string const &fileName) {
+  std::ifstream ifs(fileName, std::ios::binary);
+  std::ostringstream os;
+  os << ifs.rdbuf();
+  return os.str();
+}
+
+std::string merge(std::vector<std::string> const &texts) {
+  std::vector<std::string_view> views(texts.begin(), texts.end());
+  std::ostringstream os;
+  ShardIndex::merge(views, os);
+  return os.str();
+}
+
+void testNames() {
+  CHECK_EQUAL(ShardBuf::shardName("trace.txt", 0, 0), "trace.txt");
+  CHECK_EQUAL(ShardBuf::shardName("trace.txt", 12, 0), "trace-12.txt");
+  CHECK_EQUAL(ShardBuf::shardName("trace.txt", 12, 34), "trace-12-34.txt");
+  CHECK_EQUAL(ShardBuf::shardName("a.b/trace", 12, 0), "a.b/trace-12");
+  CHECK_EQUAL(ShardBuf::indexName("a.b/trace"), "a.b/trace.index");
+  CHECK_EQUAL(ShardBuf::indexName("trace.txt"), "trace.index");
+}
+
+void testThreads() {
+  TempDir dir("ShardedOutputTest.threads");
+  std::string const fileName = dir.file("trace.txt");
+  std::string expected;
+  {
+    ShardBuf buf(fileName, ShardBuf::Thread);
+    std::ostream os(&buf);
+    auto const line = [&](uint32_t processId, uint32_t threadId,
+                          std::string const &text) {
+      buf.source(processId, threadId);
+      os << text << std::endl;
+      expected += text + '\n';
+    };
+    line(0, 0, "Process 10 starting");
+    buf.processStarted(10, 1, "12:00:00.000", "C:\\app.exe");
+    line(10, 1, "NtOpenFile(...) => 0");
+    line(10, 2, "NtClose(0x40) => 0");
+    line(10, 1, "# a line starting with a hash");
+    line(10, 1, "NtReadFile(...) => 0");
+    buf.threadExited(10, 2);
+    // The file of the thread is written when it exits
+    CHECK_EQUAL(contents(ShardBuf::shardName(fileName, 10, 2)),
+                "#3\nNtClose(0x40) => 0\n");
+    line(10, 2, "NtYieldExecution() => 0");
+    line(0, 0, "Process 10 exit code: 0");
+    buf.processExited(10, "12:00:01.000", 0);
+    CHECK(buf.flush());
+  }
+
+  // The lines are merged in the order written, without the markers
+  std::vector<std::string> texts;
+  std::ifstream index(ShardBuf::indexName(fileName));
+  ShardIndex shards;
+  CHECK(shards.read(index));
+  CHECK_EQUAL(shards.shards().size(), 3u);
+  for (auto const &shard : shards.shards()) {
+    texts.push_back(contents(dir.file(shard.fileName.c_str())));
+  }
+  CHECK_EQUAL(shards.shards()[1].processId, 10u);
+  CHECK_EQUAL(shards.shards()[1].threadId, 1u);
+  CHECK_EQUAL(shards.shards()[1].fileName, "trace-10-1.txt");
+  // The thread used again after it exited is appended to its file
+  CHECK_EQUAL(texts[2],
+              "#3\nNtClose(0x40) => 0\n#5\nNtYieldExecution() => 0\n");
+  CHECK_EQUAL(merge(texts), expected);
+  // and the order of the files does not matter
+  std::swap(texts[0], texts[2]);
+  CHECK_EQUAL(merge(texts), expected);
+
+  CHECK_EQUAL(shards.processes().size(), 1u);
+  CHECK_EQUAL(shards.processes()[0].image, "C:\\app.exe");
+  CHECK_EQUAL(shards.processes()[0].exit, "12:00:01.000");
+}
+
+void testProcesses() {
+  TempDir dir("ShardedOutputTest.processes");
+  std::string const fileName = dir.file("trace.txt");
+  {
+    ShardBuf buf(fileName, ShardBuf::Process, 16);
+    std::ostream os(&buf);
+    buf.processStarted(10, 1, "12:00:00.000", "C:\\parent.exe");
+    buf.processStarted(11, 10, "12:00:00.500", "C:\\child.exe");
+    buf.processStarted(12, 99, "", "C:\\other.exe");
+    buf.source(10, 1);
+    os << "parent thread 1\n";
+    buf.source(10, 2);
+    os << "parent thread 2\n";
+    buf.source(11, 3);
+    // A line written in two parts, around a line for another process
+    os << "child ";
+    buf.source(10, 1);
+    os << "parent\n";
+    buf.source(11, 3);
+    os << "continued\n";
+    buf.processExited(11, "12:00:02.000", 3);
+    CHECK(buf.good());
+  }
+  CHECK_EQUAL(contents(ShardBuf::shardName(fileName, 10, 0)),
+              "#1\nparent thread 1\nparent thread 2\n#3\nparent\n");
+  CHECK_EQUAL(contents(ShardBuf::shardName(fileName, 11, 0)),
+              "#2\nchild \n#4\ncontinued\n");
+  CHECK_EQUAL(merge({contents(ShardBuf::shardName(fileName, 10, 0)),
+                     contents(ShardBuf::shardName(fileName, 11, 0))}),
+              "parent thread 1\nparent thread 2\nchild \nparent\n"
+              "continued\n");
+
+  std::ifstream index(ShardBuf::indexName(fileName));
+  ShardIndex shards;
+  CHECK(shards.read(index));
+  CHECK_EQUAL(shards.processes().size(), 3u);
+  CHECK_EQUAL(shards.processes()[1].exitCode, 3u);
+  CHECK_EQUAL(shards.processes()[2].start, "-");
+  CHECK(shards.tree(10) == std::set<uint32_t>({10, 11}));
+  CHECK(shards.tree(12) == std::set<uint32_t>({12}));
+  std::ostringstream os;
+  shards.print(os);
+  CHECK_EQUAL(os.str(), "10 C:\\parent.exe  started 12:00:00.000\n"
+                        "  11 C:\\child.exe  started 12:00:00.500, exited "
+                        "12:00:02.000 with code 3\n"
+                        "12 C:\\other.exe  started -\n");
+}
+
+void testMerge() {
+  // Lines before the first marker come first
+  CHECK_EQUAL(merge({"#2\nb\n#4\nd", "header\n#1\na\n#3\n##c\n"}),
+              "header\na\nb\n#c\nd");
+  CHECK_EQUAL(merge({}), "");
+
+  std::istringstream notIndex("shard 1 2 trace-1-2.txt\n");
+  ShardIndex shards;
+  CHECK(!shards.read(notIndex));
+}
+
+void testFailure() {
+  TempDir dir("ShardedOutputTest.failure");
+  std::string const missing = dir.file("missing/trace.txt");
+  ShardBuf bad(missing, ShardBuf::Process);
+  CHECK(!bad.good());
+  CHECK_EQUAL(bad.error(), ShardBuf::indexName(missing));
+
+  // A file that cannot be written is reported
+  std::string const fileName = dir.file("trace.txt");
+  std::filesystem::create_directory(ShardBuf::shardName(fileName, 10, 0));
+  ShardBuf buf(fileName, ShardBuf::Process);
+  std::ostream os(&buf);
+  buf.source(10, 1);
+  os << "lost\n";
+  CHECK(!buf.flush());
+  CHECK_EQUAL(buf.error(), ShardBuf::shardName(fileName, 10, 0));
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testNames();
+  testThreads();
+  testProcesses();
+  testMerge();
+  testFailure();
+  return or2::test::result();
+}
@@ -0,0 +1,173 @@
+/*
+NAME
+  SmallIoDetectorTest.cpp
+
+DESCRIPTION
+  Unit tests for the small I/O detector.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "SmallIoDetector.h"
+
+#include "Check.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using or2::SmallIoDetector;
+
+namespace {
+
+using Op = SmallIoDetector::Op;
+uint64_t const current = SmallIoDetector::current;
+
+SmallIoDetector::Settings settings() {
+  SmallIoDetector::Settings result;
+  result.minimum = 2;
+  return result;
+}
+
+void testSmallReads() {
+  SmallIoDetector detector(settings());
+  CHECK(detector.empty());
+  for (int idx = 0; idx != 100; ++idx) {
+    detector.add(1, 0x40, "C:\\data.bin", SmallIoDetector::Read, current, 100,
+                 100, 10);
+  }
+  CHECK(!detector.empty());
+  // The run still in progress is counted
+  auto const streams = detector.worst(10);
+  CHECK_EQUAL(streams.size(), 1u);
+  SmallIoDetector::Stream const &stream = streams[0];
+  CHECK_EQUAL(stream.processId, 1u);
+  CHECK_EQUAL(stream.handle, 0x40u);
+  CHECK_EQUAL(stream.name, "C:\\data.bin");
+  CHECK_EQUAL(stream.total(), 100u);
+  CHECK_EQUAL(stream.calls[SmallIoDetector::Read], 100u);
+  CHECK_EQUAL(stream.bytes, 10000u);
+  CHECK_EQUAL(stream.small, 100u);
+  CHECK_EQUAL(stream.buffered, 1u);
+  CHECK_EQUAL(stream.saved(), 99u);
+  CHECK_EQUAL(stream.timed, 100u);
+  CHECK_EQUAL(stream.microseconds, 1000u);
+}
+
+void testRuns() {
+  SmallIoDetector detector(settings());
+  // Reads at explicit offsets continue the run where the last one ended,
+  // and a seek starts a new run
+  detector.add(1, 0x40, "", SmallIoDetector::Read, 0, 100, 100, -1);
+  detector.add(1, 0x40, "", SmallIoDetector::Read, 100, 100, 100, -1);
+  detector.add(1, 0x40, "", SmallIoDetector::Read, current, 100, 50, -1);
+  detector.add(1, 0x40, "", SmallIoDetector::Read, 5000, 100, 100, -1);
+  detector.add(1, 0x40, "", SmallIoDetector::Read, 5100, 100, 100, -1);
+  // The run is small on average, even with a large call in it, which is
+  // also misaligned
+  detector.add(1, 0x40, "", SmallIoDetector::Read, 5200, 8192, 8192, -1);
+  // Device I/O controls continue the run while the code is unchanged
+  for (int idx = 0; idx != 3; ++idx) {
+    detector.add(1, 0x40, "", SmallIoDetector::Control, current, 16, 16, -1,
+                 0x90000);
+  }
+  detector.add(1, 0x40, "", SmallIoDetector::Control, current, 16, 16, -1,
+               0x90004);
+  detector.add(1, 0x40, "", SmallIoDetector::Control, current, 16, 16, -1,
+               0x90004);
+  detector.close(1, 0x40);
+
+  auto const streams = detector.worst(10);
+  CHECK_EQUAL(streams.size(), 1u);
+  SmallIoDetector::Stream const &stream = streams[0];
+  CHECK_EQUAL(stream.name, "");
+  CHECK_EQUAL(stream.total(), 11u);
+  CHECK_EQUAL(stream.calls[SmallIoDetector::Control], 5u);
+  // Runs of 3 and 3 reads, and of 3 and 2 controls
+  CHECK_EQUAL(stream.small, 3u + 3 + 3 + 2);
+  CHECK_EQUAL(stream.buffered, 4u);
+  CHECK_EQUAL(stream.saved(), 7u);
+  CHECK_EQUAL(stream.misaligned, 1u);
+}
+
+void testMisalignedAndTurns() {
+  SmallIoDetector detector(settings());
+  for (uint64_t idx = 0; idx != 3; ++idx) {
+    detector.add(2, 0x80, "C:\\log.txt", SmallIoDetector::Read,
+                 100 + idx * 8192, 8192, 8192, -1);
+  }
+  for (int idx = 0; idx != 4; ++idx) {
+    detector.add(2, 0x84, "", SmallIoDetector::Write, current, 8192, 8192, -1);
+    detector.add(2, 0x84, "", SmallIoDetector::Read, current, 8192, 8192, -1);
+  }
+  // A handle used again after being closed starts a new stream
+  detector.close(2, 0x84);
+  detector.add(2, 0x84, "", SmallIoDetector::Read, current, 8192, 8192, -1);
+  // Nothing to report
+  detector.add(2, 0x88, "", SmallIoDetector::Read, current, 100, 100, -1);
+  detector.close(2, 0x88);
+
+  auto const streams = detector.worst(10);
+  CHECK_EQUAL(streams.size(), 2u);
+  CHECK_EQUAL(streams[0].handle, 0x84u);
+  CHECK_EQUAL(streams[0].turns, 4u);
+  CHECK_EQUAL(streams[0].total(), 8u);
+  CHECK_EQUAL(streams[0].saved(), 0u);
+  CHECK_EQUAL(streams[1].handle, 0x80u);
+  CHECK_EQUAL(streams[1].misaligned, 3u);
+  CHECK_EQUAL(detector.worst(1).size(), 1u);
+}
+
+void testReport() {
+  SmallIoDetector detector(settings());
+  for (int idx = 0; idx != 4; ++idx) {
+    detector.add(3, 0x1c, "C:\\a.txt", SmallIoDetector::Write, current, 10,
+                 10, 500);
+  }
+  std::ostringstream os;
+  detector.report(os, 10);
+  CHECK_EQUAL(os.str(),
+              "\nSmall I/O on 1 handles (small < 4096, buffer 65536, "
+              "alignment 4096 bytes)\n"
+              "   Calls   Small Buffered   Saved Avg size Misaligned"
+              "   Turns   Time ms  Handle\n"
+              "       4       4        1       3       10          0"
+              "       0     2.000  [3] 0x1c C:\\a.txt\n"
+              "          calls: write:4\n");
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testSmallReads();
+  testRuns();
+  testMisalignedAndTurns();
+  testReport();
+  return or2::test::result();
+}
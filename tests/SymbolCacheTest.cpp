@@ -0,0 +1,140 @@
+/*
+NAME
+  SymbolCacheTest.cpp
+
+DESCRIPTION
+  Unit tests for the module-relative symbol cache.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "SymbolCache.h"
+
+#include <string>
+
+#include "Check.h"
+
+using or2::SymbolCache;
+
+namespace {
+
+// Resolver returning a fixed name, counting the calls
+struct Resolver {
+  std::string name;
+  bool cacheable{true};
+  int *calls{};
+
+  bool operator()(std::string &result) const {
+    ++*calls;
+    result = name;
+    return cacheable;
+  }
+};
+
+void testIdentity() {
+  std::string const identity =
+      SymbolCache::identity("C:\\Windows\\NTDLL.dll", 0x1f0000, 0x5a2b3c4d, 77);
+  CHECK_EQUAL(identity, "c:\\windows\\ntdll.dll:2031616:1512782925:77");
+
+  // A rebuilt module of the same size is a different module
+  SymbolCache cache;
+  uint32_t const original =
+      cache.moduleId(SymbolCache::identity("a.dll", 4096, 1, 2));
+  CHECK_EQUAL(cache.moduleId(SymbolCache::identity("A.DLL", 4096, 1, 2)),
+              original);
+  CHECK(cache.moduleId(SymbolCache::identity("a.dll", 4096, 3, 2)) !=
+        original);
+  CHECK(cache.moduleId(SymbolCache::identity("a.dll", 4096, 1, 4)) !=
+        original);
+}
+
+void testLookup() {
+  SymbolCache cache;
+  int calls{};
+  uint32_t const first = cache.moduleId("first");
+  uint32_t const second = cache.moduleId("second");
+  CHECK(first != second);
+
+  CHECK_EQUAL(cache.lookup(first, 0x10, Resolver{"f!one", true, &calls}),
+              "f!one");
+  CHECK_EQUAL(cache.lookup(first, 0x10, Resolver{"unused", true, &calls}),
+              "f!one");
+  CHECK_EQUAL(calls, 1);
+  CHECK_EQUAL(cache.hits(), 1u);
+  CHECK_EQUAL(cache.misses(), 1u);
+
+  // Same offset in another module is resolved separately
+  CHECK_EQUAL(cache.lookup(second, 0x10, Resolver{"s!one", true, &calls}),
+              "s!one");
+  CHECK_EQUAL(calls, 2);
+
+  // Names that cannot be cached are resolved every time
+  cache.lookup(first, 0x20, Resolver{"0x20", false, &calls});
+  cache.lookup(first, 0x20, Resolver{"0x20", false, &calls});
+  CHECK_EQUAL(calls, 4);
+  CHECK_EQUAL(cache.size(), 2u);
+
+  cache.clear();
+  CHECK_EQUAL(cache.size(), 0u);
+  CHECK_EQUAL(cache.memoryUsed(), 0u);
+  CHECK_EQUAL(cache.moduleId("second"), second);
+}
+
+void testLimit() {
+  SymbolCache cache(0);
+  int calls{};
+  uint32_t const module = cache.moduleId("module");
+  cache.lookup(module, 1, Resolver{"name", true, &calls});
+  CHECK_EQUAL(cache.size(), 0u);
+
+  // Room for two entries: the least recently used is discarded
+  cache.setLimit(1000000);
+  cache.lookup(module, 1, Resolver{"one", true, &calls});
+  size_t const entry = cache.memoryUsed();
+  cache.setLimit(entry * 2 + entry / 2);
+  cache.lookup(module, 2, Resolver{"two", true, &calls});
+  cache.lookup(module, 1, Resolver{"one", true, &calls});
+  cache.lookup(module, 3, Resolver{"six", true, &calls});
+  CHECK_EQUAL(cache.size(), 2u);
+  calls = 0;
+  cache.lookup(module, 1, Resolver{"one", true, &calls});
+  cache.lookup(module, 3, Resolver{"six", true, &calls});
+  CHECK_EQUAL(calls, 0);
+  cache.lookup(module, 2, Resolver{"two", true, &calls});
+  CHECK_EQUAL(calls, 1);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testIdentity();
+  testLookup();
+  testLimit();
+  return or2::test::result();
+}
@@ -0,0 +1,201 @@
+/*
+NAME
+  TraceDiffTest.cpp
+
+DESCRIPTION
+  Unit tests for the structural comparison of traces.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "TraceDiff.h"
+
+#include "Check.h"
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using or2::TraceDiff;
+using or2::TraceParser;
+using or2::TraceRecord;
+
+namespace {
+
+// Length of the longest common subsequence, by dynamic programming
+size_t lcs(std::vector<uint32_t> const &a, std::vector<uint32_t> const &b) {
+  std::vector<std::vector<size_t>> length(
+      a.size() + 1, std::vector<size_t>(b.size() + 1));
+  for (size_t x = 1; x <= a.size(); ++x) {
+    for (size_t y = 1; y <= b.size(); ++y) {
+      length[x][y] = a[x - 1] == b[y - 1]
+                         ? length[x - 1][y - 1] + 1
+                         : std::max(length[x - 1][y], length[x][y - 1]);
+    }
+  }
+  return length[a.size()][b.size()];
+}
+
+// Check the edit script leaves the same calls in the same order, and
+// return the number of edits
+size_t checkScript(std::vector<uint32_t> const &a,
+                   std::vector<uint32_t> const &b) {
+  std::vector<bool> removed;
+  std::vector<bool> inserted;
+  TraceDiff::diff(a, b, removed, inserted);
+  CHECK_EQUAL(removed.size(), a.size());
+  CHECK_EQUAL(inserted.size(), b.size());
+  std::vector<uint32_t> keptA;
+  std::vector<uint32_t> keptB;
+  for (size_t idx = 0; idx != a.size(); ++idx) {
+    if (!removed[idx]) {
+      keptA.push_back(a[idx]);
+    }
+  }
+  for (size_t idx = 0; idx != b.size(); ++idx) {
+    if (!inserted[idx]) {
+      keptB.push_back(b[idx]);
+    }
+  }
+  CHECK(keptA == keptB);
+  return a.size() - keptA.size() + b.size() - keptB.size();
+}
+
+void testDiff() {
+  std::vector<uint32_t> const a{1, 2, 3, 4};
+  std::vector<uint32_t> const b{1, 3, 4, 5};
+  std::vector<bool> removed;
+  std::vector<bool> inserted;
+  TraceDiff::diff(a, b, removed, inserted);
+  CHECK(removed == std::vector<bool>({false, true, false, false}));
+  CHECK(inserted == std::vector<bool>({false, false, false, true}));
+
+  CHECK_EQUAL(checkScript(a, a), 0u);
+  CHECK_EQUAL(checkScript({}, b), 4u);
+  CHECK_EQUAL(checkScript(a, {}), 4u);
+
+  // The script is a shortest one
+  std::mt19937 random(42);
+  for (int test = 0; test != 200; ++test) {
+    std::vector<uint32_t> x(random() % 40);
+    std::vector<uint32_t> y(random() % 40);
+    for (auto &value : x) {
+      value = random() % 5;
+    }
+    for (auto &value : y) {
+      value = random() % 5;
+    }
+    CHECK_EQUAL(checkScript(x, y), x.size() + y.size() - 2 * lcs(x, y));
+  }
+}
+
+void add(TraceDiff &diff, TraceDiff::Side side,
+         std::vector<char const *> const &lines) {
+  uint64_t number{};
+  for (char const *line : lines) {
+    TraceRecord record;
+    CHECK(TraceParser::parse(line, record));
+    diff.add(side, record, ++number);
+  }
+}
+
+std::string report(TraceDiff const &diff) {
+  std::ostringstream os;
+  diff.report(os, 0);
+  return os.str();
+}
+
+void testSame() {
+  // Only the IDs, handles and output values differ
+  TraceDiff diff;
+  add(diff, TraceDiff::Old,
+      {"[100/200] NtOpenKey(KeyHandle=0x12ff00 [0x40], DesiredAccess=1, "
+       "ObjectAttributes=\"\\Registry\\A\") => 0",
+       "[100/200] NtQueryValueKey(KeyHandle=0x40, ValueName=\"V\", "
+       "KeyValueInformation=0x12ff10, ResultLength=0x12ff08 [12]) => 0",
+       "[100/200] NtClose(Handle=0x40) ...",
+       "[100/200] NtClose(Handle=0x40) => 0"});
+  add(diff, TraceDiff::New,
+      {"[300/400] NtOpenKey(KeyHandle=0x22ff00 [0x88], DesiredAccess=1, "
+       "ObjectAttributes=\"\\Registry\\A\") => 0",
+       "[300/400] NtQueryValueKey(KeyHandle=0x88, ValueName=\"V\", "
+       "KeyValueInformation=0x22ff10, ResultLength=0x22ff08 [16]) => 0",
+       "[300/400] NtClose(Handle=0x88) => 0"});
+  CHECK_EQUAL(report(diff), "Calls: 3 old, 3 new\n"
+                            "\nCalls: 0 removed, 0 inserted, 0 reordered "
+                            "(shown as < where moved from and > where moved "
+                            "to)\n");
+}
+
+void testChanges() {
+  TraceDiff diff;
+  add(diff, TraceDiff::Old,
+      {"[1/2] NtOpenKey(KeyHandle=0x12ff00 [0x40], DesiredAccess=1, "
+       "ObjectAttributes=\"\\Registry\\A\") => 0",
+       "[1/2] NtClose(Handle=0x40) => 0",
+       "[1/2] NtYieldExecution() => 0",
+       "[1/2] NtOpenKey(KeyHandle=0x12ff00 [0x44], DesiredAccess=1, "
+       "ObjectAttributes=\"\\Registry\\C\") => 0",
+       "[1/2] NtClose(Handle=0x44) => 0"});
+  add(diff, TraceDiff::New,
+      {"[1/2] NtYieldExecution() => 0",
+       "[1/2] NtOpenKey(KeyHandle=0x12ff00 [0x48], DesiredAccess=1, "
+       "ObjectAttributes=\"\\Registry\\A\") => 0",
+       "[1/2] NtClose(Handle=0x48) => 0",
+       "[1/2] NtOpenKey(KeyHandle=0x12ff00 [0x4c], DesiredAccess=1, "
+       "ObjectAttributes=\"\\Registry\\D\") => 0",
+       "[1/2] NtClose(Handle=0x4c) => 0",
+       "[1/3] NtYieldExecution() => 0"});
+  std::string const text = report(diff);
+  CHECK(text.find("Calls: 5 old, 6 new\n") != std::string::npos);
+  CHECK(text.find("         1          2         +1  NtYieldExecution\n") !=
+        std::string::npos);
+  CHECK(text.find("Thread 1.1 (old 1/2, new 1/2): 2 removed, 2 inserted, "
+                  "1 reordered\n") != std::string::npos);
+  CHECK(text.find("< NtYieldExecution() => 0\n") != std::string::npos);
+  CHECK(text.find("> NtYieldExecution() => 0\n") != std::string::npos);
+  // The handles are named after the keys opened
+  CHECK(text.find("- NtClose(Handle=\"\\Registry\\C\") => 0\n") !=
+        std::string::npos);
+  CHECK(text.find("+ NtClose(Handle=\"\\Registry\\D\") => 0\n") !=
+        std::string::npos);
+  CHECK(text.find("Thread 1.2 (new 1/3, only in new): 0 removed, "
+                  "1 inserted, 0 reordered\n") != std::string::npos);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testDiff();
+  testSame();
+  testChanges();
+  return or2::test::result();
+}
@@ -0,0 +1,198 @@
+/*
+NAME
+  TraceParserTest.cpp
+
+DESCRIPTION
+  Unit tests for the trace parser.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "TraceLine.h"
+#include "TraceParser.h"
+
+#include "Check.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using or2::TraceArgument;
+using or2::TraceLine;
+using or2::TraceParser;
+using or2::TraceRecord;
+
+namespace {
+
+void testHeader() {
+  TraceRecord record;
+  std::string_view line = "12:34:56.789 +0.001: [1234/5678] NtClose(0x40) => 0";
+  size_t pos = TraceParser::parseHeader(line, record);
+  CHECK_EQUAL(record.time, "12:34:56.789 +0.001");
+  CHECK_EQUAL(record.processId, 1234u);
+  CHECK_EQUAL(record.threadId, 5678u);
+  CHECK_EQUAL(record.id, 0u);
+  CHECK_EQUAL(record.sequence(), 5678u);
+  CHECK_EQUAL(line.substr(pos), "NtClose(0x40) => 0");
+
+  // A single ID may be a process or a thread ID
+  line = "[  42] NtClose(0x40) => 0";
+  pos = TraceParser::parseHeader(line, record);
+  CHECK(record.time.empty());
+  CHECK_EQUAL(record.processId, 0u);
+  CHECK_EQUAL(record.threadId, 0u);
+  CHECK_EQUAL(record.id, 42u);
+  CHECK_EQUAL(record.sequence(), 42u);
+  CHECK_EQUAL(line.substr(pos), "NtClose(0x40) => 0");
+
+  // Not a header
+  line = "[inline frame] main";
+  CHECK_EQUAL(TraceParser::parseHeader(line, record), 0u);
+  line = "Process 1234 starting at 0x00400000";
+  CHECK_EQUAL(TraceParser::parseHeader(line, record), 0u);
+}
+
+void testParse() {
+  TraceRecord record;
+  CHECK(TraceParser::parse(
+      "[10/20] NtOpenFile(FileHandle=0x4 [0x40], ObjectAttributes=\"a(b), c\","
+      " 3) => 0xc0000034 [2 'The system cannot find the file specified.']",
+      record));
+  CHECK_EQUAL(record.function, "NtOpenFile");
+  CHECK_EQUAL(record.args,
+              "FileHandle=0x4 [0x40], ObjectAttributes=\"a(b), c\", 3");
+  CHECK_EQUAL(record.result, "0xc0000034");
+  CHECK(!record.before);
+
+  std::string_view args = record.args;
+  TraceArgument arg;
+  CHECK(TraceParser::nextArgument(args, arg));
+  CHECK_EQUAL(arg.name, "FileHandle");
+  CHECK_EQUAL(arg.value, "0x4 [0x40]");
+  CHECK(TraceParser::nextArgument(args, arg));
+  CHECK_EQUAL(arg.name, "ObjectAttributes");
+  CHECK_EQUAL(arg.value, "\"a(b), c\"");
+  CHECK(TraceParser::nextArgument(args, arg));
+  CHECK(arg.name.empty());
+  CHECK_EQUAL(arg.value, "3");
+  CHECK(!TraceParser::nextArgument(args, arg));
+
+  CHECK(TraceParser::parse("NtDelayExecution(0, 0x0012ff00 [-100]) ...",
+                           record));
+  CHECK(record.before);
+  CHECK(record.result.empty());
+
+  CHECK(!TraceParser::parse("Loaded DLL at 0x77000000 ntdll.dll", record));
+  CHECK(!TraceParser::parse("NtClose(0x40", record));
+  CHECK(!TraceParser::parse("NtClose(0x40) =>", record));
+}
+
+void testValues() {
+  uint64_t value{};
+  CHECK(TraceParser::timeOfDay("01:02:03.004", value));
+  CHECK_EQUAL(value, ((1 * 60 + 2) * 60 + 3) * 1000000ull + 4000);
+  CHECK(TraceParser::timeOfDay("01:02:03.004 +0.1", value));
+  CHECK(!TraceParser::timeOfDay("+0.1", value));
+  CHECK(!TraceParser::timeOfDay("01:02:03.0045", value));
+
+  CHECK(TraceParser::number("0x1f", value));
+  CHECK_EQUAL(value, 31u);
+  CHECK(TraceParser::number("123", value));
+  CHECK_EQUAL(value, 123u);
+  CHECK(!TraceParser::number("0x", value));
+  CHECK(!TraceParser::number("12a", value));
+
+  CHECK(TraceParser::isError(0xc0000034));
+  CHECK(!TraceParser::isError(0x80000005));
+  CHECK(!TraceParser::isError(0xffffffffc0000034));
+}
+
+void testLines() {
+  std::string const text = "one\r\ntwo\n\nthree";
+  std::vector<std::string> lines;
+  TraceParser::forEachLine(
+      text, [&](std::string_view line) { lines.emplace_back(line); });
+  CHECK_EQUAL(lines.size(), 4u);
+  CHECK_EQUAL(lines[0], "one");
+  CHECK_EQUAL(lines[2], "");
+  CHECK_EQUAL(lines[3], "three");
+
+  std::string big;
+  for (int idx = 0; idx != 1000; ++idx) {
+    big += '[';
+    big += std::to_string(idx);
+    big += "] NtClose(0x4) => 0\n";
+  }
+  auto const parts = TraceParser::chunks(big, 7);
+  CHECK(parts.size() <= 7);
+  size_t total = 0;
+  for (auto const &part : parts) {
+    CHECK_EQUAL(part.back(), '\n');
+    total += part.size();
+  }
+  CHECK_EQUAL(total, big.size());
+
+  auto const states = TraceParser::parallel<size_t>(
+      big, 4, [](size_t &calls, std::string_view line) {
+        TraceRecord record;
+        calls += TraceParser::parse(line, record) ? 1 : 0;
+      });
+  size_t calls = 0;
+  for (size_t const count : states) {
+    calls += count;
+  }
+  CHECK_EQUAL(calls, 1000u);
+}
+
+void testTraceLine() {
+  TraceLine line;
+  CHECK(line.parse("00:00:01.500: [7] NtClose(Handle=0x40) => 0"));
+  CHECK_EQUAL(line.processId, 0u);
+  CHECK_EQUAL(line.threadId, 0u);
+  CHECK_EQUAL(line.id, 7u);
+  CHECK_EQUAL(line.sequence(), 7u);
+  CHECK_EQUAL(line.function, "NtClose");
+  CHECK_EQUAL(line.args.size(), 1u);
+  CHECK_EQUAL(line.args[0].name, "Handle");
+  CHECK_EQUAL(line.args[0].value, "0x40");
+  uint64_t time{};
+  CHECK(line.timeOfDay(time));
+  CHECK_EQUAL(time, 1500000u);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testHeader();
+  testParse();
+  testValues();
+  testLines();
+  testTraceLine();
+  return or2::test::result();
+}
@@ -0,0 +1,200 @@
+/*
+NAME
+  TraceQueryTest.cpp
+
+DESCRIPTION
+  Unit tests for trace store queries.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "TraceQuery.h"
+
+#include "Check.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using or2::TraceParser;
+using or2::TraceQuery;
+using or2::TraceRecord;
+using or2::TraceStoreReader;
+using or2::TraceStoreWriter;
+using or2::TraceTotals;
+
+namespace {
+
+uint64_t const second = 1000000;
+
+// Write a store of calls from two processes, with process 1 in the first
+// two blocks and process 2 in the last one
+std::string makeStore() {
+  std::string const fileName =
+      (std::filesystem::temp_directory_path() / "TraceQueryTest.nts")
+          .string();
+  static char const *const lines[] = {
+      "00:00:01.000: [1/10] NtClose(0x40) ...",
+      "00:00:01.003: [1/10] NtClose(0x40) => 0",
+      "00:00:01.004: [1/11] NtClose(0x44) => 0xc0000008",
+      "00:00:01.010: [1/10] NtOpenKey(0x12ff00, 1, \"\\Registry\\A\") => 0",
+      "00:00:02.000: [1/11] NtClose(0x48) ...",
+      "00:00:02.001: [1/11] NtClose(0x48) => 0",
+      "00:01:00.000: [2/20] NtClose(0x40) => 0",
+      "00:01:00.500: [2/20] NtOpenKey(0x12ff00, 1, \"\\Registry\\B\") "
+      "=> 0xc0000034",
+  };
+  TraceStoreWriter writer(fileName, 3);
+  writer.beginFile(0);
+  for (char const *line : lines) {
+    TraceRecord record;
+    CHECK(TraceParser::parse(line, record));
+    writer.add(record);
+  }
+  writer.close();
+  CHECK(writer.good());
+  return fileName;
+}
+
+void testTotals() {
+  TraceTotals totals;
+  totals.count = 2;
+  totals.durations = {30, 10};
+  TraceTotals other;
+  other.count = 1;
+  other.errors = 1;
+  other.durations = {20};
+  totals.add(std::move(other));
+  totals.finish();
+  CHECK_EQUAL(totals.count, 3u);
+  CHECK_EQUAL(totals.errors, 1u);
+  CHECK_EQUAL(totals.durations.size(), 3u);
+  CHECK_EQUAL(totals.percentile(0), 10u);
+  CHECK_EQUAL(totals.percentile(50), 20u);
+  CHECK_EQUAL(totals.percentile(99), 30u);
+  CHECK_EQUAL(TraceTotals().percentile(50), 0u);
+}
+
+void testQueries(TraceStoreReader const &reader) {
+  std::vector<TraceQuery::Result> results;
+  TraceQuery::Stats stats;
+
+  // Pre-call lines are not counted
+  TraceQuery byFunction;
+  byFunction.keys = TraceQuery::Function;
+  CHECK(byFunction.run(reader, 1, results, stats));
+  CHECK_EQUAL(results.size(), 2u);
+  CHECK_EQUAL(reader.string(results[0].first.function), "NtClose");
+  CHECK_EQUAL(results[0].second.count, 4u);
+  CHECK_EQUAL(results[0].second.errors, 1u);
+  CHECK_EQUAL(results[0].second.durations.size(), 2u);
+  CHECK_EQUAL(results[0].second.duration, 4000u);
+  CHECK_EQUAL(results[0].second.durations.back(), 3000u);
+  CHECK_EQUAL(reader.string(results[1].first.function), "NtOpenKey");
+  CHECK_EQUAL(results[1].second.count, 2u);
+  CHECK_EQUAL(stats.rows, 8u);
+  CHECK_EQUAL(stats.matched, 6u);
+
+  // The same results on several threads
+  std::vector<TraceQuery::Result> parallel;
+  CHECK(byFunction.run(reader, 4, parallel, stats));
+  CHECK_EQUAL(parallel.size(), results.size());
+  for (size_t idx = 0; idx != results.size(); ++idx) {
+    CHECK(parallel[idx].first == results[idx].first);
+    CHECK_EQUAL(parallel[idx].second.count, results[idx].second.count);
+    CHECK_EQUAL(parallel[idx].second.duration, results[idx].second.duration);
+  }
+
+  // Blocks are skipped by process
+  TraceQuery process;
+  process.processId = 2;
+  process.keys = TraceQuery::Thread;
+  CHECK(process.run(reader, 1, results, stats));
+  CHECK_EQUAL(results.size(), 1u);
+  CHECK_EQUAL(results[0].first.threadId, 20u);
+  CHECK_EQUAL(results[0].second.count, 2u);
+  CHECK_EQUAL(stats.skipped, 2u);
+  CHECK_EQUAL(stats.blocks, 1u);
+
+  TraceQuery errors;
+  errors.errors = true;
+  errors.keys = TraceQuery::Function | TraceQuery::Status | TraceQuery::Args;
+  CHECK(errors.run(reader, 1, results, stats));
+  CHECK_EQUAL(results.size(), 2u);
+  CHECK_EQUAL(reader.string(results[0].first.function), "NtClose");
+  CHECK_EQUAL(results[0].first.status, 0xc0000008u);
+  CHECK_EQUAL(results[0].first.args, "0x44");
+  CHECK_EQUAL(results[1].first.status, 0xc0000034u);
+
+  TraceQuery status;
+  status.status = 0;
+  status.functions.push_back(reader.find("NtOpenKey"));
+  CHECK(status.run(reader, 1, results, stats));
+  CHECK_EQUAL(results.size(), 1u);
+  CHECK_EQUAL(results[0].second.count, 1u);
+
+  // An unknown function matches nothing
+  TraceQuery unknown;
+  unknown.functions.push_back(reader.find("NtCreateFile"));
+  CHECK(unknown.run(reader, 1, results, stats));
+  CHECK(results.empty());
+  CHECK_EQUAL(stats.skipped, 3u);
+
+  TraceQuery range;
+  range.from = 1 * second + 4000;
+  range.to = 2 * second + 1000;
+  CHECK(range.run(reader, 1, results, stats));
+  CHECK_EQUAL(results.size(), 1u);
+  CHECK_EQUAL(results[0].second.count, 3u);
+  CHECK_EQUAL(stats.skipped, 1u);
+
+  TraceQuery buckets;
+  buckets.bucket = 60 * second;
+  CHECK(buckets.run(reader, 1, results, stats));
+  CHECK_EQUAL(results.size(), 2u);
+  CHECK_EQUAL(results[0].first.bucket, 0u);
+  CHECK_EQUAL(results[0].second.count, 4u);
+  CHECK_EQUAL(results[1].first.bucket, 60 * second);
+  CHECK_EQUAL(results[1].second.count, 2u);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testTotals();
+  std::string const fileName = makeStore();
+  {
+    TraceStoreReader reader;
+    std::string error;
+    CHECK(reader.open(fileName, error));
+    testQueries(reader);
+  }
+  std::filesystem::remove(fileName);
+  return or2::test::result();
+}
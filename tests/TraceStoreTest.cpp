@@ -0,0 +1,194 @@
+/*
+NAME
+  TraceStoreTest.cpp
+
+DESCRIPTION
+  Unit tests for the columnar trace store.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "TraceStore.h"
+
+#include "Check.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using or2::TraceColumns;
+using or2::TraceParser;
+using or2::TraceRecord;
+using or2::TraceStoreReader;
+using or2::TraceStoreWriter;
+
+namespace {
+
+uint64_t const second = 1000000;
+uint64_t const day = 24 * 60 * 60 * second;
+
+std::string tempFile(char const *name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void add(TraceStoreWriter &writer, char const *line) {
+  TraceRecord record;
+  CHECK(TraceParser::parse(line, record));
+  writer.add(record);
+}
+
+void testDate() {
+  CHECK_EQUAL(TraceStoreWriter::date(1970, 1, 1), 0u);
+  CHECK_EQUAL(TraceStoreWriter::date(1970, 1, 2), day);
+  uint64_t const date = TraceStoreWriter::date(2026, 2, 28);
+  CHECK_EQUAL(TraceStoreWriter::date(2026, 3, 1) - date, day);
+  CHECK_EQUAL(TraceStoreReader::format(date), "2026-02-28 00:00:00.000");
+  CHECK_EQUAL(TraceStoreReader::format(date + 13 * 3600 * second +
+                                       62 * second + 5000),
+              "2026-02-28 13:01:02.005");
+}
+
+void testRoundTrip() {
+  std::string const fileName = tempFile("TraceStoreTest.nts");
+  uint64_t const date = TraceStoreWriter::date(2026, 10, 18);
+  {
+    TraceStoreWriter writer(fileName, 2);
+    CHECK(writer.good());
+    writer.beginFile(date);
+    add(writer, "23:59:59.000: [1/2] NtWaitForSingleObject(0x40, 0, null) ...");
+    add(writer, "23:59:59.500: [1/3] NtClose(0x44) => 0");
+    add(writer, "00:00:00.250: [1/2] NtWaitForSingleObject(0x40, 0, null) "
+                "=> 0x102");
+    // An untimed line
+    add(writer, "[1/2] NtClose(0x40) => 0xc0000008");
+    writer.close();
+    CHECK(writer.good());
+    CHECK_EQUAL(writer.rows(), 4u);
+  }
+
+  TraceStoreReader reader;
+  std::string error;
+  CHECK(reader.open(fileName, error));
+  CHECK_EQUAL(reader.rows(), 4u);
+  CHECK_EQUAL(reader.blocks().size(), 2u);
+  CHECK_EQUAL(reader.blocks()[0].threadId.min, 2u);
+  CHECK_EQUAL(reader.blocks()[0].threadId.max, 3u);
+
+  TraceColumns columns;
+  CHECK(reader.read(1, columns));
+  CHECK_EQUAL(columns.time.size(), 2u);
+  // The time passes midnight onto the next day
+  CHECK_EQUAL(columns.time[0], date + day + 250000);
+  CHECK_EQUAL(columns.time[1], 0u);
+  CHECK_EQUAL(columns.duration[0], 1250000u + 1);
+  CHECK_EQUAL(columns.duration[1], 0u);
+  CHECK_EQUAL(columns.status[0], 0x102u);
+  CHECK_EQUAL(columns.status[1], 0xc0000008u);
+  CHECK_EQUAL(reader.string(columns.function[1]), "NtClose");
+  CHECK_EQUAL(columns.args[1], "0x40");
+
+  CHECK(reader.read(0, columns, TraceColumns::Time | TraceColumns::Before));
+  CHECK_EQUAL(columns.time[0], date + day - second);
+  CHECK_EQUAL(columns.before[0], 1u);
+  CHECK_EQUAL(columns.before[1], 0u);
+  CHECK(columns.function.empty());
+
+  CHECK_EQUAL(reader.string(reader.find("NtClose")), "NtClose");
+  CHECK_EQUAL(reader.find("NtOpenFile"), reader.strings());
+  std::filesystem::remove(fileName);
+}
+
+void testFiles() {
+  std::string const fileName = tempFile("TraceStoreTest.files.nts");
+  uint64_t const date = TraceStoreWriter::date(2026, 10, 18);
+  {
+    TraceStoreWriter writer(fileName);
+    writer.beginFile(date);
+    add(writer, "10:00:00.000: [1/2] NtDelayExecution(0, 0x12ff00) ...");
+    // A pre-call line does not match a result in the next file
+    writer.beginFile(date + day);
+    add(writer, "10:00:01.000: [1/2] NtDelayExecution(0, 0x12ff00) => 0");
+  }
+  TraceStoreReader reader;
+  std::string error;
+  CHECK(reader.open(fileName, error));
+  TraceColumns columns;
+  CHECK(reader.read(0, columns));
+  CHECK_EQUAL(columns.time[0], date + 10 * 3600 * second);
+  CHECK_EQUAL(columns.time[1], date + day + 10 * 3600 * second + second);
+  CHECK_EQUAL(columns.duration[1], 0u);
+  std::filesystem::remove(fileName);
+}
+
+void testArgs() {
+  std::string const fileName = tempFile("TraceStoreTest.args.nts");
+  {
+    TraceStoreWriter writer(fileName);
+    add(writer, "[1/2] NtOpenFile(0x12ff00 [0x40], 1, \"\\??\\C:\\a.txt\", "
+                "0x12ff10 [0/1], 7, 0) => 0");
+    add(writer, "[1/2] NtOpenFile(0x12ff20 [0x44], 1, \"\\??\\C:\\a.txt\", "
+                "0x12ff30 [0/1], 7, 0) => 0");
+    add(writer, "[1/2] NtQueryValueKey(0x48, \"Value\", 2, 0x12ff40, "
+                "\"\") => 0");
+  }
+  TraceStoreReader reader;
+  std::string error;
+  CHECK(reader.open(fileName, error));
+  // Only the functions and the quoted strings are in the heap
+  CHECK_EQUAL(reader.strings(), 5u);
+  CHECK(reader.find("\"\\??\\C:\\a.txt\"") != reader.strings());
+  TraceColumns columns;
+  CHECK(reader.read(0, columns, TraceColumns::Args));
+  CHECK_EQUAL(columns.args.size(), 3u);
+  CHECK_EQUAL(columns.args[1],
+              "0x12ff20 [0x44], 1, \"\\??\\C:\\a.txt\", 0x12ff30 [0/1], 7, 0");
+  CHECK_EQUAL(columns.args[2], "0x48, \"Value\", 2, 0x12ff40, \"\"");
+  std::filesystem::remove(fileName);
+}
+
+void testNotStore() {
+  std::string const fileName = tempFile("TraceStoreTest.txt");
+  std::ofstream(fileName) << "12:00:00.000: NtClose(0x40) => 0\n";
+  TraceStoreReader reader;
+  std::string error;
+  CHECK(!reader.open(fileName, error));
+  CHECK_EQUAL(error, "not a trace store");
+  std::filesystem::remove(fileName);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testDate();
+  testRoundTrip();
+  testFiles();
+  testArgs();
+  testNotStore();
+  return or2::test::result();
+}
@@ -0,0 +1,144 @@
+/*
+NAME
+  TraceTriggerTest.cpp
+
+DESCRIPTION
+  Unit tests for the trigger starting and stopping tracing.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "TraceTrigger.h"
+
+#include "Check.h"
+
+using or2::TraceTrigger;
+using State = TraceTrigger::State;
+
+namespace {
+
+void testNoTriggers() {
+  TraceTrigger trigger;
+  CHECK(!trigger.enabled());
+  CHECK(trigger.tracing());
+  CHECK(!trigger.debugString("start", 0));
+  CHECK(!trigger.tick(1000));
+  CHECK(trigger.tracing());
+}
+
+void testStartStop() {
+  TraceTrigger trigger;
+  trigger.setStartCall(true);
+  trigger.setStopCall(true);
+  CHECK(trigger.enabled());
+  CHECK(trigger.getState() == State::Idle);
+  CHECK(!trigger.tracing());
+
+  // A stop before any start changes nothing
+  CHECK(!trigger.stopCall(10));
+  CHECK(!trigger.tracing());
+
+  CHECK(trigger.startCall(20));
+  CHECK(trigger.tracing());
+  CHECK(!trigger.startCall(30));
+
+  CHECK(trigger.stopCall(40));
+  CHECK(!trigger.tracing());
+
+  // Tracing restarts on the next start
+  CHECK(trigger.startCall(50));
+  CHECK(trigger.tracing());
+}
+
+void testStopOnly() {
+  // With no start trigger tracing is active from the beginning
+  TraceTrigger trigger;
+  trigger.setStopCall(true);
+  CHECK(trigger.enabled());
+  CHECK(!trigger.hasStart());
+  CHECK(trigger.tracing());
+  CHECK(trigger.stopCall(10));
+  CHECK(!trigger.tracing());
+}
+
+void testStopDelay() {
+  TraceTrigger trigger;
+  trigger.setStartCall(true);
+  trigger.setStopCall(true);
+  trigger.setStopDelay(100);
+  trigger.startCall(0);
+
+  CHECK(!trigger.stopCall(1000));
+  CHECK(trigger.getState() == State::Stopping);
+  CHECK(trigger.tracing());
+  CHECK(!trigger.tick(1099));
+  CHECK(trigger.tick(1100));
+  CHECK(!trigger.tracing());
+  CHECK(!trigger.tick(1200));
+
+  // A start during the delay cancels the stop
+  trigger.startCall(2000);
+  trigger.stopCall(2000);
+  CHECK(!trigger.startCall(2050));
+  CHECK(trigger.getState() == State::Active);
+  CHECK(!trigger.tick(2200));
+  CHECK(trigger.tracing());
+}
+
+void testDebugStrings() {
+  TraceTrigger trigger;
+  trigger.setStartText("BEGIN");
+  trigger.setStopText("END");
+  CHECK(trigger.enabled());
+  CHECK(!trigger.tracing());
+
+  CHECK(!trigger.debugString("nothing to see", 0));
+  CHECK(trigger.debugString("phase BEGIN here\n", 10));
+  CHECK(trigger.tracing());
+  CHECK(trigger.debugString("phase END", 20));
+  CHECK(!trigger.tracing());
+
+  // Both in one string: started and stopped, so no change
+  CHECK(!trigger.debugString("BEGIN and END", 30));
+  CHECK(!trigger.tracing());
+
+  // Matching is case sensitive
+  CHECK(!trigger.debugString("begin", 40));
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testNoTriggers();
+  testStartStop();
+  testStopOnly();
+  testStopDelay();
+  testDebugStrings();
+  return or2::test::result();
+}
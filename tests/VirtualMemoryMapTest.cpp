@@ -0,0 +1,234 @@
+/*
+NAME
+  VirtualMemoryMapTest.cpp
+
+DESCRIPTION
+  Unit tests for the map of the virtual address space.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "VirtualMemoryMap.h"
+#include "StackTable.h"
+
+#include "Check.h"
+
+#include <sstream>
+
+using or2::StackTable;
+using or2::VirtualMemoryMap;
+
+namespace {
+
+// Allocation types
+uint32_t const memCommit = 0x1000;
+uint32_t const memReserve = 0x2000;
+uint32_t const memDecommit = 0x4000;
+uint32_t const memRelease = 0x8000;
+
+// Page protections
+uint32_t const pageReadOnly = 0x02;
+uint32_t const pageReadWrite = 0x04;
+uint32_t const pageExecuteReadWrite = 0x40;
+
+void testReserveCommit() {
+  VirtualMemoryMap map;
+  map.allocate(0x10000, 0x10000, memReserve, pageReadWrite, 1, 0);
+  CHECK_EQUAL(map.allocations(), 1u);
+  CHECK_EQUAL(map.reserved(), 0x10000u);
+  CHECK_EQUAL(map.committed(), 0u);
+
+  // Committing part of the reservation splits it
+  map.allocate(0x11000, 0x1000, memCommit, pageReadWrite, 2, 10);
+  std::vector<VirtualMemoryMap::Block> blocks = map.blocks();
+  CHECK_EQUAL(blocks.size(), 3u);
+  CHECK_EQUAL(blocks[1].base, 0x11000u);
+  CHECK_EQUAL(blocks[1].size, 0x1000u);
+  CHECK_EQUAL(blocks[1].allocationBase, 0x10000u);
+  CHECK(blocks[1].committed);
+  CHECK(!blocks[2].committed);
+  CHECK_EQUAL(map.committed(), 0x1000u);
+  CHECK_EQUAL(map.reserved(), 0x10000u);
+
+  // Decommitting joins the blocks again
+  map.release(0x11000, 0x1000, memDecommit, 20);
+  CHECK_EQUAL(map.blocks().size(), 1u);
+  CHECK_EQUAL(map.committed(), 0u);
+
+  // Releasing with a size of zero frees the whole allocation
+  map.allocate(0x10000, 0x3000, memCommit, pageReadWrite, 2, 30);
+  CHECK_EQUAL(map.committed(), 0x3000u);
+  map.release(0x10000, 0, memRelease, 40);
+  CHECK(map.blocks().empty());
+  CHECK_EQUAL(map.allocations(), 0u);
+  CHECK_EQUAL(map.committed(), 0u);
+  CHECK_EQUAL(map.peak(), 0x3000u);
+}
+
+void testRounding() {
+  VirtualMemoryMap map;
+  // Addresses are rounded out to whole pages
+  map.allocate(0x40010, 0x1ff0, memReserve | memCommit, pageReadWrite, 0, 0);
+  VirtualMemoryMap::Block const *block = map.find(0x41fff);
+  CHECK(block != nullptr);
+  if (block) {
+    CHECK_EQUAL(block->base, 0x40000u);
+    CHECK_EQUAL(block->size, 0x2000u);
+  }
+  CHECK(map.find(0x3ffff) == nullptr);
+  CHECK(map.find(0x42000) == nullptr);
+
+  // An empty request does nothing
+  map.allocate(0x50000, 0, memReserve, pageReadWrite, 0, 0);
+  CHECK_EQUAL(map.allocations(), 1u);
+}
+
+void testUnknownReservation() {
+  VirtualMemoryMap map;
+  // Memory reserved before tracing began is known once it is committed
+  map.allocate(0x20000, 0x2000, memCommit, pageReadOnly, 3, 0);
+  CHECK_EQUAL(map.blocks().size(), 1u);
+  CHECK_EQUAL(map.committed(), 0x2000u);
+  CHECK_EQUAL(map.allocations(), 0u);
+  VirtualMemoryMap::Block const *block = map.find(0x21000);
+  CHECK(block != nullptr && block->allocationBase == 0x20000);
+}
+
+void testProtect() {
+  VirtualMemoryMap map;
+  map.allocate(0x20000, 0x3000, memReserve | memCommit, pageReadWrite, 0, 0);
+  CHECK(map.writableExecutable().empty());
+
+  map.protect(0x21000, 0x1000, pageExecuteReadWrite, 10);
+  CHECK_EQUAL(map.blocks().size(), 3u);
+  std::vector<VirtualMemoryMap::Block const *> const rwx =
+      map.writableExecutable();
+  CHECK_EQUAL(rwx.size(), 1u);
+  if (!rwx.empty()) {
+    CHECK_EQUAL(rwx[0]->base, 0x21000u);
+  }
+
+  map.protect(0x21000, 0x1000, pageReadWrite, 20);
+  CHECK_EQUAL(map.blocks().size(), 1u);
+  CHECK(VirtualMemoryMap::isWritableExecutable(0x80));
+  CHECK(VirtualMemoryMap::isWritableExecutable(0x140)); // with PAGE_GUARD
+  CHECK(!VirtualMemoryMap::isWritableExecutable(0x20));
+}
+
+void testViews() {
+  VirtualMemoryMap map;
+  map.mapView(0x30000, 0x4800, pageReadOnly, 0, 0);
+  VirtualMemoryMap::Block const *block = map.find(0x34000);
+  CHECK(block != nullptr);
+  if (block) {
+    CHECK_EQUAL(block->kind, VirtualMemoryMap::Mapped);
+    CHECK_EQUAL(block->size, 0x5000u);
+    CHECK(block->committed);
+  }
+  CHECK_EQUAL(map.committed(), 0x5000u);
+
+  map.unmapView(0x30000, 10);
+  CHECK(map.find(0x30000) == nullptr);
+  CHECK_EQUAL(map.committed(), 0u);
+}
+
+void testChurn() {
+  VirtualMemoryMap map(100);
+  for (uint64_t time = 0; time != 3000; time += 1000) {
+    map.allocate(0x10000, 0x1000, memReserve | memCommit, pageReadWrite, 5,
+                 time);
+    map.release(0x10000, 0, memRelease, time + 50);
+  }
+  map.allocate(0x20000, 0x2000, memReserve | memCommit, pageReadWrite, 6,
+               5000);
+  map.release(0x20000, 0, memRelease, 5500);
+
+  std::vector<VirtualMemoryMap::Churn> const churn = map.churn(10);
+  CHECK_EQUAL(churn.size(), 1u);
+  if (!churn.empty()) {
+    CHECK_EQUAL(churn[0].size, 0x1000u);
+    CHECK_EQUAL(churn[0].count, 3u);
+    CHECK_EQUAL(churn[0].stack, 5u);
+  }
+}
+
+void testTimeline() {
+  VirtualMemoryMap map(100, 1000);
+  map.allocate(0x10000, 0x1000, memReserve | memCommit, pageReadWrite, 0,
+               2000);
+  map.allocate(0x20000, 0x1000, memReserve | memCommit, pageReadWrite, 0,
+               2500);
+  map.release(0x10000, 0, memRelease, 2600);
+  map.release(0x20000, 0, memRelease, 4000);
+
+  std::vector<VirtualMemoryMap::Mark> const &marks = map.timeline();
+  CHECK_EQUAL(marks.size(), 2u);
+  CHECK_EQUAL(marks[0].time, 0u);
+  CHECK_EQUAL(marks[0].maximum, 0x2000u);
+  CHECK_EQUAL(marks[1].time, 2000u);
+  CHECK_EQUAL(marks[1].maximum, 0u);
+  CHECK_EQUAL(map.peak(), 0x2000u);
+}
+
+void testReport() {
+  StackTable stacks;
+  uint32_t const stack = stacks.intern({"VirtualAlloc", "main"});
+  VirtualMemoryMap map;
+  map.allocate(0x10000, 0x1000, memReserve | memCommit, pageExecuteReadWrite,
+               stack, 1000);
+  map.allocate(0x20000, 0x10000, memReserve, pageReadWrite, 0, 1500);
+
+  std::ostringstream os;
+  map.report(os, stacks);
+  CHECK_EQUAL(os.str(),
+              "Virtual memory: 2 allocations, 68.0 KB reserved, 4.0 KB "
+              "committed (peak 4.0 KB at 0.0s)\n"
+              "Fragmentation: 2 regions; 1 allocations are not a multiple "
+              "of 64 KB, leaving 60.0 KB of address space unusable\n"
+              "Writable and executable regions: 1\n"
+              "    0x10000 4.0 KB, protection 0x40, allocated at:\n"
+              "              VirtualAlloc\n"
+              "              main\n"
+              "Committed KB high-water mark:\n"
+              "       0.0s        4.0\n");
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testReserveCommit();
+  testRounding();
+  testUnknownReservation();
+  testProtect();
+  testViews();
+  testChurn();
+  testTimeline();
+  testReport();
+  return or2::test::result();
+}
@@ -0,0 +1,210 @@
+/*
+NAME
+  WaitProfilerTest.cpp
+
+DESCRIPTION
+  Unit tests for the profile of blocked time.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "WaitProfiler.h"
+#include "StackTable.h"
+
+#include "Check.h"
+
+#include <sstream>
+
+using or2::StackTable;
+using or2::WaitProfiler;
+
+namespace {
+
+WaitProfiler::Wait wait(uint32_t threadId, uint64_t start, uint64_t end,
+                        std::string const &object = "0x40") {
+  WaitProfiler::Wait result;
+  result.processId = 10;
+  result.threadId = threadId;
+  result.start = start;
+  result.end = end;
+  result.function = "NtWaitForSingleObject";
+  result.object = object;
+  return result;
+}
+
+void testIsWait() {
+  size_t argument{99};
+  CHECK(WaitProfiler::isWait("NtWaitForSingleObject", argument));
+  CHECK_EQUAL(argument, 0u);
+  CHECK(WaitProfiler::isWait("NtWaitForMultipleObjects", argument));
+  CHECK_EQUAL(argument, 1u);
+  CHECK(!WaitProfiler::isWait("NtClose", argument));
+}
+
+void testBeginEnd() {
+  WaitProfiler profiler;
+  CHECK(!profiler.end(10, 1, 100, "NtWaitForSingleObject", "0x40", 0));
+  profiler.begin(1, 100);
+  profiler.begin(2, 150);
+  CHECK(profiler.end(10, 1, 300, "NtWaitForSingleObject", "0x40", 7));
+  // Each start is used once
+  CHECK(!profiler.end(10, 1, 400, "NtWaitForSingleObject", "0x40", 0));
+  profiler.threadExit(2);
+  CHECK(!profiler.end(10, 2, 400, "NtWaitForSingleObject", "0x40", 0));
+
+  CHECK_EQUAL(profiler.waits().size(), 1u);
+  WaitProfiler::Wait const &first = profiler.waits()[0];
+  CHECK_EQUAL(first.threadId, 1u);
+  CHECK_EQUAL(first.start, 100u);
+  CHECK_EQUAL(first.end, 300u);
+  CHECK_EQUAL(first.stack, 7u);
+
+  // An end before the start, as across a clock adjustment, takes no time
+  profiler.begin(3, 500);
+  CHECK(profiler.end(10, 3, 400, "NtWaitForSingleObject", "0x40", 0));
+  CHECK_EQUAL(profiler.waits()[1].end, 500u);
+}
+
+void testRanked() {
+  WaitProfiler profiler;
+  WaitProfiler::Wait first = wait(1, 0, 100);
+  first.stack = 1;
+  profiler.add(first);
+  WaitProfiler::Wait second = wait(1, 200, 250);
+  second.stack = 2;
+  profiler.add(second);
+  WaitProfiler::Wait third = wait(2, 300, 330);
+  third.stack = 2;
+  profiler.add(third);
+  profiler.add(wait(3, 0, 1000, "0x44"));
+  profiler.add(wait(3, 2000, 2010, "0x48"));
+
+  std::vector<WaitProfiler::Object> const objects = profiler.ranked(10);
+  CHECK_EQUAL(objects.size(), 3u);
+  CHECK_EQUAL(objects[0].name, "0x44");
+  CHECK_EQUAL(objects[1].name, "0x40");
+  CHECK_EQUAL(objects[1].processId, 10u);
+  CHECK_EQUAL(objects[1].waits, 3u);
+  CHECK_EQUAL(objects[1].microseconds, 180u);
+  CHECK_EQUAL(objects[1].longest, 100u);
+  CHECK_EQUAL(objects[1].threads, 2u);
+  // The stack blocked for longest in total
+  CHECK_EQUAL(objects[1].stack, 1u);
+  CHECK_EQUAL(objects[1].convoys, 0u);
+  CHECK_EQUAL(profiler.ranked(1).size(), 1u);
+}
+
+// A lock handed from one waiter to the next
+void testConvoy() {
+  WaitProfiler profiler;
+  profiler.add(wait(1, 0, 100));
+  profiler.add(wait(2, 10, 200));
+  profiler.add(wait(3, 20, 300));
+  profiler.add(wait(4, 30, 400));
+  // A later run of waits, after the object was free
+  profiler.add(wait(1, 1000, 1100));
+  profiler.add(wait(2, 1010, 1200));
+  profiler.add(wait(3, 1020, 1300));
+
+  std::vector<WaitProfiler::Object> const objects = profiler.ranked(1);
+  CHECK_EQUAL(objects.size(), 1u);
+  CHECK_EQUAL(objects[0].convoys, 2u);
+  CHECK_EQUAL(objects[0].convoyThreads, 4u);
+}
+
+// Waiters all woken together are not a convoy
+void testBroadcast() {
+  WaitProfiler profiler;
+  profiler.add(wait(1, 0, 500));
+  profiler.add(wait(2, 10, 500));
+  profiler.add(wait(3, 20, 500));
+  profiler.add(wait(4, 30, 500));
+  CHECK_EQUAL(profiler.ranked(1)[0].convoys, 0u);
+
+  // Nor is a run of waits that do not overlap the previous release
+  WaitProfiler serial;
+  serial.add(wait(1, 0, 100));
+  serial.add(wait(2, 100, 200));
+  serial.add(wait(3, 200, 300));
+  CHECK_EQUAL(serial.ranked(1)[0].convoys, 0u);
+
+  // A broadcast within a handover does not extend the convoy
+  WaitProfiler mixed(3);
+  mixed.add(wait(1, 0, 100));
+  mixed.add(wait(2, 10, 100));
+  mixed.add(wait(3, 20, 200));
+  CHECK_EQUAL(mixed.ranked(1)[0].convoys, 0u);
+  mixed.add(wait(4, 30, 300));
+  CHECK_EQUAL(mixed.ranked(1)[0].convoys, 1u);
+  CHECK_EQUAL(mixed.ranked(1)[0].convoyThreads, 3u);
+}
+
+void testReport() {
+  StackTable stacks;
+  WaitProfiler profiler;
+  WaitProfiler::Wait first = wait(1, 0, 1500, "\"event\"");
+  first.stack = stacks.intern({"main"});
+  profiler.add(first);
+  profiler.add(wait(2, 100, 2000, "\"event\""));
+  profiler.add(wait(3, 200, 2500, "\"event\""));
+
+  std::ostringstream os;
+  profiler.report(os, stacks, 5);
+  CHECK_EQUAL(os.str(), "\nWaits: 3 on 1 objects, 5.700 ms blocked\n"
+                        "   Waits Threads     Time ms  Longest ms  Object\n"
+                        "       3       3       5.700       2.300  [10] "
+                        "\"event\"\n"
+                        "         convoys: 1, up to 3 threads\n"
+                        "              at: main\n");
+}
+
+void testTimeline() {
+  WaitProfiler profiler;
+  profiler.add(wait(2, 50, 60, "a,b"));
+  profiler.add(wait(1, 10, 70, "say \"x\""));
+
+  std::ostringstream os;
+  profiler.writeTimeline(os);
+  CHECK_EQUAL(os.str(), "process,thread,start,end,function,object\n"
+                        "10,1,10,70,NtWaitForSingleObject,\"say \"\"x\"\"\"\n"
+                        "10,2,50,60,NtWaitForSingleObject,\"a,b\"\n");
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testIsWait();
+  testBeginEnd();
+  testRanked();
+  testConvoy();
+  testBroadcast();
+  testReport();
+  testTimeline();
+  return or2::test::result();
+}
@@ -0,0 +1,246 @@
+/*
+NAME
+  X64TrampolineTest.cpp
+
+DESCRIPTION
+  Unit tests for the x64 register-save trampoline, run on Linux x64.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "X64Trampoline.h"
+
+#include "Check.h"
+
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+
+using or2::X64Trampoline;
+
+// Call 'stub' with the Microsoft x64 calling convention, passing the four
+// register arguments from 'args' and with known values in the non-volatile
+// registers, which are written to 'regs' after the call: rbx, rbp, rdi,
+// rsi and r12 to r15.
+extern "C" uint64_t or2TrampolineCall(void const *stub, uint64_t const *args,
+                                      uint64_t *regs);
+
+asm(R"(
+  .text
+  .globl or2TrampolineCall
+  .type or2TrampolineCall, @function
+or2TrampolineCall:
+  push %rbx
+  push %rbp
+  push %r12
+  push %r13
+  push %r14
+  push %r15
+  push %rdx
+  mov %rdi, %rax
+  mov (%rsi), %rcx
+  mov 8(%rsi), %rdx
+  mov 16(%rsi), %r8
+  mov 24(%rsi), %r9
+  movabs $0x1111111111111111, %rbx
+  movabs $0x2222222222222222, %rbp
+  movabs $0x3333333333333333, %rdi
+  movabs $0x4444444444444444, %rsi
+  movabs $0x5555555555555555, %r12
+  movabs $0x6666666666666666, %r13
+  movabs $0x7777777777777777, %r14
+  movabs $0x8888888888888888, %r15
+  sub $32, %rsp
+  call *%rax
+  add $32, %rsp
+  pop %r11
+  mov %rbx, (%r11)
+  mov %rbp, 8(%r11)
+  mov %rdi, 16(%r11)
+  mov %rsi, 24(%r11)
+  mov %r12, 32(%r11)
+  mov %r13, 40(%r11)
+  mov %r14, 48(%r11)
+  mov %r15, 56(%r11)
+  pop %r15
+  pop %r14
+  pop %r13
+  pop %r12
+  pop %rbp
+  pop %rbx
+  ret
+  .size or2TrampolineCall, . - or2TrampolineCall
+)");
+
+namespace {
+
+using Stub = uint64_t(__attribute__((ms_abi)) *)(uint64_t, uint64_t, uint64_t,
+                                                 uint64_t);
+
+uint32_t const ssn = 0x1234;
+
+// Offsets in the test page
+size_t const stubOffset = 0;        // the jump replacing 'mov eax,<ssn>'
+size_t const resumeOffset = 5;      // the rest of the system call stub
+size_t const trampolineOffset = 64; // the trampoline
+
+// The home area of the register arguments, as copied by the stub
+uint64_t home[4];
+
+// A system call stub whose 'mov eax,<ssn>' is replaced by a jump to a
+// trampoline, in an executable page. In place of the system call, the rest
+// of the stub copies the home area of the arguments to 'home' and returns.
+class Target {
+public:
+  Target() {
+    void *const page = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED) {
+      return;
+    }
+    auto const base = static_cast<unsigned char *>(page);
+    auto const address = [base](size_t offset) {
+      return reinterpret_cast<uint64_t>(base + offset);
+    };
+
+    unsigned char jump[X64Trampoline::jumpSize];
+    CHECK(X64Trampoline::jump(jump, address(stubOffset),
+                              address(trampolineOffset)));
+    memcpy(base + stubOffset, jump, sizeof(jump));
+
+    unsigned char code[X64Trampoline::size];
+    X64Trampoline::generate(code, ssn, address(resumeOffset));
+    memcpy(base + trampolineOffset, code, sizeof(code));
+
+    unsigned char *pos = base + resumeOffset;
+    *pos++ = 0x49; // mov r11,<home>
+    *pos++ = 0xbb;
+    uint64_t const target = reinterpret_cast<uint64_t>(home);
+    memcpy(pos, &target, sizeof(target));
+    pos += sizeof(target);
+    for (unsigned char idx = 0; idx != 4; ++idx) {
+      unsigned char const copy[] = {
+          0x4c, 0x8b, 0x54, 0x24,
+          static_cast<unsigned char>(8 + idx * 8), // mov r10,[rsp+8+idx*8]
+          0x4d, 0x89, 0x53,
+          static_cast<unsigned char>(idx * 8), // mov [r11+idx*8],r10
+      };
+      memcpy(pos, copy, sizeof(copy));
+      pos += sizeof(copy);
+    }
+    *pos++ = 0xc3; // ret
+
+    if (mprotect(page, size_, PROT_READ | PROT_EXEC) == 0) {
+      page_ = base;
+    } else {
+      munmap(page, size_);
+    }
+  }
+
+  ~Target() {
+    if (page_) {
+      munmap(page_, size_);
+    }
+  }
+
+  Target(Target const &) = delete;
+  Target &operator=(Target const &) = delete;
+
+  unsigned char const *stub() const { return page_; }
+
+private:
+  static constexpr size_t size_ = 4096;
+  unsigned char *page_{};
+};
+
+void testGenerate() {
+  unsigned char code[X64Trampoline::size];
+  X64Trampoline::generate(code, ssn, 0x7ffe00001005);
+  unsigned char const expected[] = {
+      0x48, 0x89, 0x4c, 0x24, 0x08, 0x48, 0x89, 0x54, 0x24, 0x10,
+      0x4c, 0x89, 0x44, 0x24, 0x18, 0x4c, 0x89, 0x4c, 0x24, 0x20,
+      0xb8, 0x34, 0x12, 0x00, 0x00, 0xff, 0x25, 0x00, 0x00, 0x00,
+      0x00, 0x05, 0x10, 0x00, 0x00, 0xfe, 0x7f, 0x00, 0x00,
+  };
+  CHECK(memcmp(code, expected, sizeof(code)) == 0);
+}
+
+void testJump() {
+  unsigned char jump[X64Trampoline::jumpSize];
+  CHECK(X64Trampoline::jump(jump, 0x7ffe00001000, 0x7ffe00000f00));
+  unsigned char const expected[] = {0xe9, 0xfb, 0xfe, 0xff, 0xff};
+  CHECK(memcmp(jump, expected, sizeof(jump)) == 0);
+
+  CHECK(X64Trampoline::jump(jump, 0x7ffe00001000, 0x7ffe80000000));
+  CHECK(!X64Trampoline::jump(jump, 0x7ffe00001000, 0x7fff00001000));
+  CHECK(!X64Trampoline::jump(jump, 0x7ffe00001000, 0x7ffd00001000));
+}
+
+void testCall() {
+  Target target;
+  if (!CHECK(target.stub() != nullptr)) {
+    return;
+  }
+  memset(home, 0, sizeof(home));
+  Stub const stub = reinterpret_cast<Stub>(
+      reinterpret_cast<uintptr_t>(target.stub() + stubOffset));
+  CHECK_EQUAL(stub(11, 22, 33, 44), ssn);
+  CHECK_EQUAL(home[0], 11u);
+  CHECK_EQUAL(home[1], 22u);
+  CHECK_EQUAL(home[2], 33u);
+  CHECK_EQUAL(home[3], 44u);
+}
+
+void testPreserved() {
+  Target target;
+  if (!CHECK(target.stub() != nullptr)) {
+    return;
+  }
+  memset(home, 0, sizeof(home));
+  uint64_t const args[] = {0x0123456789abcdef, 2, 3, 0xfedcba9876543210};
+  uint64_t regs[8]{};
+  CHECK_EQUAL(or2TrampolineCall(target.stub() + stubOffset, args, regs), ssn);
+  for (size_t idx = 0; idx != 4; ++idx) {
+    CHECK_EQUAL(home[idx], args[idx]);
+  }
+  // rbx, rbp, rdi, rsi, r12, r13, r14, r15
+  for (size_t idx = 0; idx != 8; ++idx) {
+    CHECK_EQUAL(regs[idx], 0x1111111111111111u * (idx + 1));
+  }
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testGenerate();
+  testJump();
+  testCall();
+  testPreserved();
+  return or2::test::result();
+}
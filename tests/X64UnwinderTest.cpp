@@ -0,0 +1,372 @@
+/*
+NAME
+  X64UnwinderTest.cpp
+
+DESCRIPTION
+  Unit tests for the x64 unwinder, using a synthetic image and stack.
+
+AUTHOR
+  Roger Orr mailto:rogero@howzatt.co.uk
+  Bug reports, comments, and suggestions are always welcome.
+
+COPYRIGHT
+  Copyright (C) 2026 under the MIT license:
+
+  "Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE."
+*/
+
+// $Id$
+
+#include "X64Unwinder.h"
+
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+#include "Check.h"
+
+using or2::ModuleMap;
+using or2::X64Unwinder;
+
+namespace {
+
+// Unwind operation codes
+enum UnwindOp {
+  UWOP_PUSH_NONVOL = 0,
+  UWOP_ALLOC_LARGE = 1,
+  UWOP_ALLOC_SMALL = 2,
+  UWOP_SET_FPREG = 3,
+  UWOP_SAVE_NONVOL = 4,
+};
+
+uint64_t const imageBase = 0x140000000;
+uint64_t const stackBase = 0x7ff000;
+
+// Function layout in the test image
+uint32_t const functionA = 0x1000; // push rbx, push rsi, sub rsp, save rdi
+uint32_t const functionB = 0x1100; // frame pointer in rbp
+uint32_t const functionC = 0x1200; // chained to A
+uint32_t const functionD = 0x1300; // large allocation
+uint32_t const functionEnd = 0x1400;
+
+uint16_t code(unsigned int offset, unsigned int op, unsigned int info) {
+  return static_cast<uint16_t>(offset | (op << 8) | (info << 12));
+}
+
+// A 64-bit image with an exception directory, and a copy of the stack
+class Target {
+public:
+  Target() : image_(0x4000, 0x90) {
+    // DOS header, and the PE32+ headers at 0x80
+    image_[0] = 'M';
+    image_[1] = 'Z';
+    put32(0x3c, 0x80);
+    std::memcpy(&image_[0x80], "PE\0\0", 4);
+    uint32_t const optional = 0x80 + 24;
+    put16(optional, 0x20b);
+    put32(optional + 108, 16);
+
+    // Functions and their unwind information
+    std::vector<uint32_t> table;
+    auto add = [&](uint32_t begin, uint32_t end, uint32_t info) {
+      table.insert(table.end(), {begin, end, info});
+    };
+    add(functionA, functionB, 0x2000);
+    unwindInfo(0x2000, 1, 11, 0, 0,
+               {code(11, UWOP_SAVE_NONVOL, X64Unwinder::RDI), 0x48 / 8,
+                code(6, UWOP_ALLOC_SMALL, (0x28 - 8) / 8),
+                code(2, UWOP_PUSH_NONVOL, X64Unwinder::RSI),
+                code(1, UWOP_PUSH_NONVOL, X64Unwinder::RBX)});
+    add(functionB, functionC, 0x2040);
+    unwindInfo(0x2040, 1, 10, X64Unwinder::RBP, 2,
+               {code(10, UWOP_SET_FPREG, 0),
+                code(5, UWOP_ALLOC_SMALL, (0x40 - 8) / 8),
+                code(1, UWOP_PUSH_NONVOL, X64Unwinder::RBP)});
+    add(functionC, functionD, 0x2080);
+    unwindInfo(0x2080, 1 | (4 << 3), 4, 0, 0,
+               {code(4, UWOP_ALLOC_SMALL, (0x18 - 8) / 8)});
+    // Chained to the entry for A
+    put32(0x2080 + 4 + 4, functionA);
+    put32(0x2080 + 4 + 8, functionB);
+    put32(0x2080 + 4 + 12, 0x2000);
+    add(functionD, functionEnd, 0x20c0);
+    unwindInfo(0x20c0, 1, 7, 0, 0,
+               {code(7, UWOP_ALLOC_LARGE, 0), 0x1000 / 8});
+
+    uint32_t const pdata = 0x3000;
+    for (size_t idx = 0; idx != table.size(); ++idx) {
+      put32(pdata + static_cast<uint32_t>(idx * 4), table[idx]);
+    }
+    put32(optional + 112 + 8 * 3, pdata);
+    put32(optional + 112 + 8 * 3 + 4,
+          static_cast<uint32_t>(table.size() * 4));
+
+    // Epilogs
+    bytes(functionA + 0x80, {0x48, 0x83, 0xc4, 0x28, 0x5e, 0x5b, 0xc3});
+    bytes(functionB + 0x80, {0x48, 0x8d, 0x65, 0x20, 0x5d, 0xc3});
+
+    modules_.add(imageBase, image_.size(), "test.dll");
+    stack_.address = stackBase;
+    stack_.bytes.resize(0x2000);
+  }
+
+  X64Unwinder::ReadMemory reader() {
+    return [this](uint64_t address, void *buffer, size_t size) {
+      if (address >= imageBase && address + size <= imageBase + image_.size()) {
+        std::memcpy(buffer, &image_[address - imageBase], size);
+        return true;
+      }
+      if (stack_.contains(address) && stack_.contains(address + size - 1)) {
+        std::memcpy(buffer, &stack_.bytes[address - stackBase], size);
+        return true;
+      }
+      return false;
+    };
+  }
+
+  // Put a value on the stack
+  void push(uint64_t address, uint64_t value) {
+    std::memcpy(&stack_.bytes[address - stackBase], &value, sizeof(value));
+  }
+
+  X64Unwinder::Stack const &stack() const { return stack_; }
+
+  ModuleMap const &modules() const { return modules_; }
+
+private:
+  void put16(uint32_t rva, uint16_t value) {
+    std::memcpy(&image_[rva], &value, sizeof(value));
+  }
+
+  void put32(uint32_t rva, uint32_t value) {
+    std::memcpy(&image_[rva], &value, sizeof(value));
+  }
+
+  void bytes(uint32_t rva, std::initializer_list<unsigned char> values) {
+    std::memcpy(&image_[rva], values.begin(), values.size());
+  }
+
+  void unwindInfo(uint32_t rva, unsigned char flags, unsigned char prolog,
+                  unsigned char frameRegister, unsigned char frameOffset,
+                  std::initializer_list<uint16_t> codes) {
+    image_[rva] = flags;
+    image_[rva + 1] = prolog;
+    image_[rva + 2] = static_cast<unsigned char>(codes.size());
+    image_[rva + 3] =
+        static_cast<unsigned char>(frameRegister | (frameOffset << 4));
+    uint32_t pos = rva + 4;
+    for (uint16_t const value : codes) {
+      put16(pos, value);
+      pos += 2;
+    }
+  }
+
+  std::vector<unsigned char> image_;
+  ModuleMap modules_;
+  X64Unwinder::Stack stack_;
+};
+
+X64Unwinder::Context context(uint64_t rip, uint64_t rsp) {
+  X64Unwinder::Context result;
+  result.rip = rip;
+  result.regs[X64Unwinder::RSP] = rsp;
+  return result;
+}
+
+// Stack of function A after its prolog, with the stack pointer at 'rsp'
+void frameA(Target &target, uint64_t rsp, uint64_t returnAddress) {
+  target.push(rsp + 0x28, 0x5151);        // rsi
+  target.push(rsp + 0x30, 0xb0b0);        // rbx
+  target.push(rsp + 0x38, returnAddress); // return address
+  target.push(rsp + 0x48, 0xd1d1);        // rdi, saved in the home area
+}
+
+void testBody() {
+  Target target;
+  X64Unwinder unwinder(target.reader());
+  uint64_t const rsp = stackBase + 0x100;
+  frameA(target, rsp, 0x12345);
+
+  auto regs = context(imageBase + functionA + 0x40, rsp);
+  CHECK(unwinder.step(regs, target.stack(), target.modules(), true));
+  CHECK_EQUAL(regs.rip, 0x12345u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSP], rsp + 0x40);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RBX], 0xb0b0u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSI], 0x5151u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RDI], 0xd1d1u);
+}
+
+void testProlog() {
+  Target target;
+  X64Unwinder unwinder(target.reader());
+  uint64_t const rsp = stackBase + 0x100;
+
+  // Stopped after 'push rbx; push rsi', before the allocation
+  target.push(rsp, 0x5151);
+  target.push(rsp + 8, 0xb0b0);
+  target.push(rsp + 16, 0x12345);
+  auto regs = context(imageBase + functionA + 2, rsp);
+  CHECK(unwinder.step(regs, target.stack(), target.modules(), true));
+  CHECK_EQUAL(regs.rip, 0x12345u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSP], rsp + 24);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RBX], 0xb0b0u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSI], 0x5151u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RDI], 0u);
+
+  // Stopped at the start of the function
+  target.push(rsp, 0x6789);
+  regs = context(imageBase + functionA, rsp);
+  CHECK(unwinder.step(regs, target.stack(), target.modules(), true));
+  CHECK_EQUAL(regs.rip, 0x6789u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSP], rsp + 8);
+}
+
+void testEpilog() {
+  Target target;
+  X64Unwinder unwinder(target.reader());
+  uint64_t const rsp = stackBase + 0x100;
+  frameA(target, rsp, 0x12345);
+
+  // At 'add rsp,28h; pop rsi; pop rbx; ret'
+  auto regs = context(imageBase + functionA + 0x80, rsp);
+  CHECK(unwinder.step(regs, target.stack(), target.modules(), true));
+  CHECK_EQUAL(regs.rip, 0x12345u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSP], rsp + 0x40);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSI], 0x5151u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RBX], 0xb0b0u);
+
+  // At 'pop rbx; ret', part way through the epilog
+  regs = context(imageBase + functionA + 0x85, rsp + 0x30);
+  CHECK(unwinder.step(regs, target.stack(), target.modules(), true));
+  CHECK_EQUAL(regs.rip, 0x12345u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSP], rsp + 0x40);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RBX], 0xb0b0u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSI], 0u);
+
+  // At 'ret'
+  regs = context(imageBase + functionA + 0x86, rsp + 0x38);
+  CHECK(unwinder.step(regs, target.stack(), target.modules(), true));
+  CHECK_EQUAL(regs.rip, 0x12345u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSP], rsp + 0x40);
+}
+
+void testFramePointer() {
+  Target target;
+  X64Unwinder unwinder(target.reader());
+  // rbp is 20h above the stack after the prolog; the body has since
+  // allocated more stack
+  uint64_t const frame = stackBase + 0x200;
+  target.push(frame + 0x40, 0xbbbb); // caller's rbp
+  target.push(frame + 0x48, 0x12345);
+
+  auto regs = context(imageBase + functionB + 0x40, frame - 0x100);
+  regs.regs[X64Unwinder::RBP] = frame + 0x20;
+  CHECK(unwinder.step(regs, target.stack(), target.modules(), true));
+  CHECK_EQUAL(regs.rip, 0x12345u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSP], frame + 0x50);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RBP], 0xbbbbu);
+
+  // At 'lea rsp,[rbp+20h]; pop rbp; ret'
+  regs = context(imageBase + functionB + 0x80, frame - 0x100);
+  regs.regs[X64Unwinder::RBP] = frame + 0x20;
+  CHECK(unwinder.step(regs, target.stack(), target.modules(), true));
+  CHECK_EQUAL(regs.rip, 0x12345u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSP], frame + 0x50);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RBP], 0xbbbbu);
+}
+
+void testChained() {
+  Target target;
+  X64Unwinder unwinder(target.reader());
+  uint64_t const rsp = stackBase + 0x100;
+  // C allocates 18h below the frame of A
+  frameA(target, rsp + 0x18, 0x12345);
+
+  auto regs = context(imageBase + functionC + 0x40, rsp);
+  CHECK(unwinder.step(regs, target.stack(), target.modules(), true));
+  CHECK_EQUAL(regs.rip, 0x12345u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSP], rsp + 0x18 + 0x40);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RBX], 0xb0b0u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSI], 0x5151u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RDI], 0xd1d1u);
+}
+
+void testLargeAllocation() {
+  Target target;
+  X64Unwinder unwinder(target.reader());
+  uint64_t const rsp = stackBase + 0x100;
+  target.push(rsp + 0x1000, 0x12345);
+
+  auto regs = context(imageBase + functionD + 0x40, rsp);
+  CHECK(unwinder.step(regs, target.stack(), target.modules(), true));
+  CHECK_EQUAL(regs.rip, 0x12345u);
+  CHECK_EQUAL(regs.regs[X64Unwinder::RSP], rsp + 0x1008);
+}
+
+void testUnwind() {
+  Target target;
+  X64Unwinder unwinder(target.reader());
+
+  // Leaf code with no function table entry, called from A, called from B,
+  // called from the outermost frame
+  uint64_t const rsp = stackBase + 0x100;
+  uint64_t const returnToA = imageBase + functionA + 0x50;
+  uint64_t const returnToB = imageBase + functionB + 0x50;
+  target.push(rsp, returnToA);
+  frameA(target, rsp + 8, returnToB);
+  uint64_t const frameB = rsp + 8 + 0x40;
+  target.push(frameB + 0x40, 0);
+  target.push(frameB + 0x48, 0);
+
+  auto regs = context(imageBase + 0x3800, rsp);
+  regs.regs[X64Unwinder::RBP] = frameB + 0x20;
+  std::vector<X64Unwinder::Frame> frames;
+  CHECK(unwinder.unwind(regs, target.stack(), target.modules(), frames));
+  CHECK_EQUAL(frames.size(), 3u);
+  if (frames.size() == 3) {
+    CHECK_EQUAL(frames[0].rip, imageBase + 0x3800);
+    CHECK_EQUAL(frames[1].rip, returnToA);
+    CHECK_EQUAL(frames[1].rsp, rsp + 8);
+    CHECK_EQUAL(frames[2].rip, returnToB);
+    CHECK_EQUAL(frames[2].rsp, frameB);
+  }
+
+  // The frame limit is respected
+  CHECK(unwinder.unwind(regs, target.stack(), target.modules(), frames, 2));
+  CHECK_EQUAL(frames.size(), 2u);
+
+  // An address outside any module cannot be unwound
+  regs = context(0x1000, rsp);
+  CHECK(!unwinder.unwind(regs, target.stack(), target.modules(), frames));
+  CHECK_EQUAL(frames.size(), 1u);
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+int main() {
+  testBody();
+  testProlog();
+  testEpilog();
+  testFramePointer();
+  testChained();
+  testLargeAllocation();
+  testUnwind();
+  return or2::test::result();
+}